@@ -237,6 +237,9 @@ int main(int argc, char** argv) {
              "Use the specified log level (default info). "
              "Overridden by log level in configuration file")
             ("syslog", "Log to syslog instead of file or standard out")
+            ("log_async", "Write log messages from a background thread")
+            ("log_format", po::value<string>()->default_value("text"),
+             "Log message format for file or standard out: text or json")
             ("daemon", "Run the agent as a daemon");
     } catch (const boost::bad_lexical_cast& e) {
         std::cerr << e.what() << std::endl;
@@ -246,6 +249,8 @@ int main(int argc, char** argv) {
     bool daemon = false;
     bool watch = false;
     bool logToSyslog = false;
+    bool logAsync = false;
+    std::string log_format;
     std::string log_file;
     std::string level_str;
 
@@ -276,6 +281,10 @@ int main(int argc, char** argv) {
         if (vm.count("syslog")) {
             logToSyslog = true;
         }
+        if (vm.count("log_async")) {
+            logAsync = true;
+        }
+        log_format = vm["log_format"].as<string>();
     } catch (const po::unknown_option& e) {
         std::cerr << e.what() << std::endl;
         return 2;
@@ -287,6 +296,7 @@ int main(int argc, char** argv) {
     if (daemon)
         daemonize();
 
+    setLogOutputOptions(logAsync, log_format == "json");
     initLogging(level_str, logToSyslog, log_file);
 
     // Initialize agent and configuration
@@ -88,7 +88,9 @@ int main(int argc, char** argv) {
             ("grpc_conf", po::value<string>()->default_value(""),
              "GRPC config file, should be in same directory as policy file")
             ("prr_interval_secs", po::value<int>()->default_value(60),
-             "How often to wakeup prr thread to check for prr timeouts");
+             "How often to wakeup prr thread to check for prr timeouts")
+            ("listener_loops", po::value<size_t>()->default_value(1),
+             "Number of event loops used to service agent connections");
     } catch (const boost::bad_lexical_cast& e) {
         std::cerr << e.what() << std::endl;
         return 1;
@@ -107,6 +109,7 @@ int main(int argc, char** argv) {
     std::vector<std::string> peers;
     std::vector<std::string> transport_mode_proxies;
     int prr_interval_secs;
+    size_t listener_loops;
 #ifdef HAVE_GRPC_SUPPORT
     std::string grpc_address;
     std::string grpc_conf_file;
@@ -168,6 +171,7 @@ int main(int argc, char** argv) {
             grpc_address = vm["grpc_address"].as<string>();
 #endif
         prr_interval_secs = vm["prr_interval_secs"].as<int>();
+        listener_loops = vm["listener_loops"].as<size_t>();
     } catch (const po::unknown_option& e) {
         std::cerr << e.what() << std::endl;
         return 2;
@@ -219,8 +223,10 @@ int main(int argc, char** argv) {
             server.enableSSL(ssl_castore, ssl_key, ssl_pass);
         }
 
+        server.setListenerLoops(listener_loops);
         server.start();
-        signal(SIGINT | SIGTERM, sighandler);
+        signal(SIGINT, sighandler);
+        signal(SIGTERM, sighandler);
         fd = inotify_init();
         if (fd < 0) {
             LOG(ERROR) << "Could not initialize inotify: "
@@ -0,0 +1,423 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*
+ * Load generator for the OpFlex server.  Simulates many lightweight
+ * agents that connect, resolve endpoint groups and receive policy
+ * updates, and reports resolve latency and update throughput.
+ *
+ * Copyright (c) 2020 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <unistd.h>
+#include <csignal>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <modelgbp/dmtree/Root.hpp>
+#include <modelgbp/metadata/metadata.hpp>
+#include <opflex/test/GbpOpflexServer.h>
+#include <opflex/ofcore/OFFramework.h>
+#include <opflex/ofcore/OFConstants.h>
+#include <rapidjson/filereadstream.h>
+
+#include <opflexagent/logging.h>
+
+using std::string;
+using std::make_pair;
+using std::shared_ptr;
+namespace po = boost::program_options;
+using opflex::test::GbpOpflexServer;
+using opflex::ofcore::OFConstants;
+using opflex::modb::URI;
+using namespace opflexagent;
+
+typedef std::chrono::steady_clock sclock;
+
+std::atomic<bool> running(true);
+
+void sighandler(int sig) {
+    running = false;
+    LOG(INFO) << "Got " << strsignal(sig) << " signal";
+}
+
+#define SERVER_ROLES \
+        (OFConstants::POLICY_REPOSITORY |     \
+         OFConstants::ENDPOINT_REGISTRY |     \
+         OFConstants::OBSERVER)
+
+/**
+ * Track the endpoint groups a simulated agent is waiting for, and
+ * record how long each took to arrive
+ */
+class ResolveTracker : public opflex::modb::ObjectListener {
+public:
+    ResolveTracker() : updates(0) {}
+    virtual ~ResolveTracker() {}
+
+    void expect(const URI& uri, sclock::time_point start) {
+        std::lock_guard<std::mutex> guard(mutex);
+        pending.emplace(uri, start);
+    }
+
+    virtual void objectUpdated(opflex::modb::class_id_t class_id,
+                               const URI& uri) {
+        sclock::time_point now = sclock::now();
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = pending.find(uri);
+        if (it == pending.end()) {
+            updates += 1;
+            return;
+        }
+        latencies.push_back(std::chrono::duration<double, std::milli>
+                            (now - it->second).count());
+        pending.erase(it);
+        if (pending.empty())
+            cond.notify_all();
+    }
+
+    bool waitResolved(sclock::time_point deadline) {
+        std::unique_lock<std::mutex> guard(mutex);
+        return cond.wait_until(guard, deadline,
+                               [this]() { return pending.empty(); });
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::unordered_map<URI, sclock::time_point> pending;
+    std::vector<double> latencies;
+    uint64_t updates;
+};
+
+/**
+ * A simulated agent: an OpFlex framework declaring a set of local
+ * endpoints, without any renderer
+ */
+class SimAgent {
+public:
+    SimAgent(const string& identity, const string& domain) {
+        framework.setModel(modelgbp::getMetadata());
+        framework.setOpflexIdentity(identity, domain);
+    }
+
+    void start(const string& host, int port) {
+        framework.start();
+        modelgbp::gbp::EpGroup::registerListener(framework, &tracker);
+        framework.addPeer(host, port);
+
+        opflex::modb::Mutator mutator(framework, "init");
+        shared_ptr<modelgbp::dmtree::Root> root =
+            modelgbp::dmtree::Root::createRootElement(framework);
+        root->addPolicyUniverse();
+        root->addRelatorUniverse();
+        root->addEprL2Universe();
+        root->addEprL3Universe();
+        l2d = root->addEpdrL2Discovered();
+        root->addEpdrL3Discovered();
+        root->addGbpeVMUniverse();
+        root->addObserverEpStatUniverse();
+        root->addObserverSysStatUniverse();
+        root->addSvcServiceUniverse();
+        mutator.commit();
+    }
+
+    void declareEndpoints(const std::vector<std::pair<string, URI> >& eps) {
+        sclock::time_point now = sclock::now();
+        for (auto& ep : eps)
+            tracker.expect(ep.second, now);
+
+        opflex::modb::Mutator mutator(framework, "policyelement");
+        for (auto& ep : eps) {
+            l2d->addEpdrLocalL2Ep(ep.first)
+                ->addEpdrEndPointToGroupRSrc()
+                ->setTargetEpGroup(ep.second);
+        }
+        mutator.commit();
+    }
+
+    void stop() {
+        modelgbp::gbp::EpGroup::unregisterListener(framework, &tracker);
+        framework.stop();
+    }
+
+    opflex::ofcore::OFFramework framework;
+    ResolveTracker tracker;
+    shared_ptr<modelgbp::epdr::L2Discovered> l2d;
+};
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+    signal(SIGPIPE, SIG_IGN);
+    // Parse command line options
+    po::options_description desc("Allowed options");
+    try {
+        desc.add_options()
+            ("help,h", "Print this help message")
+            ("log", po::value<string>()->default_value(""),
+             "Log to the specified file (default standard out)")
+            ("level", po::value<string>()->default_value("warning"),
+             "Use the specified log level (default warning)")
+            ("host", po::value<string>()->default_value("127.0.0.1"),
+             "OpFlex server host name")
+            ("port", po::value<int>()->default_value(8009),
+             "OpFlex server port")
+            ("domain", po::value<string>()->default_value("test"),
+             "OpFlex domain")
+            ("policy,p", po::value<string>()->default_value(""),
+             "Run an in-process server seeded with the specified policy "
+             "file instead of connecting to an external server")
+            ("listener_loops", po::value<size_t>()->default_value(1),
+             "Number of listener loops for the in-process server")
+            ("churn_interval", po::value<uint32_t>()->default_value(0),
+             "Interval in milliseconds between replaying the policy file "
+             "as an update on the in-process server for the rest of each "
+             "round once resolved.  The updates cycle through replacing, "
+             "removing and adding back the objects. 0 to disable.")
+            ("agents,a", po::value<uint32_t>()->default_value(100),
+             "Number of simulated agents")
+            ("endpoints,e", po::value<uint32_t>()->default_value(10),
+             "Number of endpoints per agent")
+            ("epgroups,g", po::value<uint32_t>()->default_value(3),
+             "Number of EP groups to spread endpoints across")
+            ("rounds,r", po::value<uint32_t>()->default_value(1),
+             "Number of times to connect and resolve with all agents")
+            ("timeout", po::value<uint32_t>()->default_value(30000),
+             "Time in milliseconds to wait for each round to resolve")
+            ("identity_template", po::value<string>()->
+                 default_value("load_agent_<agent_id>"),
+             "Template for OpFlex agent identities")
+            ("epg_template", po::value<string>()->
+                 default_value("/PolicyUniverse/PolicySpace/test/"
+                               "GbpEpGroup/group<group_id>/"),
+             "Template for EPG URIs for endpoints; group IDs start at 1");
+    } catch (const boost::bad_lexical_cast& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::string log_file;
+    std::string level_str;
+    std::string host;
+    int port;
+    std::string domain;
+    std::string policy_file;
+    size_t listener_loops;
+    uint32_t churn_interval;
+    uint32_t num_agents;
+    uint32_t num_endpoints;
+    uint32_t num_epgs;
+    uint32_t num_rounds;
+    uint32_t timeout;
+    std::string identity_template;
+    std::string epg_template;
+
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).
+                  options(desc).run(), vm);
+        po::notify(vm);
+
+        if (vm.count("help")) {
+            std::cout << "Usage: " << argv[0] << " [options]\n";
+            std::cout << desc;
+            return 0;
+        }
+        log_file = vm["log"].as<string>();
+        level_str = vm["level"].as<string>();
+        host = vm["host"].as<string>();
+        port = vm["port"].as<int>();
+        domain = vm["domain"].as<string>();
+        policy_file = vm["policy"].as<string>();
+        listener_loops = vm["listener_loops"].as<size_t>();
+        churn_interval = vm["churn_interval"].as<uint32_t>();
+        num_agents = vm["agents"].as<uint32_t>();
+        num_endpoints = vm["endpoints"].as<uint32_t>();
+        num_epgs = std::max(vm["epgroups"].as<uint32_t>(), 1u);
+        num_rounds = vm["rounds"].as<uint32_t>();
+        timeout = vm["timeout"].as<uint32_t>();
+        identity_template = vm["identity_template"].as<string>();
+        epg_template = vm["epg_template"].as<string>();
+    } catch (const po::unknown_option& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    } catch (const std::bad_cast& e) {
+        std::cerr << e.what() << std::endl;
+        return 3;
+    }
+
+    initLogging(level_str, false /*syslog*/, log_file, "opflex-server-load");
+
+    try {
+        std::unique_ptr<GbpOpflexServer> server;
+        rapidjson::Document churnDoc;
+        if (!policy_file.empty()) {
+            GbpOpflexServer::peer_vec_t peer_vec;
+            peer_vec.push_back(make_pair(SERVER_ROLES,
+                                         host + ":" +
+                                         std::to_string(port)));
+            server.reset(new GbpOpflexServer(port, SERVER_ROLES, peer_vec,
+                                             std::vector<std::string>(),
+                                             modelgbp::getMetadata(), 60));
+            server->readPolicy(policy_file);
+            server->setListenerLoops(listener_loops);
+            server->start();
+
+            if (churn_interval > 0) {
+                FILE* fp = fopen(policy_file.c_str(), "r");
+                if (fp == NULL) {
+                    LOG(ERROR) << "Could not open policy file "
+                               << policy_file << " for reading";
+                    return 4;
+                }
+                char buffer[1024];
+                rapidjson::FileReadStream f(fp, buffer, sizeof(buffer));
+                churnDoc.ParseStream<0, rapidjson::UTF8<>,
+                    rapidjson::FileReadStream>(f);
+                fclose(fp);
+            }
+        } else if (churn_interval > 0) {
+            LOG(WARNING) << "Policy churn requires an in-process server;"
+                         << " ignoring churn_interval";
+            churn_interval = 0;
+        }
+
+        signal(SIGINT, sighandler);
+        signal(SIGTERM, sighandler);
+
+        std::vector<std::vector<URI> > agentGroups(num_agents);
+        for (uint32_t i = 0; i < num_agents; i++) {
+            for (uint32_t j = 0; j < num_endpoints; j++) {
+                uint32_t groupId = 1 + (i * num_endpoints + j) % num_epgs;
+                string uri =
+                    boost::replace_all_copy(epg_template, "<group_id>",
+                                            std::to_string(groupId));
+                agentGroups[i].push_back(URI(uri));
+            }
+        }
+
+        std::vector<double> latencies;
+        uint64_t updates = 0;
+        uint64_t unresolved = 0;
+        uint64_t churns = 0;
+        double resolveSecs = 0;
+        double churnSecs = 0;
+
+        for (uint32_t round = 0; round < num_rounds && running; round++) {
+            std::vector<std::unique_ptr<SimAgent> > agents;
+            for (uint32_t i = 0; i < num_agents; i++) {
+                string identity =
+                    boost::replace_all_copy(identity_template, "<agent_id>",
+                                            std::to_string(i));
+                agents.emplace_back(new SimAgent(identity, domain));
+                agents.back()->start(host, port);
+            }
+
+            sclock::time_point start = sclock::now();
+            for (uint32_t i = 0; i < num_agents; i++) {
+                std::vector<std::pair<string, URI> > eps;
+                for (uint32_t j = 0; j < num_endpoints; j++) {
+                    eps.push_back(make_pair(std::to_string(j),
+                                            agentGroups[i][j]));
+                }
+                agents[i]->declareEndpoints(eps);
+            }
+
+            sclock::time_point deadline =
+                start + std::chrono::milliseconds(timeout);
+            for (auto& a : agents) {
+                if (!a->tracker.waitResolved(deadline))
+                    break;
+            }
+            resolveSecs += std::chrono::duration<double>
+                (sclock::now() - start).count();
+
+            if (server && churn_interval > 0) {
+                // replace, remove, then add back the objects, so each
+                // kind of update is fanned out and the policy is whole
+                // again at the end of every cycle
+                static const opflex::gbp::PolicyUpdateOp churnOps[] = {
+                    opflex::gbp::PolicyUpdateOp::REPLACE,
+                    opflex::gbp::PolicyUpdateOp::DELETE,
+                    opflex::gbp::PolicyUpdateOp::ADD,
+                };
+                const size_t nChurnOps =
+                    sizeof(churnOps) / sizeof(churnOps[0]);
+                sclock::time_point churnStart = sclock::now();
+                size_t op = 0;
+                while (running &&
+                       (sclock::now() < deadline || op % nChurnOps != 0)) {
+                    server->updatePolicy(churnDoc, churnOps[op % nChurnOps]);
+                    op += 1;
+                    churns += 1;
+                    std::this_thread::sleep_for
+                        (std::chrono::milliseconds(churn_interval));
+                }
+                churnSecs += std::chrono::duration<double>
+                    (sclock::now() - churnStart).count();
+            }
+
+            for (auto& a : agents) {
+                a->stop();
+                std::lock_guard<std::mutex> guard(a->tracker.mutex);
+                latencies.insert(latencies.end(),
+                                 a->tracker.latencies.begin(),
+                                 a->tracker.latencies.end());
+                unresolved += a->tracker.pending.size();
+                updates += a->tracker.updates;
+            }
+            LOG(INFO) << "Round " << (round + 1) << " complete";
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << std::fixed << std::setprecision(2)
+                  << "agents: " << num_agents
+                  << " rounds: " << num_rounds
+                  << " listener_loops: " << listener_loops << "\n"
+                  << "resolved: " << latencies.size()
+                  << " unresolved: " << unresolved << "\n"
+                  << "resolve latency ms:"
+                  << " p50=" << percentile(latencies, 0.50)
+                  << " p90=" << percentile(latencies, 0.90)
+                  << " p99=" << percentile(latencies, 0.99)
+                  << " max=" << (latencies.empty() ? 0 : latencies.back())
+                  << "\n"
+                  << "resolve throughput: "
+                  << (resolveSecs > 0 ? latencies.size() / resolveSecs : 0)
+                  << " objects/s\n";
+        if (churns > 0) {
+            std::cout << "policy churn: " << churns << " updates, "
+                      << (churnSecs > 0 ? updates / churnSecs : 0)
+                      << " object updates/s received\n";
+        }
+
+        if (server)
+            server->stop();
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Fatal error: " << e.what();
+        return 4;
+    } catch (...) {
+        LOG(ERROR) << "Unknown fatal error";
+        return 5;
+    }
+}
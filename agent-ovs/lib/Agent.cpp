@@ -151,6 +151,8 @@ void Agent::loadPlugin(const std::string& name) {
 
 void Agent::setProperties(const boost::property_tree::ptree& properties) {
     static const std::string LOG_LEVEL("log.level");
+    static const std::string LOG_ASYNC("log.async");
+    static const std::string LOG_FORMAT("log.format");
 #ifdef HAVE_PROMETHEUS_SUPPORT
     static const std::string PROMETHEUS_ENABLED("prometheus.enabled");
     static const std::string PROMETHEUS_LOCALHOST_ONLY("prometheus.localhost-only");
@@ -196,6 +198,11 @@ void Agent::setProperties(const boost::property_tree::ptree& properties) {
     static const std::string OPFLEX_STATS_SECGRP_INTERVAL("opflex.statistics.security-group.interval");
     static const std::string OPFLEX_PRR_INTERVAL("opflex.timers.prr");
     static const std::string OPFLEX_HANDSHAKE("opflex.timers.handshake-timeout");
+    static const std::string OPFLEX_CONNECTION_LOOPS("opflex.connection-loops");
+    static const std::string OPFLEX_NOTIF_THREADS("opflex.notification-threads");
+    static const std::string OPFLEX_SNAPSHOT_PATH("opflex.snapshot.path");
+    static const std::string OPFLEX_SNAPSHOT_INTERVAL("opflex.snapshot.interval");
+    static const std::string OPFLEX_SNAPSHOT_HOLD("opflex.snapshot.hold-time");
     static const std::string DISABLED_FEATURES("feature.disabled");
     static const std::string BEHAVIOR_L34FLOWS_WITHOUT_SUBNET("behavior.l34flows-without-subnet");
 
@@ -213,6 +220,30 @@ void Agent::setProperties(const boost::property_tree::ptree& properties) {
         logParams = std::make_tuple(level_str, toSyslog, log_file);
     }
 
+    optional<bool> logAsync = properties.get_optional<bool>(LOG_ASYNC);
+    optional<std::string> logFormat =
+        properties.get_optional<std::string>(LOG_FORMAT);
+    if (logAsync || logFormat) {
+        bool curAsync, curJson;
+        getLogOutputOptions(curAsync, curJson);
+        bool async = logAsync ? logAsync.get() : curAsync;
+        bool json = curJson;
+        if (logFormat) {
+            json = logFormat.get() == "json";
+            if (!json && logFormat.get() != "text") {
+                LOG(ERROR) << "Invalid log format " << logFormat.get()
+                           << "; using text";
+            }
+        }
+        if (async != curAsync || json != curJson) {
+            std::string level_str,log_file;
+            bool toSyslog;
+            std::tie(level_str, toSyslog, log_file) = logParams;
+            setLogOutputOptions(async, json);
+            initLogging(level_str, toSyslog, log_file);
+        }
+    }
+
     boost::optional<std::string> ofName =
         properties.get_optional<std::string>(OPFLEX_NAME);
     if (ofName) opflexName = ofName;
@@ -483,6 +514,31 @@ void Agent::setProperties(const boost::property_tree::ptree& properties) {
         LOG(INFO) << "peer handshake timeout set to " << peerHandshakeTimeout << " ms";
     }
 
+    boost::optional<size_t> connLoopsOpt =
+        properties.get_optional<size_t>(OPFLEX_CONNECTION_LOOPS);
+    if (connLoopsOpt) {
+        connectionLoops = connLoopsOpt.get() > 0 ? connLoopsOpt.get() : 1;
+        LOG(INFO) << "opflex connection loops set to " << connectionLoops;
+    }
+
+    boost::optional<size_t> notifThreadsOpt =
+        properties.get_optional<size_t>(OPFLEX_NOTIF_THREADS);
+    if (notifThreadsOpt) {
+        notifThreads = notifThreadsOpt.get() > 0 ? notifThreadsOpt.get() : 1;
+        LOG(INFO) << "opflex notification threads set to " << notifThreads;
+    }
+
+    boost::optional<std::string> snapshotPathOpt =
+        properties.get_optional<std::string>(OPFLEX_SNAPSHOT_PATH);
+    if (snapshotPathOpt) {
+        snapshotPath = snapshotPathOpt.get();
+        LOG(INFO) << "policy snapshot path set to " << snapshotPath;
+    }
+    snapshotInterval =
+        properties.get<uint64_t>(OPFLEX_SNAPSHOT_INTERVAL, snapshotInterval);
+    snapshotHoldTime =
+        properties.get<uint64_t>(OPFLEX_SNAPSHOT_HOLD, snapshotHoldTime);
+
     LOG(INFO) << "Agent mode set to " <<
        ((this->rendererFwdMode == opflex::ofcore::OFConstants::TRANSPORT_MODE)?
         "transport-mode" : "stitched-mode");
@@ -548,6 +604,11 @@ void Agent::applyProperties() {
      
     framework.setPrrTimerDuration(prr_timer);
     framework.setHandshakeTimeout(peerHandshakeTimeout);
+    framework.setConnectionLoops(connectionLoops);
+    framework.setNotifThreads(notifThreads);
+    if (!snapshotPath.empty())
+        framework.setSnapshot(snapshotPath, snapshotInterval,
+                              snapshotHoldTime);
 }
 
 void Agent::start() {
@@ -602,6 +663,9 @@ void Agent::start() {
         r.second->start();
     }
 
+    // program the last known policy while the peers are connecting
+    framework.loadSnapshot();
+
     io_work.reset(new io_service::work(agent_io));
     io_service_thread.reset(new thread([this]() { agent_io.run(); }));
 
@@ -675,6 +739,8 @@ void Agent::start() {
         framework.overrideObservableReporting(modelgbp::gbpe::TableDropCounter::CLASS_ID, false);
         framework.overrideObservableReporting(modelgbp::gbpe::SvcCounter::CLASS_ID, false);
         framework.overrideObservableReporting(modelgbp::gbpe::SvcTargetCounter::CLASS_ID, false);
+        // report faults ahead of counter updates
+        framework.setObservablePriority(modelgbp::fault::Instance::CLASS_ID, 1);
     }
 }
 
@@ -740,6 +806,7 @@ void Agent::stop() {
 	    LOG(DEBUG) << "IO service thread stopped";
     }
 
+    framework.writeSnapshot();
     framework.stop();
     endpointSources.clear();
     rdConfigSources.clear();
@@ -218,13 +218,10 @@ static void updateEpMap(const optional<std::string>& oldVal,
                         const std::string& uuid) {
     if (oldVal != val) {
         if (oldVal) {
-            unordered_set<string>& eps = val_map[oldVal.get()];
-            eps.erase(uuid);
-            if (eps.empty())
-                val_map.erase(oldVal.get());
+            val_map.erase(oldVal.get(), uuid);
         }
         if (val) {
-            val_map[val.get()].insert(uuid);
+            val_map.insert(val.get(), uuid);
         }
     }
 }
@@ -289,16 +286,12 @@ void EndpointManager::updateEndpoint(const Endpoint& endpoint) {
     for (const Endpoint::IPAddressMapping& ipm :
              es.endpoint->getIPAddressMappings()) {
         if (!ipm.getNextHopIf()) continue;
-        unordered_set<string>& eps =
-            ipm_nexthop_if_ep_map[ipm.getNextHopIf().get()];
-        eps.erase(uuid);
-        if (eps.empty())
-            ipm_nexthop_if_ep_map.erase(ipm.getNextHopIf().get());
+        ipm_nexthop_if_ep_map.erase(ipm.getNextHopIf().get(), uuid);
     }
     for (const Endpoint::IPAddressMapping& ipm :
              endpoint.getIPAddressMappings()) {
         if (!ipm.getNextHopIf()) continue;
-        ipm_nexthop_if_ep_map[ipm.getNextHopIf().get()].insert(uuid);
+        ipm_nexthop_if_ep_map.insert(ipm.getNextHopIf().get(), uuid);
     }
 
     // update epg mapping alias to endpoint mapping
@@ -387,16 +380,11 @@ void EndpointManager::removeEndpoint(const std::string& uuid) {
         }
         EpCounter::remove(framework, uuid);
         if (es.egURI) {
-            group_ep_map_t::iterator it = group_ep_map.find(es.egURI.get());
-            if (it != group_ep_map.end()) {
-                it->second.erase(uuid);
-                if (it->second.empty()) {
-                    group_ep_map.erase(it);
-                    if(es.endpoint->isExternal()){
-                        notifyExtDomSets.insert(es.egURI.get());
-                        local_ext_dom_map.erase(es.egURI.get());
-                    }
-                }
+            group_ep_map.erase(es.egURI.get(), uuid);
+            if (!group_ep_map.find(es.egURI.get()) &&
+                es.endpoint->isExternal()) {
+                notifyExtDomSets.insert(es.egURI.get());
+                local_ext_dom_map.erase(es.egURI.get());
             }
         }
 
@@ -414,13 +402,7 @@ void EndpointManager::removeEndpoint(const std::string& uuid) {
         }
 
         for (const URI& ipmGrp : es.ipMappingGroups) {
-            group_ep_map_t::iterator it = ipm_group_ep_map.find(ipmGrp);
-            if (it != ipm_group_ep_map.end()) {
-                it->second.erase(uuid);
-                if (it->second.empty()) {
-                    ipm_group_ep_map.erase(it);
-                }
-            }
+            ipm_group_ep_map.erase(ipmGrp, uuid);
         }
 
         updateEpMap(es.endpoint->getInterfaceName(), boost::none,
@@ -433,11 +415,7 @@ void EndpointManager::removeEndpoint(const std::string& uuid) {
         for (const Endpoint::IPAddressMapping& ipm :
                  es.endpoint->getIPAddressMappings()) {
             if (!ipm.getNextHopIf()) continue;
-            unordered_set<string>& eps =
-                ipm_nexthop_if_ep_map[ipm.getNextHopIf().get()];
-            eps.erase(uuid);
-            if (eps.empty())
-                ipm_nexthop_if_ep_map.erase(ipm.getNextHopIf().get());
+            ipm_nexthop_if_ep_map.erase(ipm.getNextHopIf().get(), uuid);
         }
 
         updateEpMap(es.endpoint->getEgMappingAlias(), boost::none,
@@ -567,14 +545,10 @@ void EndpointManager::updateEndpointRemote(const opflex::modb::URI& uri) {
 
         if (oldEgUri != egUri) {
             if (oldEgUri) {
-                unordered_set<string>& eps =
-                    group_remote_ep_map[oldEgUri.get()];
-                eps.erase(uuid.get());
-                if (eps.empty())
-                    group_remote_ep_map.erase(oldEgUri.get());
+                group_remote_ep_map.erase(oldEgUri.get(), uuid.get());
             }
             if (egUri) {
-                group_remote_ep_map[egUri.get()].insert(uuid.get());
+                group_remote_ep_map.insert(egUri.get(), uuid.get());
                 remote_ep_group_map.emplace(uuid.get(), egUri.get());
             } else {
                 remote_ep_group_map.erase(uuid.get());
@@ -627,13 +601,10 @@ void EndpointManager::updateEndpointExternal(const Endpoint& endpoint) {
    // update endpoint group to endpoint mapping
     if(oldEgURI != egURI) {
         if (oldEgURI) {
-            unordered_set<string>& eps = group_ep_map[oldEgURI.get()];
-            eps.erase(uuid);
-            if (eps.empty())
-                group_ep_map.erase(oldEgURI.get());
+            group_ep_map.erase(oldEgURI.get(), uuid);
         }
         if (egURI) {
-            group_ep_map[egURI.get()].insert(uuid);
+            group_ep_map.insert(egURI.get(), uuid);
         }
         es.egURI = egURI;
     }
@@ -762,13 +733,7 @@ void EndpointManager::removeEndpointExternal(const std::string& uuid) {
             }
         }
         if (es.egURI) {
-            group_ep_map_t::iterator it = group_ep_map.find(es.egURI.get());
-            if (it != group_ep_map.end()) {
-                it->second.erase(uuid);
-                if (it->second.empty()) {
-                    group_ep_map.erase(it);
-                }
-            }
+            group_ep_map.erase(es.egURI.get(), uuid);
         }
         {
             const set<URI>& secGroups = es.endpoint->getSecurityGroups();
@@ -823,10 +788,8 @@ bool EndpointManager::updateEndpointLocal(const std::string& uuid,
 
     if (oldEgURI != egURI) {
         if (oldEgURI) {
-            unordered_set<string>& eps = group_ep_map[oldEgURI.get()];
-            eps.erase(uuid);
-            if (eps.empty()) {
-                group_ep_map.erase(oldEgURI.get());
+            group_ep_map.erase(oldEgURI.get(), uuid);
+            if (!group_ep_map.find(oldEgURI.get())) {
                 auto it = local_ext_dom_map.find(oldEgURI.get());
                 if(it != local_ext_dom_map.end()) {
                     local_ext_dom_map.erase(it);
@@ -837,7 +800,7 @@ bool EndpointManager::updateEndpointLocal(const std::string& uuid,
             }
         }
         if (egURI) {
-            group_ep_map[egURI.get()].insert(uuid);
+            group_ep_map.insert(egURI.get(), uuid);
         }
         if(es.endpoint->isExternal()) {
             auto it = local_ext_dom_map.find(egURI.get());
@@ -1009,14 +972,11 @@ bool EndpointManager::updateEndpointLocal(const std::string& uuid,
 
     // Update IP address mapping group map
     for (const URI& ipmGrp : newipmgroups) {
-        ipm_group_ep_map[ipmGrp].insert(uuid);
+        ipm_group_ep_map.insert(ipmGrp, uuid);
     }
     for (const URI& ipmGrp : es.ipMappingGroups) {
         if (newipmgroups.find(ipmGrp) == newipmgroups.end()) {
-            unordered_set<string>& eps = ipm_group_ep_map[ipmGrp];
-            eps.erase(uuid);
-            if (eps.empty())
-                ipm_group_ep_map.erase(ipmGrp);
+            ipm_group_ep_map.erase(ipmGrp, uuid);
         }
     }
     es.ipMappingGroups = newipmgroups;
@@ -1266,24 +1226,22 @@ void EndpointManager::egDomainUpdated(const URI& egURI) {
     unordered_set<string> remoteNotify;
     unique_lock<mutex> guard(ep_mutex);
 
-    group_ep_map_t::const_iterator it = group_ep_map.find(egURI);
-    if (it != group_ep_map.end()) {
-        for (const std::string& uuid : it->second) {
+    ep_set_view_t eps = group_ep_map.find(egURI);
+    if (eps) {
+        for (const std::string& uuid : *eps) {
             if (updateEndpointReg(uuid))
                 notify.insert(uuid);
         }
     }
 
-    group_ep_map_t::const_iterator rit = group_remote_ep_map.find(egURI);
-    if (rit != group_remote_ep_map.end()) {
-        for (const std::string& uuid : rit->second) {
-            remoteNotify.insert(uuid);
-        }
+    ep_set_view_t remoteEps = group_remote_ep_map.find(egURI);
+    if (remoteEps) {
+        remoteNotify = *remoteEps;
     }
 
-    it = ipm_group_ep_map.find(egURI);
-    if (it != ipm_group_ep_map.end()) {
-        for (const std::string& uuid : it->second) {
+    eps = ipm_group_ep_map.find(egURI);
+    if (eps) {
+        for (const std::string& uuid : *eps) {
             if (updateEndpointReg(uuid))
                 notify.insert(uuid);
         }
@@ -1301,17 +1259,17 @@ void EndpointManager::egDomainUpdated(const URI& egURI) {
 void EndpointManager::externalInterfaceUpdated(const URI& extIntURI) {
     using namespace modelgbp::gbp;
     unique_lock<mutex> guard(ep_mutex);
-    group_ep_map_t::const_iterator gep_it = group_ep_map.find(extIntURI);
+    ep_set_view_t eps = group_ep_map.find(extIntURI);
     optional<shared_ptr<RoutingDomain>> rd;
     unordered_set<string> notify;
     rd = policyManager.getRDForExternalInterface(extIntURI);
     if(!rd)
         return;
     ipmac_map_t &ip_mac_map = adj_ep_map[rd.get()->getURI()];
-    if (gep_it == group_ep_map.end()) {
+    if (!eps) {
         return;
     }
-    for (const std::string& uuid : gep_it->second) {
+    for (const std::string& uuid : *eps) {
         auto eep_it = ext_ep_map.find(uuid);
         if (eep_it != ext_ep_map.end()) {
             notify.insert(uuid);
@@ -1345,16 +1303,9 @@ bool EndpointManager::getAdjacency(const URI& rdURI,
 template <typename K, typename M>
 static void getEps(const K& key, const M& map,
                    /* out */ unordered_set<string>& eps) {
-    auto it = map.find(key);
-    if (it != map.end()) {
-        eps.insert(it->second.begin(), it->second.end());
-    }
-}
-
-template <typename M>
-static void getEps(const M& map, /* out */ unordered_set<string>& eps) {
-    for (const auto& elem : map) {
-        eps.insert(elem.second.begin(), elem.second.end());
+    ep_set_view_t view = map.find(key);
+    if (view) {
+        eps.insert(view->begin(), view->end());
     }
 }
 
@@ -1364,6 +1315,11 @@ void EndpointManager::getEndpointsForGroup(const URI& egURI,
     getEps(egURI, group_ep_map, eps);
 }
 
+ep_set_view_t EndpointManager::getEndpointsForGroup(const URI& egURI) {
+    unique_lock<mutex> guard(ep_mutex);
+    return group_ep_map.find(egURI);
+}
+
 bool EndpointManager::secGrpSetEmpty(const uri_set_t& secGrps) {
     unique_lock<mutex> guard(ep_mutex);
     return secgrp_ep_map.find(secGrps) == secgrp_ep_map.end();
@@ -1385,12 +1341,23 @@ void EndpointManager::getEndpointsForIPMGroup(const URI& egURI,
     getEps(egURI, ipm_group_ep_map, eps);
 }
 
+ep_set_view_t EndpointManager::getEndpointsForIPMGroup(const URI& egURI) {
+    unique_lock<mutex> guard(ep_mutex);
+    return ipm_group_ep_map.find(egURI);
+}
+
 void EndpointManager::getEndpointsByIface(const std::string& ifaceName,
                                           /* out */ str_uset_t& eps) {
     unique_lock<mutex> guard(ep_mutex);
     getEps(ifaceName, iface_ep_map, eps);
 }
 
+ep_set_view_t
+EndpointManager::getEndpointsByIface(const std::string& ifaceName) {
+    unique_lock<mutex> guard(ep_mutex);
+    return iface_ep_map.find(ifaceName);
+}
+
 const ip_ep_map_t& EndpointManager::getIPLocalEpMap (void) {
     unique_lock<mutex> guard(ep_mutex);
     return ip_local_ep_map;
@@ -1398,7 +1365,7 @@ const ip_ep_map_t& EndpointManager::getIPLocalEpMap (void) {
 
 void EndpointManager::getEndpointUUIDs( /* out */ str_uset_t& eps) {
     unique_lock<mutex> guard(ep_mutex);
-    getEps(iface_ep_map, eps);
+    iface_ep_map.getAll(eps);
 }
 
 void EndpointManager::getEndpointsByAccessIface(const std::string& ifaceName,
@@ -1407,6 +1374,12 @@ void EndpointManager::getEndpointsByAccessIface(const std::string& ifaceName,
     getEps(ifaceName, access_iface_ep_map, eps);
 }
 
+ep_set_view_t
+EndpointManager::getEndpointsByAccessIface(const std::string& ifaceName) {
+    unique_lock<mutex> guard(ep_mutex);
+    return access_iface_ep_map.find(ifaceName);
+}
+
 void EndpointManager::getEndpointsByAccessUplink(const std::string& ifaceName,
                                                  /* out */ str_uset_t& eps) {
     unique_lock<mutex> guard(ep_mutex);
@@ -1532,12 +1505,11 @@ void EndpointManager::EPGMappingListener::objectUpdated(class_id_t classId,
         optional<const std::string&> name = epgMapping.get()->getName();
         if (!name) return;
 
-        string_ep_map_t::iterator it =
-            epmanager.epgmapping_ep_map.find(name.get());
-        if (it == epmanager.epgmapping_ep_map.end()) return;
+        ep_set_view_t eps = epmanager.epgmapping_ep_map.find(name.get());
+        if (!eps) return;
 
         unordered_set<string> notify;
-        for (const std::string& uuid : it->second) {
+        for (const std::string& uuid : *eps) {
             if (epmanager.updateEndpointLocal(uuid)) {
                 notify.insert(uuid);
             }
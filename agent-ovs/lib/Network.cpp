@@ -214,5 +214,41 @@ bool prefix_match(const boost::asio::ip::address& addr,
     return false;
 }
 
+uint8_t to_prefix_key(const boost::asio::ip::address& addr,
+                      uint32_t prefixLen,
+                      /* out */ prefix_key_t& key) {
+    key.fill(0);
+    if (addr.is_v4()) {
+        if (prefixLen > 32) prefixLen = 32;
+        boost::asio::ip::address_v4::bytes_type b = addr.to_v4().to_bytes();
+        std::copy(b.begin(), b.end(), key.begin());
+    } else {
+        if (prefixLen > 128) prefixLen = 128;
+        boost::asio::ip::address_v6::bytes_type b = addr.to_v6().to_bytes();
+        std::copy(b.begin(), b.end(), key.begin());
+    }
+    for (size_t i = prefixLen; i < key.size() * 8; ++i)
+        key[i / 8] &= ~(1 << (7 - i % 8));
+    return (uint8_t)prefixLen;
+}
+
+uint8_t prefix_key_common(const prefix_key_t& a, const prefix_key_t& b,
+                          uint8_t maxLen) {
+    uint8_t len = 0;
+    for (size_t i = 0; i < a.size() && len < maxLen; ++i) {
+        uint8_t diff = a[i] ^ b[i];
+        if (diff == 0) {
+            len += 8;
+            continue;
+        }
+        while (!(diff & 0x80)) {
+            diff <<= 1;
+            len += 1;
+        }
+        break;
+    }
+    return std::min(len, maxLen);
+}
+
 } /* namespace packets */
 } /* namespace opflexagent */
@@ -47,7 +47,7 @@ using boost::asio::ip::address;
 PolicyManager::PolicyManager(OFFramework& framework_,
                              boost::asio::io_service& agent_io_)
     : framework(framework_), opflexDomain("default"), taskQueue(agent_io_),
-      domainListener(*this), contractListener(*this),
+      ruleSetVersion(0), domainListener(*this), contractListener(*this),
       secGroupListener(*this), configListener(*this), routeListener(*this) {
 
 }
@@ -335,6 +335,66 @@ PolicyManager::findSubnetForEp(const opflex::modb::URI& eg,
     return boost::none;
 }
 
+// Get the URIs of the objects holding a relation of the given type
+// to the target
+template <class Rel>
+static void getRelSources(OFFramework& framework, const URI& target,
+                          /* out */ vector<URI>& sources) {
+    vector<shared_ptr<Rel> > rels;
+    Rel::resolveByTarget(framework, target, rels);
+    for (const shared_ptr<Rel>& rel : rels) {
+        optional<URI> source = rel->getParentURI();
+        if (source)
+            sources.push_back(source.get());
+    }
+}
+
+bool PolicyManager::getDomainGroups(class_id_t class_id, const URI& uri,
+                                    /* out */ uri_set_t& groups) {
+    using namespace modelgbp::gbp;
+    using namespace modelgbp::gbpe;
+
+    vector<URI> domains;
+    vector<URI> egs;
+    switch (class_id) {
+    case EpGroup::CLASS_ID:
+        groups.insert(uri);
+        return true;
+    case L3ExternalNetwork::CLASS_ID:
+    case ExternalInterface::CLASS_ID:
+    case ExternalL3BridgeDomain::CLASS_ID:
+        return true;
+    case Subnet::CLASS_ID:
+        // Updates are also delivered for the parent Subnets, but a
+        // removed subnet can no longer be traced to its parent
+        return (bool)Subnet::resolve(framework, uri);
+    case FloodContext::CLASS_ID:
+        return (bool)FloodContext::resolve(framework, uri);
+    case Subnets::CLASS_ID:
+        getRelSources<EpGroupToSubnetsRSrc>(framework, uri, egs);
+        getRelSources<ForwardingBehavioralGroupToSubnetsRSrc>(framework,
+                                                              uri, domains);
+        break;
+    default:
+        domains.push_back(uri);
+        break;
+    }
+
+    // walk down the chain of forwarding domains to the groups in it
+    uri_set_t visited;
+    while (!domains.empty()) {
+        URI du = domains.back();
+        domains.pop_back();
+        if (!visited.insert(du).second) continue;
+
+        getRelSources<EpGroupToNetworkRSrc>(framework, du, egs);
+        getRelSources<BridgeDomainToNetworkRSrc>(framework, du, domains);
+        getRelSources<FloodDomainToNetworkRSrc>(framework, du, domains);
+    }
+    groups.insert(egs.begin(), egs.end());
+    return true;
+}
+
 bool PolicyManager::updateEPGDomains(const URI& egURI, bool& toRemove) {
     using namespace modelgbp;
     using namespace modelgbp::gbp;
@@ -630,6 +690,8 @@ bool PolicyManager::removeContractIfRequired(const URI& contractURI) {
         itr->second.intraGroups.empty()) {
         LOG(DEBUG) << "Removing index for contract " << contractURI;
         contractMap.erase(itr);
+        contractDeps.erase(contractURI);
+        publishRules(contractRules, contractURI, rule_snapshot_t());
         return true;
     }
     return false;
@@ -1037,17 +1099,22 @@ void resolveChildren(shared_ptr<modelgbp::gbp::SecGroup>& secgroup,
 template <typename Rule>
 void resolveRemoteSubnets(OFFramework& framework,
                           shared_ptr<Rule>& parent,
-                          /* out */ network::subnets_t &remoteSubnets) {}
+                          /* out */ network::subnets_t &remoteSubnets,
+                          /* out */ PolicyManager::uri_set_t& deps) {}
 
 template <>
 void resolveRemoteSubnets(OFFramework& framework,
                           shared_ptr<modelgbp::gbp::SecGroupRule>& rule,
-                          /* out */ network::subnets_t &remoteSubnets) {
+                          /* out */ network::subnets_t &remoteSubnets,
+                          /* out */ PolicyManager::uri_set_t& deps) {
     typedef modelgbp::gbp::SecGroupRuleToRemoteAddressRSrc RASrc;
     vector<shared_ptr<RASrc> > raSrcs;
     rule->resolveGbpSecGroupRuleToRemoteAddressRSrc(raSrcs);
     for (const shared_ptr<RASrc>& ra : raSrcs) {
+        deps.insert(ra->getURI());
         optional<URI> subnets_uri = ra->getTargetURI();
+        if (subnets_uri)
+            deps.insert(subnets_uri.get());
         PolicyManager::resolveSubnets(framework, subnets_uri, remoteSubnets);
     }
 }
@@ -1055,9 +1122,11 @@ void resolveRemoteSubnets(OFFramework& framework,
 template <typename Parent, typename Subject, typename Rule>
 static bool updatePolicyRules(OFFramework& framework,
                               const URI& parentURI, bool& notFound,
-                              PolicyManager::rule_list_t& oldRules,
+                              PolicyManager::rule_snapshot_t& rules,
+                              uint64_t& version,
                               PolicyManager::uri_set_t &oldRedirGrps,
-                              PolicyManager::uri_set_t &newRedirGrps)
+                              PolicyManager::uri_set_t &newRedirGrps,
+                              /* out */ PolicyManager::uri_set_t& deps)
 {
     using modelgbp::gbpe::L24Classifier;
     using modelgbp::gbp::RuleToClassifierRSrc;
@@ -1075,12 +1144,13 @@ static bool updatePolicyRules(OFFramework& framework,
     notFound = false;
 
     /* get all classifiers for this parent as an ordered-list */
-    PolicyManager::rule_list_t newRules;
+    PolicyRuleSet::rule_vec_t newRules;
     OrderComparator<shared_ptr<Rule> > ruleComp;
     OrderComparator<shared_ptr<L24Classifier> > classifierComp;
     vector<shared_ptr<Subject> > subjects;
     resolveChildren(parent.get(), subjects);
     for (shared_ptr<Subject>& sub : subjects) {
+        deps.insert(sub->getURI());
         vector<shared_ptr<Rule> > rules;
         resolveChildren(sub, rules);
         stable_sort(rules.begin(), rules.end(), ruleComp);
@@ -1088,21 +1158,25 @@ static bool updatePolicyRules(OFFramework& framework,
         uint16_t rulePrio = PolicyManager::MAX_POLICY_RULE_PRIORITY;
 
         for (shared_ptr<Rule>& rule : rules) {
+            deps.insert(rule->getURI());
             if (!rule->isDirectionSet()) {
                 continue;       // ignore rules with no direction
             }
             uint8_t dir = rule->getDirection().get();
             network::subnets_t remoteSubnets;
-            resolveRemoteSubnets(framework, rule, remoteSubnets);
+            resolveRemoteSubnets(framework, rule, remoteSubnets, deps);
             vector<shared_ptr<L24Classifier> > classifiers;
             vector<shared_ptr<RuleToClassifierRSrc> > clsRel;
             rule->resolveGbpRuleToClassifierRSrc(clsRel);
 
             for (shared_ptr<RuleToClassifierRSrc>& r : clsRel) {
+                deps.insert(r->getURI());
                 if (!r->isTargetSet() ||
                     r->getTargetClass().get() != L24Classifier::CLASS_ID) {
                     continue;
                 }
+                // depend on the target even if it is not resolved yet
+                deps.insert(r->getTargetURI().get());
                 optional<shared_ptr<L24Classifier> > cls =
                     L24Classifier::resolve(framework, r->getTargetURI().get());
                 if (cls) {
@@ -1119,9 +1193,11 @@ static bool updatePolicyRules(OFFramework& framework,
             optional<shared_ptr<RedirectDestGroup>> redirDstGrp;
             optional<URI> destGrpUri;
             for (shared_ptr<RuleToActionRSrc>& r : actRel) {
+                deps.insert(r->getURI());
                 if (!r->isTargetSet()) {
                     continue;
                 }
+                deps.insert(r->getTargetURI().get());
                 if(r->getTargetClass().get() == AllowDenyAction::CLASS_ID) {
                     optional<shared_ptr<AllowDenyAction> > act =
                         AllowDenyAction::resolve(framework, r->getTargetURI().get());
@@ -1146,6 +1222,7 @@ static bool updatePolicyRules(OFFramework& framework,
                     if(!destRef){
                         continue;
                     }
+                    deps.insert(destRef.get()->getURI());
                     destGrpUri = destRef.get()->getTargetURI();
                     if(!destGrpUri) {
                         continue;
@@ -1172,15 +1249,18 @@ static bool updatePolicyRules(OFFramework& framework,
                 rulePrio -= 128;
         }
     }
-    PolicyManager::rule_list_t::const_iterator oi = oldRules.begin();
+    static const PolicyRuleSet::rule_vec_t noRules;
+    const PolicyRuleSet::rule_vec_t& oldRules =
+        rules ? rules->getRules() : noRules;
+    PolicyRuleSet::rule_vec_t::const_iterator oi = oldRules.begin();
     while(oi != oldRules.end()) {
         if(oi->get()->getRedirectDestGrpURI()) {
             oldRedirGrps.insert(oi->get()->getRedirectDestGrpURI().get());
         }
         ++oi;
     }
-    PolicyManager::rule_list_t::const_iterator li = oldRules.begin();
-    PolicyManager::rule_list_t::const_iterator ri = newRules.begin();
+    PolicyRuleSet::rule_vec_t::const_iterator li = oldRules.begin();
+    PolicyRuleSet::rule_vec_t::const_iterator ri = newRules.begin();
     while (li != oldRules.end() && ri != newRules.end() &&
            li->get() == ri->get()) {
         ++li;
@@ -1188,32 +1268,83 @@ static bool updatePolicyRules(OFFramework& framework,
     }
     bool updated = (li != oldRules.end() || ri != newRules.end());
     if (updated) {
-        oldRules.swap(newRules);
-        for (shared_ptr<PolicyRule>& c : oldRules) {
+        for (shared_ptr<PolicyRule>& c : newRules) {
             LOG(DEBUG) << parentURI << ": " << *c;
         }
+        rules = std::make_shared<const PolicyRuleSet>(++version,
+                                                      std::move(newRules));
     }
     return updated;
 }
 
+void PolicyManager::publishRules(rule_snapshot_map_t& ruleMap,
+                                 const URI& uri,
+                                 const rule_snapshot_t& rules) {
+    lock_guard<mutex> guard(rule_mutex);
+    if (rules)
+        ruleMap[uri] = rules;
+    else
+        ruleMap.erase(uri);
+}
+
 bool PolicyManager::updateSecGrpRules(const URI& secGrpURI, bool& notFound) {
     using namespace modelgbp::gbp;
-    uri_set_t oldRedirGrps, newRedirGrps;
-    return updatePolicyRules<SecGroup, SecGroupSubject,
-                             SecGroupRule>(framework, secGrpURI,
-                                           notFound, secGrpMap[secGrpURI],
-                                           oldRedirGrps, newRedirGrps);
+    uri_set_t oldRedirGrps, newRedirGrps, deps;
+    rule_snapshot_t rules = getSecGroupRuleSnapshot(secGrpURI);
+    bool updated =
+        updatePolicyRules<SecGroup, SecGroupSubject,
+                          SecGroupRule>(framework, secGrpURI,
+                                        notFound, rules, ruleSetVersion,
+                                        oldRedirGrps, newRedirGrps, deps);
+
+    lock_guard<mutex> guard(state_mutex);
+    auto it = secGrps.find(secGrpURI);
+    if (it == secGrps.end())
+        return false;
+    if (notFound) {
+        secGrpDeps.erase(secGrpURI);
+        secGrps.erase(it);
+        publishRules(secGrpRules, secGrpURI, rule_snapshot_t());
+        return true;
+    }
+    secGrpDeps.set(secGrpURI, deps);
+    if (updated)
+        publishRules(secGrpRules, secGrpURI, rules);
+    return updated;
 }
 
 bool PolicyManager::updateContractRules(const URI& contrURI, bool& notFound) {
     using namespace modelgbp::gbp;
-    uri_set_t oldRedirGrps, newRedirGrps;
-    ContractState& cs = contractMap[contrURI];
+    uri_set_t oldRedirGrps, newRedirGrps, deps;
+    rule_snapshot_t rules = getContractRuleSnapshot(contrURI);
     bool updated = updatePolicyRules<Contract, Subject,
                                      Rule>(framework, contrURI,
-                                           notFound, cs.rules,
-                                           oldRedirGrps,
-                                           newRedirGrps);
+                                           notFound, rules,
+                                           ruleSetVersion, oldRedirGrps,
+                                           newRedirGrps, deps);
+
+    lock_guard<mutex> guard(state_mutex);
+    auto itr = contractMap.find(contrURI);
+    if (itr == contractMap.end())
+        return false;
+    /*
+     * notFound == true may happen if the contract was
+     * removed or there is a reference from a group to
+     * a contract that has not been received yet.
+     */
+    if (notFound) {
+        contractDeps.erase(contrURI);
+        // if contract has providers/consumers, only
+        // clear the rules
+        if (itr->second.providerGroups.empty() &&
+            itr->second.consumerGroups.empty() &&
+            itr->second.intraGroups.empty()) {
+            contractMap.erase(itr);
+        }
+        publishRules(contractRules, contrURI, rule_snapshot_t());
+        return true;
+    }
+    contractDeps.set(contrURI, deps);
     for (const URI& u : oldRedirGrps) {
         if(redirGrpMap.find(u) != redirGrpMap.end()) {
             redirGrpMap[u].ctrctSet.erase(contrURI);
@@ -1222,44 +1353,33 @@ bool PolicyManager::updateContractRules(const URI& contrURI, bool& notFound) {
     for (const URI& u : newRedirGrps) {
         redirGrpMap[u].ctrctSet.insert(contrURI);
     }
+    if (updated)
+        publishRules(contractRules, contrURI, rules);
     return updated;
 }
 
 void PolicyManager::updateContracts() {
-    unique_lock<mutex> guard(state_mutex);
+    /* recompute the rules only for the contracts affected by the
+       policy objects that changed.  Contracts marked dirty while
+       this runs are picked up by the next update. */
+    lock_guard<mutex> update_guard(rule_update_mutex);
     uri_set_t contractsToNotify;
+    uri_set_t dirty;
+    {
+        lock_guard<mutex> guard(state_mutex);
+        for (const URI& uri : dirtyContracts) {
+            if (contractMap.find(uri) != contractMap.end())
+                dirty.insert(uri);
+        }
+        dirtyContracts.clear();
+    }
 
-    /* recompute the rules for all contracts if a policy
-       object changed */
-    for (auto itr = contractMap.begin();
-         itr != contractMap.end();) {
-
+    for (const URI& uri : dirty) {
         bool notFound = false;
-        if (updateContractRules(itr->first, notFound)) {
-            contractsToNotify.insert(itr->first);
-        }
-        /*
-         * notFound == true may happen if the contract was
-         * removed or there is a reference from a group to
-         * a contract that has not been received yet.
-         */
-        if (notFound) {
-            contractsToNotify.insert(itr->first);
-            // if contract has providers/consumers, only
-            // clear the rules
-            if (itr->second.providerGroups.empty() &&
-                itr->second.consumerGroups.empty() &&
-                itr->second.intraGroups.empty()) {
-                itr = contractMap.erase(itr);
-            } else {
-                itr->second.rules.clear();
-                ++itr;
-            }
-        } else {
-            ++itr;
+        if (updateContractRules(uri, notFound)) {
+            contractsToNotify.insert(uri);
         }
     }
-    guard.unlock();
 
     for (const URI& u : contractsToNotify) {
         notifyContract(u);
@@ -1267,31 +1387,61 @@ void PolicyManager::updateContracts() {
 }
 
 void PolicyManager::updateSecGrps() {
-    /* recompute the rules for all security groups if a policy
-       object changed */
-    unique_lock<mutex> guard(state_mutex);
-
+    /* recompute the rules only for the security groups affected by
+       the policy objects that changed */
+    lock_guard<mutex> update_guard(rule_update_mutex);
     uri_set_t toNotify;
-    auto it = secGrpMap.begin();
-    while (it != secGrpMap.end()) {
-        bool notfound = false;
-        if (updateSecGrpRules(it->first, notfound)) {
-            toNotify.insert(it->first);
+    uri_set_t dirty;
+    {
+        lock_guard<mutex> guard(state_mutex);
+        for (const URI& uri : dirtySecGrps) {
+            if (secGrps.find(uri) != secGrps.end())
+                dirty.insert(uri);
         }
-        if (notfound) {
-            toNotify.insert(it->first);
-            it = secGrpMap.erase(it);
-        } else {
-            ++it;
+        dirtySecGrps.clear();
+    }
+
+    for (const URI& uri : dirty) {
+        bool notfound = false;
+        if (updateSecGrpRules(uri, notfound)) {
+            toNotify.insert(uri);
         }
     }
-    guard.unlock();
 
     for (const URI& u : toNotify) {
         notifySecGroup(u);
     }
 }
 
+void PolicyManager::RuleDeps::set(const URI& parent, uri_set_t& deps) {
+    uri_set_t& cur = depMap[parent];
+    for (const URI& u : cur) {
+        if (deps.find(u) != deps.end()) continue;
+        auto it = parentMap.find(u);
+        if (it == parentMap.end()) continue;
+        it->second.erase(parent);
+        if (it->second.empty())
+            parentMap.erase(it);
+    }
+    for (const URI& u : deps) {
+        parentMap[u].insert(parent);
+    }
+    cur.swap(deps);
+}
+
+void PolicyManager::RuleDeps::erase(const URI& parent) {
+    uri_set_t empty;
+    set(parent, empty);
+    depMap.erase(parent);
+}
+
+void PolicyManager::RuleDeps::getAffected(const URI& dep,
+                                          /* out */ uri_set_t& parents) const {
+    auto it = parentMap.find(dep);
+    if (it != parentMap.end())
+        parents.insert(it->second.begin(), it->second.end());
+}
+
 void PolicyManager::getContractProviders(const URI& contractURI,
                                          /* out */ uri_set_t& epgURIs) {
     lock_guard<mutex> guard(state_mutex);
@@ -1352,22 +1502,35 @@ void PolicyManager::getContractsForGroup(const URI& eg,
     }
 }
 
+PolicyManager::rule_snapshot_t
+PolicyManager::getContractRuleSnapshot(const URI& contractURI) {
+    lock_guard<mutex> guard(rule_mutex);
+    auto it = contractRules.find(contractURI);
+    return it != contractRules.end() ? it->second : rule_snapshot_t();
+}
+
 void PolicyManager::getContractRules(const URI& contractURI,
                                      /* out */ rule_list_t& rules) {
-    lock_guard<mutex> guard(state_mutex);
-    contract_map_t::const_iterator it = contractMap.find(contractURI);
-    if (it != contractMap.end()) {
-        rules.insert(rules.end(), it->second.rules.begin(),
-                     it->second.rules.end());
+    rule_snapshot_t snapshot = getContractRuleSnapshot(contractURI);
+    if (snapshot) {
+        rules.insert(rules.end(), snapshot->getRules().begin(),
+                     snapshot->getRules().end());
     }
 }
 
+PolicyManager::rule_snapshot_t
+PolicyManager::getSecGroupRuleSnapshot(const URI& secGroupURI) {
+    lock_guard<mutex> guard(rule_mutex);
+    auto it = secGrpRules.find(secGroupURI);
+    return it != secGrpRules.end() ? it->second : rule_snapshot_t();
+}
+
 void PolicyManager::getSecGroupRules(const URI& secGroupURI,
                                      /* out */ rule_list_t& rules) {
-    lock_guard<mutex> guard(state_mutex);
-    secgrp_map_t::const_iterator it = secGrpMap.find(secGroupURI);
-    if (it != secGrpMap.end()) {
-        rules.insert(rules.end(), it->second.begin(), it->second.end());
+    rule_snapshot_t snapshot = getSecGroupRuleSnapshot(secGroupURI);
+    if (snapshot) {
+        rules.insert(rules.end(), snapshot->getRules().begin(),
+                     snapshot->getRules().end());
     }
 }
 
@@ -1394,7 +1557,9 @@ void PolicyManager::updateRemoteRouteChildrenForPolicyPrefix(
         return;
     }
     RoutingDomainState &rs = rd_map[rdURI];
-    for(const auto& remoteRt : rs.remote_routes) {
+    vector<URI> coveredRoutes;
+    rs.remoteRouteTrie.getCovered(targetAddr, pfxLen, coveredRoutes);
+    for(const auto& remoteRt : coveredRoutes) {
         auto route_iter = remote_route_map.find(remoteRt);
         if(route_iter == remote_route_map.end()) {
             LOG(ERROR) << "No cached policy route for " << remoteRt;
@@ -1403,49 +1568,20 @@ void PolicyManager::updateRemoteRouteChildrenForPolicyPrefix(
         shared_ptr<PolicyRoute> &route = route_iter->second;
         const boost::asio::ip::address& addr = route->getAddress();
         uint32_t prefixLen = route->getPrefixLen();
-        if(addr.is_v4()  !=  targetAddr.is_v4()) {
-            continue;
-        }
-        bool is_exact_match = false;
-        if(network::prefix_match( targetAddr, pfxLen,
-                                 addr, prefixLen, is_exact_match)) {
-            optional<shared_ptr<LocalRoute>> localRoute
-                = boost::make_optional<shared_ptr<LocalRoute> >(false, nullptr);
-            optional<shared_ptr<LocalRouteToPrtRSrc>> lrtToPrt;
-            optional<shared_ptr<LocalRouteToPsrtRSrc>> lrtToPsrt;
-            localRoute = LocalRoute::resolve(framework,
-                                             rdURI.toString(),
-                                             addr.to_string(),
-                                             prefixLen);
-            lrtToPrt = localRoute.get()->resolveEpdrLocalRouteToPrtRSrc();
-            lrtToPsrt = localRoute.get()->resolveEpdrLocalRouteToPsrtRSrc();
-            if(lrtToPsrt && lrtToPrt) {
-                if(lrtToPsrt.get()->getTargetURI().get() == extSubURI) {
-                    Mutator mutator(framework, "policyelement");
-                    if(newNet && newExtSub) {
-                        localRoute.get()->
-                            addEpdrLocalRouteToPsrtRSrc()->
-                                setTargetExternalSubnet(
-                                    newExtSub.get()->getURI());
-                        localRoute.get()->
-                            addEpdrLocalRouteToPrtRSrc()->
-                                setTargetL3ExternalNetwork(
-                                    newNet.get()->getURI());
-                        LOG(DEBUG) << "Inheriting " <<
-                            newNet.get()->getURI() << " for "
-                            << rdURI << addr << "/" << prefixLen;
-                    } else {
-                        lrtToPrt.get()->remove();
-                        lrtToPsrt.get()->remove();
-                        LOG(DEBUG) << "Orphaning "
-                            << rdURI << addr << "/" << prefixLen;
-                    }
-                    mutator.commit();
-                    notifyLocalRoutes.insert(localRoute.get()->getURI());
-                }
-            } else {
+        optional<shared_ptr<LocalRoute>> localRoute
+            = boost::make_optional<shared_ptr<LocalRoute> >(false, nullptr);
+        optional<shared_ptr<LocalRouteToPrtRSrc>> lrtToPrt;
+        optional<shared_ptr<LocalRouteToPsrtRSrc>> lrtToPsrt;
+        localRoute = LocalRoute::resolve(framework,
+                                         rdURI.toString(),
+                                         addr.to_string(),
+                                         prefixLen);
+        lrtToPrt = localRoute.get()->resolveEpdrLocalRouteToPrtRSrc();
+        lrtToPsrt = localRoute.get()->resolveEpdrLocalRouteToPsrtRSrc();
+        if(lrtToPsrt && lrtToPrt) {
+            if(lrtToPsrt.get()->getTargetURI().get() == extSubURI) {
+                Mutator mutator(framework, "policyelement");
                 if(newNet && newExtSub) {
-                    Mutator mutator(framework, "policyelement");
                     localRoute.get()->
                         addEpdrLocalRouteToPsrtRSrc()->
                             setTargetExternalSubnet(
@@ -1457,9 +1593,31 @@ void PolicyManager::updateRemoteRouteChildrenForPolicyPrefix(
                     LOG(DEBUG) << "Inheriting " <<
                         newNet.get()->getURI() << " for "
                         << rdURI << addr << "/" << prefixLen;
-                    mutator.commit();
-                    notifyLocalRoutes.insert(localRoute.get()->getURI());
+                } else {
+                    lrtToPrt.get()->remove();
+                    lrtToPsrt.get()->remove();
+                    LOG(DEBUG) << "Orphaning "
+                        << rdURI << addr << "/" << prefixLen;
                 }
+                mutator.commit();
+                notifyLocalRoutes.insert(localRoute.get()->getURI());
+            }
+        } else {
+            if(newNet && newExtSub) {
+                Mutator mutator(framework, "policyelement");
+                localRoute.get()->
+                    addEpdrLocalRouteToPsrtRSrc()->
+                        setTargetExternalSubnet(
+                            newExtSub.get()->getURI());
+                localRoute.get()->
+                    addEpdrLocalRouteToPrtRSrc()->
+                        setTargetL3ExternalNetwork(
+                            newNet.get()->getURI());
+                LOG(DEBUG) << "Inheriting " <<
+                    newNet.get()->getURI() << " for "
+                    << rdURI << addr << "/" << prefixLen;
+                mutator.commit();
+                notifyLocalRoutes.insert(localRoute.get()->getURI());
             }
         }
     }
@@ -1590,6 +1748,10 @@ void PolicyManager::updateL3Nets(const opflex::modb::URI& rdURI,
                             notifyLocalRoutes);
                         notifyLocalRoutes.insert(localRoute.get()->getURI());
                         l3s.subnet_map[extsub->getURI()] = extsub;
+                        if (rds.extNets.find(net->getURI()) !=
+                            rds.extNets.end())
+                            indexPolicyPrefix(rds, net->getURI(), extsub,
+                                              true);
                     }
                 }
                 for (auto snet = l3s.subnet_map.begin();
@@ -1620,6 +1782,8 @@ void PolicyManager::updateL3Nets(const opflex::modb::URI& rdURI,
                             localRoute.get()->remove();
                             mutator.commit();
                         }
+                        indexPolicyPrefix(rds, net->getURI(), snet->second,
+                                          false);
                         snet = l3s.subnet_map.erase(snet);
                         getBestPolicyPrefix(
                             rd.get()->getURI(),
@@ -1647,6 +1811,7 @@ void PolicyManager::updateL3Nets(const opflex::modb::URI& rdURI,
 
         for (const URI& net : rds.extNets) {
             if (newNets.find(net) == newNets.end()) {
+                indexPolicyPrefixes(rds, net, false);
                 l3n_map_t::const_iterator lit = l3n_map.find(net);
                 if (lit != l3n_map.end()) {
                     if (lit->second.natEpg) {
@@ -1666,6 +1831,10 @@ void PolicyManager::updateL3Nets(const opflex::modb::URI& rdURI,
                                      net, contractsToNotify);
             }
         }
+        for (const URI& net : newNets) {
+            if (rds.extNets.find(net) == rds.extNets.end())
+                indexPolicyPrefixes(rds, net, true);
+        }
         rds.extNets = newNets;
     } else {
         for (const URI& net : rds.extNets) {
@@ -1733,33 +1902,14 @@ void PolicyManager::getBestRemoteRoute(
     boost::system::error_code ec;
     address targetAddr =
     address::from_string(pfx, ec);
-    if (ec || (rd_map.find(rdURI) == rd_map.end())) {
+    auto rdIter = rd_map.find(rdURI);
+    if (ec || (rdIter == rd_map.end())) {
         return;
     }
-    uint32_t bestLen=0;
-    RoutingDomainState &rs = rd_map[rdURI];
-    for(auto remoteRt : rs.remote_routes) {
-        auto route_iter = remote_route_map.find(remoteRt);
-        if(route_iter == remote_route_map.end()) {
-            LOG(ERROR) << "No cached policy route for " << remoteRt;
-            return;
-        }
-        shared_ptr<PolicyRoute> &route = route_iter->second;
-        const boost::asio::ip::address& addr = route->getAddress();
-        uint32_t prefixLen = route->getPrefixLen();
-        if(addr.is_v4()  !=  targetAddr.is_v4()) {
-            continue;
-        }
-        bool is_exact_match = false;
-        if(network::prefix_match(addr, prefixLen, targetAddr,
-                                 pfxLen, is_exact_match) &&
-           (prefixLen >= bestLen)) {
-            newRemoteRt = remoteRt;
-            bestLen = prefixLen;
-            if(is_exact_match) {
-                return;
-            }
-        }
+    vector<URI> routes;
+    if (rdIter->second.remoteRouteTrie.getBestMatch(targetAddr, pfxLen,
+                                                    routes) >= 0) {
+        newRemoteRt = routes.back();
     }
 }
 
@@ -1775,37 +1925,48 @@ void PolicyManager::getBestPolicyPrefix(
     boost::system::error_code ec;
     address targetAddr =
     address::from_string(pfx, ec);
-    if (ec || (rd_map.find(rdURI) == rd_map.end())) {
+    auto rdIter = rd_map.find(rdURI);
+    if (ec || (rdIter == rd_map.end())) {
         return;
     }
-    uint32_t bestLen = 0;
-    RoutingDomainState &rs = rd_map[rdURI];
-    for (const auto& extNet : rs.extNets) {
-        L3NetworkState &l3s = l3n_map[extNet];
-        for (auto &extSubItr: l3s.subnet_map) {
-            shared_ptr<modelgbp::gbp::ExternalSubnet> &extsub =
-            extSubItr.second;
-            if (!extsub->isAddressSet() || !extsub->isPrefixLenSet())
-                continue;
-            address addr =
-            address::from_string(extsub->getAddress().get(), ec);
-            if (ec) continue;
-            uint32_t prefixLen = extsub->getPrefixLen().get();
-            if(addr.is_v4()  !=  targetAddr.is_v4()) {
-                continue;
-            }
-            bool is_exact_match = false;
-            if(network::prefix_match(addr, prefixLen, targetAddr,
-                                     pfxLen, is_exact_match) &&
-               (prefixLen >= bestLen)) {
-                newNet = l3s.extNet;
-                newExtSub = extsub;
-                bestLen = prefixLen;
-                if(is_exact_match) {
-                    return;
-                }
-            }
-        }
+    vector<ext_subnet_ref_t> subs;
+    rdIter->second.policyPrefixTrie.getBestMatch(targetAddr, pfxLen, subs);
+    for (auto it = subs.rbegin(); it != subs.rend(); ++it) {
+        auto l3nIter = l3n_map.find(it->first);
+        if (l3nIter == l3n_map.end()) continue;
+        L3NetworkState &l3s = l3nIter->second;
+        auto subIter = l3s.subnet_map.find(it->second);
+        if (subIter == l3s.subnet_map.end()) continue;
+        newNet = l3s.extNet;
+        newExtSub = subIter->second;
+        return;
+    }
+}
+
+void PolicyManager::indexPolicyPrefix(RoutingDomainState& rs,
+                                      const URI& extNetURI,
+                                      const shared_ptr<modelgbp::gbp::
+                                      ExternalSubnet>& extSub,
+                                      bool add) {
+    if (!extSub->isAddressSet() || !extSub->isPrefixLenSet())
+        return;
+    boost::system::error_code ec;
+    address addr = address::from_string(extSub->getAddress().get(), ec);
+    if (ec) return;
+    ext_subnet_ref_t ref(extNetURI, extSub->getURI());
+    if (add)
+        rs.policyPrefixTrie.insert(addr, extSub->getPrefixLen().get(), ref);
+    else
+        rs.policyPrefixTrie.erase(addr, extSub->getPrefixLen().get(), ref);
+}
+
+void PolicyManager::indexPolicyPrefixes(RoutingDomainState& rs,
+                                        const URI& extNetURI,
+                                        bool add) {
+    auto l3nIter = l3n_map.find(extNetURI);
+    if (l3nIter == l3n_map.end()) return;
+    for (auto& extSubItr : l3nIter->second.subnet_map) {
+        indexPolicyPrefix(rs, extNetURI, extSubItr.second, add);
     }
 }
 
@@ -1936,12 +2097,25 @@ void PolicyManager::updateDomain(class_id_t class_id, const URI& uri) {
     if (class_id == modelgbp::gbp::ExternalInterface::CLASS_ID) {
         ext_int_map[uri];
     }
-    for (auto itr = group_map.begin(); itr != group_map.end(); ) {
-        bool toRemove = false;
-        if (updateEPGDomains(itr->first, toRemove)) {
-            notifyGroups.insert(itr->first);
+    uri_set_t affectedGroups;
+    if (getDomainGroups(class_id, uri, affectedGroups)) {
+        for (const URI& eg : affectedGroups) {
+            auto itr = group_map.find(eg);
+            if (itr == group_map.end()) continue;
+            bool toRemove = false;
+            if (updateEPGDomains(eg, toRemove)) {
+                notifyGroups.insert(eg);
+            }
+            if (toRemove) group_map.erase(itr);
+        }
+    } else {
+        for (auto itr = group_map.begin(); itr != group_map.end(); ) {
+            bool toRemove = false;
+            if (updateEPGDomains(itr->first, toRemove)) {
+                notifyGroups.insert(itr->first);
+            }
+            itr = (toRemove ? group_map.erase(itr) : ++itr);
         }
-        itr = (toRemove ? group_map.erase(itr) : ++itr);
     }
     // Determine routing-domains that may be affected by changes to NAT EPG
     for (const URI& u : notifyGroups) {
@@ -2349,76 +2523,74 @@ void PolicyManager::updatePolicyPrefixChildrenForRemoteRoute(
         return;
     }
     RoutingDomainState &rs = rd_map[rdURI];
-    for (const auto& extNet : rs.extNets) {
-        L3NetworkState &l3s = l3n_map[extNet];
-        for (auto &extSubItr: l3s.subnet_map) {
-            shared_ptr<modelgbp::gbp::ExternalSubnet> &extsub =
-                extSubItr.second;
-            if (!extsub->isAddressSet() || !extsub->isPrefixLenSet())
-                continue;
-            address addr =
-            address::from_string(extsub->getAddress().get(), ec);
-            if (ec) continue;
-            uint32_t prefixLen = extsub->getPrefixLen().get();
-            bool is_exact_match = false;
-            if(network::prefix_match(targetAddr, pfxLen, addr,
-                                     prefixLen, is_exact_match)) {
-                optional<shared_ptr<LocalRoute>> localRoute
-                    = boost::make_optional<shared_ptr<LocalRoute> >(false, nullptr);
-                optional<shared_ptr<LocalRouteToRrtRSrc>> lrtToRrt;
-                optional<shared_ptr<LocalRouteToPrtRSrc>> lrtToPrt;
+    vector<ext_subnet_ref_t> coveredSubs;
+    rs.policyPrefixTrie.getCovered(targetAddr, pfxLen, coveredSubs);
+    for (const auto& ref : coveredSubs) {
+        auto l3nIter = l3n_map.find(ref.first);
+        if (l3nIter == l3n_map.end()) continue;
+        L3NetworkState &l3s = l3nIter->second;
+        auto extSubItr = l3s.subnet_map.find(ref.second);
+        if (extSubItr == l3s.subnet_map.end()) continue;
+        shared_ptr<modelgbp::gbp::ExternalSubnet> &extsub =
+            extSubItr->second;
+        address addr =
+        address::from_string(extsub->getAddress().get(), ec);
+        if (ec) continue;
+        uint32_t prefixLen = extsub->getPrefixLen().get();
+        optional<shared_ptr<LocalRoute>> localRoute
+            = boost::make_optional<shared_ptr<LocalRoute> >(false, nullptr);
+        optional<shared_ptr<LocalRouteToRrtRSrc>> lrtToRrt;
+        optional<shared_ptr<LocalRouteToPrtRSrc>> lrtToPrt;
+        localRoute = LocalRoute::resolve(framework,
+                                         rdURI.toString(),
+                                         addr.to_string(),
+                                         prefixLen);
+        lrtToRrt = localRoute.get()->resolveEpdrLocalRouteToRrtRSrc();
+        lrtToPrt = localRoute.get()->resolveEpdrLocalRouteToPrtRSrc();
+        if(routeURI == parentRemoteRt) {
+            notifyLocalRoutes.insert(localRoute.get()->getURI());
+            continue;
+        }
+        if(lrtToRrt) {
+            if(lrtToRrt.get()->getTargetURI() == routeURI) {
+                Mutator mutator(framework, "policyelement");
+                if(parentRemoteRt) {
+                    localRoute.get()->
+                        addEpdrLocalRouteToRrtRSrc()
+                            ->setTargetRemoteRoute(
+                                parentRemoteRt.get());
+                    LOG(DEBUG) << "Inheriting " <<
+                        parentRemoteRt.get() << " for ppfx " <<
+                        rdURI << addr << "/" << prefixLen;
+                }
+                else {
+                    lrtToRrt.get()->remove();
+                    LOG(DEBUG) << "Orphaning " << " for ppfx "
+                        << rdURI << addr << "/" << prefixLen;
+                }
+                mutator.commit();
+                notifyLocalRoutes.insert(localRoute.get()->getURI());
+            }
+        } else {
+            if(parentRemoteRt) {
+                Mutator mutator(framework, "policyelement");
+                localRoute.get()->
+                    addEpdrLocalRouteToRrtRSrc()
+                        ->setTargetRemoteRoute(
+                            parentRemoteRt.get());
+                LOG(DEBUG) << "Inheriting " <<
+                     parentRemoteRt.get() << " for ppfx " <<
+                     rdURI << addr << "/" << prefixLen;
+                mutator.commit();
+                notifyLocalRoutes.insert(localRoute.get()->getURI());
                 localRoute = LocalRoute::resolve(framework,
                                                  rdURI.toString(),
                                                  addr.to_string(),
                                                  prefixLen);
-                lrtToRrt = localRoute.get()->resolveEpdrLocalRouteToRrtRSrc();
-                lrtToPrt = localRoute.get()->resolveEpdrLocalRouteToPrtRSrc();
-                if(routeURI == parentRemoteRt) {
-                    notifyLocalRoutes.insert(localRoute.get()->getURI());
-                    continue;
-                }
-                if(lrtToRrt) {
-                    if(lrtToRrt.get()->getTargetURI() == routeURI) {
-                        Mutator mutator(framework, "policyelement");
-                        if(parentRemoteRt) {
-                            localRoute.get()->
-                                addEpdrLocalRouteToRrtRSrc()
-                                    ->setTargetRemoteRoute(
-                                        parentRemoteRt.get());
-                            LOG(DEBUG) << "Inheriting " <<
-                                parentRemoteRt.get() << " for ppfx " <<
-                                rdURI << addr << "/" << prefixLen;
-                        }
-                        else {
-                            lrtToRrt.get()->remove();
-                            LOG(DEBUG) << "Orphaning " << " for ppfx "
-                                << rdURI << addr << "/" << prefixLen;
-                        }
-                        mutator.commit();
-                        notifyLocalRoutes.insert(localRoute.get()->getURI());
-                    }
-                } else {
-                    if(parentRemoteRt) {
-                        Mutator mutator(framework, "policyelement");
-                        localRoute.get()->
-                            addEpdrLocalRouteToRrtRSrc()
-                                ->setTargetRemoteRoute(
-                                    parentRemoteRt.get());
-                        LOG(DEBUG) << "Inheriting " <<
-                             parentRemoteRt.get() << " for ppfx " <<
-                             rdURI << addr << "/" << prefixLen;
-                        mutator.commit();
-                        notifyLocalRoutes.insert(localRoute.get()->getURI());
-                        localRoute = LocalRoute::resolve(framework,
-                                                         rdURI.toString(),
-                                                         addr.to_string(),
-                                                         prefixLen);
-                        lrtToPrt = localRoute.get()->
-                                       resolveEpdrLocalRouteToPrtRSrc();
-                        LOG(DEBUG) << "ExtNet URI:" <<
-                        lrtToPrt.get()->getTargetURI().get();
-                    }
-                }
+                lrtToPrt = localRoute.get()->
+                               resolveEpdrLocalRouteToPrtRSrc();
+                LOG(DEBUG) << "ExtNet URI:" <<
+                lrtToPrt.get()->getTargetURI().get();
             }
         }
     }
@@ -2443,6 +2615,7 @@ void PolicyManager::updateRemoteRoutes(const URI& uri,
             }
             //RoutingDomain deletion will happen in domain context
             rdIter->second.remote_routes.clear();
+            rdIter->second.remoteRouteTrie.clear();
         }
         return;
     }
@@ -2541,6 +2714,8 @@ void PolicyManager::updateRemoteRoutes(const URI& uri,
                 newRemoteRt,
                 notifyLocalRoutes);
             rs.remote_routes.insert(route->getURI());
+            rs.remoteRouteTrie.insert(addr, route->getPrefixLen().get(),
+                                      route->getURI());
             auto rIter = remote_route_map.insert(
                              std::make_pair(route->getURI(),newRoute));
             rIter.first->second->setPresent(true);
@@ -2555,6 +2730,16 @@ void PolicyManager::updateRemoteRoutes(const URI& uri,
         routeIter->second->setPresent(true);
         if(*(routeIter->second) != *newRoute) {
             //Updated remote route
+            if (routeIter->second->getAddress() != newRoute->getAddress() ||
+                routeIter->second->getPrefixLen() !=
+                newRoute->getPrefixLen()) {
+                rs.remoteRouteTrie.erase(routeIter->second->getAddress(),
+                                         routeIter->second->getPrefixLen(),
+                                         route->getURI());
+                rs.remoteRouteTrie.insert(newRoute->getAddress(),
+                                          newRoute->getPrefixLen(),
+                                          route->getURI());
+            }
             routeIter->second = newRoute;
             routeIter->second->setPresent(true);
             notifyRemoteRoutes.insert(route->getURI());
@@ -2586,6 +2771,8 @@ void PolicyManager::updateRemoteRoutes(const URI& uri,
             std::string delRemoteRt =
                 routeIter->second->getAddress().to_string();
             uint32_t prefixLen = routeIter->second->getPrefixLen();
+            rs.remoteRouteTrie.erase(routeIter->second->getAddress(),
+                                     prefixLen, *itr);
             remote_route_map.erase(routeIter);
             itr = rs.remote_routes.erase(itr);
             Mutator mutator(framework, "policyelement");
@@ -2698,6 +2885,9 @@ void PolicyManager::updateExternalNetworkPrefixes(
             Mutator mutator(framework, "policyelement");
             lrtToPrt.get()->remove();
             mutator.commit();
+            auto rdIter = rd_map.find(rd.get()->getURI());
+            if (rdIter != rd_map.end())
+                indexPolicyPrefix(rdIter->second, uri, snet->second, false);
             snet = l3s.subnet_map.erase(snet);
             if(isLocalRouteDeletable(localRoute.get())) {
                 localRoute.get()->remove();
@@ -2808,9 +2998,8 @@ void PolicyManager::ContractListener::objectUpdated(class_id_t classId,
     } else {
         {
             unique_lock<mutex> guard(pmanager.state_mutex);
-            if (classId == Contract::CLASS_ID) {
-                pmanager.contractMap[uri];
-            }
+            if (!markDirty(classId, uri))
+                return;
         }
 
         pmanager.taskQueue.dispatch("contract", [this]() {
@@ -2819,6 +3008,47 @@ void PolicyManager::ContractListener::objectUpdated(class_id_t classId,
     }
 }
 
+bool PolicyManager::ContractListener::markDirty(class_id_t classId,
+                                                const URI& uri) {
+    if (classId == modelgbp::gbp::Contract::CLASS_ID) {
+        pmanager.contractMap[uri];
+        pmanager.dirtyContracts.insert(uri);
+        return true;
+    }
+    size_t count = pmanager.dirtyContracts.size();
+    pmanager.contractDeps.getAffected(uri, pmanager.dirtyContracts);
+    return pmanager.dirtyContracts.size() != count;
+}
+
+void PolicyManager::ContractListener::objectsUpdated(class_id_t classId,
+                                                     const std::vector<URI>& uris) {
+    using namespace modelgbp::gbp;
+    if (classId == EpGroup::CLASS_ID ||
+        classId == L3ExternalNetwork::CLASS_ID ||
+        classId == RoutingDomain::CLASS_ID ||
+        classId == RedirectDestGroup::CLASS_ID ||
+        classId == RedirectDest::CLASS_ID) {
+        ObjectListener::objectsUpdated(classId, uris);
+        return;
+    }
+
+    LOG(DEBUG) << "ContractListener update for " << uris.size() << " URIs";
+    {
+        unique_lock<mutex> guard(pmanager.state_mutex);
+        bool dirty = false;
+        for (const URI& uri : uris) {
+            dirty |= markDirty(classId, uri);
+        }
+        if (!dirty)
+            return;
+    }
+
+    // one contract update covers the whole batch
+    pmanager.taskQueue.dispatch("contract", [this]() {
+            pmanager.updateContracts();
+        });
+}
+
 PolicyManager::SecGroupListener::SecGroupListener(PolicyManager& pmanager_)
     : pmanager(pmanager_) {}
 
@@ -2829,16 +3059,46 @@ void PolicyManager::SecGroupListener::objectUpdated(class_id_t classId,
     LOG(DEBUG) << "SecGroupListener update for URI " << uri;
     {
         unique_lock<mutex> guard(pmanager.state_mutex);
-        if (classId == modelgbp::gbp::SecGroup::CLASS_ID) {
-            pmanager.secGrpMap[uri];
+        if (!markDirty(classId, uri))
+            return;
+    }
+
+    pmanager.taskQueue.dispatch("secgroup", [this]() {
+            pmanager.updateSecGrps();
+        });
+}
+
+void PolicyManager::SecGroupListener::objectsUpdated(class_id_t classId,
+                                                     const std::vector<URI>& uris) {
+    LOG(DEBUG) << "SecGroupListener update for " << uris.size() << " URIs";
+    {
+        unique_lock<mutex> guard(pmanager.state_mutex);
+        bool dirty = false;
+        for (const URI& uri : uris) {
+            dirty |= markDirty(classId, uri);
         }
+        if (!dirty)
+            return;
     }
 
+    // one security group update covers the whole batch
     pmanager.taskQueue.dispatch("secgroup", [this]() {
             pmanager.updateSecGrps();
         });
 }
 
+bool PolicyManager::SecGroupListener::markDirty(class_id_t classId,
+                                                const URI& uri) {
+    if (classId == modelgbp::gbp::SecGroup::CLASS_ID) {
+        pmanager.secGrps.insert(uri);
+        pmanager.dirtySecGrps.insert(uri);
+        return true;
+    }
+    size_t count = pmanager.dirtySecGrps.size();
+    pmanager.secGrpDeps.getAffected(uri, pmanager.dirtySecGrps);
+    return pmanager.dirtySecGrps.size() != count;
+}
+
 PolicyManager::ConfigListener::ConfigListener(PolicyManager& pmanager_)
     : pmanager(pmanager_) {}
 
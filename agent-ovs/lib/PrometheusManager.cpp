@@ -135,7 +135,12 @@ static string ofpeer_family_names[] =
   "opflex_peer_state_report_req_count",
   "opflex_peer_state_report_resp_count",
   "opflex_peer_state_report_err_count",
-  "opflex_peer_unresolved_policy_count"
+  "opflex_peer_unresolved_policy_count",
+  "opflex_peer_loop_id",
+  "opflex_peer_loop_cpu_ms",
+  "opflex_peer_write_queue_depth",
+  "opflex_peer_tls_full_handshake_count",
+  "opflex_peer_tls_resumed_handshake_count"
 };
 
 static string ofpeer_family_help[] =
@@ -159,7 +164,12 @@ static string ofpeer_family_help[] =
   "number of state reports sent to opflex peer",
   "number of state reports responses received from opflex peer",
   "number of state reports error repsonses from opflex peer",
-  "number of policies requested by the agent which is not yet resolved by opflex peer"
+  "number of policies requested by the agent which is not yet resolved by opflex peer",
+  "index of the connection event loop serving opflex peer",
+  "cpu time in ms used by the connection event loop serving opflex peer",
+  "number of messages waiting to be written to opflex peer",
+  "number of full tls handshakes with opflex peer",
+  "number of resumed tls handshakes with opflex peer"
 };
 
 static string remote_ep_family_names[] =
@@ -184,6 +194,18 @@ static string rddrop_family_help[] =
   "number of policy/contract dropped packets per routing domain"
 };
 
+static string pktin_drop_family_names[] =
+{
+  "opflex_packet_in_rate_limited_drops",
+  "opflex_packet_in_queue_full_drops"
+};
+
+static string pktin_drop_family_help[] =
+{
+  "number of packet-ins dropped by admission control per packet-in type",
+  "number of packet-ins dropped due to a full worker queue per packet-in type"
+};
+
 static string sgclassifier_family_names[] =
 {
   "opflex_sg_tx_bytes",
@@ -393,6 +415,12 @@ void PrometheusManager::removeDynamicGauges ()
         removeDynamicGaugeRDDrop();
     }
 
+    // Remove PacketInDrop related gauges
+    {
+        const lock_guard<mutex> lock(pktin_drop_mutex);
+        removeDynamicGaugePktInDrop();
+    }
+
     // Remove SGClassifierCounter related gauges
     {
         const lock_guard<mutex> lock(sgclassifier_stats_mutex);
@@ -546,6 +574,21 @@ void PrometheusManager::createStaticGaugeFamiliesRDDrop (void)
     }
 }
 
+// create all PacketInDrop specific gauge families during start
+void PrometheusManager::createStaticGaugeFamiliesPktInDrop (void)
+{
+    for (PKTIN_DROP_METRICS metric=PKTIN_DROP_METRICS_MIN;
+            metric <= PKTIN_DROP_METRICS_MAX;
+                metric = PKTIN_DROP_METRICS(metric+1)) {
+        auto& gauge_pktin_drop_family = BuildGauge()
+                             .Name(pktin_drop_family_names[metric])
+                             .Help(pktin_drop_family_help[metric])
+                             .Labels({})
+                             .Register(*registry_ptr);
+        gauge_pktin_drop_family_ptr[metric] = &gauge_pktin_drop_family;
+    }
+}
+
 // create all EP specific gauge families during start
 void PrometheusManager::createStaticGaugeFamiliesEp (void)
 {
@@ -717,6 +760,11 @@ void PrometheusManager::createStaticGaugeFamilies (void)
         createStaticGaugeFamiliesRDDrop();
     }
 
+    {
+        const lock_guard<mutex> lock(pktin_drop_mutex);
+        createStaticGaugeFamiliesPktInDrop();
+    }
+
     {
         const lock_guard<mutex> lock(sgclassifier_stats_mutex);
         createStaticGaugeFamiliesSGClassifier();
@@ -947,6 +995,15 @@ void PrometheusManager::init ()
         }
     }
 
+    {
+        const lock_guard<mutex> lock(pktin_drop_mutex);
+        for (PKTIN_DROP_METRICS metric=PKTIN_DROP_METRICS_MIN;
+                metric <= PKTIN_DROP_METRICS_MAX;
+                    metric = PKTIN_DROP_METRICS(metric+1)) {
+            gauge_pktin_drop_family_ptr[metric] = nullptr;
+        }
+    }
+
     {
         const lock_guard<mutex> lock(table_drop_counter_mutex);
         for (TABLE_DROP_METRICS metric = TABLE_DROP_BYTES;
@@ -1355,6 +1412,28 @@ void PrometheusManager::createDynamicGaugeRDDrop (RDDROP_METRICS metric,
     rddrop_gauge_map[metric][rdURI] = &gauge;
 }
 
+// Create PacketInDrop gauge given metric type, packet-in type
+void PrometheusManager::createDynamicGaugePktInDrop (PKTIN_DROP_METRICS metric,
+                                                     const string& type)
+{
+    // Retrieve the Gauge if its already created
+    if (getDynamicGaugePktInDrop(metric, type))
+        return;
+
+    auto& gauge = gauge_pktin_drop_family_ptr[metric]->Add({{"type", type}});
+    if (gauge_check.is_dup(&gauge)) {
+        LOG(DEBUG) << "duplicate pktin drop dyn gauge family"
+                   << " metric: " << metric
+                   << " type: " << type;
+        return;
+    }
+    LOG(DEBUG) << "created pktin drop dyn gauge family"
+               << " metric: " << metric
+               << " type: " << type;
+    gauge_check.add(&gauge);
+    pktin_drop_gauge_map[metric][type] = &gauge;
+}
+
 // Create SvcTargetCounter gauge given metric type, svc-tgt uuid & ep attr_map
 void PrometheusManager::createDynamicGaugeSvcTarget (SVC_TARGET_METRICS metric,
                                                      const string& uuid,
@@ -1856,6 +1935,16 @@ Gauge * PrometheusManager::getDynamicGaugeRDDrop (RDDROP_METRICS metric,
     return pgauge;
 }
 
+// Get PacketInDrop gauge given the metric, packet-in type
+Gauge * PrometheusManager::getDynamicGaugePktInDrop (PKTIN_DROP_METRICS metric,
+                                                     const string& type)
+{
+    auto itr = pktin_drop_gauge_map[metric].find(type);
+    if (itr == pktin_drop_gauge_map[metric].end())
+        return nullptr;
+    return itr->second;
+}
+
 // Get SvcTargetCounter gauge given the metric, uuid of SvcTarget
 mgauge_pair_t PrometheusManager::getDynamicGaugeSvcTarget (SVC_TARGET_METRICS metric,
                                                            const string& uuid)
@@ -2086,6 +2175,22 @@ void PrometheusManager::removeDynamicGaugeRDDrop ()
     }
 }
 
+// Remove dynamic PacketInDrop gauges for all metrics
+void PrometheusManager::removeDynamicGaugePktInDrop ()
+{
+    for (PKTIN_DROP_METRICS metric=PKTIN_DROP_METRICS_MIN;
+            metric <= PKTIN_DROP_METRICS_MAX;
+                metric = PKTIN_DROP_METRICS(metric+1)) {
+        for (auto& elem : pktin_drop_gauge_map[metric]) {
+            LOG(DEBUG) << "Delete PacketInDrop type: " << elem.first
+                       << " Gauge: " << elem.second;
+            gauge_check.remove(elem.second);
+            gauge_pktin_drop_family_ptr[metric]->Remove(elem.second);
+        }
+        pktin_drop_gauge_map[metric].clear();
+    }
+}
+
 // Remove dynamic OFPeerStats gauge given a metic type and peer (IP,port) tuple
 // Note: The below api doesnt get called today. But keeping it in case we have
 // a requirement to delete a gauge metric per peer, in case a leaf goes down
@@ -2404,6 +2509,16 @@ void PrometheusManager::removeStaticGaugeFamiliesRDDrop ()
     }
 }
 
+// Remove all statically allocated PacketInDrop gauge families
+void PrometheusManager::removeStaticGaugeFamiliesPktInDrop ()
+{
+    for (PKTIN_DROP_METRICS metric=PKTIN_DROP_METRICS_MIN;
+            metric <= PKTIN_DROP_METRICS_MAX;
+                metric = PKTIN_DROP_METRICS(metric+1)) {
+        gauge_pktin_drop_family_ptr[metric] = nullptr;
+    }
+}
+
 // Remove all statically allocated podsvc gauge families
 void PrometheusManager::removeStaticGaugeFamiliesPodSvc()
 {
@@ -2501,6 +2616,12 @@ void PrometheusManager::removeStaticGaugeFamilies()
         removeStaticGaugeFamiliesRDDrop();
     }
 
+    // PacketInDrop specific
+    {
+        const lock_guard<mutex> lock(pktin_drop_mutex);
+        removeStaticGaugeFamiliesPktInDrop();
+    }
+
     // SGClassifierCounter specific
     {
         const lock_guard<mutex> lock(sgclassifier_stats_mutex);
@@ -2923,6 +3044,35 @@ void PrometheusManager::addNUpdateRDDropCounter (const string& rdURI,
     }
 }
 
+/* Function called from PacketInHandler to update PacketInDrop */
+void PrometheusManager::addNUpdatePacketInDrops (const string& type,
+                                                 uint64_t rateLimited,
+                                                 uint64_t queueFull)
+{
+    RETURN_IF_DISABLED
+
+    const lock_guard<mutex> lock(pktin_drop_mutex);
+
+    for (PKTIN_DROP_METRICS metric=PKTIN_DROP_METRICS_MIN;
+            metric <= PKTIN_DROP_METRICS_MAX;
+                metric = PKTIN_DROP_METRICS(metric+1)) {
+        createDynamicGaugePktInDrop(metric, type);
+        Gauge *pgauge = getDynamicGaugePktInDrop(metric, type);
+        if (!pgauge)
+            continue;
+        switch (metric) {
+        case PKTIN_DROP_RATE_LIMITED:
+            pgauge->Set(static_cast<double>(rateLimited));
+            break;
+        case PKTIN_DROP_QUEUE_FULL:
+            pgauge->Set(static_cast<double>(queueFull));
+            break;
+        default:
+            LOG(ERROR) << "Unhandled pktin drop metric: " << metric;
+        }
+    }
+}
+
 /* Function called from PolicyStatsManager to update OFPeerStats */
 void PrometheusManager::addNUpdateOFPeerStats (const std::string& peer,
                                                const OF_SHARED_PTR<OFStats> stats)
@@ -3006,6 +3156,21 @@ void PrometheusManager::addNUpdateOFPeerStats (const std::string& peer,
         case OFPEER_UNRESOLVED_POLS:
             metric_opt = stats->getPolUnresolvedCount();
             break;
+        case OFPEER_LOOP_ID:
+            metric_opt = stats->getLoopId();
+            break;
+        case OFPEER_LOOP_CPU_MS:
+            metric_opt = stats->getLoopCpuMs();
+            break;
+        case OFPEER_WRITE_QUEUE_DEPTH:
+            metric_opt = stats->getWriteQueueDepth();
+            break;
+        case OFPEER_TLS_FULL_HANDSHAKES:
+            metric_opt = stats->getTlsFullHandshakes();
+            break;
+        case OFPEER_TLS_RESUMED_HANDSHAKES:
+            metric_opt = stats->getTlsResumedHandshakes();
+            break;
         default:
             LOG(ERROR) << "Unhandled ofpeer metric: " << metric;
         }
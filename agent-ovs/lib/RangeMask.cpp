@@ -10,7 +10,7 @@
 #include <algorithm>
 #include <iomanip>
 
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 #include <opflexagent/logging.h>
 
 using namespace std;
@@ -361,6 +361,14 @@ private:
     boost::uint_t<64>::fast prr_timer = 7200;  /* seconds */
     /* handshake timeout */
     uint32_t peerHandshakeTimeout = 45000;
+    /* number of event loops for peer connections */
+    size_t connectionLoops = 1;
+    /* number of threads delivering object notifications */
+    size_t notifThreads = 1;
+    /* warm-start policy snapshot */
+    std::string snapshotPath;
+    uint64_t snapshotInterval = 300000;
+    uint64_t snapshotHoldTime = 600000;
 
     std::set<std::string> endpointSourceFSPaths;
     std::set<std::string> disabledFeaturesSet;
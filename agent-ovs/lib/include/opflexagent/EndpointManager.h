@@ -42,6 +42,12 @@ class Agent;
 typedef std::unordered_map<std::string,
                         std::shared_ptr<const Endpoint>> ip_ep_map_t;
 
+/**
+ * A read-only view of a set of endpoint UUIDs.  The set is never
+ * modified after the view is returned.
+ */
+typedef std::shared_ptr<const std::unordered_set<std::string>> ep_set_view_t;
+
 /**
  * Counter values for endpoint stats
  */
@@ -195,6 +201,16 @@ public:
     void getEndpointsForGroup(const opflex::modb::URI& egURI,
                               /* out */ std::unordered_set<std::string>& eps);
 
+    /**
+     * Get a view of the endpoints that exist for a given endpoint
+     * group without copying the set
+     *
+     * @param egURI the URI for the endpoint group
+     * @return the UUIDs of matching endpoints, or an empty pointer if
+     * there are none
+     */
+    ep_set_view_t getEndpointsForGroup(const opflex::modb::URI& egURI);
+
     /**
      * Check whether the given security group set contains any endpoints
      *
@@ -225,6 +241,17 @@ public:
     void getEndpointsForIPMGroup(const opflex::modb::URI& egURI,
                                  /* out */ std::unordered_set<std::string>& eps);
 
+    /**
+     * Get a view of the endpoints with IP address mappings mapped to
+     * the given endpoint group without copying the set
+     *
+     * @param egURI the URI for the endpoint group for the ip address
+     * mappings
+     * @return the UUIDs of matching endpoints, or an empty pointer if
+     * there are none
+     */
+    ep_set_view_t getEndpointsForIPMGroup(const opflex::modb::URI& egURI);
+
     /**
      * Get the endpoints that are on a particular integration interface
      *
@@ -235,6 +262,16 @@ public:
     void getEndpointsByIface(const std::string& ifaceName,
                              /* out */ std::unordered_set<std::string>& eps);
 
+    /**
+     * Get a view of the endpoints that are on a particular
+     * integration interface without copying the set
+     *
+     * @param ifaceName the name of the interface
+     * @return the UUIDs of matching endpoints, or an empty pointer if
+     * there are none
+     */
+    ep_set_view_t getEndpointsByIface(const std::string& ifaceName);
+
     /**
      * Get all endpoints
      *
@@ -260,6 +297,16 @@ public:
     void getEndpointsByAccessIface(const std::string& ifaceName,
                                    /* out */ std::unordered_set<std::string>& eps);
 
+    /**
+     * Get a view of the endpoints that are on a particular access
+     * interface without copying the set
+     *
+     * @param ifaceName the name of the interface
+     * @return the UUIDs of matching endpoints, or an empty pointer if
+     * there are none
+     */
+    ep_set_view_t getEndpointsByAccessIface(const std::string& ifaceName);
+
     /**
      * Get the endpoints that are on a particular access uplink interface
      *
@@ -444,10 +491,87 @@ private:
     boost::optional<opflex::modb::URI> resolveEpgMapping(EndpointState& es);
     typedef std::unordered_map<std::string, EndpointState> ep_map_t;
     typedef std::unordered_set<std::string> str_uset_t;
-    typedef std::unordered_map<opflex::modb::URI, str_uset_t> group_ep_map_t;
+
+    /**
+     * An index from a key to the UUIDs of the endpoints with that
+     * key.  The UUID sets are copy-on-write: a set is shared with the
+     * views returned by queries, and is only cloned if it is
+     * modified while a view is outstanding.  Queries therefore never
+     * copy a set.  All access must hold ep_mutex; views may be
+     * released without it.
+     */
+    template <typename K>
+    class EpIndex {
+    public:
+        /**
+         * Add an endpoint to the set for the key
+         */
+        void insert(const K& key, const std::string& uuid) {
+            std::shared_ptr<str_uset_t>& eps = map[key];
+            if (!eps)
+                eps = std::make_shared<str_uset_t>();
+            writable(eps).insert(uuid);
+        }
+
+        /**
+         * Remove an endpoint from the set for the key, dropping the
+         * key once its set is empty
+         */
+        void erase(const K& key, const std::string& uuid) {
+            auto it = map.find(key);
+            if (it == map.end() || it->second->count(uuid) == 0)
+                return;
+            if (it->second->size() == 1)
+                map.erase(it);
+            else
+                writable(it->second).erase(uuid);
+        }
+
+        /**
+         * Remove the key and its set
+         */
+        void erase(const K& key) {
+            map.erase(key);
+        }
+
+        /**
+         * Get a view of the set for the key, or an empty pointer if
+         * there is none
+         */
+        ep_set_view_t find(const K& key) const {
+            auto it = map.find(key);
+            if (it == map.end())
+                return ep_set_view_t();
+            return it->second;
+        }
+
+        /**
+         * Add all endpoints in the index to eps
+         */
+        void getAll(/* out */ str_uset_t& eps) const {
+            for (const auto& elem : map)
+                eps.insert(elem.second->begin(), elem.second->end());
+        }
+
+        void clear() {
+            map.clear();
+        }
+
+    private:
+        std::unordered_map<K, std::shared_ptr<str_uset_t> > map;
+
+        // clone the set first if a view of it is outstanding
+        static str_uset_t& writable(std::shared_ptr<str_uset_t>& eps) {
+            if (eps.use_count() > 1)
+                eps = std::make_shared<str_uset_t>(*eps);
+            return *eps;
+        }
+    };
+
+    typedef EpIndex<opflex::modb::URI> group_ep_map_t;
     typedef std::unordered_map<std::string, opflex::modb::URI> ep_group_map_t;
     typedef std::unordered_map<opflex::modb::URI, std::string> ep_uuid_map_t;
-    typedef std::unordered_map<std::string, str_uset_t> string_ep_map_t;
+    typedef EpIndex<std::string> string_ep_map_t;
     typedef std::unordered_map<EndpointListener::uri_set_t,
                                str_uset_t> secgrp_ep_map_t;
     typedef std::unordered_map<std::string,
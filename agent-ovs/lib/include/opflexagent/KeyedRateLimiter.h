@@ -17,9 +17,11 @@
 
 #include <string>
 #include <unordered_set>
+#include <unordered_map>
 #include <mutex>
 #include <vector>
 #include <chrono>
+#include <algorithm>
 
 namespace opflexagent {
 
@@ -94,6 +96,16 @@ public:
         return true;
     }
 
+    /**
+     * Get the number of keys with a partially-empty bucket
+     *
+     * @return the number of buckets being tracked
+     */
+    size_t size() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return buckets.size();
+    }
+
 private:
     typedef std::chrono::steady_clock::time_point time_point;
     typedef std::chrono::milliseconds duration;
@@ -112,6 +124,118 @@ private:
     }
 };
 
+/**
+ * A token bucket rate limiter that keeps an independent bucket for
+ * each key.  Each bucket refills at a fixed rate up to a maximum
+ * burst size, and an event for a key is admitted only if its bucket
+ * holds at least one token.  Unlike KeyedRateLimiter this allows a
+ * sustained rate of events for the same key rather than one event
+ * per window.  Buckets that have refilled completely are discarded,
+ * so memory use follows the number of recently active keys.
+ *
+ * @param K the key type; must be hashable
+ */
+template <typename K>
+class KeyedTokenBucket : private boost::noncopyable {
+public:
+    /**
+     * Instantiate a keyed token bucket
+     *
+     * @param rate_ the number of events per second to allow for each
+     * key.  A rate of zero disables the rate limiter.
+     * @param burst_ the maximum number of events that can be
+     * admitted at once for a key.  If zero, the rate is used.
+     */
+    KeyedTokenBucket(uint64_t rate_ = 0, uint64_t burst_ = 0) {
+        setRate(rate_, burst_);
+    }
+
+    /**
+     * Set the rate and burst size for the rate limiter, and reset
+     * all buckets to full.
+     *
+     * @param rate_ the number of events per second to allow for each
+     * key.  A rate of zero disables the rate limiter.
+     * @param burst_ the maximum number of events that can be
+     * admitted at once for a key.  If zero, the rate is used.
+     */
+    void setRate(uint64_t rate_, uint64_t burst_ = 0) {
+        std::lock_guard<std::mutex> guard(mtx);
+        rate = rate_;
+        burst = burst_ ? burst_ : rate_;
+        buckets.clear();
+        lastSweep = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Clear the rate limiter and reset all buckets to full
+     */
+    void clear() {
+        std::lock_guard<std::mutex> guard(mtx);
+        buckets.clear();
+    }
+
+    /**
+     * Apply the rate limiter to the given key, consuming a token
+     * from its bucket if one is available.
+     *
+     * @param key the key to check
+     * @return true to indicate the event should be handled, otherwise
+     * false.
+     */
+    bool event(const K& key) {
+        time_point now = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> guard(mtx);
+        if (rate == 0) return true;
+
+        // A bucket that has refilled completely is the same as a new
+        // one; sweep them once per refill period
+        std::chrono::duration<double> sinceSweep = now - lastSweep;
+        if (sinceSweep.count() * rate >= burst) {
+            for (auto bit = buckets.begin(); bit != buckets.end(); ) {
+                std::chrono::duration<double> idle = now - bit->second.last;
+                if (bit->second.tokens + idle.count() * rate >= burst)
+                    bit = buckets.erase(bit);
+                else
+                    ++bit;
+            }
+            lastSweep = now;
+        }
+
+        auto it = buckets.find(key);
+        if (it == buckets.end()) {
+            it = buckets.emplace(key, bucket{static_cast<double>(burst),
+                                             now}).first;
+        } else {
+            std::chrono::duration<double> elapsed = now - it->second.last;
+            it->second.tokens =
+                std::min(static_cast<double>(burst),
+                         it->second.tokens + elapsed.count() * rate);
+            it->second.last = now;
+        }
+
+        if (it->second.tokens < 1.0)
+            return false;
+        it->second.tokens -= 1.0;
+        return true;
+    }
+
+private:
+    typedef std::chrono::steady_clock::time_point time_point;
+
+    struct bucket {
+        double tokens;
+        time_point last;
+    };
+
+    std::mutex mtx;
+    uint64_t rate;
+    uint64_t burst;
+    time_point lastSweep;
+    std::unordered_map<K, bucket> buckets;
+};
+
 } /* namespace opflexagent */
 
 #endif /* OPFLEXAGENT_KEYED_RATE_LIMITER */
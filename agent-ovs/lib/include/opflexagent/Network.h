@@ -15,6 +15,10 @@
 #include <utility>
 #include <string>
 #include <unordered_set>
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
 
 #include <boost/asio/ip/address.hpp>
 #include <opflex/modb/MAC.h>
@@ -201,6 +205,251 @@ bool prefix_match(const boost::asio::ip::address& addr,
                   uint32_t tgtPfxLen,
                   bool &is_exact_match);
 
+/**
+ * The bits of an IPv4 or IPv6 address in network byte order, used as
+ * a key in a PrefixTrie
+ */
+typedef std::array<uint8_t, 16> prefix_key_t;
+
+/**
+ * Convert an address to a prefix key, clearing the bits beyond the
+ * prefix length
+ *
+ * @param addr the address to convert
+ * @param prefixLen the prefix length; clamped to the address size
+ * @param key the output key
+ * @return the clamped prefix length
+ */
+uint8_t to_prefix_key(const boost::asio::ip::address& addr,
+                      uint32_t prefixLen,
+                      /* out */ prefix_key_t& key);
+
+/**
+ * Get a bit from a prefix key
+ *
+ * @param key the key
+ * @param bit the index of the bit, starting from the most significant
+ * @return the value of the bit
+ */
+inline int prefix_key_bit(const prefix_key_t& key, uint8_t bit) {
+    return (key[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+/**
+ * Get the length of the common prefix of two prefix keys
+ *
+ * @param a the first key
+ * @param b the second key
+ * @param maxLen the maximum number of bits to compare
+ * @return the number of leading bits that are equal, up to maxLen
+ */
+uint8_t prefix_key_common(const prefix_key_t& a, const prefix_key_t& b,
+                          uint8_t maxLen);
+
+/**
+ * A path-compressed binary trie of IPv4 and IPv6 prefixes.  Several
+ * values may be stored for the same prefix.  Lookups cost time
+ * proportional to the prefix length rather than the number of
+ * prefixes in the trie.
+ *
+ * @tparam T the value type; must be equality comparable
+ */
+template <typename T>
+class PrefixTrie {
+public:
+    /**
+     * Add a value for the given prefix
+     *
+     * @param addr the prefix address
+     * @param prefixLen the prefix length
+     * @param value the value to add
+     * @return true if the value was not already present
+     */
+    bool insert(const boost::asio::ip::address& addr, uint32_t prefixLen,
+                const T& value) {
+        prefix_key_t key;
+        uint8_t len = to_prefix_key(addr, prefixLen, key);
+        std::unique_ptr<Node>* slot = &root(addr);
+        while (true) {
+            Node* n = slot->get();
+            if (!n) {
+                slot->reset(new Node(key, len));
+                n = slot->get();
+            }
+            uint8_t common =
+                prefix_key_common(n->key, key, std::min(n->len, len));
+            if (common < n->len) {
+                // split the node at the common prefix
+                std::unique_ptr<Node> mid(new Node(key, common));
+                mid->child[prefix_key_bit(n->key, common)] = std::move(*slot);
+                *slot = std::move(mid);
+                n = slot->get();
+            }
+            if (n->len == len) {
+                if (std::find(n->values.begin(), n->values.end(), value) !=
+                    n->values.end())
+                    return false;
+                n->values.push_back(value);
+                count += 1;
+                return true;
+            }
+            slot = &n->child[prefix_key_bit(key, n->len)];
+        }
+    }
+
+    /**
+     * Remove a value for the given prefix
+     *
+     * @param addr the prefix address
+     * @param prefixLen the prefix length
+     * @param value the value to remove
+     * @return true if the value was present
+     */
+    bool erase(const boost::asio::ip::address& addr, uint32_t prefixLen,
+               const T& value) {
+        prefix_key_t key;
+        uint8_t len = to_prefix_key(addr, prefixLen, key);
+        std::vector<std::unique_ptr<Node>*> path;
+        std::unique_ptr<Node>* slot = &root(addr);
+        while (true) {
+            Node* n = slot->get();
+            if (!n || n->len > len ||
+                prefix_key_common(n->key, key, n->len) < n->len)
+                return false;
+            path.push_back(slot);
+            if (n->len == len) break;
+            slot = &n->child[prefix_key_bit(key, n->len)];
+        }
+
+        std::vector<T>& values = (*slot)->values;
+        auto it = std::find(values.begin(), values.end(), value);
+        if (it == values.end()) return false;
+        values.erase(it);
+        count -= 1;
+
+        // remove empty nodes and collapse pass-through nodes
+        while (!path.empty()) {
+            std::unique_ptr<Node>& s = *path.back();
+            path.pop_back();
+            if (!s->values.empty() || (s->child[0] && s->child[1]))
+                break;
+            if (s->child[0]) {
+                s = std::move(s->child[0]);
+                break;
+            } else if (s->child[1]) {
+                s = std::move(s->child[1]);
+                break;
+            }
+            s.reset();
+        }
+        return true;
+    }
+
+    /**
+     * Find the longest prefix in the trie that contains the given
+     * prefix, including the prefix itself
+     *
+     * @param addr the prefix address
+     * @param prefixLen the prefix length
+     * @param values the values for the longest matching prefix
+     * @return the length of the longest matching prefix, or -1 if
+     * there is no match
+     */
+    int getBestMatch(const boost::asio::ip::address& addr,
+                     uint32_t prefixLen,
+                     /* out */ std::vector<T>& values) const {
+        prefix_key_t key;
+        uint8_t len = to_prefix_key(addr, prefixLen, key);
+        const Node* best = NULL;
+        const Node* n = root(addr).get();
+        while (n) {
+            if (n->len > len ||
+                prefix_key_common(n->key, key, n->len) < n->len)
+                break;
+            if (!n->values.empty()) best = n;
+            if (n->len == len) break;
+            n = n->child[prefix_key_bit(key, n->len)].get();
+        }
+        if (!best) return -1;
+        values.insert(values.end(), best->values.begin(), best->values.end());
+        return best->len;
+    }
+
+    /**
+     * Find the prefixes in the trie that are contained in the given
+     * prefix, including the prefix itself
+     *
+     * @param addr the prefix address
+     * @param prefixLen the prefix length
+     * @param values the values for all covered prefixes
+     */
+    void getCovered(const boost::asio::ip::address& addr,
+                    uint32_t prefixLen,
+                    /* out */ std::vector<T>& values) const {
+        prefix_key_t key;
+        uint8_t len = to_prefix_key(addr, prefixLen, key);
+        const Node* n = root(addr).get();
+        while (n) {
+            uint8_t cmp = std::min(n->len, len);
+            if (prefix_key_common(n->key, key, cmp) < cmp)
+                return;
+            if (n->len >= len) {
+                collect(n, values);
+                return;
+            }
+            n = n->child[prefix_key_bit(key, n->len)].get();
+        }
+    }
+
+    /**
+     * Get the number of values in the trie
+     */
+    size_t size() const { return count; }
+
+    /**
+     * Remove all the values in the trie
+     */
+    void clear() {
+        root_v4.reset();
+        root_v6.reset();
+        count = 0;
+    }
+
+private:
+    struct Node {
+        Node(const prefix_key_t& key_, uint8_t len_) : key(key_), len(len_) {
+            // clear the bits beyond the prefix
+            for (size_t i = len; i < key.size() * 8; ++i)
+                key[i / 8] &= ~(1 << (7 - i % 8));
+        }
+
+        prefix_key_t key;
+        uint8_t len;
+        std::unique_ptr<Node> child[2];
+        std::vector<T> values;
+    };
+
+    std::unique_ptr<Node> root_v4;
+    std::unique_ptr<Node> root_v6;
+    size_t count = 0;
+
+    std::unique_ptr<Node>& root(const boost::asio::ip::address& addr) {
+        return addr.is_v4() ? root_v4 : root_v6;
+    }
+
+    const std::unique_ptr<Node>&
+    root(const boost::asio::ip::address& addr) const {
+        return addr.is_v4() ? root_v4 : root_v6;
+    }
+
+    static void collect(const Node* n, std::vector<T>& values) {
+        values.insert(values.end(), n->values.begin(), n->values.end());
+        for (const std::unique_ptr<Node>& c : n->child) {
+            if (c) collect(c.get(), values);
+        }
+    }
+};
+
 } /* namespace packets */
 } /* namespace opflexagent */
 
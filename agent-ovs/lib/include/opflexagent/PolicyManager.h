@@ -16,6 +16,7 @@
 #include <opflexagent/PolicyListener.h>
 #include <opflexagent/Network.h>
 #include <opflexagent/TaskQueue.h>
+#include <opflexagent/RangeMask.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/asio/io_service.hpp>
@@ -65,6 +66,10 @@ public:
         direction(dir), prio(prio_), l24Classifier(c), allow(allow_),
         redirect(redirect_), remoteSubnets(remoteSubnets_),
         redirDstGrp(rDG) {
+        RangeMask::getMasks(c->getSFromPort(), c->getSToPort(),
+                            srcPortMasks);
+        RangeMask::getMasks(c->getDFromPort(), c->getDToPort(),
+                            dstPortMasks);
     }
 
     /**
@@ -125,6 +130,24 @@ public:
         return redirect;
     }
 
+    /**
+     * Get the masked values that cover the source port range of the
+     * classifier, computed when the rule is built
+     * @return the source port masks; empty if no range is set
+     */
+    const MaskList& getSrcPortMasks() const {
+        return srcPortMasks;
+    }
+
+    /**
+     * Get the masked values that cover the destination port range
+     * of the classifier, computed when the rule is built
+     * @return the destination port masks; empty if no range is set
+     */
+    const MaskList& getDstPortMasks() const {
+        return dstPortMasks;
+    }
+
 private:
     uint8_t direction;
     uint16_t prio;
@@ -133,9 +156,54 @@ private:
     bool redirect;
     network::subnets_t remoteSubnets;
     boost::optional<opflex::modb::URI> redirDstGrp;
+    MaskList srcPortMasks;
+    MaskList dstPortMasks;
     friend bool operator==(const PolicyRule& lhs, const PolicyRule& rhs);
 };
 
+/**
+ * An immutable set of policy rules compiled for a contract or
+ * security group.  A new rule set is built each time the rules
+ * change, and the same object is shared by every renderer that
+ * reads it.
+ */
+class PolicyRuleSet {
+public:
+    /**
+     * Vector of rules in descending priority order
+     */
+    typedef std::vector<std::shared_ptr<PolicyRule> > rule_vec_t;
+
+    /**
+     * Construct a rule set
+     * @param version_ the version of the rule set
+     * @param rules_ the rules in descending priority order
+     */
+    PolicyRuleSet(uint64_t version_, rule_vec_t rules_)
+        : version(version_), rules(std::move(rules_)) {}
+
+    /**
+     * Get the version of this rule set.  Versions increase each time
+     * any rule set is rebuilt.
+     * @return the version
+     */
+    uint64_t getVersion() const {
+        return version;
+    }
+
+    /**
+     * Get the rules in descending priority order
+     * @return the rules
+     */
+    const rule_vec_t& getRules() const {
+        return rules;
+    }
+
+private:
+    uint64_t version;
+    rule_vec_t rules;
+};
+
 /**
  * Class to represent information about a redirect destination.
  */
@@ -594,6 +662,13 @@ public:
      */
     typedef std::list<std::shared_ptr<PolicyRule> > rule_list_t;
 
+    /**
+     * An immutable snapshot of a compiled rule set.  A new snapshot
+     * is published each time the rules change, so a reader holding
+     * one is never affected by later updates.
+     */
+    typedef std::shared_ptr<const PolicyRuleSet> rule_snapshot_t;
+
     /**
      * Set of URIs.
      */
@@ -659,6 +734,16 @@ public:
     void getContractRules(const opflex::modb::URI& contractURI,
                           /* out */ rule_list_t& rules);
 
+    /**
+     * Get the current snapshot of the PolicyRule objects that
+     * compose a contract, without copying the rule list.
+     *
+     * @param contractURI URI of contract to look for
+     * @return the compiled rule set, or an empty pointer if
+     * the contract has no rules
+     */
+    rule_snapshot_t getContractRuleSnapshot(const opflex::modb::URI& contractURI);
+
     /**
      * Check if a contract exists.
      *
@@ -677,6 +762,15 @@ public:
     void getSecGroupRules(const opflex::modb::URI& secGroupURI,
                           /* out */ rule_list_t& rules);
 
+    /**
+     * Get the current snapshot of the PolicyRule objects that
+     * compose a security group, without copying the rule list.
+     *
+     * @param secGroupURI URI of security group to look for
+     * @return the compiled rule set, or an empty pointer if
+     * the security group has no rules
+     */
+    rule_snapshot_t getSecGroupRuleSnapshot(const opflex::modb::URI& secGroupURI);
 
     /**
      * Get the routing-mode applicable to endpoints in specified group.
@@ -807,9 +901,18 @@ private:
     typedef std::unordered_map<opflex::modb::URI, std::shared_ptr<PolicyRoute>>
         route_map_t;
 
+    /**
+     * An external network and one of its external subnets
+     */
+    typedef std::pair<opflex::modb::URI, opflex::modb::URI> ext_subnet_ref_t;
+
     struct RoutingDomainState {
         std::unordered_set<opflex::modb::URI> extNets;
         uri_set_t remote_routes;
+        // remote_routes indexed by prefix
+        network::PrefixTrie<opflex::modb::URI> remoteRouteTrie;
+        // external subnets of extNets indexed by prefix
+        network::PrefixTrie<ext_subnet_ref_t> policyPrefixTrie;
     };
 
     struct ExternalNodeState {
@@ -873,6 +976,27 @@ private:
     std::mutex state_mutex;
     std::mutex subnets_rd_mutex;
 
+    /**
+     * Guards the published rule snapshots in contractRules and
+     * secGrpRules.  Rule queries only take this lock, so they never
+     * wait behind updates holding state_mutex.  May be acquired while
+     * holding state_mutex but not the other way around.
+     */
+    std::mutex rule_mutex;
+
+    /**
+     * Serializes contract and security group rule recomputation,
+     * which resolves rules from the store without holding
+     * state_mutex.
+     */
+    std::mutex rule_update_mutex;
+
+    /**
+     * Version of the last rule set built, guarded by
+     * rule_update_mutex
+     */
+    uint64_t ruleSetVersion;
+
     // Listen to changes related to forwarding domains
     class DomainListener : public opflex::modb::ObjectListener {
     public:
@@ -915,7 +1039,6 @@ private:
         uri_set_t providerGroups;
         uri_set_t consumerGroups;
         uri_set_t intraGroups;
-        rule_list_t rules;
     };
     typedef std::unordered_map<opflex::modb::URI, ContractState>
         contract_map_t;
@@ -925,12 +1048,69 @@ private:
      */
     contract_map_t contractMap;
 
-    typedef std::unordered_map<opflex::modb::URI, rule_list_t> secgrp_map_t;
+    /**
+     * Security groups whose rules are tracked
+     */
+    uri_set_t secGrps;
+
+    typedef std::unordered_map<opflex::modb::URI, rule_snapshot_t>
+        rule_snapshot_map_t;
+
+    /**
+     * Published rules of each contract and security group, guarded
+     * by rule_mutex
+     */
+    rule_snapshot_map_t contractRules;
+    rule_snapshot_map_t secGrpRules;
 
     /**
-     * Map of security group URI to its rules
+     * Replace the published rules for a contract or security group.
+     * An empty snapshot removes the entry.
      */
-    secgrp_map_t secGrpMap;
+    void publishRules(rule_snapshot_map_t& ruleMap,
+                      const opflex::modb::URI& uri,
+                      const rule_snapshot_t& rules);
+
+    /**
+     * Tracks the policy objects that the rules of each contract or
+     * security group were computed from: subjects, rules, relation
+     * sources and their targets.  A change to one of these objects
+     * only recomputes the rules that depend on it.
+     */
+    class RuleDeps {
+    public:
+        /**
+         * Replace the dependencies of the given contract or security
+         * group.  deps is left in an unspecified state.
+         */
+        void set(const opflex::modb::URI& parent, uri_set_t& deps);
+
+        /**
+         * Remove all dependencies of the given contract or security
+         * group
+         */
+        void erase(const opflex::modb::URI& parent);
+
+        /**
+         * Add the contracts or security groups that depend on the
+         * given object to parents
+         */
+        void getAffected(const opflex::modb::URI& dep,
+                         /* out */ uri_set_t& parents) const;
+
+    private:
+        std::unordered_map<opflex::modb::URI, uri_set_t> depMap;
+        std::unordered_map<opflex::modb::URI, uri_set_t> parentMap;
+    };
+
+    RuleDeps contractDeps;
+    RuleDeps secGrpDeps;
+
+    /**
+     * Contracts and security groups whose rules must be recomputed
+     */
+    uri_set_t dirtyContracts;
+    uri_set_t dirtySecGrps;
 
     /**
      * Listener for changes related to policy objects.
@@ -942,8 +1122,14 @@ private:
 
         virtual void objectUpdated(opflex::modb::class_id_t class_id,
                                     const opflex::modb::URI& uri);
+        virtual void objectsUpdated(opflex::modb::class_id_t class_id,
+                                    const std::vector<opflex::modb::URI>& uris);
     private:
         PolicyManager& pmanager;
+
+        // mark the affected rules dirty; called with state_mutex held
+        bool markDirty(opflex::modb::class_id_t class_id,
+                       const opflex::modb::URI& uri);
     };
     ContractListener contractListener;
 
@@ -957,8 +1143,14 @@ private:
 
         virtual void objectUpdated(opflex::modb::class_id_t class_id,
                                     const opflex::modb::URI& uri);
+        virtual void objectsUpdated(opflex::modb::class_id_t class_id,
+                                    const std::vector<opflex::modb::URI>& uris);
     private:
         PolicyManager& pmanager;
+
+        // mark the affected rules dirty; called with state_mutex held
+        bool markDirty(opflex::modb::class_id_t class_id,
+                       const opflex::modb::URI& uri);
     };
     SecGroupListener secGroupListener;
 
@@ -1008,6 +1200,22 @@ private:
      */
     bool updateEPGDomains(const opflex::modb::URI& egURI, bool& toRemove);
 
+    /**
+     * Find the endpoint groups whose forwarding domains could be
+     * affected by a change to the specified object, by walking the
+     * store's reference index back from the object to the groups.
+     * You must hold a state lock to call this function.
+     *
+     * @param class_id the class of the object that changed
+     * @param uri the URI of the object that changed
+     * @param groups the affected groups are added to this set
+     * @return false if the object could not be placed and every
+     * group must be updated
+     */
+    bool getDomainGroups(opflex::modb::class_id_t class_id,
+                         const opflex::modb::URI& uri,
+                         /* out */ uri_set_t& groups);
+
     /**
      * Notify policy listeners about an update to the forwarding
      * domains for an endpoint group.
@@ -1085,7 +1293,9 @@ private:
                               uri_set_t& updatedContracts);
 
     /**
-     * Update the classifier rules associated with a contract.
+     * Update the classifier rules associated with a contract.  The
+     * rules are resolved without holding state_mutex; the caller
+     * must hold rule_update_mutex but not state_mutex.
      *
      * @param contractURI URI of contract to update
      * @param notFound set to true if contract could not be resolved
@@ -1094,6 +1304,15 @@ private:
     bool updateContractRules(const opflex::modb::URI& contractURI,
             bool& notFound);
 
+    /**
+     * Update the classifier rules associated with a security group,
+     * with the same locking requirements as updateContractRules.
+     *
+     * @param secGrpURI URI of security group to update
+     * @param notFound set to true if security group could not be
+     * resolved
+     * @return true if rules for this security group were updated
+     */
     bool updateSecGrpRules(const opflex::modb::URI& secGrpURI,
                            bool& notFound);
 
@@ -1362,6 +1581,33 @@ private:
      */
     bool isLocalRouteDeletable(
              std::shared_ptr<modelgbp::epdr::LocalRoute> &localRoute);
+
+    /**
+     * Add or remove an external subnet in the policy prefix trie of
+     * a routing domain
+     *
+     * @param rs the routing domain state
+     * @param extNetURI the external network of the subnet
+     * @param extSub the external subnet
+     * @param add true to add the subnet, false to remove it
+     */
+    void indexPolicyPrefix(
+             RoutingDomainState& rs,
+             const opflex::modb::URI& extNetURI,
+             const std::shared_ptr<modelgbp::gbp::ExternalSubnet>& extSub,
+             bool add);
+
+    /**
+     * Add or remove all the external subnets of an external network
+     * in the policy prefix trie of a routing domain
+     *
+     * @param rs the routing domain state
+     * @param extNetURI the external network
+     * @param add true to add the subnets, false to remove them
+     */
+    void indexPolicyPrefixes(RoutingDomainState& rs,
+                             const opflex::modb::URI& extNetURI,
+                             bool add);
 };
 
 /**
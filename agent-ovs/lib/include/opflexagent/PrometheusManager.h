@@ -256,6 +256,19 @@ public:
      */
     void removeRDDropCounter(const string& rdURI);
 
+    /* PacketInDrop related APIs */
+    /**
+     * Create PacketInDrop metrics for the given packet-in type if
+     * not present, and set them to the given totals
+     *
+     * @param type         the packet-in type, e.g. "dhcpv4"
+     * @param rateLimited  total packet-ins dropped by admission control
+     * @param queueFull    total packet-ins dropped due to a full queue
+     */
+    void addNUpdatePacketInDrops(const string& type,
+                                 uint64_t rateLimited,
+                                 uint64_t queueFull);
+
     /**
      * Add TableDropGauge metric given bridge name and table name
      *
@@ -740,7 +753,12 @@ private:
         OFPEER_STATE_REPORT_RESPS,
         OFPEER_STATE_REPORT_ERRS,
         OFPEER_UNRESOLVED_POLS,
-        OFPEER_METRICS_MAX = OFPEER_UNRESOLVED_POLS
+        OFPEER_LOOP_ID,
+        OFPEER_LOOP_CPU_MS,
+        OFPEER_WRITE_QUEUE_DEPTH,
+        OFPEER_TLS_FULL_HANDSHAKES,
+        OFPEER_TLS_RESUMED_HANDSHAKES,
+        OFPEER_METRICS_MAX = OFPEER_TLS_RESUMED_HANDSHAKES
     };
 
     // Static Metric families and metrics
@@ -858,6 +876,42 @@ private:
     unordered_map<string, Gauge*> rddrop_gauge_map[RDDROP_METRICS_MAX+1];
     /* End of RDDropCounter related apis and state */
 
+    /* Start of PacketInDrop related apis and state */
+    // Lock to safe guard PacketInDrop related state
+    mutex pktin_drop_mutex;
+
+    enum PKTIN_DROP_METRICS {
+        PKTIN_DROP_METRICS_MIN,
+        PKTIN_DROP_RATE_LIMITED = PKTIN_DROP_METRICS_MIN,
+        PKTIN_DROP_QUEUE_FULL,
+        PKTIN_DROP_METRICS_MAX = PKTIN_DROP_QUEUE_FULL
+    };
+
+    // Static Metric families and metrics
+    // metric families to track all PacketInDrop metrics
+    Family<Gauge>      *gauge_pktin_drop_family_ptr[PKTIN_DROP_METRICS_MAX+1];
+
+    // create any packet-in drop gauge metric families during start
+    void createStaticGaugeFamiliesPktInDrop(void);
+    // remove any packet-in drop gauge metric families during stop
+    void removeStaticGaugeFamiliesPktInDrop(void);
+
+    // Dynamic Metric families and metrics
+    // func to create gauge for PacketInDrop given metric type, pkt-in type
+    void createDynamicGaugePktInDrop(PKTIN_DROP_METRICS metric,
+                                     const string& type);
+    // func to get Gauge for PacketInDrop given metric type, pkt-in type
+    Gauge * getDynamicGaugePktInDrop(PKTIN_DROP_METRICS metric,
+                                     const string& type);
+    // func to remove all gauges of every PacketInDrop
+    void removeDynamicGaugePktInDrop(void);
+
+    /**
+     * cache Gauge ptr for every PacketInDrop metric
+     */
+    unordered_map<string, Gauge*> pktin_drop_gauge_map[PKTIN_DROP_METRICS_MAX+1];
+    /* End of PacketInDrop related apis and state */
+
     /* Start of TableDropCounter related apis and state */
     // Lock to safe guard TableDropCounter related state
     mutex table_drop_counter_mutex;
@@ -16,6 +16,7 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <cstdint>
 #include <boost/assert.hpp>
 
 namespace opflexagent {
@@ -32,6 +33,8 @@ extern LogLevel logLevel;
  */
 class LogSink {
 public:
+    virtual ~LogSink() {}
+
     /**
      * Write a log message to the log destination alongwith information about
      * its origin (source file, line number etc).
@@ -45,6 +48,12 @@ public:
     virtual
     void write(LogLevel level, const char *filename, int lineno,
                const char *functionName, const std::string& message) = 0;
+
+    /**
+     * Wait until the messages written so far have reached the log
+     * destination
+     */
+    virtual void flush() {}
 };
 
 /**
@@ -60,6 +69,60 @@ void initLogging(const std::string& level, bool toSyslog,
                  const std::string& log_file,
                  const std::string& syslog_name = "opflex-agent");
 
+/**
+ * Select how log messages are delivered by the sinks created by
+ * subsequent calls to initLogging().
+ *
+ * @param async if true, messages are queued on a per-thread ring and
+ * written in batches by a background thread, so the logging thread
+ * never waits for the log destination.  A message is dropped and
+ * counted if its thread's ring is full.
+ * @param json if true, console and file output is written as one
+ * JSON object per line instead of plain text
+ */
+void setLogOutputOptions(bool async, bool json);
+
+/**
+ * Get the options set by setLogOutputOptions()
+ *
+ * @param async set to true if asynchronous logging is selected
+ * @param json set to true if JSON output is selected
+ */
+void getLogOutputOptions(bool& async, bool& json);
+
+/**
+ * Get the number of log messages dropped because an asynchronous
+ * log queue was full
+ *
+ * @return the number of dropped messages
+ */
+uint64_t getDroppedLogCount();
+
+/**
+ * Wait until all log messages written so far have reached the log
+ * destination
+ */
+void flushLogging();
+
+/**
+ * Stop the background writer of an asynchronous log destination
+ * after writing out the queued messages.  Messages logged afterwards
+ * are written synchronously.  Called at exit when asynchronous
+ * logging is enabled.
+ */
+void stopLogging();
+
+/**
+ * Replace the current log destination.  Messages queued for a
+ * previous asynchronous destination are written to it before this
+ * returns.
+ *
+ * @param sink the new log destination; it is never freed
+ * @param async if true, messages are queued and written to the sink
+ * from a background thread as described in setLogOutputOptions()
+ */
+void setLogSink(LogSink* sink, bool async);
+
 /**
  * Change the logging level of the agent.
  *
@@ -20,10 +20,20 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
+#include <pthread.h>
 #include <syslog.h>
+#include <unistd.h>
 
 using opflex::logging::OFLogHandler;
 
@@ -33,17 +43,85 @@ AgentLogHandler logHandler(OFLogHandler::NO_LOGGING);
 
 LogLevel logLevel = DEBUG;
 
+static std::atomic<uint64_t> droppedLogMessages(0);
+static bool asyncOutput = false;
+static bool jsonOutput = false;
+
+/**
+ * A log message captured by the thread that logged it
+ */
+struct LogRecord {
+    boost::posix_time::ptime time;
+    LogLevel level;
+    int lineno;
+    std::string filename;
+    std::string functionName;
+    std::string message;
+};
+
+/**
+ * A log sink that can write a record captured earlier, keeping the
+ * time at which it was logged
+ */
+class RecordLogSink : public LogSink {
+public:
+    /**
+     * Write a captured record to the log destination
+     * @param r the record to write
+     */
+    virtual void writeRecord(const LogRecord& r) {
+        write(r.level, r.filename.c_str(), r.lineno,
+              r.functionName.c_str(), r.message);
+    }
+};
+
+static const char* levelString(LogLevel level) {
+    switch (level) {
+    case TRACE:   return "trace";
+    case DEBUG:   return "debug";
+    case INFO:    return "info";
+    case WARNING: return "warning";
+    case ERROR:   return "error";
+    case FATAL:   return "fatal";
+    }
+    return "debug";
+}
+
+static void writeJsonString(std::ostream& out, const char* str) {
+    out << '"';
+    for (const char* c = str; *c; ++c) {
+        switch (*c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if ((unsigned char)*c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*c);
+                out << esc;
+            } else {
+                out << *c;
+            }
+        }
+    }
+    out << '"';
+}
+
 /**
  * Log sink to write log messages to a standard output stream, such as
  * standard output or file stream.
  */
-class OStreamLogSink : public LogSink {
+class OStreamLogSink : public RecordLogSink {
 public:
     /**
      * Constructor that accepts the output stream to write logs to.
      * @param outStream The stream to send messages to.
+     * @param json_ write messages as JSON objects
      */
-    OStreamLogSink(std::ostream& outStream) : out(&outStream) {
+    OStreamLogSink(std::ostream& outStream, bool json_ = false)
+        : out(&outStream), json(json_), flushEachLine(true) {
         static const boost::posix_time::time_facet facet;
         out->imbue(std::locale(out->getloc(), &facet));
     }
@@ -52,9 +130,11 @@ public:
      * Constructor that accepts the name of a file where log messages will be
      * appended.
      * @param fileName The filename to send log messages to.
+     * @param json_ write messages as JSON objects
      */
-    OStreamLogSink(const std::string& fileName) :
-        fileStream(fileName.c_str(), std::ios_base::out | std::ios_base::app) {
+    OStreamLogSink(const std::string& fileName, bool json_ = false) :
+        fileStream(fileName.c_str(), std::ios_base::out | std::ios_base::app),
+        json(json_), flushEachLine(true) {
         if (!fileStream.good()) {
             out = &std::cout;
             std::cerr << "Unable to open log file: " << fileName << std::endl;
@@ -66,44 +146,63 @@ public:
     virtual
     void write(LogLevel level, const char *filename, int lineno,
                const char *functionName, const std::string& message) {
-        const char *levelStr = LEVEL_STR_DEBUG;
-        switch (level) {
-        case TRACE:   levelStr = LEVEL_STR_TRACE; break;
-        case DEBUG:   levelStr = LEVEL_STR_DEBUG; break;
-        case INFO:    levelStr = LEVEL_STR_INFO; break;
-        case WARNING: levelStr = LEVEL_STR_WARNING; break;
-        case ERROR:   levelStr = LEVEL_STR_ERROR; break;
-        case FATAL:   levelStr = LEVEL_STR_FATAL; break;
-        }
         std::lock_guard<std::mutex> lock(logMtx);
-        (*out) << "[" << boost::posix_time::microsec_clock::local_time()
-            << "] [" << levelStr << "] [" << filename << ":" << lineno << ":"
-            << functionName << "] " << message << std::endl;
+        format(boost::posix_time::microsec_clock::local_time(),
+               level, filename, lineno, functionName, message);
+    }
+
+    virtual void writeRecord(const LogRecord& r) {
+        std::lock_guard<std::mutex> lock(logMtx);
+        format(r.time, r.level, r.filename.c_str(), r.lineno,
+               r.functionName.c_str(), r.message);
+    }
+
+    virtual void flush() {
+        std::lock_guard<std::mutex> lock(logMtx);
+        out->flush();
     }
 
+    /**
+     * Leave flushing the stream to the caller of flush() instead of
+     * flushing after every message
+     */
+    void setBatched() { flushEachLine = false; }
+
 private:
+    void format(const boost::posix_time::ptime& time,
+                LogLevel level, const char *filename, int lineno,
+                const char *functionName, const std::string& message) {
+        if (json) {
+            (*out) << "{\"time\":\"" << time << "\",\"level\":\""
+                   << levelString(level) << "\",\"file\":";
+            writeJsonString(*out, filename);
+            (*out) << ",\"line\":" << lineno << ",\"function\":";
+            writeJsonString(*out, functionName);
+            (*out) << ",\"message\":";
+            writeJsonString(*out, message.c_str());
+            (*out) << "}";
+        } else {
+            (*out) << "[" << time << "] [" << levelString(level) << "] ["
+                   << filename << ":" << lineno << ":"
+                   << functionName << "] " << message;
+        }
+        if (flushEachLine)
+            (*out) << std::endl;
+        else
+            (*out) << '\n';
+    }
+
     std::fstream fileStream;
     std::ostream *out;
     std::mutex logMtx;
-    static const char * LEVEL_STR_TRACE;
-    static const char * LEVEL_STR_DEBUG;
-    static const char * LEVEL_STR_INFO;
-    static const char * LEVEL_STR_WARNING;
-    static const char * LEVEL_STR_ERROR;
-    static const char * LEVEL_STR_FATAL;
+    bool json;
+    bool flushEachLine;
 };
 
-const char * OStreamLogSink::LEVEL_STR_TRACE = "trace";
-const char * OStreamLogSink::LEVEL_STR_DEBUG = "debug";
-const char * OStreamLogSink::LEVEL_STR_INFO = "info";
-const char * OStreamLogSink::LEVEL_STR_WARNING = "warning";
-const char * OStreamLogSink::LEVEL_STR_ERROR = "error";
-const char * OStreamLogSink::LEVEL_STR_FATAL = "fatal";
-
 /**
  * Log sink to write log messages to syslog.
  */
-class SyslogLogSink : public LogSink {
+class SyslogLogSink : public RecordLogSink {
 public:
     SyslogLogSink(const std::string& name) : syslog_name(name) {
         openlog(syslog_name.c_str(), LOG_CONS | LOG_PID, LOG_DAEMON);
@@ -133,22 +232,404 @@ private:
     std::string syslog_name;
 };
 
+/** Records taken from each ring per pass of the writer thread */
+static const size_t LOG_BATCH_PER_RING = 128;
+/** How long the writer thread waits for more records */
+static const std::chrono::milliseconds LOG_WRITE_INTERVAL(10);
+
+/**
+ * Single producer, single consumer ring of log records owned by one
+ * logging thread and drained by the writer thread
+ */
+class LogRing {
+public:
+    LogRing() : closed(false), head(0), tail(0) {}
+
+    /**
+     * Add a record; called only by the owning thread
+     * @return false if the ring is full
+     */
+    bool push(LogLevel level, const char *filename, int lineno,
+              const char *functionName, const std::string& message) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= SIZE)
+            return false;
+        LogRecord& r = slots[t & (SIZE - 1)];
+        r.time = boost::posix_time::microsec_clock::local_time();
+        r.level = level;
+        r.lineno = lineno;
+        r.filename = filename;
+        r.functionName = functionName;
+        r.message = message;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the oldest record; called only by the writer thread
+     * @return false if the ring is empty
+     */
+    bool pop(LogRecord& r) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        std::swap(r, slots[h & (SIZE - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Check whether the ring is empty; called only by the writer
+     * thread
+     */
+    bool empty() const {
+        return head.load(std::memory_order_relaxed) ==
+            tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Set once the owning thread has exited
+     */
+    std::atomic<bool> closed;
+
+private:
+    static const size_t SIZE = 512;
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    LogRecord slots[SIZE];
+};
+
+/*
+ * The rings of the logging threads are shared by all asynchronous
+ * sinks, so messages queued around a sink change are written by
+ * whichever sink drains them next rather than being lost.  Only the
+ * holder of drainMutex may take records off the rings.
+ */
+static std::mutex ringMutex;
+static std::vector<std::shared_ptr<LogRing> > rings;
+static pid_t ringsPid = 0;
+
+static std::mutex drainMutex;
+static std::vector<LogRecord> drainBatch;
+static uint64_t dropsReported = 0;
+
+/*
+ * Incremented in a forked child.  A sink created before the fork has
+ * no writer thread in the child, and its own mutex and condition
+ * variable may have been held by that thread when the process forked.
+ */
+static std::atomic<unsigned> forkGeneration(0);
+
+/*
+ * Hold the ring locks across fork() so that the child does not
+ * inherit them locked by a thread that no longer exists
+ */
+static void atforkPrepare() {
+    drainMutex.lock();
+    ringMutex.lock();
+}
+
+static void atforkParent() {
+    ringMutex.unlock();
+    drainMutex.unlock();
+}
+
+static void atforkChild() {
+    ringMutex.unlock();
+    drainMutex.unlock();
+    forkGeneration++;
+}
+
+/*
+ * Forget the rings inherited from the parent; their records were
+ * queued by the parent and are written by it.  Called with ringMutex
+ * held.
+ */
+static void resetRingsAfterFork() {
+    pid_t pid = getpid();
+    if (ringsPid != pid) {
+        rings.clear();
+        ringsPid = pid;
+    }
+}
+
+struct ThreadRing {
+    pid_t pid = 0;
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRing() {
+        if (ring) ring->closed = true;
+    }
+};
+
+static LogRing* getThreadRing() {
+    static thread_local ThreadRing tr;
+    // A forked child starts over with rings of its own
+    if (!tr.ring || tr.pid != getpid()) {
+        tr.ring = std::make_shared<LogRing>();
+        tr.pid = getpid();
+        std::lock_guard<std::mutex> guard(ringMutex);
+        resetRingsAfterFork();
+        rings.push_back(tr.ring);
+    }
+    return tr.ring.get();
+}
+
+/**
+ * Log sink that queues messages on per-thread rings and writes them
+ * to the target sink from a background thread.  Logging never blocks
+ * on the log destination or on other logging threads; when a ring
+ * fills up the message is dropped and counted, and the writer
+ * reports the number of dropped messages.  Fatal messages are written
+ * synchronously after the messages queued before them.
+ */
+class AsyncLogSink : public LogSink {
+public:
+    /**
+     * Start the writer thread
+     * @param target_ the sink to write to
+     */
+    AsyncLogSink(LogSink* target_)
+        : target(target_),
+          recordTarget(dynamic_cast<RecordLogSink*>(target_)),
+          generation(forkGeneration.load()), stopped(false) {
+        static int atforkRegistered =
+            pthread_atfork(atforkPrepare, atforkParent, atforkChild);
+        (void)atforkRegistered;
+        {
+            std::lock_guard<std::mutex> guard(ringMutex);
+            resetRingsAfterFork();
+        }
+        writer = std::thread([this]() { run(); });
+    }
+
+    virtual
+    void write(LogLevel level, const char *filename, int lineno,
+               const char *functionName, const std::string& message) {
+        if (level == FATAL) {
+            std::lock_guard<std::mutex> guard(drainMutex);
+            drain();
+            target->write(level, filename, lineno, functionName, message);
+            target->flush();
+            return;
+        }
+        if (!getThreadRing()->push(level, filename, lineno,
+                                   functionName, message)) {
+            droppedLogMessages++;
+            return;
+        }
+        // Pairs with the fence in stop(): either the final drain sees
+        // this record or this thread sees that the writer is gone
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (stopped.load(std::memory_order_relaxed))
+            flush();
+        else if (level == ERROR && !inherited())
+            cond.notify_one();
+    }
+
+    virtual void flush() {
+        std::lock_guard<std::mutex> guard(drainMutex);
+        drain();
+    }
+
+    /**
+     * Stop the writer thread and write out the queued messages.
+     * Messages written to this sink afterwards are written
+     * synchronously.
+     */
+    void stop() {
+        if (inherited()) {
+            // The writer thread does not survive a fork, so there is
+            // nothing to wake or join, and mutex and cond must not be
+            // touched
+            if (stopped.exchange(true)) return;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            flush();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (stopped) return;
+            stopped = true;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond.notify_one();
+        writer.join();
+        flush();
+    }
+
+private:
+    /**
+     * Check whether this sink was created before the process forked
+     */
+    bool inherited() const {
+        return generation != forkGeneration.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Drain every ring, writing the records in time order.  Called
+     * with drainMutex held.
+     */
+    void drain() {
+        std::vector<std::shared_ptr<LogRing> > current;
+        {
+            std::lock_guard<std::mutex> guard(ringMutex);
+            resetRingsAfterFork();
+            current = rings;
+        }
+
+        while (true) {
+            drainBatch.clear();
+            for (auto& ring : current) {
+                size_t n = 0;
+                LogRecord r;
+                while (n < LOG_BATCH_PER_RING && ring->pop(r)) {
+                    drainBatch.push_back(std::move(r));
+                    n += 1;
+                }
+            }
+            if (drainBatch.empty()) break;
+
+            std::stable_sort(drainBatch.begin(), drainBatch.end(),
+                             [](const LogRecord& a, const LogRecord& b) {
+                                 return a.time < b.time;
+                             });
+            for (const LogRecord& r : drainBatch)
+                writeRecord(r);
+            target->flush();
+        }
+
+        uint64_t dropped = droppedLogMessages.load();
+        if (dropped != dropsReported) {
+            LogRecord r;
+            r.time = boost::posix_time::microsec_clock::local_time();
+            r.level = WARNING;
+            r.lineno = __LINE__;
+            r.filename = __FILE__;
+            r.functionName = __FUNCTION__;
+            r.message = "Dropped " +
+                std::to_string(dropped - dropsReported) +
+                " log messages because the log queue was full";
+            writeRecord(r);
+            target->flush();
+            dropsReported = dropped;
+        }
+
+        // Forget the rings of threads that have exited once they are
+        // empty
+        std::lock_guard<std::mutex> guard(ringMutex);
+        rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                   [](const std::shared_ptr<LogRing>& r) {
+                                       return r->closed && r->empty();
+                                   }),
+                    rings.end());
+    }
+
+    void writeRecord(const LogRecord& r) {
+        if (recordTarget)
+            recordTarget->writeRecord(r);
+        else
+            target->write(r.level, r.filename.c_str(), r.lineno,
+                          r.functionName.c_str(), r.message);
+    }
+
+    void run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(mutex);
+                if (!stopped)
+                    cond.wait_for(guard, LOG_WRITE_INTERVAL);
+                if (stopped) break;
+            }
+            flush();
+        }
+    }
+
+    LogSink* target;
+    RecordLogSink* recordTarget;
+    const unsigned generation;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> stopped;
+
+    std::thread writer;
+};
+
 static OStreamLogSink consoleLogSink(std::cout);
-static LogSink * currentLogSink = &consoleLogSink;
+static std::atomic<LogSink*> currentLogSink(&consoleLogSink);
 
 LogSink * getLogSink() {
-    return currentLogSink;
+    return currentLogSink.load(std::memory_order_acquire);
+}
+
+void setLogOutputOptions(bool async, bool json) {
+    asyncOutput = async;
+    jsonOutput = json;
+}
+
+void getLogOutputOptions(bool& async, bool& json) {
+    async = asyncOutput;
+    json = jsonOutput;
+}
+
+uint64_t getDroppedLogCount() {
+    return droppedLogMessages.load();
+}
+
+void flushLogging() {
+    getLogSink()->flush();
+}
+
+void stopLogging() {
+    AsyncLogSink* async = dynamic_cast<AsyncLogSink*>(getLogSink());
+    if (async)
+        async->stop();
+    else
+        flushLogging();
+}
+
+void setLogSink(LogSink* sink, bool async) {
+    LogSink* newSink = async ? new AsyncLogSink(sink) : sink;
+    // The previous sink is not freed since other threads may still be
+    // writing to it; an asynchronous one is drained and then writes
+    // synchronously
+    LogSink* oldSink = currentLogSink.exchange(newSink);
+    AsyncLogSink* oldAsync = dynamic_cast<AsyncLogSink*>(oldSink);
+    if (oldAsync) oldAsync->stop();
 }
 
 void initLogging(const std::string& levelstr,
                  bool toSyslog,
                  const std::string& log_file,
                  const std::string& syslog_name) {
+    static bool consoleReplaced = false;
+    RecordLogSink* sink = NULL;
+    LogSink* newSink = NULL;
     if (toSyslog) {
-        currentLogSink = new SyslogLogSink(syslog_name);
+        sink = new SyslogLogSink(syslog_name);
     } else if (!log_file.empty()) {
-        currentLogSink = new OStreamLogSink(log_file);
+        sink = new OStreamLogSink(log_file, jsonOutput);
+    } else if (asyncOutput || jsonOutput) {
+        sink = new OStreamLogSink(std::cout, jsonOutput);
+        consoleReplaced = true;
+    } else if (consoleReplaced) {
+        newSink = &consoleLogSink;
+        consoleReplaced = false;
+    }
+    if (sink) {
+        newSink = sink;
+        if (asyncOutput) {
+            OStreamLogSink* osink = dynamic_cast<OStreamLogSink*>(sink);
+            if (osink) osink->setBatched();
+            static bool stopAtExit = false;
+            if (!stopAtExit) {
+                std::atexit(stopLogging);
+                stopAtExit = true;
+            }
+        }
     }
+    if (newSink)
+        setLogSink(newSink, sink && asyncOutput);
     OFLogHandler::registerHandler(logHandler);
 
     setLoggingLevel(levelstr);
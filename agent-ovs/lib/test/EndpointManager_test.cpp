@@ -387,11 +387,20 @@ BOOST_FIXTURE_TEST_CASE( basic, EndpointFixture ) {
     BOOST_CHECK(epUuids.find(ep1.getUUID()) != epUuids.end());
     BOOST_CHECK(epUuids.find(ep2.getUUID()) != epUuids.end());
 
+    ep_set_view_t epView =
+        agent.getEndpointManager().getEndpointsForGroup(epgu);
+    BOOST_REQUIRE(epView);
+    BOOST_CHECK_EQUAL(2, epView->size());
+
     epSource.removeEndpoint(ep2.getUUID());
     epUuids.clear();
     agent.getEndpointManager().getEndpointsForGroup(epgu, epUuids);
     BOOST_CHECK_EQUAL(1, epUuids.size());
     BOOST_CHECK(epUuids.find(ep1.getUUID()) != epUuids.end());
+    // a view is not modified by later updates
+    BOOST_CHECK_EQUAL(2, epView->size());
+    BOOST_CHECK_EQUAL(1,
+        agent.getEndpointManager().getEndpointsForGroup(epgu)->size());
 
     epSource.updateEndpoint(ep2);
 
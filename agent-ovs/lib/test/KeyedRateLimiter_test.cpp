@@ -33,6 +33,30 @@ BOOST_AUTO_TEST_CASE(limit) {
     BOOST_CHECK(l.event("test"));
 }
 
+BOOST_AUTO_TEST_CASE(tokenBucket) {
+    KeyedTokenBucket<std::string> l(100, 2);
+    BOOST_CHECK(l.event("test"));
+    BOOST_CHECK(l.event("test"));
+    BOOST_CHECK_EQUAL(false, l.event("test"));
+    // other keys have their own bucket
+    BOOST_CHECK(l.event("other"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    BOOST_CHECK(l.event("test"));
+    BOOST_CHECK(l.event("test"));
+    BOOST_CHECK_EQUAL(false, l.event("test"));
+
+    // buckets that have refilled are discarded
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    BOOST_CHECK(l.event("third"));
+    BOOST_CHECK_EQUAL(1, l.size());
+
+    // a zero rate disables the limiter
+    l.setRate(0);
+    for (int i = 0; i < 10; i++)
+        BOOST_CHECK(l.event("test"));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
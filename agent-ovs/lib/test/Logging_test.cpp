@@ -0,0 +1,308 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*
+ * Test suite for asynchronous logging
+ *
+ * Copyright (c) 2020 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include <opflexagent/logging.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <rapidjson/document.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace opflexagent {
+
+BOOST_AUTO_TEST_SUITE(Logging_test)
+
+/**
+ * Sink that remembers the messages written to it and can be made to
+ * block in write()
+ */
+class TestLogSink : public LogSink {
+public:
+    TestLogSink() : blocked(false), waiting(false) {}
+
+    virtual
+    void write(LogLevel level, const char *filename, int lineno,
+               const char *functionName, const std::string& message) {
+        std::unique_lock<std::mutex> guard(mutex);
+        waiting = true;
+        cond.notify_all();
+        cond.wait(guard, [this]() { return !blocked; });
+        waiting = false;
+        messages.push_back(message);
+        levels.push_back(level);
+    }
+
+    void block() {
+        std::lock_guard<std::mutex> guard(mutex);
+        blocked = true;
+    }
+
+    void unblock() {
+        std::lock_guard<std::mutex> guard(mutex);
+        blocked = false;
+        cond.notify_all();
+    }
+
+    void waitBlocked() {
+        std::unique_lock<std::mutex> guard(mutex);
+        cond.wait(guard, [this]() { return waiting; });
+    }
+
+    size_t count(const std::string& prefix) {
+        std::lock_guard<std::mutex> guard(mutex);
+        size_t n = 0;
+        for (const std::string& m : messages) {
+            if (m.compare(0, prefix.size(), prefix) == 0)
+                n += 1;
+        }
+        return n;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool blocked;
+    bool waiting;
+    std::vector<std::string> messages;
+    std::vector<LogLevel> levels;
+};
+
+class LoggingFixture {
+public:
+    LoggingFixture() : saved(getLogSink()) {}
+
+    ~LoggingFixture() {
+        setLogSink(saved, false);
+    }
+
+    static std::string waitChild(pid_t pid) {
+        for (int i = 0; i < 500; i++) {
+            int status;
+            if (waitpid(pid, &status, WNOHANG) == pid) {
+                if (!WIFEXITED(status))
+                    return "child terminated abnormally";
+                if (WEXITSTATUS(status) != 0)
+                    return "child exited with " +
+                        std::to_string(WEXITSTATUS(status));
+                return "";
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return "child did not exit";
+    }
+
+    static void log(LogLevel level, const std::string& message) {
+        getLogSink()->write(level, __FILE__, __LINE__, __FUNCTION__,
+                            message);
+    }
+
+    LogSink* saved;
+};
+
+BOOST_FIXTURE_TEST_CASE(flush, LoggingFixture) {
+    TestLogSink sink;
+    setLogSink(&sink, true);
+
+    for (int i = 0; i < 100; i++)
+        log(INFO, "message " + std::to_string(i));
+    flushLogging();
+    BOOST_CHECK_EQUAL(100, sink.count("message "));
+    BOOST_CHECK_EQUAL("message 0", sink.messages.front());
+    BOOST_CHECK_EQUAL("message 99", sink.messages.back());
+}
+
+BOOST_FIXTURE_TEST_CASE(drops, LoggingFixture) {
+    TestLogSink sink;
+    setLogSink(&sink, true);
+    uint64_t dropped = getDroppedLogCount();
+
+    // hold the writer inside the sink so the ring cannot drain
+    sink.block();
+    log(INFO, "first");
+    sink.waitBlocked();
+
+    for (int i = 0; i < 600; i++)
+        log(INFO, "queued " + std::to_string(i));
+    BOOST_CHECK_EQUAL(88, getDroppedLogCount() - dropped);
+
+    // a fatal message is never dropped, and is written after the
+    // messages queued before it
+    std::thread fatal([]() { log(FATAL, "fatal"); });
+    sink.unblock();
+    fatal.join();
+    BOOST_CHECK_EQUAL(88, getDroppedLogCount() - dropped);
+    BOOST_CHECK_EQUAL(512, sink.count("queued "));
+    BOOST_CHECK_EQUAL("fatal", sink.messages.back());
+    BOOST_CHECK_EQUAL(FATAL, sink.levels.back());
+    BOOST_CHECK_EQUAL(1, sink.count("Dropped 88 log messages"));
+}
+
+BOOST_FIXTURE_TEST_CASE(swap, LoggingFixture) {
+    TestLogSink sink1;
+    TestLogSink sink2;
+    TestLogSink sink3;
+    uint64_t dropped = getDroppedLogCount();
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int step = 0;
+    int done = 0;
+
+    // a thread that keeps logging across sink changes
+    std::thread t([&]() {
+            std::unique_lock<std::mutex> guard(mutex);
+            for (int s = 1; s <= 3; s++) {
+                cond.wait(guard, [&]() { return step == s; });
+                for (int i = 0; i < 100; i++)
+                    log(INFO, "step" + std::to_string(s));
+                done = s;
+                cond.notify_all();
+            }
+        });
+    auto runStep = [&](int s) {
+        std::unique_lock<std::mutex> guard(mutex);
+        step = s;
+        cond.notify_all();
+        cond.wait(guard, [&]() { return done == s; });
+    };
+
+    setLogSink(&sink1, true);
+    runStep(1);
+
+    // the messages queued for the old sink are written out before
+    // the change completes
+    setLogSink(&sink2, true);
+    BOOST_CHECK_EQUAL(100, sink1.count("step1"));
+    runStep(2);
+
+    setLogSink(&sink3, false);
+    BOOST_CHECK_EQUAL(100, sink2.count("step2"));
+    runStep(3);
+    BOOST_CHECK_EQUAL(100, sink3.count("step3"));
+
+    t.join();
+    BOOST_CHECK_EQUAL(0, sink1.count("step2"));
+    BOOST_CHECK_EQUAL(0, sink2.count("step1"));
+    BOOST_CHECK_EQUAL(0, getDroppedLogCount() - dropped);
+}
+
+BOOST_FIXTURE_TEST_CASE(stop, LoggingFixture) {
+    TestLogSink sink;
+    setLogSink(&sink, true);
+
+    for (int i = 0; i < 100; i++)
+        log(INFO, "queued " + std::to_string(i));
+    stopLogging();
+    BOOST_CHECK_EQUAL(100, sink.count("queued "));
+
+    // with the writer stopped, messages are written before write()
+    // returns
+    log(INFO, "after stop");
+    BOOST_CHECK_EQUAL(1, sink.count("after stop"));
+}
+
+BOOST_FIXTURE_TEST_CASE(fork_child, LoggingFixture) {
+    TestLogSink sink;
+    setLogSink(&sink, true);
+
+    for (int i = 0; i < 20; i++) {
+        // fork while the writer thread is draining, so the child is
+        // likely to inherit the log locks held by a thread it does
+        // not have
+        for (int j = 0; j < 500; j++)
+            log(INFO, "parent " + std::to_string(j));
+        pid_t pid = fork();
+        if (pid == 0) {
+            TestLogSink childSink;
+            log(INFO, "child before");
+            setLogSink(&childSink, true);
+            log(INFO, "child after");
+            stopLogging();
+            // messages queued before the change go to the old sink,
+            // but the records the parent had queued are left to it
+            bool ok = sink.count("child before") == 1 &&
+                childSink.count("child after") == 1 &&
+                childSink.count("parent ") == 0;
+            _exit(ok ? 0 : 1);
+        }
+        BOOST_REQUIRE(pid > 0);
+        BOOST_CHECK_EQUAL("", waitChild(pid));
+    }
+
+    flushLogging();
+    BOOST_CHECK_EQUAL(0, sink.count("child"));
+}
+
+BOOST_FIXTURE_TEST_CASE(json_format, LoggingFixture) {
+    namespace fs = boost::filesystem;
+    fs::path temp(fs::temp_directory_path() / fs::unique_path());
+    std::string level = getLogLevelString();
+
+    setLogOutputOptions(false, true);
+    initLogging("info", false, temp.string());
+    LOG(INFO) << "plain";
+    LOG(WARNING) << "quote \" backslash \\ newline \n tab \t bell \a";
+    LOG(DEBUG) << "below the log level";
+    flushLogging();
+
+    setLogOutputOptions(false, false);
+    setLoggingLevel(level);
+
+    std::vector<std::string> lines;
+    {
+        fs::ifstream in(temp);
+        std::string line;
+        while (std::getline(in, line))
+            lines.push_back(line);
+    }
+    fs::remove(temp);
+    BOOST_REQUIRE_EQUAL(2, lines.size());
+
+    rapidjson::Document d;
+    d.Parse(lines[0].c_str());
+    BOOST_REQUIRE(!d.HasParseError());
+    BOOST_REQUIRE(d.IsObject());
+    BOOST_REQUIRE(d.HasMember("time") && d["time"].IsString());
+    BOOST_CHECK(d["time"].GetStringLength() > 0);
+    BOOST_REQUIRE(d.HasMember("level") && d["level"].IsString());
+    BOOST_CHECK_EQUAL("info", d["level"].GetString());
+    BOOST_REQUIRE(d.HasMember("file") && d["file"].IsString());
+    BOOST_CHECK_EQUAL(__FILE__, d["file"].GetString());
+    BOOST_REQUIRE(d.HasMember("line") && d["line"].IsInt());
+    BOOST_CHECK(d["line"].GetInt() > 0);
+    BOOST_REQUIRE(d.HasMember("function") && d["function"].IsString());
+    BOOST_CHECK_EQUAL("test_method", d["function"].GetString());
+    BOOST_REQUIRE(d.HasMember("message") && d["message"].IsString());
+    BOOST_CHECK_EQUAL("plain", d["message"].GetString());
+    BOOST_CHECK_EQUAL(6, d.MemberCount());
+
+    d.Parse(lines[1].c_str());
+    BOOST_REQUIRE(!d.HasParseError());
+    BOOST_CHECK_EQUAL("warning", d["level"].GetString());
+    BOOST_CHECK_EQUAL("quote \" backslash \\ newline \n tab \t bell \a",
+                      d["message"].GetString());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} /* namespace opflexagent */
@@ -156,4 +156,72 @@ BOOST_AUTO_TEST_CASE(test_solicited_node) {
 #undef cni
 }
 
+BOOST_AUTO_TEST_CASE(test_prefix_trie) {
+#define a address::from_string
+    PrefixTrie<int> trie;
+    BOOST_CHECK(trie.insert(a("10.0.0.0"), 8, 1));
+    BOOST_CHECK(trie.insert(a("10.1.0.0"), 16, 2));
+    BOOST_CHECK(trie.insert(a("10.1.2.0"), 24, 3));
+    BOOST_CHECK(trie.insert(a("10.1.2.0"), 24, 4));
+    BOOST_CHECK(!trie.insert(a("10.1.2.0"), 24, 4));
+    BOOST_CHECK(trie.insert(a("10.2.0.0"), 16, 5));
+    // host bits beyond the prefix are ignored
+    BOOST_CHECK(trie.insert(a("192.168.1.1"), 16, 6));
+    BOOST_CHECK(trie.insert(a("2001:db8::"), 32, 7));
+    BOOST_CHECK(trie.insert(a("::"), 0, 8));
+    BOOST_CHECK_EQUAL(8, trie.size());
+
+    std::vector<int> v;
+    BOOST_CHECK_EQUAL(24, trie.getBestMatch(a("10.1.2.3"), 32, v));
+    std::sort(v.begin(), v.end());
+    BOOST_CHECK(v == std::vector<int>({3, 4}));
+    v.clear();
+    BOOST_CHECK_EQUAL(16, trie.getBestMatch(a("10.1.3.0"), 24, v));
+    BOOST_CHECK(v == std::vector<int>({2}));
+    v.clear();
+    BOOST_CHECK_EQUAL(8, trie.getBestMatch(a("10.1.0.0"), 15, v));
+    BOOST_CHECK(v == std::vector<int>({1}));
+    v.clear();
+    BOOST_CHECK_EQUAL(16, trie.getBestMatch(a("192.168.0.0"), 16, v));
+    BOOST_CHECK(v == std::vector<int>({6}));
+    v.clear();
+    BOOST_CHECK_EQUAL(-1, trie.getBestMatch(a("11.0.0.0"), 8, v));
+    BOOST_CHECK(v.empty());
+    BOOST_CHECK_EQUAL(0, trie.getBestMatch(a("2001:db9::1"), 128, v));
+    BOOST_CHECK(v == std::vector<int>({8}));
+    v.clear();
+
+    trie.getCovered(a("10.1.0.0"), 16, v);
+    std::sort(v.begin(), v.end());
+    BOOST_CHECK(v == std::vector<int>({2, 3, 4}));
+    v.clear();
+    trie.getCovered(a("10.0.0.0"), 7, v);
+    std::sort(v.begin(), v.end());
+    BOOST_CHECK(v == std::vector<int>({1, 2, 3, 4, 5}));
+    v.clear();
+    trie.getCovered(a("::"), 0, v);
+    std::sort(v.begin(), v.end());
+    BOOST_CHECK(v == std::vector<int>({7, 8}));
+    v.clear();
+
+    BOOST_CHECK(trie.erase(a("10.1.0.0"), 16, 2));
+    BOOST_CHECK(!trie.erase(a("10.1.0.0"), 16, 2));
+    BOOST_CHECK(!trie.erase(a("10.1.2.0"), 24, 9));
+    BOOST_CHECK_EQUAL(8, trie.getBestMatch(a("10.1.3.0"), 24, v));
+    v.clear();
+    BOOST_CHECK(trie.erase(a("10.1.2.0"), 24, 3));
+    BOOST_CHECK(trie.erase(a("10.1.2.0"), 24, 4));
+    BOOST_CHECK(trie.erase(a("10.0.0.0"), 8, 1));
+    BOOST_CHECK_EQUAL(16, trie.getBestMatch(a("10.2.3.0"), 24, v));
+    BOOST_CHECK(v == std::vector<int>({5}));
+    v.clear();
+    BOOST_CHECK_EQUAL(-1, trie.getBestMatch(a("10.1.2.3"), 32, v));
+    BOOST_CHECK_EQUAL(4, trie.size());
+
+    trie.clear();
+    BOOST_CHECK_EQUAL(0, trie.size());
+    BOOST_CHECK_EQUAL(-1, trie.getBestMatch(a("2001:db8::1"), 128, v));
+#undef a
+}
+
 BOOST_AUTO_TEST_SUITE_END()
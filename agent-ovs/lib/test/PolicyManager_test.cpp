@@ -14,6 +14,7 @@
 #include <boost/assign/list_of.hpp>
 #include <modelgbp/dmtree/Root.hpp>
 #include <opflex/modb/Mutator.h>
+#include <opflex/modb/URIBuilder.h>
 #include <modelgbp/gbp/DirectionEnumT.hpp>
 
 #include <opflexagent/logging.h>
@@ -29,6 +30,7 @@ using std::mutex;
 using boost::optional;
 using opflex::modb::Mutator;
 using opflex::modb::URI;
+using opflex::modb::URIBuilder;
 
 using namespace std;
 using namespace modelgbp;
@@ -326,6 +328,57 @@ BOOST_FIXTURE_TEST_CASE( domain, PolicyFixture ) {
                      eg1->getURI(), fd->getURI()), 500);
 }
 
+static bool checkBd(PolicyManager& policyManager,
+                    const URI& egURI,
+                    const URI& domainURI) {
+    optional<shared_ptr<BridgeDomain> > rbd =
+        policyManager.getBDForGroup(egURI);
+    return rbd && rbd.get()->getURI() == domainURI;
+}
+
+BOOST_FIXTURE_TEST_CASE( domain_update, PolicyFixture ) {
+    PolicyManager& pm = agent.getPolicyManager();
+    WAIT_FOR(hasUriRef(pm, eg1->getURI(), subnetsbd1->getURI()), 500);
+    WAIT_FOR(hasUriRef(pm, eg2->getURI(), subnetseg2_1->getURI()), 500);
+
+    // subnets reach the groups through the domains referring to them
+    Mutator mutator(framework, "policyreg");
+    shared_ptr<Subnet> subnetsbd2 = subnetsbd->addGbpSubnet("subnetsbd2");
+    shared_ptr<Subnet> subnetseg2_2 =
+        subnetseg2->addGbpSubnet("subnetseg2_2");
+    mutator.commit();
+    WAIT_FOR(hasUriRef(pm, eg1->getURI(), subnetsbd2->getURI()), 500);
+    WAIT_FOR(hasUriRef(pm, eg2->getURI(), subnetseg2_2->getURI()), 500);
+    BOOST_CHECK(!hasUriRef(pm, eg2->getURI(), subnetsbd2->getURI()));
+    BOOST_CHECK(!hasUriRef(pm, eg1->getURI(), subnetseg2_2->getURI()));
+
+    subnetsbd2->remove();
+    subnetseg2_2->remove();
+    mutator.commit();
+    WAIT_FOR(!hasUriRef(pm, eg1->getURI(), subnetsbd2->getURI()), 500);
+    WAIT_FOR(!hasUriRef(pm, eg2->getURI(), subnetseg2_2->getURI()), 500);
+
+    // a domain that appears after the group referring to it
+    URI bd2URI = URIBuilder(space->getURI())
+        .addElement("GbpBridgeDomain").addElement("bd2").build();
+    eg3->addGbpEpGroupToNetworkRSrc()->setTargetBridgeDomain(bd2URI);
+    mutator.commit();
+    WAIT_FOR(pm.groupExists(eg3->getURI()), 500);
+    BOOST_CHECK(!pm.getBDForGroup(eg3->getURI()));
+
+    shared_ptr<BridgeDomain> bd2 = space->addGbpBridgeDomain("bd2");
+    bd2->addGbpBridgeDomainToNetworkRSrc()
+        ->setTargetRoutingDomain(rd->getURI());
+    mutator.commit();
+    WAIT_FOR(checkBd(pm, eg3->getURI(), bd2URI), 500);
+    WAIT_FOR(hasUriRef(pm, eg3->getURI(), subnetsrd1->getURI()), 500);
+    BOOST_CHECK(checkBd(pm, eg1->getURI(), bd->getURI()));
+
+    bd2->remove();
+    mutator.commit();
+    WAIT_FOR(!pm.getBDForGroup(eg3->getURI()), 500);
+}
+
 BOOST_FIXTURE_TEST_CASE( group, PolicyFixture ) {
     PolicyManager& pm = agent.getPolicyManager();
     WAIT_FOR(pm.groupExists(eg1->getURI()), 500);
@@ -489,6 +542,10 @@ BOOST_FIXTURE_TEST_CASE( contract_rules, PolicyFixture ) {
                    (classifier4)(classifier5),
                    list_of(true)(true)(true)(true)(true)(false),
                    DirectionEnumT::CONST_IN));
+    PolicyManager::rule_snapshot_t snapshot =
+        pm.getContractRuleSnapshot(con1->getURI());
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK_EQUAL(6, snapshot->getRules().size());
 
     /*
      *  remove classifier2 & subject2
@@ -515,6 +572,14 @@ BOOST_FIXTURE_TEST_CASE( contract_rules, PolicyFixture ) {
                            (classifier1)(classifier5),
                            list_of(true)(true)(true)(false),
                            DirectionEnumT::CONST_IN));
+
+    // the earlier snapshot is unaffected by the update
+    BOOST_CHECK_EQUAL(6, snapshot->getRules().size());
+    PolicyManager::rule_snapshot_t updated =
+        pm.getContractRuleSnapshot(con1->getURI());
+    BOOST_REQUIRE(updated);
+    BOOST_CHECK_EQUAL(4, updated->getRules().size());
+    BOOST_CHECK(updated->getVersion() > snapshot->getVersion());
 }
 
 BOOST_FIXTURE_TEST_CASE( nat_rd_update, PolicyFixture ) {
@@ -631,6 +696,171 @@ BOOST_FIXTURE_TEST_CASE( group_contract_remove_add, PolicyFixture ) {
     BOOST_CHECK(rules.size() == 0);
 }
 
+/*
+ * Wait until all the contract updates queued so far have been
+ * processed by computing the rules of a new contract
+ */
+static void settleContracts(Mutator& mutator, PolicyManager& pm,
+                            shared_ptr<policy::Space>& space,
+                            const string& name) {
+    shared_ptr<Contract> sentinel = space->addGbpContract(name);
+    sentinel->addGbpSubject("subject")->addGbpRule("rule")
+        ->setDirection(DirectionEnumT::CONST_IN);
+    mutator.commit();
+    WAIT_FOR(pm.getContractRuleSnapshot(sentinel->getURI()), 500);
+}
+
+static uint64_t contractVersion(PolicyManager& pm, const URI& uri) {
+    PolicyManager::rule_snapshot_t rules = pm.getContractRuleSnapshot(uri);
+    return rules ? rules->getVersion() : 0;
+}
+
+static uint64_t secGroupVersion(PolicyManager& pm, const URI& uri) {
+    PolicyManager::rule_snapshot_t rules = pm.getSecGroupRuleSnapshot(uri);
+    return rules ? rules->getVersion() : 0;
+}
+
+BOOST_FIXTURE_TEST_CASE( contract_classifier_deps, PolicyFixture ) {
+    PolicyManager& pm = agent.getPolicyManager();
+    PolicyManager::rule_list_t rules;
+    WAIT_FOR_DO(rules.size() == 6, 500,
+        rules.clear(); pm.getContractRules(con1->getURI(), rules));
+    WAIT_FOR(pm.getContractRuleSnapshot(con2->getURI()), 500);
+    WAIT_FOR(pm.getContractRuleSnapshot(con3->getURI()), 500);
+    Mutator mutator(framework, "policyreg");
+    settleContracts(mutator, pm, space, "sentinel");
+
+    MockListener listener(pm);
+    uint64_t version1 = contractVersion(pm, con1->getURI());
+    uint64_t version2 = contractVersion(pm, con2->getURI());
+    uint64_t version3 = contractVersion(pm, con3->getURI());
+
+    // classifier5 is only used by contract1
+    classifier5->setProt(6);
+    mutator.commit();
+    WAIT_FOR(contractVersion(pm, con1->getURI()) > version1, 500);
+    settleContracts(mutator, pm, space, "sentinel2");
+
+    rules.clear();
+    pm.getContractRules(con1->getURI(), rules);
+    bool found = false;
+    for (const shared_ptr<PolicyRule>& rule : rules) {
+        if (rule->getL24Classifier()->getURI() == classifier5->getURI()) {
+            BOOST_CHECK_EQUAL(6, rule->getL24Classifier()->getProt(0));
+            found = true;
+        }
+    }
+    BOOST_CHECK(found);
+    BOOST_CHECK(listener.hasNotif(con1->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con2->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con3->getURI()));
+    BOOST_CHECK_EQUAL(version2, contractVersion(pm, con2->getURI()));
+    BOOST_CHECK_EQUAL(version3, contractVersion(pm, con3->getURI()));
+
+    // classifier1 is used by all three contracts
+    version1 = contractVersion(pm, con1->getURI());
+    classifier1->setProt(17);
+    mutator.commit();
+    WAIT_FOR(contractVersion(pm, con1->getURI()) > version1, 500);
+    WAIT_FOR(contractVersion(pm, con2->getURI()) > version2, 500);
+    WAIT_FOR(contractVersion(pm, con3->getURI()) > version3, 500);
+    BOOST_CHECK(listener.hasNotif(con2->getURI()));
+    BOOST_CHECK(listener.hasNotif(con3->getURI()));
+}
+
+BOOST_FIXTURE_TEST_CASE( unrelated_subject_deps, PolicyFixture ) {
+    PolicyManager& pm = agent.getPolicyManager();
+    WAIT_FOR(pm.getContractRuleSnapshot(con1->getURI()), 500);
+    WAIT_FOR(pm.getContractRuleSnapshot(con2->getURI()), 500);
+    WAIT_FOR(pm.getContractRuleSnapshot(con3->getURI()), 500);
+
+    Mutator mutator(framework, "policyreg");
+    shared_ptr<SecGroup> secGrp = space->addGbpSecGroup("secgrp1");
+    shared_ptr<SecGroupRule> sgRule =
+        secGrp->addGbpSecGroupSubject("sg_subject1")
+        ->addGbpSecGroupRule("sg_rule1");
+    sgRule->setDirection(DirectionEnumT::CONST_IN)
+        .addGbpRuleToClassifierRSrc(classifier7->getURI().toString());
+    mutator.commit();
+    WAIT_FOR(pm.getSecGroupRuleSnapshot(secGrp->getURI()), 500);
+    settleContracts(mutator, pm, space, "sentinel");
+
+    MockListener listener(pm);
+    uint64_t version1 = contractVersion(pm, con1->getURI());
+    uint64_t version2 = contractVersion(pm, con2->getURI());
+    uint64_t version3 = contractVersion(pm, con3->getURI());
+    uint64_t sgVersion = secGroupVersion(pm, secGrp->getURI());
+
+    // a security group subject does not affect any contract
+    sgRule->setDirection(DirectionEnumT::CONST_OUT);
+    mutator.commit();
+    WAIT_FOR(secGroupVersion(pm, secGrp->getURI()) > sgVersion, 500);
+    settleContracts(mutator, pm, space, "sentinel2");
+    BOOST_CHECK(!listener.hasNotif(con1->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con2->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con3->getURI()));
+    BOOST_CHECK_EQUAL(version1, contractVersion(pm, con1->getURI()));
+    BOOST_CHECK_EQUAL(version2, contractVersion(pm, con2->getURI()));
+    BOOST_CHECK_EQUAL(version3, contractVersion(pm, con3->getURI()));
+
+    // a subject of contract2 only affects contract2
+    con2->addGbpSubject("2_subject1")->addGbpRule("2_1_rule1")
+        ->setDirection(DirectionEnumT::CONST_BIDIRECTIONAL);
+    mutator.commit();
+    WAIT_FOR(contractVersion(pm, con2->getURI()) > version2, 500);
+    settleContracts(mutator, pm, space, "sentinel3");
+    BOOST_CHECK(listener.hasNotif(con2->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con1->getURI()));
+    BOOST_CHECK(!listener.hasNotif(con3->getURI()));
+    BOOST_CHECK_EQUAL(version1, contractVersion(pm, con1->getURI()));
+    BOOST_CHECK_EQUAL(version3, contractVersion(pm, con3->getURI()));
+}
+
+BOOST_FIXTURE_TEST_CASE( contract_remove_recreate_rules, PolicyFixture ) {
+    PolicyManager& pm = agent.getPolicyManager();
+    PolicyManager::rule_list_t rules;
+    WAIT_FOR_DO(rules.size() == 1, 500,
+        rules.clear(); pm.getContractRules(con2->getURI(), rules));
+
+    // remove the contract and its rules, but keep the group references
+    Mutator mutator(framework, "policyreg");
+    con2->addGbpSubject("2_subject1")->remove();
+    con2->remove();
+    mutator.commit();
+    WAIT_FOR(!pm.getContractRuleSnapshot(con2->getURI()), 500);
+    BOOST_CHECK(pm.contractExists(con2->getURI()));
+
+    // changes to the old classifier no longer affect the contract
+    MockListener listener(pm);
+    classifier1->setProt(6);
+    mutator.commit();
+    WAIT_FOR(listener.hasNotif(con1->getURI()), 500);
+    settleContracts(mutator, pm, space, "sentinel");
+    BOOST_CHECK(!listener.hasNotif(con2->getURI()));
+    BOOST_CHECK(!pm.getContractRuleSnapshot(con2->getURI()));
+
+    // recreating the contract restores its rules and dependencies
+    con2 = space->addGbpContract("contract2");
+    con2->addGbpSubject("2_subject1")->addGbpRule("2_1_rule1")
+        ->setDirection(DirectionEnumT::CONST_OUT)
+        .addGbpRuleToClassifierRSrc(classifier1->getURI().toString());
+    mutator.commit();
+    rules.clear();
+    WAIT_FOR_DO(rules.size() == 1, 500,
+        rules.clear(); pm.getContractRules(con2->getURI(), rules));
+    BOOST_CHECK(checkRules(rules, list_of(classifier1), list_of(true),
+                           DirectionEnumT::CONST_OUT));
+
+    uint64_t version2 = contractVersion(pm, con2->getURI());
+    classifier1->setProt(17);
+    mutator.commit();
+    WAIT_FOR(contractVersion(pm, con2->getURI()) > version2, 500);
+    rules.clear();
+    WAIT_FOR_DO(!rules.empty() &&
+                rules.front()->getL24Classifier()->getProt(0) == 17, 500,
+        rules.clear(); pm.getContractRules(con2->getURI(), rules));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } /* namespace opflexagent */
@@ -12,7 +12,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/assign/list_of.hpp>
 
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 
 using namespace opflexagent;
 using namespace std;
@@ -11,9 +11,9 @@
 #include "FlowBuilder.h"
 #include "FlowUtils.h"
 #include "FlowConstants.h"
-#include "RangeMask.h"
 #include "eth.h"
 #include <opflexagent/logging.h>
+#include <opflexagent/RangeMask.h>
 
 #include <boost/algorithm/string/find_iterator.hpp>
 #include <boost/algorithm/string/finder.hpp>
@@ -23,6 +23,7 @@
 #include <modelgbp/gbp/DirectionEnumT.hpp>
 #include <modelgbp/gbp/ConnTrackEnumT.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -42,10 +43,11 @@ using boost::copy_range;
 using boost::optional;
 
 static const char* ID_NAMESPACES[] =
-    {"secGroup", "secGroupSet"};
+    {"secGroup", "secGroupSet", "secGroupConj"};
 
-static const char* ID_NMSPC_SECGROUP     = ID_NAMESPACES[0];
-static const char* ID_NMSPC_SECGROUP_SET = ID_NAMESPACES[1];
+static const char* ID_NMSPC_SECGROUP      = ID_NAMESPACES[0];
+static const char* ID_NMSPC_SECGROUP_SET  = ID_NAMESPACES[1];
+static const char* ID_NMSPC_SECGROUP_CONJ = ID_NAMESPACES[2];
 
 void AccessFlowManager::populateTableDescriptionMap(
         SwitchManager::TableDescriptionMap &fwdTblDescr) {
@@ -69,7 +71,8 @@ AccessFlowManager::AccessFlowManager(Agent& agent_,
                                      CtZoneManager& ctZoneManager_)
     : agent(agent_), switchManager(switchManager_), idGen(idGen_),
       ctZoneManager(ctZoneManager_), taskQueue(agent.getAgentIOService()),
-      conntrackEnabled(false), stopping(false), dropLogRemotePort(0) {
+      conntrackEnabled(false), secGroupConjunction(false), stopping(false),
+      dropLogRemotePort(0) {
     // set up flow tables
     switchManager.setMaxFlowTables(NUM_FLOW_TABLES);
     SwitchManager::TableDescriptionMap fwdTblDescr;
@@ -92,6 +95,10 @@ void AccessFlowManager::enableConnTrack() {
     conntrackEnabled = true;
 }
 
+void AccessFlowManager::enableSecGroupConjunction() {
+    secGroupConjunction = true;
+}
+
 void AccessFlowManager::start() {
     switchManager.getPortMapper().registerPortStatusListener(this);
     agent.getEndpointManager().registerListener(this);
@@ -556,23 +563,21 @@ void AccessFlowManager::handlePortStatusUpdate(const string& portName,
 void AccessFlowManager::handleSecGrpUpdate(const opflex::modb::URI& uri) {
     unordered_set<uri_set_t> secGrpSets;
     agent.getEndpointManager().getSecGrpSetsForSecGrp(uri, secGrpSets);
+    if (secGroupConjunction) {
+        // Recompile the group once; the sets only need their
+        // conjunction IDs refreshed
+        std::lock_guard<std::mutex> guard(secGrpConjMutex);
+        if (secGrpSets.empty())
+            removeSecGrpConj(uri);
+        else
+            updateSecGrpConj(uri);
+    }
     for (const uri_set_t& secGrpSet : secGrpSets)
         secGroupSetUpdated(secGrpSet);
 }
 
 void AccessFlowManager::handleSecGrpSetUpdate(const uri_set_t& secGrps,
                                               const string& secGrpsIdStr) {
-    using modelgbp::gbpe::L24Classifier;
-    using modelgbp::gbp::DirectionEnumT;
-    using modelgbp::gbp::ConnTrackEnumT;
-    using flowutils::CA_REFLEX_REV_ALLOW;
-    using flowutils::CA_REFLEX_REV_TRACK;
-    using flowutils::CA_REFLEX_FWD;
-    using flowutils::CA_ALLOW;
-    using flowutils::CA_REFLEX_FWD_TRACK;
-    using flowutils::CA_REFLEX_FWD_EST;
-    using flowutils::CA_REFLEX_REV_RELATED;
-
     LOG(DEBUG) << "Updating security group set \"" << secGrpsIdStr << "\"";
 
     if (agent.getEndpointManager().secGrpSetEmpty(secGrps)) {
@@ -581,193 +586,361 @@ void AccessFlowManager::handleSecGrpSetUpdate(const uri_set_t& secGrps,
         return;
     }
 
+    if (secGroupConjunction) {
+        handleSecGrpSetConjUpdate(secGrps, secGrpsIdStr);
+        return;
+    }
+
     uint32_t secGrpSetId = idGen.getId(ID_NMSPC_SECGROUP_SET, secGrpsIdStr);
 
     FlowEntryList secGrpIn;
     FlowEntryList secGrpOut;
 
     for (const opflex::modb::URI& secGrp : secGrps) {
-        PolicyManager::rule_list_t rules;
-        agent.getPolicyManager().getSecGroupRules(secGrp, rules);
-
-        for (shared_ptr<PolicyRule>& pc : rules) {
-            uint8_t dir = pc->getDirection();
-            bool skipL34 = false;
-            const shared_ptr<L24Classifier>& cls = pc->getL24Classifier();
-            const URI& ruleURI = cls.get()->getURI();
-            uint64_t secGrpCookie =
-                idGen.getId("l24classifierRule", ruleURI.toString());
-            boost::optional<const network::subnets_t&> remoteSubs;
-            if (!pc->getRemoteSubnets().empty()) {
-                remoteSubs = pc->getRemoteSubnets();
-            } else {
-                skipL34 = !agent.addL34FlowsWithoutSubnet();
-                LOG(DEBUG) << "skipL34 flows: " << skipL34
-                           << " for rule: " << ruleURI;
-            }
+        buildSecGrpRules(secGrp, secGrpSetId, secGrpIn, secGrpOut);
+    }
 
-            flowutils::ClassAction act = flowutils::CA_DENY;
-            if (pc->getAllow()) {
-                if (cls->getConnectionTracking(ConnTrackEnumT::CONST_NORMAL) ==
-                    ConnTrackEnumT::CONST_REFLEXIVE) {
-                    act = CA_REFLEX_FWD;
-                } else {
-                    act = CA_ALLOW;
-                }
-            }
+    switchManager.writeFlow(secGrpsIdStr, SEC_GROUP_IN_TABLE_ID, secGrpIn);
+    switchManager.writeFlow(secGrpsIdStr, SEC_GROUP_OUT_TABLE_ID, secGrpOut);
+}
 
-            /*
-             * Do not program higher level protocols
-             * when remote subnet is missing
-             * except when agent.addL34FlowsWithoutSubnet() == true
-             */
-            if (skipL34) {
-                if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
-                    dir == DirectionEnumT::CONST_IN) {
-                    flowutils::add_l2classifier_entries(*cls, act,
-                                                        OUT_TABLE_ID,
-                                                        pc->getPriority(),
-                                                        OFPUTIL_FF_SEND_FLOW_REM,
-                                                        secGrpCookie,
-                                                        secGrpSetId, 0,
-                                                        secGrpIn);
-                }
-                if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
-                    dir == DirectionEnumT::CONST_OUT) {
-                    flowutils::add_l2classifier_entries(*cls, act,
-                                                        OUT_TABLE_ID,
-                                                        pc->getPriority(),
-                                                        OFPUTIL_FF_SEND_FLOW_REM,
-                                                        secGrpCookie,
-                                                        secGrpSetId, 0,
-                                                        secGrpOut);
-                }
-                continue;
+void AccessFlowManager::buildSecGrpRules(const URI& secGrp,
+                                         uint32_t secGrpSetId,
+                                         FlowEntryList& secGrpIn,
+                                         FlowEntryList& secGrpOut) {
+    using modelgbp::gbpe::L24Classifier;
+    using modelgbp::gbp::DirectionEnumT;
+    using modelgbp::gbp::ConnTrackEnumT;
+    using flowutils::CA_REFLEX_REV_ALLOW;
+    using flowutils::CA_REFLEX_REV_TRACK;
+    using flowutils::CA_REFLEX_FWD;
+    using flowutils::CA_ALLOW;
+    using flowutils::CA_REFLEX_FWD_TRACK;
+    using flowutils::CA_REFLEX_FWD_EST;
+    using flowutils::CA_REFLEX_REV_RELATED;
+
+    PolicyManager::rule_snapshot_t rules =
+        agent.getPolicyManager().getSecGroupRuleSnapshot(secGrp);
+    if (!rules)
+        return;
+
+    for (const shared_ptr<PolicyRule>& pc : rules->getRules()) {
+        uint8_t dir = pc->getDirection();
+        bool skipL34 = false;
+        const shared_ptr<L24Classifier>& cls = pc->getL24Classifier();
+        const URI& ruleURI = cls.get()->getURI();
+        uint64_t secGrpCookie =
+            idGen.getId("l24classifierRule", ruleURI.toString());
+        boost::optional<const network::subnets_t&> remoteSubs;
+        if (!pc->getRemoteSubnets().empty()) {
+            remoteSubs = pc->getRemoteSubnets();
+        } else {
+            skipL34 = !agent.addL34FlowsWithoutSubnet();
+            LOG(DEBUG) << "skipL34 flows: " << skipL34
+                       << " for rule: " << ruleURI;
+        }
+
+        flowutils::ClassAction act = flowutils::CA_DENY;
+        if (pc->getAllow()) {
+            if (cls->getConnectionTracking(ConnTrackEnumT::CONST_NORMAL) ==
+                ConnTrackEnumT::CONST_REFLEXIVE) {
+                act = CA_REFLEX_FWD;
+            } else {
+                act = CA_ALLOW;
             }
+        }
 
+        /*
+         * Do not program higher level protocols
+         * when remote subnet is missing
+         * except when agent.addL34FlowsWithoutSubnet() == true
+         */
+        if (skipL34) {
             if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
                 dir == DirectionEnumT::CONST_IN) {
-                flowutils::add_classifier_entries(*cls, act,
+                flowutils::add_l2classifier_entries(*cls, act,
+                                                    OUT_TABLE_ID,
+                                                    pc->getPriority(),
+                                                    OFPUTIL_FF_SEND_FLOW_REM,
+                                                    secGrpCookie,
+                                                    secGrpSetId, 0,
+                                                    secGrpIn);
+            }
+            if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
+                dir == DirectionEnumT::CONST_OUT) {
+                flowutils::add_l2classifier_entries(*cls, act,
+                                                    OUT_TABLE_ID,
+                                                    pc->getPriority(),
+                                                    OFPUTIL_FF_SEND_FLOW_REM,
+                                                    secGrpCookie,
+                                                    secGrpSetId, 0,
+                                                    secGrpOut);
+            }
+            continue;
+        }
+
+        if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
+            dir == DirectionEnumT::CONST_IN) {
+            flowutils::add_classifier_entries(*pc, act,
+                                              remoteSubs,
+                                              boost::none,
+                                              OUT_TABLE_ID,
+                                              OFPUTIL_FF_SEND_FLOW_REM,
+                                              secGrpCookie,
+                                              secGrpSetId, 0,
+                                              secGrpIn);
+            if (act == CA_REFLEX_FWD) {
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_FWD_TRACK,
+                                                  remoteSubs,
+                                                  boost::none,
+                                                  GROUP_MAP_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpIn);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_FWD_EST,
                                                   remoteSubs,
                                                   boost::none,
                                                   OUT_TABLE_ID,
-                                                  pc->getPriority(),
                                                   OFPUTIL_FF_SEND_FLOW_REM,
                                                   secGrpCookie,
                                                   secGrpSetId, 0,
                                                   secGrpIn);
-                if (act == CA_REFLEX_FWD) {
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_FWD_TRACK,
-                                                      remoteSubs,
-                                                      boost::none,
-                                                      GROUP_MAP_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpIn);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_FWD_EST,
-                                                      remoteSubs,
-                                                      boost::none,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpIn);
-                    // add reverse entries for reflexive classifier
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_TRACK,
-                                                      boost::none,
-                                                      remoteSubs,
-                                                      GROUP_MAP_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      0,
-                                                      secGrpSetId, 0,
-                                                      secGrpOut);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_ALLOW,
-                                                      boost::none,
-                                                      remoteSubs,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpOut);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_RELATED,
-                                                      boost::none,
-                                                      remoteSubs,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpOut);
-                }
+                // add reverse entries for reflexive classifier
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_TRACK,
+                                                  boost::none,
+                                                  remoteSubs,
+                                                  GROUP_MAP_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  0,
+                                                  secGrpSetId, 0,
+                                                  secGrpOut);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_ALLOW,
+                                                  boost::none,
+                                                  remoteSubs,
+                                                  OUT_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpOut);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_RELATED,
+                                                  boost::none,
+                                                  remoteSubs,
+                                                  OUT_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpOut);
             }
-            if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
-                dir == DirectionEnumT::CONST_OUT) {
-                flowutils::add_classifier_entries(*cls, act,
+        }
+        if (dir == DirectionEnumT::CONST_BIDIRECTIONAL ||
+            dir == DirectionEnumT::CONST_OUT) {
+            flowutils::add_classifier_entries(*pc, act,
+                                              boost::none,
+                                              remoteSubs,
+                                              OUT_TABLE_ID,
+                                              OFPUTIL_FF_SEND_FLOW_REM,
+                                              secGrpCookie,
+                                              secGrpSetId, 0,
+                                              secGrpOut);
+            if (act == CA_REFLEX_FWD) {
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_FWD_TRACK,
+                                                  boost::none,
+                                                  remoteSubs,
+                                                  GROUP_MAP_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpOut);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_FWD_EST,
                                                   boost::none,
                                                   remoteSubs,
                                                   OUT_TABLE_ID,
-                                                  pc->getPriority(),
                                                   OFPUTIL_FF_SEND_FLOW_REM,
                                                   secGrpCookie,
                                                   secGrpSetId, 0,
                                                   secGrpOut);
-                if (act == CA_REFLEX_FWD) {
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_FWD_TRACK,
-                                                      boost::none,
-                                                      remoteSubs,
-                                                      GROUP_MAP_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpOut);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_FWD_EST,
-                                                      boost::none,
-                                                      remoteSubs,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpOut);
-                    // add reverse entries for reflexive classifier
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_TRACK,
-                                                      remoteSubs,
-                                                      boost::none,
-                                                      GROUP_MAP_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      0,
-                                                      secGrpSetId, 0,
-                                                      secGrpIn);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_ALLOW,
-                                                      remoteSubs,
-                                                      boost::none,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpIn);
-                    flowutils::add_classifier_entries(*cls, CA_REFLEX_REV_RELATED,
-                                                      remoteSubs,
-                                                      boost::none,
-                                                      OUT_TABLE_ID,
-                                                      pc->getPriority(),
-                                                      OFPUTIL_FF_SEND_FLOW_REM,
-                                                      secGrpCookie,
-                                                      secGrpSetId, 0,
-                                                      secGrpIn);
-                }
+                // add reverse entries for reflexive classifier
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_TRACK,
+                                                  remoteSubs,
+                                                  boost::none,
+                                                  GROUP_MAP_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  0,
+                                                  secGrpSetId, 0,
+                                                  secGrpIn);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_ALLOW,
+                                                  remoteSubs,
+                                                  boost::none,
+                                                  OUT_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpIn);
+                flowutils::add_classifier_entries(*pc, CA_REFLEX_REV_RELATED,
+                                                  remoteSubs,
+                                                  boost::none,
+                                                  OUT_TABLE_ID,
+                                                  OFPUTIL_FF_SEND_FLOW_REM,
+                                                  secGrpCookie,
+                                                  secGrpSetId, 0,
+                                                  secGrpIn);
+            }
+        }
+    }
+}
+
+static string getConjClauseKey(uint8_t tableId, const FlowEntry& fe) {
+    std::stringstream ss;
+    ss << "conj:" << (int)tableId << ":" << fe.entry->priority
+       << ":" << fe.entry->match;
+    return ss.str();
+}
+
+void AccessFlowManager::writeConjClause(const string& clauseKey) {
+    auto it = conjClauseMap.find(clauseKey);
+    if (it == conjClauseMap.end())
+        return;
+    uint8_t tableId = it->second.match->entry->table_id;
+    if (it->second.members.empty()) {
+        switchManager.clearFlows(clauseKey, tableId);
+        conjClauseMap.erase(it);
+        return;
+    }
+
+    vector<uint32_t> conjIds;
+    for (const auto& m : it->second.members)
+        conjIds.insert(conjIds.end(), m.second.begin(), m.second.end());
+    std::sort(conjIds.begin(), conjIds.end());
+    switchManager.writeFlow(clauseKey, tableId,
+                            flowutils::conjunction_clause(*it->second.match,
+                                                          conjIds, 2, 2));
+}
+
+void AccessFlowManager::updateSecGrpConj(const URI& secGrp) {
+    LOG(DEBUG) << "Compiling security group " << secGrp;
+
+    FlowEntryList secGrpIn;
+    FlowEntryList secGrpOut;
+    buildSecGrpRules(secGrp, 0, secGrpIn, secGrpOut);
+
+    const string& secGrpStr = secGrp.toString();
+    const string objId = "secgrp:" + secGrpStr;
+    SecGrpConj compiled;
+    FlowEntryList conjIn;
+    FlowEntryList conjOut;
+    // Conjunction IDs are keyed by the rule that produced the flow
+    // (table, priority and classifier cookie) and the index of the
+    // flow among those of that rule, so adding or removing a rule
+    // doesn't renumber the conjunctions of the other rules
+    std::unordered_map<string, size_t> ruleFlows;
+    for (uint8_t tableId : {SEC_GROUP_IN_TABLE_ID, SEC_GROUP_OUT_TABLE_ID}) {
+        FlowEntryList& rules =
+            (tableId == SEC_GROUP_IN_TABLE_ID) ? secGrpIn : secGrpOut;
+        FlowEntryList& conjFlows =
+            (tableId == SEC_GROUP_IN_TABLE_ID) ? conjIn : conjOut;
+        for (FlowEntryPtr& fe : rules) {
+            fe->entry->table_id = tableId;
+            std::stringstream rs;
+            rs << secGrpStr << "#" << (int)tableId << ":"
+               << fe->entry->priority << ":" << fe->entry->cookie;
+            const string ruleKey = rs.str();
+            const string idKey =
+                ruleKey + ":" + std::to_string(ruleFlows[ruleKey]++);
+            uint32_t conjId = idGen.getId(ID_NMSPC_SECGROUP_CONJ, idKey);
+            compiled.idKeys.insert(idKey);
+            compiled.conjIds[std::make_pair(tableId, fe->entry->priority)]
+                .push_back(conjId);
+
+            const string clauseKey = getConjClauseKey(tableId, *fe);
+            ConjClause& clause = conjClauseMap[clauseKey];
+            if (!clause.match)
+                clause.match = fe;
+            if (compiled.clauses.insert(clauseKey).second)
+                clause.members[secGrp].clear();
+            clause.members[secGrp].push_back(conjId);
+
+            conjFlows.push_back(flowutils::conjunction_action(*fe, conjId));
+        }
+    }
+
+    // Drop this group from clauses it no longer contributes to
+    SecGrpConj& existing = secGrpConjMap[secGrp];
+    for (const string& clauseKey : existing.clauses) {
+        if (compiled.clauses.find(clauseKey) != compiled.clauses.end())
+            continue;
+        auto it = conjClauseMap.find(clauseKey);
+        if (it != conjClauseMap.end())
+            it->second.members.erase(secGrp);
+    }
+
+    switchManager.writeFlow(objId, SEC_GROUP_IN_TABLE_ID, conjIn);
+    switchManager.writeFlow(objId, SEC_GROUP_OUT_TABLE_ID, conjOut);
+    for (const string& clauseKey : compiled.clauses)
+        writeConjClause(clauseKey);
+    for (const string& clauseKey : existing.clauses) {
+        if (compiled.clauses.find(clauseKey) == compiled.clauses.end())
+            writeConjClause(clauseKey);
+    }
+    for (const string& idKey : existing.idKeys) {
+        if (compiled.idKeys.find(idKey) == compiled.idKeys.end())
+            idGen.erase(ID_NMSPC_SECGROUP_CONJ, idKey);
+    }
+
+    existing = std::move(compiled);
+}
+
+void AccessFlowManager::removeSecGrpConj(const URI& secGrp) {
+    auto it = secGrpConjMap.find(secGrp);
+    if (it == secGrpConjMap.end())
+        return;
+
+    LOG(DEBUG) << "Removing compiled security group " << secGrp;
+    const string objId = "secgrp:" + secGrp.toString();
+    switchManager.clearFlows(objId, SEC_GROUP_IN_TABLE_ID);
+    switchManager.clearFlows(objId, SEC_GROUP_OUT_TABLE_ID);
+    for (const string& clauseKey : it->second.clauses) {
+        auto cit = conjClauseMap.find(clauseKey);
+        if (cit == conjClauseMap.end())
+            continue;
+        cit->second.members.erase(secGrp);
+        writeConjClause(clauseKey);
+    }
+    for (const string& idKey : it->second.idKeys)
+        idGen.erase(ID_NMSPC_SECGROUP_CONJ, idKey);
+    secGrpConjMap.erase(it);
+}
+
+void AccessFlowManager::handleSecGrpSetConjUpdate(const uri_set_t& secGrps,
+                                                  const string& secGrpsIdStr) {
+    uint32_t secGrpSetId = idGen.getId(ID_NMSPC_SECGROUP_SET, secGrpsIdStr);
+
+    conj_prio_map_t setConjIds;
+    {
+        std::lock_guard<std::mutex> guard(secGrpConjMutex);
+        for (const URI& secGrp : secGrps) {
+            if (secGrpConjMap.find(secGrp) == secGrpConjMap.end())
+                updateSecGrpConj(secGrp);
+            for (const auto& p : secGrpConjMap[secGrp].conjIds) {
+                vector<uint32_t>& ids = setConjIds[p.first];
+                ids.insert(ids.end(), p.second.begin(), p.second.end());
             }
         }
     }
 
+    FlowEntryList secGrpIn;
+    FlowEntryList secGrpOut;
+
+    for (auto& p : setConjIds) {
+        std::sort(p.second.begin(), p.second.end());
+        FlowBuilder f;
+        f.priority(p.first.second).reg(0, secGrpSetId);
+        for (uint32_t conjId : p.second)
+            f.action().conjunction(conjId, 1, 2);
+        f.build((p.first.first == SEC_GROUP_IN_TABLE_ID)
+                ? secGrpIn : secGrpOut);
+    }
+
     switchManager.writeFlow(secGrpsIdStr, SEC_GROUP_IN_TABLE_ID, secGrpIn);
     switchManager.writeFlow(secGrpsIdStr, SEC_GROUP_OUT_TABLE_ID, secGrpOut);
 }
@@ -783,10 +956,12 @@ void AccessFlowManager::lbIfaceUpdated(const std::string& uuid) {
 
     if (iface->getInterfaceName()) {
         EndpointManager& epMgr = agent.getEndpointManager();
-        std::unordered_set<std::string> epUuids;
-        epMgr.getEndpointsByIface(iface->getInterfaceName().get(), epUuids);
+        ep_set_view_t epUuids =
+            epMgr.getEndpointsByIface(iface->getInterfaceName().get());
+        if (!epUuids)
+            return;
 
-        for (auto& epUuid : epUuids) {
+        for (auto& epUuid : *epUuids) {
             endpointUpdated(epUuid);
         }
     }
@@ -920,6 +1095,31 @@ void AccessFlowManager::cleanup() {
         return secGrpSetIdGarbageCb(agent.getEndpointManager(), str);
     };
     idGen.collectGarbage(ID_NMSPC_SECGROUP_SET, gcb2);
+
+    if (secGroupConjunction) {
+        std::lock_guard<std::mutex> guard(secGrpConjMutex);
+        vector<URI> unused;
+        for (const auto& v : secGrpConjMap) {
+            unordered_set<uri_set_t> secGrpSets;
+            agent.getEndpointManager()
+                .getSecGrpSetsForSecGrp(v.first, secGrpSets);
+            if (secGrpSets.empty())
+                unused.push_back(v.first);
+        }
+        for (const URI& secGrp : unused)
+            removeSecGrpConj(secGrp);
+    }
+
+    auto gcb3 = [=](const std::string&,
+                    const std::string& str) -> bool {
+        std::lock_guard<std::mutex> guard(secGrpConjMutex);
+        size_t pos = str.find('#');
+        if (pos == string::npos) return false;
+        auto it = secGrpConjMap.find(URI(str.substr(0, pos)));
+        return it != secGrpConjMap.end() &&
+            it->second.idKeys.find(str) != it->second.idKeys.end();
+    };
+    idGen.collectGarbage(ID_NMSPC_SECGROUP_CONJ, gcb3);
 }
 
 } // namespace opflexagent
@@ -254,6 +254,12 @@ ActionBuilder& ActionBuilder::multipath(enum nx_hash_fields fields,
     return *this;
 }
 
+ActionBuilder& ActionBuilder::conjunction(uint32_t id, uint8_t clause,
+                                          uint8_t nClauses) {
+    act_conjunction(buf, id, clause - 1, nClauses);
+    return *this;
+}
+
 ActionBuilder& ActionBuilder::macVlanLearn(uint16_t prio,
                                            uint64_t cookie,
                                            uint8_t table) {
@@ -25,6 +25,8 @@
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/placeholders.hpp>
 
+#include <algorithm>
+
 #include <modelgbp/gbp/RoutingModeEnumT.hpp>
 
 #include "ovs-ofputil.h"
@@ -32,10 +34,12 @@
 // OVS lib
 #include <lib/util.h>
 #include <openvswitch/match.h>
+#include <openvswitch/ofp-msgs.h>
 
 using std::string;
 using std::shared_ptr;
 using std::unordered_set;
+using std::vector;
 using std::unique_lock;
 using std::mutex;
 using std::bind;
@@ -54,12 +58,21 @@ namespace opflexagent {
 
 static const address_v6 ALL_NODES_IP(address_v6::from_string("ff02::1"));
 
+// resolution of the advertisement timing wheel in milliseconds
+static const uint64_t ADV_TICK_MS = 100;
+// number of slots in the advertisement timing wheel
+static const size_t ADV_WHEEL_SLOTS = 512;
+
 AdvertManager::AdvertManager(Agent& agent_,
                              IntFlowManager& intFlowManager_)
     : urng(rng()), all_ep_dis(300,600), repeat_dis(3000,5000),
       sendRouterAdv(false), initialRouterAdvs(0),
       sendEndpointAdv(EPADV_DISABLED), tunnelEndpointAdv(EPADV_DISABLED),
       tunnelEpAdvInterval(300),
+      advRateLimit(0), advBundles(false), advBundleId(0),
+      advWheel(ADV_WHEEL_SLOTS),
+      advEpoch(std::chrono::steady_clock::now()), advTick(0), advTokens(0),
+      advTickScheduled(false),
       agent(agent_), intFlowManager(intFlowManager_),
       portMapper(NULL), switchConnection(NULL),
       ioService(&agent.getAgentIOService()),
@@ -82,14 +95,26 @@ void AdvertManager::start() {
     if (sendEndpointAdv != EPADV_DISABLED) {
         allEndpointAdvTimer.reset(new deadline_timer(*ioService));
         endpointAdvTimer.reset(new deadline_timer(*ioService));
+        advTickTimer.reset(new deadline_timer(*ioService));
         scheduleInitialEndpointAdv();
     }
 
+    if (switchConnection) {
+        switchConnection->RegisterMessageHandler(OFPTYPE_BUNDLE_CONTROL,
+                                                 this);
+        switchConnection->RegisterMessageHandler(OFPTYPE_ERROR, this);
+    }
 }
 
 void AdvertManager::stop() {
     stopping = true;
 
+    if (switchConnection) {
+        switchConnection->UnregisterMessageHandler(OFPTYPE_BUNDLE_CONTROL,
+                                                   this);
+        switchConnection->UnregisterMessageHandler(OFPTYPE_ERROR, this);
+    }
+
     lock_guard<recursive_mutex> guard(timer_mutex);
     try {
         if (routerAdvTimer)
@@ -98,6 +123,8 @@ void AdvertManager::stop() {
             endpointAdvTimer->cancel();
         if (allEndpointAdvTimer)
             allEndpointAdvTimer->cancel();
+        if (advTickTimer)
+            advTickTimer->cancel();
         if(tunnelEpAdvTimer)
             tunnelEpAdvTimer->cancel();
     } catch(const std::exception &e) {
@@ -121,7 +148,7 @@ void AdvertManager::scheduleInitialEndpointAdv(uint64_t delay) {
         allEndpointAdvTimer->expires_from_now(milliseconds(delay));
         allEndpointAdvTimer->
             async_wait(bind(&AdvertManager::onAllEndpointAdvTimer,
-                            this, error));
+                            this, error, true));
     }
 }
 
@@ -165,7 +192,8 @@ static int send_packet_out(SwitchConnection* conn,
                            IntFlowManager::EncapType encapType =
                            IntFlowManager::ENCAP_NONE,
                            uint32_t vnid = 0,
-                           const address& tunDst = address()) {
+                           const address& tunDst = address(),
+                           uint32_t bundleId = 0) {
     struct ofputil_packet_out po{};
     po.buffer_id = UINT32_MAX;
     po.packet = b.data();
@@ -186,9 +214,27 @@ static int send_packet_out(SwitchConnection* conn,
         ((ofp_version)conn->GetProtocolVersion());
     assert(ofputil_protocol_is_valid(proto));
     OfpBuf message(ofputil_encode_packet_out(&po, proto));
-    int error = conn->SendMessage(message);
     free(po.ofpacts);
-    return error;
+    if (bundleId != 0) {
+        struct ofputil_bundle_add_msg bam;
+        bam.bundle_id = bundleId;
+        bam.flags = 0;
+        bam.msg = (const struct ofp_header*)message.data();
+        OfpBuf add(ofputil_encode_bundle_add
+                   ((ofp_version)conn->GetProtocolVersion(), &bam));
+        return conn->SendMessage(add);
+    }
+    return conn->SendMessage(message);
+}
+
+static OfpBuf encode_bundle_ctrl(SwitchConnection* conn, uint32_t bundleId,
+                                 uint16_t type) {
+    struct ofputil_bundle_ctrl_msg bc;
+    bc.bundle_id = bundleId;
+    bc.type = type;
+    bc.flags = 0;
+    return OfpBuf(ofputil_encode_bundle_ctrl_request
+                  ((ofp_version)conn->GetProtocolVersion(), &bc));
 }
 
 void AdvertManager::sendRouterAdvs() {
@@ -201,10 +247,11 @@ void AdvertManager::sendRouterAdvs() {
     polMgr.getGroups(epgURIs);
 
     for (const URI& epg : epgURIs) {
-        unordered_set<string> eps;
+        ep_set_view_t eps = epMgr.getEndpointsForGroup(epg);
+        if (!eps) continue;
+
         unordered_set<uint32_t> out_ports;
-        epMgr.getEndpointsForGroup(epg, eps);
-        for (const string& uuid : eps) {
+        for (const string& uuid : *eps) {
             shared_ptr<const Endpoint> ep = epMgr.getEndpoint(uuid);
             if (!ep) continue;
 
@@ -270,7 +317,7 @@ void AdvertManager::onRouterAdvTimer(const boost::system::error_code& ec) {
     }
 }
 
-static void doSendEpAdv(PolicyManager& policyManager,
+static size_t doSendEpAdv(PolicyManager& policyManager,
                         SwitchConnection* switchConnection,
                         const string& ip, const uint8_t* epMac,
                         const uint8_t* routerMac,
@@ -278,13 +325,14 @@ static void doSendEpAdv(PolicyManager& policyManager,
                         unordered_set<uint32_t>& out_ports,
                         AdvertManager::EndpointAdvMode mode,
                         IntFlowManager::EncapType encapType,
-                        const address& tunDst) {
+                        const address& tunDst,
+                        uint32_t bundleId) {
     boost::system::error_code ec;
     address addr = address::from_string(ip, ec);
     if (ec) {
         LOG(ERROR) << "Invalid IP address: " << ip
                    << ": " << ec.message();
-        return;
+        return 0;
     }
 
     OfpBuf b((struct ofpbuf*)NULL);
@@ -354,19 +402,23 @@ static void doSendEpAdv(PolicyManager& policyManager,
                                                 addrv, allnodes);
         }
     }
-    if (!b.get()) return;
+    if (!b.get()) return 0;
 
     int error = send_packet_out(switchConnection, b, out_ports,
-                                encapType, epgVnid, tunDst);
+                                encapType, epgVnid, tunDst, bundleId);
     if (error) {
         LOG(ERROR) << "Could not write packet-out: "
                    << ovs_strerror(error);
+        return 0;
     }
+    return 1;
 }
 
-void AdvertManager::sendEndpointAdvs(const string& uuid) {
+size_t AdvertManager::sendEndpointAdvs(const string& uuid,
+                                       uint32_t bundleId) {
+    size_t sent = 0;
     uint32_t tunPort = intFlowManager.getTunnelPort();
-    if (tunPort == OFPP_NONE) return;
+    if (tunPort == OFPP_NONE) return sent;
     unordered_set<uint32_t> out_ports;
     out_ports.insert(tunPort);
 
@@ -374,14 +426,14 @@ void AdvertManager::sendEndpointAdvs(const string& uuid) {
     PolicyManager& polMgr = agent.getPolicyManager();
 
     shared_ptr<const Endpoint> ep = epMgr.getEndpoint(uuid);
-    if (!ep) return;
-    if (!ep->getMAC()) return;
-    if (ep->isDisableAdv()) return;
+    if (!ep) return sent;
+    if (!ep->getMAC()) return sent;
+    if (ep->isDisableAdv()) return sent;
 
     optional<URI> epgURI = epMgr.getComputedEPG(uuid);
-    if (!epgURI) return;
+    if (!epgURI) return sent;
     optional<uint32_t> epgVnid = polMgr.getVnidForGroup(epgURI.get());
-    if (!epgVnid) return;
+    if (!epgVnid) return sent;
 
     uint8_t epMac[6];
     ep->getMAC().get().toUIntArray(epMac);
@@ -391,11 +443,12 @@ void AdvertManager::sendEndpointAdvs(const string& uuid) {
         LOG(DEBUG) << "Sending endpoint advertisement for "
                    << ep->getMAC().get() << " " << ip;
 
-        doSendEpAdv(polMgr, switchConnection,
-                    ip, epMac, routerMac, epgURI.get(), epgVnid.get(),
-                    out_ports, sendEndpointAdv,
-                    intFlowManager.getEncapType(),
-                    intFlowManager.getEPGTunnelDst(epgURI.get()));
+        sent += doSendEpAdv(polMgr, switchConnection,
+                            ip, epMac, routerMac, epgURI.get(),
+                            epgVnid.get(), out_ports, sendEndpointAdv,
+                            intFlowManager.getEncapType(),
+                            intFlowManager.getEPGTunnelDst(epgURI.get()),
+                            bundleId);
 
     }
 
@@ -413,28 +466,40 @@ void AdvertManager::sendEndpointAdvs(const string& uuid) {
         LOG(DEBUG) << "Sending endpoint advertisement for "
                    << ep->getMAC().get() << " " << ipm.getFloatingIP().get();
 
-        doSendEpAdv(polMgr, switchConnection,
-                    ipm.getFloatingIP().get(), epMac,
-                    routerMac, ipm.getEgURI().get(),
-                    ipmVnid.get(), out_ports, sendEndpointAdv,
-                    intFlowManager.getEncapType(),
-                    intFlowManager.getEPGTunnelDst(ipm.getEgURI().get()));
+        sent += doSendEpAdv(polMgr, switchConnection,
+                            ipm.getFloatingIP().get(), epMac,
+                            routerMac, ipm.getEgURI().get(),
+                            ipmVnid.get(), out_ports, sendEndpointAdv,
+                            intFlowManager.getEncapType(),
+                            intFlowManager.getEPGTunnelDst(ipm.getEgURI().get()),
+                            bundleId);
     }
+    return sent;
 }
 
-void AdvertManager::sendAllEndpointAdvs() {
-    LOG(DEBUG) << "Sending all endpoint advertisements";
+void AdvertManager::queueAllEndpointAdvs(bool immediate) {
+    LOG(DEBUG) << "Queuing all endpoint advertisements";
 
     EndpointManager& epMgr = agent.getEndpointManager();
     PolicyManager& polMgr = agent.getPolicyManager();
 
     PolicyManager::uri_set_t epgURIs;
     polMgr.getGroups(epgURIs);
+
+    // Collect the endpoints before taking ep_mutex, which must not
+    // be held while calling into the endpoint manager
+    vector<ep_set_view_t> epViews;
     for (const URI& epg : epgURIs) {
-        unordered_set<string> eps;
-        epMgr.getEndpointsForGroup(epg, eps);
-        for (const string& uuid : eps) {
-            sendEndpointAdvs(uuid);
+        ep_set_view_t eps = epMgr.getEndpointsForGroup(epg);
+        if (eps) epViews.push_back(eps);
+    }
+
+    unique_lock<mutex> guard(ep_mutex);
+    uint64_t spread = all_ep_dis.min() * 1000;
+    for (const ep_set_view_t& eps : epViews) {
+        for (const string& uuid : *eps) {
+            wheelSchedule(adv_key_t(ADV_ENDPOINT, uuid),
+                          immediate ? 0 : urng() % spread);
         }
     }
 }
@@ -471,8 +536,8 @@ static bool shouldSendAdv(const Service& s) {
             s.getInterfaceName());
 }
 
-void AdvertManager::sendAllServiceAdvs() {
-    LOG(DEBUG) << "Sending all service advertisements";
+void AdvertManager::queueAllServiceAdvs(bool immediate) {
+    LOG(DEBUG) << "Queuing all service advertisements";
 
     ServiceManager& svcMgr = agent.getServiceManager();
     PolicyManager& polMgr = agent.getPolicyManager();
@@ -495,12 +560,16 @@ void AdvertManager::sendAllServiceAdvs() {
             }
             advs.insert(*s);
 
-            sendServiceAdvs(uuid);
+            unique_lock<mutex> guard(ep_mutex);
+            uint64_t spread = all_ep_dis.min() * 1000;
+            wheelSchedule(adv_key_t(ADV_SERVICE, uuid),
+                          immediate ? 0 : urng() % spread);
         }
     }
 }
 
-void AdvertManager::onAllEndpointAdvTimer(const boost::system::error_code& ec) {
+void AdvertManager::onAllEndpointAdvTimer(const boost::system::error_code& ec,
+                                          bool initial) {
     if (ec)
         return;
     if (sendEndpointAdv == EPADV_DISABLED)
@@ -510,11 +579,14 @@ void AdvertManager::onAllEndpointAdvTimer(const boost::system::error_code& ec) {
     if (!portMapper)
         return;
 
+    // Each endpoint and service refreshes on its own schedule once
+    // it is in the timing wheel, so this periodic pass only needs to
+    // pick up anything that is missing from the wheel.  Only the
+    // initial pass sends everything right away.
     if (switchConnection->IsConnected()) {
-        agent.getAgentIOService()
-            .dispatch(bind(&AdvertManager::sendAllEndpointAdvs, this));
-        agent.getAgentIOService()
-            .dispatch(bind(&AdvertManager::sendAllServiceAdvs, this));
+        queueAllEndpointAdvs(initial);
+        queueAllServiceAdvs(initial);
+        scheduleAdvTick(ADV_TICK_MS);
     }
 
     if (!stopping) {
@@ -522,21 +594,22 @@ void AdvertManager::onAllEndpointAdvTimer(const boost::system::error_code& ec) {
         allEndpointAdvTimer->expires_from_now(seconds(all_ep_dis(urng)));
         allEndpointAdvTimer->
             async_wait(bind(&AdvertManager::onAllEndpointAdvTimer,
-                            this, error));
+                            this, error, false));
     }
 }
 
-void AdvertManager::sendServiceAdvs(const string& uuid) {
+size_t AdvertManager::sendServiceAdvs(const string& uuid,
+                                      uint32_t bundleId) {
     PolicyManager& polMgr = agent.getPolicyManager();
     ServiceManager& svcMgr = agent.getServiceManager();
 
     shared_ptr<const Service> svc = svcMgr.getService(uuid);
 
-    if (!svc || !shouldSendAdv(*svc)) return;
+    if (!svc || !shouldSendAdv(*svc)) return 0;
 
     uint32_t port = portMapper->FindPort(svc->getInterfaceName().get());
     if (port == OFPP_NONE)
-        return;
+        return 0;
 
     unordered_set<uint32_t> out_ports {port};
 
@@ -557,9 +630,265 @@ void AdvertManager::sendServiceAdvs(const string& uuid) {
                << svc->getInterfaceName().get()
                << " (vlan " << unsigned(vnid) << ")";
 
-    doSendEpAdv(polMgr, switchConnection, svc->getIfaceIP().get(),
-                svcMac, routerMac, URI::ROOT, vnid,
-                out_ports, sendEndpointAdv, encapType, address());
+    return doSendEpAdv(polMgr, switchConnection, svc->getIfaceIP().get(),
+                       svcMac, routerMac, URI::ROOT, vnid,
+                       out_ports, sendEndpointAdv, encapType, address(),
+                       bundleId);
+}
+
+uint64_t AdvertManager::currentAdvTick() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+        (std::chrono::steady_clock::now() - advEpoch).count() / ADV_TICK_MS;
+}
+
+void AdvertManager::wheelSchedule(const adv_key_t& key, uint64_t delay) {
+    uint64_t deadline =
+        std::max(currentAdvTick(), advTick) + 1 + delay / ADV_TICK_MS;
+    auto it = advDeadlines.find(key);
+    if (it != advDeadlines.end()) {
+        if (it->second <= deadline)
+            return;
+        advWheel[it->second % ADV_WHEEL_SLOTS].erase(key);
+        it->second = deadline;
+    } else {
+        // already due and waiting for rate limit budget
+        if (advReadySet.find(key) != advReadySet.end())
+            return;
+        advDeadlines[key] = deadline;
+    }
+    advWheel[deadline % ADV_WHEEL_SLOTS].insert(key);
+}
+
+void AdvertManager::scheduleAdvTick(uint64_t delay) {
+    lock_guard<recursive_mutex> guard(timer_mutex);
+    if (!advTickTimer || stopping)
+        return;
+    auto expiry = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(delay);
+    if (advTickScheduled && advTickExpiry <= expiry)
+        return;
+    advTickScheduled = true;
+    advTickExpiry = expiry;
+    advTickTimer->expires_from_now(milliseconds(delay));
+    advTickTimer->async_wait(bind(&AdvertManager::onAdvTickTimer,
+                                  this, error));
+}
+
+boost::optional<uint64_t> AdvertManager::getAdvTickDelay() {
+    lock_guard<recursive_mutex> guard(timer_mutex);
+    if (!advTickScheduled)
+        return boost::none;
+    auto now = std::chrono::steady_clock::now();
+    if (advTickExpiry <= now)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+        (advTickExpiry - now).count();
+}
+
+size_t AdvertManager::sendAdvBatch(const vector<adv_key_t>& batch,
+                                   vector<adv_key_t>& rearm) {
+    size_t sent = 0;
+    if (batch.empty()) return sent;
+
+    uint32_t bundleId = 0;
+    if (advBundles && batch.size() > 1) {
+        bundleId = ++advBundleId;
+        if (bundleId == 0) bundleId = ++advBundleId;
+        OfpBuf open(encode_bundle_ctrl(switchConnection, bundleId,
+                                       OFPBCT_OPEN_REQUEST));
+        {
+            // track the bundle before sending so that a fast reply
+            // can't be missed
+            unique_lock<mutex> guard(ep_mutex);
+            advPendingBundles[bundleId] = batch;
+            advBundleXids[ntohl(((ofp_header*)open.data())->xid)] = bundleId;
+        }
+        int error = switchConnection->SendMessage(open);
+        if (error) {
+            LOG(ERROR) << "Could not open advertisement bundle: "
+                       << ovs_strerror(error);
+            unique_lock<mutex> guard(ep_mutex);
+            clearPendingBundles(bundleId);
+            bundleId = 0;
+        }
+    }
+
+    for (const adv_key_t& key : batch) {
+        size_t n = (key.first == ADV_ENDPOINT)
+            ? sendEndpointAdvs(key.second, bundleId)
+            : sendServiceAdvs(key.second, bundleId);
+        // items that no longer produce advertisements drop out of the
+        // wheel; the periodic pass picks them up again if needed
+        if (n > 0)
+            rearm.push_back(key);
+        sent += n;
+    }
+
+    if (bundleId != 0) {
+        OfpBuf commit(encode_bundle_ctrl(switchConnection, bundleId,
+                                         OFPBCT_COMMIT_REQUEST));
+        {
+            unique_lock<mutex> guard(ep_mutex);
+            if (advPendingBundles.count(bundleId))
+                advBundleXids[ntohl(((ofp_header*)commit.data())->xid)] =
+                    bundleId;
+        }
+        int error = switchConnection->SendMessage(commit);
+        if (error) {
+            LOG(ERROR) << "Could not commit advertisement bundle: "
+                       << ovs_strerror(error);
+        }
+    }
+    return sent;
+}
+
+void AdvertManager::clearPendingBundles(uint32_t bundleId) {
+    auto end = advPendingBundles.upper_bound(bundleId);
+    advPendingBundles.erase(advPendingBundles.begin(), end);
+    auto it = advBundleXids.begin();
+    while (it != advBundleXids.end()) {
+        if (advPendingBundles.count(it->second))
+            it++;
+        else
+            it = advBundleXids.erase(it);
+    }
+}
+
+void AdvertManager::Handle(SwitchConnection*, int msgType,
+                           ofpbuf* msg, struct ofputil_flow_removed*) {
+    const ofp_header* oh = (const ofp_header*)msg->data;
+    bool resend = false;
+    {
+        unique_lock<mutex> guard(ep_mutex);
+        auto xit = advBundleXids.find(ntohl(oh->xid));
+        if (xit == advBundleXids.end())
+            return;
+        uint32_t bundleId = xit->second;
+
+        if (msgType == OFPTYPE_BUNDLE_CONTROL) {
+            struct ofputil_bundle_ctrl_msg bc;
+            if (ofputil_decode_bundle_ctrl(oh, &bc) ||
+                bc.type != OFPBCT_COMMIT_REPLY)
+                return;
+            // replies arrive in order, so earlier bundles are done too
+            clearPendingBundles(bundleId);
+        } else if (msgType == OFPTYPE_ERROR) {
+            LOG(WARNING) << "Advertisement bundle " << bundleId
+                         << " failed: "
+                         << ofperr_to_string(ofperr_decode_msg(oh, NULL))
+                         << ", falling back to individual packet-outs";
+            advBundles = false;
+            // send the items of the failed bundle again, ahead of the
+            // items already waiting
+            const vector<adv_key_t>& keys = advPendingBundles[bundleId];
+            for (auto it = keys.rbegin(); it != keys.rend(); it++) {
+                if (advReadySet.insert(*it).second)
+                    advReady.push_front(*it);
+            }
+            resend = !keys.empty();
+            clearPendingBundles(bundleId);
+        }
+    }
+    if (resend)
+        scheduleAdvTick(0);
+}
+
+void AdvertManager::onAdvTickTimer(const boost::system::error_code& ec) {
+    if (ec)
+        return;
+    {
+        lock_guard<recursive_mutex> guard(timer_mutex);
+        advTickScheduled = false;
+    }
+    if (stopping || sendEndpointAdv == EPADV_DISABLED)
+        return;
+    if (!switchConnection || !portMapper)
+        return;
+
+    vector<adv_key_t> batch;
+    {
+        unique_lock<mutex> guard(ep_mutex);
+        uint64_t now = std::max(currentAdvTick(), advTick + 1);
+        uint64_t elapsed = now - advTick;
+
+        // move the items that are due to the ready queue, catching up
+        // on the slots passed while the timer was idle.  One rotation
+        // covers every slot.
+        uint64_t first = advTick + 1;
+        if (elapsed > ADV_WHEEL_SLOTS)
+            first = now - ADV_WHEEL_SLOTS + 1;
+        advTick = now;
+        for (uint64_t t = first; t <= now; t++) {
+            adv_key_set_t& slot = advWheel[t % ADV_WHEEL_SLOTS];
+            auto it = slot.begin();
+            while (it != slot.end()) {
+                auto dit = advDeadlines.find(*it);
+                if (dit != advDeadlines.end() && dit->second > now) {
+                    it++;
+                    continue;
+                }
+                if (dit != advDeadlines.end())
+                    advDeadlines.erase(dit);
+                if (advReadySet.insert(*it).second)
+                    advReady.push_back(*it);
+                it = slot.erase(it);
+            }
+        }
+
+        // refill the budget, allowing at most one tick of burst
+        if (advRateLimit) {
+            double perTick = advRateLimit * ADV_TICK_MS / 1000.0;
+            advTokens = std::min(advTokens + perTick * elapsed,
+                                 std::max(perTick, 1.0));
+        }
+        while (!advReady.empty() &&
+               (advRateLimit == 0 || advTokens >= 1.0)) {
+            batch.push_back(advReady.front());
+            advReadySet.erase(advReady.front());
+            advReady.pop_front();
+            if (advRateLimit) advTokens -= 1.0;
+        }
+    }
+
+    if (!batch.empty() && switchConnection->IsConnected()) {
+        vector<adv_key_t> rearm;
+        size_t sent = sendAdvBatch(batch, rearm);
+
+        unique_lock<mutex> guard(ep_mutex);
+        // items that sent more than one packet use up the budget of
+        // future ticks
+        if (advRateLimit && sent > batch.size())
+            advTokens -= sent - batch.size();
+        for (const adv_key_t& key : rearm) {
+            wheelSchedule(key, all_ep_dis(urng) * 1000);
+        }
+    }
+
+    // Keep ticking while items are waiting for budget; otherwise
+    // sleep until the next item is due, at most one rotation ahead,
+    // or until something is scheduled if the wheel is empty
+    uint64_t next = 0;
+    {
+        unique_lock<mutex> guard(ep_mutex);
+        if (!advReady.empty()) {
+            next = 1;
+        } else if (!advDeadlines.empty()) {
+            next = ADV_WHEEL_SLOTS;
+            for (uint64_t i = 1; i < ADV_WHEEL_SLOTS; i++) {
+                uint64_t t = advTick + i;
+                for (const adv_key_t& key : advWheel[t % ADV_WHEEL_SLOTS]) {
+                    auto dit = advDeadlines.find(key);
+                    if (dit == advDeadlines.end() || dit->second <= t) {
+                        next = i;
+                        break;
+                    }
+                }
+                if (next == i) break;
+            }
+        }
+    }
+    if (next)
+        scheduleAdvTick(next * ADV_TICK_MS);
 }
 
 void AdvertManager::onEndpointAdvTimer(const boost::system::error_code& ec) {
@@ -576,9 +905,7 @@ void AdvertManager::onEndpointAdvTimer(const boost::system::error_code& ec) {
     {
         auto it = pendingEps.begin();
         while (it != pendingEps.end()) {
-            agent.getAgentIOService()
-                .post(bind(&AdvertManager::sendEndpointAdvs,
-                           this, it->first));
+            wheelSchedule(adv_key_t(ADV_ENDPOINT, it->first), 0);
             if (it->second <= 1) {
                 it = pendingEps.erase(it);
             } else {
@@ -604,9 +931,7 @@ void AdvertManager::onEndpointAdvTimer(const boost::system::error_code& ec) {
             }
             advs.insert(*s);
 
-            agent.getAgentIOService()
-                .post(bind(&AdvertManager::sendServiceAdvs,
-                           this, it->first));
+            wheelSchedule(adv_key_t(ADV_SERVICE, it->first), 0);
             if (it->second <= 1) {
                 it = pendingServices.erase(it);
             } else {
@@ -616,10 +941,12 @@ void AdvertManager::onEndpointAdvTimer(const boost::system::error_code& ec) {
         }
     }
 
-    if (!pendingEps.empty() || !pendingServices.empty()) {
-        guard.unlock();
+    bool repeat = !pendingEps.empty() || !pendingServices.empty();
+    guard.unlock();
+
+    scheduleAdvTick(ADV_TICK_MS);
+    if (repeat)
         doScheduleEpAdv(repeat_dis(urng));
-    }
 }
 
 void AdvertManager::sendTunnelEpRarp(const string& uuid) {
@@ -0,0 +1,398 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*
+ * Implementation file for CompiledPacketDecoder
+ *
+ * Copyright (c) 2020 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+#include "CompiledPacketDecoder.h"
+#include <boost/asio/ip/address.hpp>
+#include <opflex/modb/MAC.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+
+namespace opflexagent {
+
+namespace {
+
+/* Byte offsets of the fields used from each layer */
+enum GeneveOffsets {
+    GENEVE_OPTLEN = 0, GENEVE_PROTO = 2, GENEVE_VNI = 4, GENEVE_LEN = 8
+};
+enum GeneveOptOffsets {
+    GENEVE_OPT_CLASS = 0, GENEVE_OPT_TYPE = 2, GENEVE_OPT_LENGTH = 3,
+    GENEVE_OPT_DATA = 4
+};
+enum EthernetOffsets {
+    ETH_DST = 0, ETH_SRC = 6, ETH_TYPE = 12, ETH_LEN = 14
+};
+enum QtagOffsets {
+    QTAG_TCI = 0, QTAG_TYPE = 2, QTAG_LEN = 4
+};
+enum IPv4Offsets {
+    IPV4_VIHL = 0, IPV4_TOS = 1, IPV4_TOTLEN = 2, IPV4_ID = 4,
+    IPV4_FRAG = 6, IPV4_TTL = 8, IPV4_PROTO = 9, IPV4_SRC = 12,
+    IPV4_DST = 16, IPV4_LEN = 20
+};
+enum IPv6Offsets {
+    IPV6_VTCFL = 0, IPV6_PLEN = 4, IPV6_NXT = 6, IPV6_HLIM = 7,
+    IPV6_SRC = 8, IPV6_DST = 24, IPV6_LEN = 40
+};
+enum ARPOffsets {
+    ARP_OP = 6, ARP_SPA = 14, ARP_TPA = 24, ARP_LEN = 28
+};
+enum ICMPOffsets {
+    ICMP_TYPE = 0, ICMP_CODE = 1, ICMP_ID = 4, ICMP_SEQ = 6, ICMP_LEN = 8
+};
+enum TCPOffsets {
+    TCP_SPORT = 0, TCP_DPORT = 2, TCP_SEQ = 4, TCP_ACK = 8,
+    TCP_OFFFLAGS = 12, TCP_WINDOW = 14, TCP_URGENT = 18, TCP_LEN = 20
+};
+enum UDPOffsets {
+    UDP_SPORT = 0, UDP_DPORT = 2, UDP_ULEN = 4, UDP_LEN = 8
+};
+
+/* Geneve option carrying the table id; see GeneveOptTableIdLayerVariant */
+const uint16_t GENEVE_OPT_CLASS_TABLE = 65535;
+const uint8_t GENEVE_OPT_TYPE_TABLE = 12;
+const uint16_t GENEVE_PROTO_ETHERNET = 25944;
+
+const uint16_t ETHTYPE_QTAG = 33024;
+const uint16_t ETHTYPE_IPV4 = 2048;
+const uint16_t ETHTYPE_ARP = 2054;
+const uint16_t ETHTYPE_IPV6 = 34525;
+
+const uint8_t IP_PROTO_ICMP = 1;
+const uint8_t IP_PROTO_TCP = 6;
+const uint8_t IP_PROTO_UDP = 17;
+
+/* Layer names keyed by the value selecting them, as in
+   PacketDecoderLayers */
+struct LayerKey {
+    uint32_t key;
+    const char *name;
+};
+
+const LayerKey ETHER_LAYERS[] = {
+    {ETHTYPE_QTAG, "Qtag"},
+    {ETHTYPE_IPV4, "IPv4"},
+    {ETHTYPE_ARP, "ARP"},
+    {ETHTYPE_IPV6, "IPv6"},
+};
+
+const LayerKey IP_LAYERS[] = {
+    {IP_PROTO_ICMP, "ICMP"},
+    {IP_PROTO_TCP, "TCP"},
+    {IP_PROTO_UDP, "UDP"},
+};
+
+const char *TCP_FLAG_NAMES[] = {
+    "NS", "CWR", "ECE", "URG", "ACK", "PSH", "RST", "SYN", "FIN"
+};
+
+template <size_t N>
+const char *layerName(const LayerKey (&table)[N], uint32_t key) {
+    for (const LayerKey& l : table) {
+        if (l.key == key)
+            return l.name;
+    }
+    return nullptr;
+}
+
+template <size_t N>
+void writeLayerName(std::ostream &os, const LayerKey (&table)[N],
+                    uint32_t key) {
+    const char *name = layerName(table, key);
+    if (name)
+        os << name;
+    else
+        os << key << "(unrecognized)";
+}
+
+template <size_t N>
+std::string layerNameString(const LayerKey (&table)[N], uint32_t key) {
+    const char *name = layerName(table, key);
+    if (name)
+        return name;
+    return std::to_string(key) + "(unrecognized)";
+}
+
+inline uint16_t rd16(const unsigned char *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+inline uint32_t rd32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+        ((uint32_t)p[2] << 8) | p[3];
+}
+
+inline uint32_t rdN(const unsigned char *p, size_t len) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < len; i++)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+void writeAddr(std::ostream &os, const uint8_t *addr, bool v6) {
+    if (v6) {
+        boost::asio::ip::address_v6::bytes_type bytes;
+        std::copy(addr, addr + bytes.size(), bytes.begin());
+        os << boost::asio::ip::address_v6(bytes);
+    } else {
+        boost::asio::ip::address_v4::bytes_type bytes;
+        std::copy(addr, addr + bytes.size(), bytes.begin());
+        os << boost::asio::ip::address_v4(bytes);
+    }
+}
+
+std::string addrString(const uint8_t *addr, bool v6) {
+    std::stringstream ostr;
+    writeAddr(ostr, addr, v6);
+    return ostr.str();
+}
+
+std::string macString(const uint8_t *mac) {
+    std::stringstream ostr;
+    ostr << opflex::modb::MAC(mac);
+    return ostr.str();
+}
+
+int decodeL4(const unsigned char *buf, std::size_t length,
+             CompactPacketTuple &t) {
+    if (length == 0)
+        return 0;
+    switch (t.ipProto) {
+    case IP_PROTO_ICMP:
+        if (length < ICMP_LEN)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_ICMP;
+        t.icmpType = buf[ICMP_TYPE];
+        t.icmpCode = buf[ICMP_CODE];
+        t.icmpId = rd16(buf + ICMP_ID);
+        t.icmpSeq = rd16(buf + ICMP_SEQ);
+        break;
+    case IP_PROTO_TCP:
+        if (length < TCP_LEN)
+            return -1;
+        t.tcpDataOffset = buf[TCP_OFFFLAGS] >> 4;
+        if (t.tcpDataOffset * 4 < TCP_LEN ||
+            t.tcpDataOffset * 4u > length)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_TCP;
+        t.srcPort = rd16(buf + TCP_SPORT);
+        t.dstPort = rd16(buf + TCP_DPORT);
+        t.tcpSeq = rd32(buf + TCP_SEQ);
+        t.tcpAck = rd32(buf + TCP_ACK);
+        t.tcpFlags = rd16(buf + TCP_OFFFLAGS) & 0x1ff;
+        t.tcpWindow = rd16(buf + TCP_WINDOW);
+        t.tcpUrgent = rd16(buf + TCP_URGENT);
+        break;
+    case IP_PROTO_UDP:
+        if (length < UDP_LEN)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_UDP;
+        t.srcPort = rd16(buf + UDP_SPORT);
+        t.dstPort = rd16(buf + UDP_DPORT);
+        t.udpLength = rd16(buf + UDP_ULEN);
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+} /* anonymous namespace */
+
+int CompiledPacketDecoder::decode(const unsigned char *buf,
+                                  std::size_t length,
+                                  CompactPacketTuple &t) const {
+    t = CompactPacketTuple();
+    t.timeStamp = std::time(nullptr);
+
+    /* Geneve header and options */
+    if (length < GENEVE_LEN)
+        return -1;
+    std::size_t optLen = (buf[GENEVE_OPTLEN] & 0x3f) * 4;
+    uint16_t proto = rd16(buf + GENEVE_PROTO);
+    t.meta[0] = rdN(buf + GENEVE_VNI, 3);
+    if (length < GENEVE_LEN + optLen)
+        return -1;
+    const unsigned char *opt = buf + GENEVE_LEN;
+    const unsigned char *optEnd = opt + optLen;
+    while (opt < optEnd) {
+        std::size_t rem = optEnd - opt;
+        if (rem < GENEVE_OPT_DATA)
+            return -1;
+        std::size_t dataLen = (opt[GENEVE_OPT_LENGTH] & 0x1f) * 4;
+        if (rem < GENEVE_OPT_DATA + dataLen)
+            return -1;
+        if (rd16(opt + GENEVE_OPT_CLASS) == GENEVE_OPT_CLASS_TABLE &&
+            opt[GENEVE_OPT_TYPE] == GENEVE_OPT_TYPE_TABLE && dataLen <= 4)
+            t.meta[1] = rdN(opt + GENEVE_OPT_DATA, dataLen);
+        opt += GENEVE_OPT_DATA + dataLen;
+    }
+    buf = optEnd;
+    length -= GENEVE_LEN + optLen;
+    if (length == 0 || proto != GENEVE_PROTO_ETHERNET)
+        return 0;
+
+    /* Ethernet and an optional 802.1Q tag */
+    if (length < ETH_LEN)
+        return -1;
+    t.layers |= CompactPacketTuple::LAYER_ETHERNET;
+    std::memcpy(t.dstMac, buf + ETH_DST, sizeof(t.dstMac));
+    std::memcpy(t.srcMac, buf + ETH_SRC, sizeof(t.srcMac));
+    t.outerEtherType = t.etherType = rd16(buf + ETH_TYPE);
+    buf += ETH_LEN;
+    length -= ETH_LEN;
+    if (length == 0)
+        return 0;
+    if (t.etherType == ETHTYPE_QTAG) {
+        if (length < QTAG_LEN)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_QTAG;
+        t.vlan = rd16(buf + QTAG_TCI) & 0xfff;
+        t.etherType = rd16(buf + QTAG_TYPE);
+        buf += QTAG_LEN;
+        length -= QTAG_LEN;
+        if (length == 0)
+            return 0;
+    }
+
+    /* Network layer */
+    switch (t.etherType) {
+    case ETHTYPE_IPV4:
+        {
+            if (length < IPV4_LEN)
+                return -1;
+            std::size_t hdrLen = (buf[IPV4_VIHL] & 0xf) * 4;
+            if (hdrLen < IPV4_LEN || hdrLen > length)
+                return -1;
+            t.layers |= CompactPacketTuple::LAYER_IPV4;
+            t.dscp = buf[IPV4_TOS] >> 2;
+            t.l3Length = rd16(buf + IPV4_TOTLEN);
+            t.ipId = rd16(buf + IPV4_ID);
+            t.ipFlags = buf[IPV4_FRAG] >> 5;
+            t.fragOffset = rd16(buf + IPV4_FRAG) & 0x1fff;
+            t.ttl = buf[IPV4_TTL];
+            t.ipProto = buf[IPV4_PROTO];
+            std::memcpy(t.srcIp, buf + IPV4_SRC, 4);
+            std::memcpy(t.dstIp, buf + IPV4_DST, 4);
+            return decodeL4(buf + hdrLen, length - hdrLen, t);
+        }
+    case ETHTYPE_IPV6:
+        if (length < IPV6_LEN)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_IPV6;
+        t.dscp = (rd16(buf + IPV6_VTCFL) >> 4) & 0xff;
+        t.flowLabel = rd32(buf + IPV6_VTCFL) & 0xfffff;
+        t.l3Length = rd16(buf + IPV6_PLEN);
+        t.ipProto = buf[IPV6_NXT];
+        t.ttl = buf[IPV6_HLIM];
+        std::memcpy(t.srcIp, buf + IPV6_SRC, 16);
+        std::memcpy(t.dstIp, buf + IPV6_DST, 16);
+        return decodeL4(buf + IPV6_LEN, length - IPV6_LEN, t);
+    case ETHTYPE_ARP:
+        if (length < ARP_LEN)
+            return -1;
+        t.layers |= CompactPacketTuple::LAYER_ARP;
+        t.arpOp = rd16(buf + ARP_OP);
+        std::memcpy(t.srcIp, buf + ARP_SPA, 4);
+        std::memcpy(t.dstIp, buf + ARP_TPA, 4);
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+void CompactPacketTuple::toPacketTuple(PacketTuple &pt) const {
+    char currTime[256];
+    struct tm tp;
+    std::strftime(currTime, sizeof(currTime), "%a %b %d %H:%M:%S %Z %Y",
+                  localtime_r(&timeStamp, &tp));
+    pt.TimeStamp = currTime;
+
+    if (!has(LAYER_ETHERNET))
+        return;
+    pt.setField(1, macString(srcMac));
+    pt.setField(2, macString(dstMac));
+    pt.setField(3, layerNameString(ETHER_LAYERS, etherType));
+    bool v6 = has(LAYER_IPV6);
+    if (has(LAYER_IPV4) || v6 || has(LAYER_ARP)) {
+        pt.setField(4, addrString(srcIp, v6));
+        pt.setField(5, addrString(dstIp, v6));
+    }
+    if (has(LAYER_IPV4) || v6)
+        pt.setField(6, layerNameString(IP_LAYERS, ipProto));
+    if (has(LAYER_TCP) || has(LAYER_UDP)) {
+        pt.setField(7, std::to_string(srcPort));
+        pt.setField(8, std::to_string(dstPort));
+    }
+}
+
+std::ostream& operator<<(std::ostream &os, const CompactPacketTuple &t) {
+    typedef CompactPacketTuple CPT;
+    if (!t.has(CPT::LAYER_ETHERNET))
+        return os;
+    os << " MAC=" << opflex::modb::MAC(t.dstMac)
+       << ":" << opflex::modb::MAC(t.srcMac) << ":";
+    writeLayerName(os, ETHER_LAYERS, t.outerEtherType);
+    if (t.has(CPT::LAYER_QTAG))
+        os << " QTAG=" << t.vlan;
+
+    if (t.has(CPT::LAYER_IPV4)) {
+        os << " SRC=";
+        writeAddr(os, t.srcIp, false);
+        os << " DST=";
+        writeAddr(os, t.dstIp, false);
+        os << " LEN=" << t.l3Length << " DSCP=" << (unsigned)t.dscp
+           << " TTL=" << (unsigned)t.ttl << " ID=" << t.ipId
+           << " FLAGS=" << (unsigned)t.ipFlags << " FRAG=" << t.fragOffset
+           << " PROTO=";
+        writeLayerName(os, IP_LAYERS, t.ipProto);
+    } else if (t.has(CPT::LAYER_IPV6)) {
+        os << " SRC=";
+        writeAddr(os, t.srcIp, true);
+        os << " DST=";
+        writeAddr(os, t.dstIp, true);
+        os << " LEN=" << t.l3Length << " TC=" << (unsigned)t.dscp
+           << " HL=" << (unsigned)t.ttl << " FL=" << t.flowLabel
+           << " PROTO=";
+        writeLayerName(os, IP_LAYERS, t.ipProto);
+    } else if (t.has(CPT::LAYER_ARP)) {
+        os << " ARP_SPA=";
+        writeAddr(os, t.srcIp, false);
+        os << " ARP_TPA=";
+        writeAddr(os, t.dstIp, false);
+        os << " ARP_OP=" << t.arpOp;
+    }
+
+    if (t.has(CPT::LAYER_ICMP)) {
+        os << " TYPE=" << (unsigned)t.icmpType
+           << " CODE=" << (unsigned)t.icmpCode
+           << " ID=" << t.icmpId << " SEQ=" << t.icmpSeq;
+    } else if (t.has(CPT::LAYER_TCP)) {
+        os << " SPT=" << t.srcPort << " DPT=" << t.dstPort
+           << " SEQ=" << t.tcpSeq << " ACK=" << t.tcpAck
+           << " LEN=" << (unsigned)t.tcpDataOffset
+           << " WINDOWS=" << t.tcpWindow << " ";
+        for (unsigned i = 0; i < 9; i++) {
+            if (t.tcpFlags & (1 << (8 - i)))
+                os << TCP_FLAG_NAMES[i] << " ";
+        }
+        os << " URGP=" << t.tcpUrgent;
+    } else if (t.has(CPT::LAYER_UDP)) {
+        os << " SPT=" << t.srcPort << " DPT=" << t.dstPort
+           << " LEN=" << t.udpLength;
+    }
+    return os;
+}
+
+} /* namespace opflexagent */
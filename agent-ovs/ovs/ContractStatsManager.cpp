@@ -96,6 +96,7 @@ void ContractStatsManager::on_timer(const error_code& ec) {
     };
 
     // Request Switch Manager to provide flow entries
+    long interval;
     {
         std::lock_guard<std::mutex> lock(pstatMtx);
         switchManager.forEachCookieMatch(IntFlowManager::POL_TABLE_ID,
@@ -103,6 +104,10 @@ void ContractStatsManager::on_timer(const error_code& ec) {
         PolicyCounterMap_t newClassCountersMap;
         on_timer_base(ec, contractState, newClassCountersMap);
         generatePolicyStatsObjects(&newClassCountersMap);
+        removeIdleCounterObjects();
+
+        interval = getNextPollInterval(contractState.changed);
+        contractState.changed = false;
     }
 
     sendRequest(IntFlowManager::POL_TABLE_ID);
@@ -110,7 +115,7 @@ void ContractStatsManager::on_timer(const error_code& ec) {
     if (!stopping) {
         std::lock_guard<std::mutex> lock(timer_mutex);
         if (timer) {
-            timer->expires_from_now(milliseconds(timer_interval));
+            timer->expires_from_now(milliseconds(interval));
             timer->async_wait(bind(&ContractStatsManager::on_timer, this, error));
         }
     }
@@ -320,6 +320,11 @@ FlowBuilder& FlowBuilder::mark(uint32_t value, uint32_t mask) {
     return *this;
 }
 
+FlowBuilder& FlowBuilder::conjId(uint32_t conjId) {
+    match_set_conj_id(match(), conjId);
+    return *this;
+}
+
 FlowBuilder& FlowBuilder::conntrackState(uint32_t ctState, uint32_t mask) {
     match_set_ct_state_masked(match(), ctState, mask);
     return *this;
@@ -8,10 +8,12 @@
 
 #include "FlowConstants.h"
 #include "FlowUtils.h"
-#include "RangeMask.h"
 #include "FlowBuilder.h"
 #include "eth.h"
 #include "ovs-shim.h"
+#include "ovs-ofputil.h"
+
+#include <opflexagent/RangeMask.h>
 
 #include <modelgbp/l2/EtherTypeEnumT.hpp>
 #include <modelgbp/l4/TcpFlagsEnumT.hpp>
@@ -21,6 +23,7 @@
 
 #include <vector>
 #include <functional>
+#include <cstring>
 
 namespace opflexagent {
 namespace flowutils {
@@ -144,38 +147,40 @@ void add_l2classifier_entries(L24Classifier& clsfr, ClassAction act,
     entries.push_back(f.build());
 }
 
-void add_classifier_entries(L24Classifier& clsfr, ClassAction act,
-                            boost::optional<const network::subnets_t&> sourceSub,
-                            boost::optional<const network::subnets_t&> destSub,
-                            uint8_t nextTable, uint16_t priority,
-                            uint32_t flags, uint64_t cookie,
-                            uint32_t svnid, uint32_t dvnid,
-                            /* out */ FlowEntryList& entries) {
+static void
+add_classifier_entries_masked(L24Classifier& clsfr,
+                              const MaskList& srcPortMasks,
+                              const MaskList& dstPortMasks,
+                              ClassAction act,
+                              boost::optional<const network::subnets_t&> sourceSub,
+                              boost::optional<const network::subnets_t&> destSub,
+                              uint8_t nextTable, uint16_t priority,
+                              uint32_t flags, uint64_t cookie,
+                              uint32_t svnid, uint32_t dvnid,
+                              /* out */ FlowEntryList& entries) {
     using modelgbp::l4::TcpFlagsEnumT;
 
+    /* An "ignore" mask for empty ranges - makes the loop later easy */
+    static const MaskList ignoreMask(1, Mask(0x0, 0x0));
+
     ovs_be64 ckbe = ovs_htonll(cookie);
-    MaskList srcPorts;
-    MaskList dstPorts;
+    MaskList icmpType;
+    MaskList icmpCode;
+    const MaskList* srcPortsp = &srcPortMasks;
+    const MaskList* dstPortsp = &dstPortMasks;
     if (clsfr.getProt(0) == 1 &&
         (clsfr.isIcmpTypeSet() || clsfr.isIcmpCodeSet())) {
         if (clsfr.isIcmpTypeSet()) {
-            srcPorts.push_back(Mask(clsfr.getIcmpType(0), ~0));
+            icmpType.push_back(Mask(clsfr.getIcmpType(0), ~0));
         }
         if (clsfr.isIcmpCodeSet()) {
-            dstPorts.push_back(Mask(clsfr.getIcmpCode(0), ~0));
+            icmpCode.push_back(Mask(clsfr.getIcmpCode(0), ~0));
         }
-    } else {
-        RangeMask::getMasks(clsfr.getSFromPort(), clsfr.getSToPort(), srcPorts);
-        RangeMask::getMasks(clsfr.getDFromPort(), clsfr.getDToPort(), dstPorts);
-    }
-
-    /* Add a "ignore" mask to empty ranges - makes the loop later easy */
-    if (srcPorts.empty()) {
-        srcPorts.push_back(Mask(0x0, 0x0));
-    }
-    if (dstPorts.empty()) {
-        dstPorts.push_back(Mask(0x0, 0x0));
+        srcPortsp = &icmpType;
+        dstPortsp = &icmpCode;
     }
+    const MaskList& srcPorts = srcPortsp->empty() ? ignoreMask : *srcPortsp;
+    const MaskList& dstPorts = dstPortsp->empty() ? ignoreMask : *dstPortsp;
 
     vector<uint32_t> tcpFlagsVec;
     uint32_t tcpFlags = clsfr.getTcpFlags(TcpFlagsEnumT::CONST_UNSPECIFIED);
@@ -293,6 +298,37 @@ void add_classifier_entries(L24Classifier& clsfr, ClassAction act,
     }
 }
 
+void add_classifier_entries(L24Classifier& clsfr, ClassAction act,
+                            boost::optional<const network::subnets_t&> sourceSub,
+                            boost::optional<const network::subnets_t&> destSub,
+                            uint8_t nextTable, uint16_t priority,
+                            uint32_t flags, uint64_t cookie,
+                            uint32_t svnid, uint32_t dvnid,
+                            /* out */ FlowEntryList& entries) {
+    MaskList srcPorts;
+    MaskList dstPorts;
+    RangeMask::getMasks(clsfr.getSFromPort(), clsfr.getSToPort(), srcPorts);
+    RangeMask::getMasks(clsfr.getDFromPort(), clsfr.getDToPort(), dstPorts);
+    add_classifier_entries_masked(clsfr, srcPorts, dstPorts, act,
+                                  sourceSub, destSub, nextTable, priority,
+                                  flags, cookie, svnid, dvnid, entries);
+}
+
+void add_classifier_entries(const PolicyRule& rule, ClassAction act,
+                            boost::optional<const network::subnets_t&> sourceSub,
+                            boost::optional<const network::subnets_t&> destSub,
+                            uint8_t nextTable,
+                            uint32_t flags, uint64_t cookie,
+                            uint32_t svnid, uint32_t dvnid,
+                            /* out */ FlowEntryList& entries) {
+    add_classifier_entries_masked(*rule.getL24Classifier(),
+                                  rule.getSrcPortMasks(),
+                                  rule.getDstPortMasks(), act,
+                                  sourceSub, destSub, nextTable,
+                                  rule.getPriority(),
+                                  flags, cookie, svnid, dvnid, entries);
+}
+
 FlowBuilder& match_dhcp_req(FlowBuilder& fb, bool v4) {
     fb.proto(17);
     if (v4) {
@@ -307,5 +343,35 @@ FlowBuilder& match_dhcp_req(FlowBuilder& fb, bool v4) {
     return fb;
 }
 
+FlowEntryPtr conjunction_clause(const FlowEntry& fe,
+                                const std::vector<uint32_t>& conjIds,
+                                uint8_t clause, uint8_t nClauses) {
+    FlowBuilder f;
+    f.table(fe.entry->table_id)
+     .priority(fe.entry->priority);
+    for (uint32_t conjId : conjIds)
+        f.action().conjunction(conjId, clause, nClauses);
+    FlowEntryPtr clauseEntry = f.build();
+    clauseEntry->entry->match = fe.entry->match;
+    return clauseEntry;
+}
+
+FlowEntryPtr conjunction_action(const FlowEntry& fe, uint32_t conjId) {
+    FlowEntryPtr actEntry = FlowBuilder()
+        .table(fe.entry->table_id)
+        .priority(fe.entry->priority)
+        .cookie(fe.entry->cookie)
+        .flags(fe.entry->flags)
+        .conjId(conjId)
+        .build();
+    if (fe.entry->ofpacts_len > 0) {
+        void* acts = malloc(fe.entry->ofpacts_len);
+        memcpy(acts, fe.entry->ofpacts, fe.entry->ofpacts_len);
+        actEntry->entry->ofpacts = (struct ofpact*)acts;
+        actEntry->entry->ofpacts_len = fe.entry->ofpacts_len;
+    }
+    return actEntry;
+}
+
 } // namespace flowutils
 } // namespace opflexagent
@@ -10,6 +10,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <tuple>
 #include <boost/system/error_code.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -39,6 +42,7 @@
 #include <opflexagent/EndpointManager.h>
 #include <opflexagent/Faults.h>
 #include <opflexagent/Network.h>
+#include <opflexagent/RangeMask.h>
 
 #include "SwitchConnection.h"
 #include "IntFlowManager.h"
@@ -49,7 +53,6 @@
 #include "FlowUtils.h"
 #include "FlowConstants.h"
 #include "FlowBuilder.h"
-#include "RangeMask.h"
 
 #include "arp.h"
 #include "eth.h"
@@ -94,7 +97,7 @@ namespace opflexagent {
 static const char* ID_NAMESPACES[] =
     {"floodDomain", "bridgeDomain", "routingDomain",
      "externalNetwork", "l24classifierRule",
-     "svcstats", "service"};
+     "svcstats", "service", "serviceGroup"};
 
 static const char* ID_NMSPC_FD            = ID_NAMESPACES[0];
 static const char* ID_NMSPC_BD            = ID_NAMESPACES[1];
@@ -103,6 +106,11 @@ static const char* ID_NMSPC_EXTNET        = ID_NAMESPACES[3];
 static const char* ID_NMSPC_L24CLASS_RULE = ID_NAMESPACES[4];
 static const char* ID_NMSPC_SVCSTATS      = ID_NAMESPACES[5];
 static const char* ID_NMSPC_SERVICE       = ID_NAMESPACES[6];
+static const char* ID_NMSPC_SVCGROUP      = ID_NAMESPACES[7];
+
+/* Marks group IDs of service select groups, which are allocated
+ * separately from the flood group IDs */
+static const uint32_t SERVICE_GROUP_FLAG = 1u << 31;
 
 
 
@@ -152,7 +160,8 @@ IntFlowManager::IntFlowManager(Agent& agent_,
     floodScope(FLOOD_DOMAIN), tunnelPortStr("4789"),
     virtualRouterEnabled(false), routerAdv(false),
     virtualDHCPEnabled(false), conntrackEnabled(false), dropLogRemotePort(0),
-    serviceStatsFlowDisabled(false),
+    serviceStatsFlowDisabled(false), serviceStatsAggregated(false),
+    serviceSelectGroups(false),
     advertManager(agent, *this), isSyncing(false), stopping(false) {
     // set up flow tables
     switchManager.setMaxFlowTables(NUM_FLOW_TABLES);
@@ -315,6 +324,11 @@ void IntFlowManager::setEndpointAdv(AdvertManager::EndpointAdvMode mode,
     advertManager.enableTunnelEndpointAdv(tunnelMode, tunnelAdvIntvl);
 }
 
+void IntFlowManager::setEndpointAdvRate(uint32_t pps, bool bundles) {
+    advertManager.setAdvRateLimit(pps);
+    advertManager.enableAdvBundles(bundles);
+}
+
 void IntFlowManager::setMulticastGroupFile(const std::string& mcastGroupFile) {
     this->mcastGroupFile = mcastGroupFile;
 }
@@ -323,6 +337,14 @@ void IntFlowManager::enableConnTrack() {
     conntrackEnabled = true;
 }
 
+void IntFlowManager::enableServiceSelectGroups() {
+    serviceSelectGroups = true;
+}
+
+void IntFlowManager::enableServiceStatsAggregation() {
+    serviceStatsAggregated = true;
+}
+
 address IntFlowManager::getEPGTunnelDst(const URI& epgURI) {
     if (encapType != IntFlowManager::ENCAP_VXLAN &&
         encapType != IntFlowManager::ENCAP_IVXLAN)
@@ -1336,6 +1358,19 @@ static void matchServiceProto (FlowBuilder& flow, uint8_t proto,
     }
 }
 
+// key of a service mapping within its service
+static std::string
+getServiceMappingKey(const Service::ServiceMapping& sm) {
+    std::string key = sm.getServiceIP() ? sm.getServiceIP().get() : "";
+    key += ":";
+    if (sm.getServiceProto())
+        key += sm.getServiceProto().get();
+    key += ":";
+    if (sm.getServicePort())
+        key += std::to_string(sm.getServicePort().get());
+    return key;
+}
+
 static void matchActionServiceProto(FlowBuilder& flow, uint8_t proto,
                                     const Service::ServiceMapping& sm,
                                     bool forward, bool applyAction) {
@@ -1396,9 +1431,9 @@ bool getHostAccess(EndpointManager& epMgr,
                    SwitchManager& switchMgr,
                    uint32_t& hostPort,
                    uint8_t* hostMac) {
-    unordered_set<std::string> eps;
-    epMgr.getEndpointsByAccessIface("veth_host_ac", eps);
-    for (const std::string& ep : eps) {
+    ep_set_view_t eps = epMgr.getEndpointsByAccessIface("veth_host_ac");
+    if (!eps) return false;
+    for (const std::string& ep : *eps) {
         shared_ptr<const Endpoint> epWrapper = epMgr.getEndpoint(ep);
         if (epWrapper) {
            const Endpoint& endPoint = *epWrapper.get();
@@ -2217,6 +2252,15 @@ void IntFlowManager::
 updateSvcStatsCounters (const uint64_t &cookie,
                         const uint64_t &newPktCount,
                         const uint64_t &newByteCount)
+{
+    SvcStatsCounterMap counters;
+    counters.emplace(cookie, SvcStatsCounter(newPktCount, newByteCount));
+    updateSvcStatsCounters(counters);
+}
+
+// Called from ServiceStatsManager to update stats of a polling interval
+void IntFlowManager::
+updateSvcStatsCounters (const SvcStatsCounterMap& counters)
 {
     const std::lock_guard<mutex> lock(svcStatMutex);
 
@@ -2228,14 +2272,6 @@ updateSvcStatsCounters (const uint64_t &cookie,
     if (serviceStatsFlowDisabled)
         return;
 
-    boost::optional<std::string> str =
-        idGen.getStringForId(ID_NMSPC_SVCSTATS, cookie);
-    if (str == boost::none) {
-        LOG(ERROR) << "Cookie: " << cookie
-                   << " to svc metric translation does not exist";
-        return;
-    }
-
     // The idgen strings for epToSvc and svcToEp will have below format
     // eptosvc:ep-uuid:svc-uuid
     // svctoep:ep-uuid:svc-uuid
@@ -2252,24 +2288,166 @@ updateSvcStatsCounters (const uint64_t &cookie,
     // notosvc:svc-nod:svc-uuid:nh-ip
     // svctono:svc-nod:svc-uuid:nh-ip
 
-    const string& statType = str.get().substr(0,7);
-    if ((statType == "eptosvc") || (statType == "svctoep")) {
-        updatePodSvcStatsCounters(cookie,
-                                  statType == "eptosvc",
-                                  str.get(),
-                                  newPktCount,
-                                  newByteCount);
-    } else if ((statType == "antosvc") || (statType == "svctoan")
-                || (statType == "extosvc") || (statType == "svctoex")
-                || (statType == "notosvc") || (statType == "svctono")) {
-        updateSvcTgtStatsCounters(cookie,
-                                  (statType == "antosvc") || (statType == "extosvc") || (statType == "notosvc"),
-                                  str.get(),
-                                  newPktCount,
-                                  newByteCount,
-                                  attr_map(),
-                                  attr_map());
+    // Decode all the cookies first. The rx and tx cookies of a
+    // svc-tgt, and all the svc-tgts of a svc, land on the same
+    // observer object; fold them so that every object is read and
+    // written once for the whole batch.
+    typedef std::tuple<string, string, bool> SvcTgtKey;
+    typedef pair<string, bool> SvcKey;
+    std::map<SvcTgtKey, SvcStatsDirCounter> svcTgtCounters;
+    std::map<SvcKey, SvcStatsDirCounter> svcCounters;
+    std::vector<std::tuple<uint64_t, string, SvcStatsCounter> > podSvcCounters;
+
+    for (const auto& c : counters) {
+        const SvcStatsCounter& count = c.second;
+        if (!count.pkts)
+            continue;
+
+        boost::optional<std::string> str =
+            idGen.getStringForId(ID_NMSPC_SVCSTATS, c.first);
+        if (str == boost::none) {
+            LOG(ERROR) << "Cookie: " << c.first
+                       << " to svc metric translation does not exist";
+            continue;
+        }
+
+        const string& idStr = str.get();
+        const string& statType = idStr.substr(0,7);
+        if ((statType == "eptosvc") || (statType == "svctoep")) {
+            podSvcCounters.emplace_back(c.first, idStr, count);
+        } else if ((statType == "antosvc") || (statType == "svctoan")
+                   || (statType == "extosvc") || (statType == "svctoex")
+                   || (statType == "notosvc") || (statType == "svctono")) {
+            size_t pos1 = idStr.find(":");
+            size_t pos2 = idStr.find(":", pos1+1);
+            size_t pos3 = idStr.find(":", pos2+1);
+            const string& svcUuid = idStr.substr(pos2+1, pos3-pos2-1);
+            const string& nhipStr = idStr.substr(pos3+1);
+            bool isIngress = (statType == "antosvc") || (statType == "extosvc")
+                || (statType == "notosvc");
+            bool isNodePort = (statType == "notosvc") || (statType == "svctono");
+
+            SvcStatsDirCounter& tgt =
+                svcTgtCounters[SvcTgtKey(svcUuid, nhipStr, isNodePort)];
+            SvcStatsDirCounter& svc = svcCounters[SvcKey(svcUuid, isNodePort)];
+            SvcStatsCounter& tgtDir = isIngress ? tgt.rx : tgt.tx;
+            SvcStatsCounter& svcDir = isIngress ? svc.rx : svc.tx;
+            tgtDir.pkts += count.pkts;
+            tgtDir.bytes += count.bytes;
+            svcDir.pkts += count.pkts;
+            svcDir.bytes += count.bytes;
+        }
+    }
+
+    Mutator mutator(agent.getFramework(), "policyelement");
+    for (const auto& p : podSvcCounters) {
+        const string& idStr = std::get<1>(p);
+        const SvcStatsCounter& count = std::get<2>(p);
+        updatePodSvcStatsCounters(std::get<0>(p),
+                                  idStr.substr(0,7) == "eptosvc",
+                                  idStr,
+                                  count.pkts,
+                                  count.bytes);
+    }
+    for (const auto& t : svcTgtCounters) {
+        addSvcTgtStatsCounters(std::get<0>(t.first),
+                               std::get<1>(t.first),
+                               std::get<2>(t.first),
+                               t.second);
+    }
+    for (const auto& v : svcCounters) {
+        addSvcStatsCounters(v.first.first, v.first.second, v.second);
+    }
+    mutator.commit();
+}
+
+void IntFlowManager::
+addSvcTgtStatsCounters (const string& svcUuid,
+                        const string& nhipStr,
+                        const bool isNodePort,
+                        const SvcStatsDirCounter& counts)
+{
+    auto opSvcTgt = SvcTargetCounter::resolve(agent.getFramework(),
+                                              svcUuid, nhipStr);
+    if (!opSvcTgt)
+        return;
+
+    uint64_t rxPktCount, rxByteCount, txPktCount, txByteCount;
+    if (isNodePort) {
+        rxPktCount = opSvcTgt.get()->getNodePortRxpackets(0) + counts.rx.pkts;
+        rxByteCount = opSvcTgt.get()->getNodePortRxbytes(0) + counts.rx.bytes;
+        txPktCount = opSvcTgt.get()->getNodePortTxpackets(0) + counts.tx.pkts;
+        txByteCount = opSvcTgt.get()->getNodePortTxbytes(0) + counts.tx.bytes;
+        opSvcTgt.get()->setNodePortRxpackets(rxPktCount)
+                       .setNodePortRxbytes(rxByteCount)
+                       .setNodePortTxpackets(txPktCount)
+                       .setNodePortTxbytes(txByteCount);
+    } else {
+        rxPktCount = opSvcTgt.get()->getRxpackets(0) + counts.rx.pkts;
+        rxByteCount = opSvcTgt.get()->getRxbytes(0) + counts.rx.bytes;
+        txPktCount = opSvcTgt.get()->getTxpackets(0) + counts.tx.pkts;
+        txByteCount = opSvcTgt.get()->getTxbytes(0) + counts.tx.bytes;
+        opSvcTgt.get()->setRxpackets(rxPktCount)
+                       .setRxbytes(rxByteCount)
+                       .setTxpackets(txPktCount)
+                       .setTxbytes(txByteCount);
     }
+#ifdef HAVE_PROMETHEUS_SUPPORT
+    // Both directions are known here, so prom is updated with the
+    // values being committed rather than reading them back from modb.
+    prometheusManager.addNUpdateSvcTargetCounter(isNodePort
+                                                 ? "nodeport-"+svcUuid
+                                                 : svcUuid,
+                                                 nhipStr,
+                                                 rxByteCount,
+                                                 rxPktCount,
+                                                 txByteCount,
+                                                 txPktCount,
+                                                 attr_map(),
+                                                 attr_map(),
+                                                 false, false, isNodePort);
+#endif
+}
+
+void IntFlowManager::
+addSvcStatsCounters (const string& svcUuid,
+                     const bool isNodePort,
+                     const SvcStatsDirCounter& counts)
+{
+    auto opSvc = SvcCounter::resolve(agent.getFramework(), svcUuid);
+    if (!opSvc)
+        return;
+
+    uint64_t rxPktCount, rxByteCount, txPktCount, txByteCount;
+    if (isNodePort) {
+        rxPktCount = opSvc.get()->getNodePortRxpackets(0) + counts.rx.pkts;
+        rxByteCount = opSvc.get()->getNodePortRxbytes(0) + counts.rx.bytes;
+        txPktCount = opSvc.get()->getNodePortTxpackets(0) + counts.tx.pkts;
+        txByteCount = opSvc.get()->getNodePortTxbytes(0) + counts.tx.bytes;
+        opSvc.get()->setNodePortRxpackets(rxPktCount)
+                    .setNodePortRxbytes(rxByteCount)
+                    .setNodePortTxpackets(txPktCount)
+                    .setNodePortTxbytes(txByteCount);
+    } else {
+        rxPktCount = opSvc.get()->getRxpackets(0) + counts.rx.pkts;
+        rxByteCount = opSvc.get()->getRxbytes(0) + counts.rx.bytes;
+        txPktCount = opSvc.get()->getTxpackets(0) + counts.tx.pkts;
+        txByteCount = opSvc.get()->getTxbytes(0) + counts.tx.bytes;
+        opSvc.get()->setRxpackets(rxPktCount)
+                    .setRxbytes(rxByteCount)
+                    .setTxpackets(txPktCount)
+                    .setTxbytes(txByteCount);
+    }
+#ifdef HAVE_PROMETHEUS_SUPPORT
+    prometheusManager.addNUpdateSvcCounter(isNodePort
+                                           ? "nodeport-"+svcUuid
+                                           : svcUuid,
+                                           rxByteCount,
+                                           rxPktCount,
+                                           txByteCount,
+                                           txPktCount,
+                                           attr_map(), isNodePort);
+#endif
 }
 
 void IntFlowManager::
@@ -2505,7 +2683,8 @@ updateSvcTgtStatsCounters (const uint64_t &cookie,
     updateSvcStatsCounters(isIngress, svcUuid, newPktCount, newByteCount, true, isNodePort);
 }
 
-// Private function to update stats and attributes
+// Private function to update stats and attributes. Must be called
+// with a mutator in scope.
 void IntFlowManager::
 updatePodSvcStatsCounters (const uint64_t &cookie,
                            const bool& isEpToSvc,
@@ -2539,7 +2718,6 @@ updatePodSvcStatsCounters (const uint64_t &cookie,
     const Endpoint& endPoint = *epWrapper.get();
     const attr_map &epAttr = endPoint.getAttributes();
 
-    Mutator mutator(agent.getFramework(), "policyelement");
     optional<shared_ptr<SvcStatUniverse> > su =
         SvcStatUniverse::resolve(agent.getFramework());
     if (su) {
@@ -2605,7 +2783,6 @@ updatePodSvcStatsCounters (const uint64_t &cookie,
             }
         }
     }
-    mutator.commit();
 }
 
 // Clear pod svc objects
@@ -3143,9 +3320,11 @@ void IntFlowManager::updateSvcNodeStatsFlows (const string &uuid,
             }
         }
 
-        unordered_set<std::string> eps;
-        agent.getEndpointManager().getEndpointsByAccessIface("veth_host_ac", eps);
-        for (const std::string& ep : eps) {
+        ep_set_view_t eps =
+            agent.getEndpointManager().getEndpointsByAccessIface("veth_host_ac");
+        if (!eps)
+            return;
+        for (const std::string& ep : *eps) {
             shared_ptr<const Endpoint> epWrapper = agent.getEndpointManager().getEndpoint(ep);
             if (!epWrapper)
                 break;
@@ -3443,6 +3622,15 @@ void IntFlowManager::updateSvcTgtStatsFlows (const string &uuid,
         updateSvcTgtStatsCounters(cookieIdIg, true, ingStr, 0, 0, svcAttr, epAttr);
         updateSvcTgtStatsCounters(cookieIdEg, false, egrStr, 0, 0, svcAttr, epAttr);
 
+        // In aggregated mode the cookies are only attached to the
+        // service next hop and reverse flows, which are already per
+        // (svc, svc-tgt), so no stats table flows are needed.  Those
+        // flows match the service IP, so traffic sent straight to the
+        // target IP is not counted in that mode, unlike with the
+        // stats flows below which match the target IP and port.
+        if (serviceStatsAggregated)
+            return;
+
         FlowBuilder anyToSvc; // to service stats
         FlowBuilder svcToAny; // from service stats
 
@@ -3524,7 +3712,7 @@ void IntFlowManager::updateSvcTgtStatsFlows (const string &uuid,
 
         // flush svc-tgt counters and idgen cookies of NH flows that got
         // removed due to config updates of svc or ep/nh
-        if (!uuid_felist_map.size()) {
+        if (nhips.empty()) {
             LOG(TRACE) << "####*<-->svc-tgt no flows created for svc_uuid: " << uuid;
             // clear obs and prom metrics during update;
             // below will be no-op during create
@@ -3671,8 +3859,12 @@ void IntFlowManager::updatePodSvcStatsFlows (const string &uuid,
 
         // Note: the objects are created once. But we still call below counter
         // updates to take care of ep/svc attr changes
-        updatePodSvcStatsCounters(podSvcUuidCkMap[uuid].first, true, ingStr, 0, 0);
-        updatePodSvcStatsCounters(podSvcUuidCkMap[uuid].second, false, egrStr, 0, 0);
+        {
+            Mutator mutator(agent.getFramework(), "policyelement");
+            updatePodSvcStatsCounters(podSvcUuidCkMap[uuid].first, true, ingStr, 0, 0);
+            updatePodSvcStatsCounters(podSvcUuidCkMap[uuid].second, false, egrStr, 0, 0);
+            mutator.commit();
+        }
 
         FlowBuilder epToSvc; // to service stats
         FlowBuilder svcToEp; // from service stats
@@ -3968,6 +4160,7 @@ void IntFlowManager::programServiceSnatDnatFlows (const string& uuid)
             }
 
 
+            const string& smKey = getServiceMappingKey(sm);
             uint16_t link = 0;
             for (const address& nextHopAddr : nextHopAddrs) {
                 {
@@ -3976,10 +4169,16 @@ void IntFlowManager::programServiceSnatDnatFlows (const string& uuid)
                     matchActionServiceProto(ipMap, proto, sm, true, true);
                     ipMap.ipDst(serviceAddr);
 
-                    // use the first address as a "default" so that
-                    // there is no transient case where there is no
-                    // match while flows are updated.
-                    if (link == 0) {
+                    if (serviceSelectGroups) {
+                        // match the stable bucket ID set by the
+                        // select group
+                        ipMap.priority(100)
+                            .reg(7, getServiceBucketId(uuid, smKey,
+                                                       nextHopAddr.to_string()));
+                    } else if (link == 0) {
+                        // use the first address as a "default" so
+                        // that there is no transient case where there
+                        // is no match while flows are updated.
                         ipMap.priority(99);
                     } else {
                         ipMap.priority(100)
@@ -4148,6 +4347,7 @@ void IntFlowManager::handleServiceUpdate(const string& uuid) {
         switchManager.clearFlows(uuid, SERVICE_REV_TABLE_ID);
         switchManager.clearFlows(uuid, SERVICE_DST_TABLE_ID);
         switchManager.clearFlows(uuid, SERVICE_NEXTHOP_TABLE_ID);
+        writeServiceGroups(uuid, {});
         updateSvcStatsFlows(uuid, true, false);
         idGen.erase(ID_NMSPC_SERVICE, uuid);
         return;
@@ -4158,6 +4358,7 @@ void IntFlowManager::handleServiceUpdate(const string& uuid) {
     FlowEntryList secFlows;
     FlowEntryList bridgeFlows;
     FlowEntryList serviceDstFlows;
+    std::unordered_map<std::string, std::vector<std::string> > svcGroups;
 
     boost::system::error_code ec;
 
@@ -4255,13 +4456,23 @@ void IntFlowManager::handleServiceUpdate(const string& uuid) {
                     } else {
                         serviceDest.action().ethDst(getRouterMacAddr());
                     }
-                    serviceDest.action()
-                        .multipath(NX_HASH_FIELDS_SYMMETRIC_L3L4_UDP,
-                                   1024,
-                                   ActionBuilder::NX_MP_ALG_ITER_HASH,
-                                   static_cast<uint16_t>(nextHopAddrs.size()-1),
-                                   32, MFF_REG7)
-                        .go(SERVICE_NEXTHOP_TABLE_ID);
+                    if (serviceSelectGroups) {
+                        // the group buckets select the next hop
+                        const string& smKey = getServiceMappingKey(sm);
+                        vector<string>& groupNhs = svcGroups[smKey];
+                        for (const address& nextHopAddr : nextHopAddrs)
+                            groupNhs.push_back(nextHopAddr.to_string());
+                        serviceDest.action()
+                            .group(getServiceGroupId(uuid, smKey));
+                    } else {
+                        serviceDest.action()
+                            .multipath(NX_HASH_FIELDS_SYMMETRIC_L3L4_UDP,
+                                       1024,
+                                       ActionBuilder::NX_MP_ALG_ITER_HASH,
+                                       static_cast<uint16_t>(nextHopAddrs.size()-1),
+                                       32, MFF_REG7)
+                            .go(SERVICE_NEXTHOP_TABLE_ID);
+                    }
                 } else if (as.getServiceMode() == Service::LOCAL_ANYCAST &&
                            ofPort != OFPP_NONE) {
                     serviceDest.action()
@@ -4426,6 +4637,8 @@ void IntFlowManager::handleServiceUpdate(const string& uuid) {
     }
 
     programServiceSnatDnatFlows(uuid);
+    // the groups must exist before the flows that refer to them
+    writeServiceGroups(uuid, svcGroups);
     switchManager.writeFlow(uuid, SEC_TABLE_ID, secFlows);
     switchManager.writeFlow(uuid, BRIDGE_TABLE_ID, bridgeFlows);
     switchManager.writeFlow(uuid, SERVICE_DST_TABLE_ID, serviceDstFlows);
@@ -5066,19 +5279,21 @@ void IntFlowManager::handleEndpointGroupDomainUpdate(const URI& epgURI) {
     }
     switchManager.writeFlow(epgId, OUT_TABLE_ID, egOutFlows);
 
-    unordered_set<string> epUuids;
     EndpointManager& epMgr = agent.getEndpointManager();
-    epMgr.getEndpointsForIPMGroup(epgURI, epUuids);
+    ep_set_view_t ipmEps = epMgr.getEndpointsForIPMGroup(epgURI);
+    ep_set_view_t groupEps = epMgr.getEndpointsForGroup(epgURI);
     std::unordered_set<URI> ipmRds;
-    for (const string& uuid : epUuids) {
-        std::shared_ptr<const Endpoint> ep = epMgr.getEndpoint(uuid);
-        if (!ep) continue;
-        const boost::optional<opflex::modb::URI>& egURI = ep->getEgURI();
-        if (!egURI) continue;
-        boost::optional<std::shared_ptr<modelgbp::gbp::RoutingDomain> > rd =
-            polMgr.getRDForGroup(egURI.get());
-        if (rd)
-            ipmRds.insert(rd.get()->getURI());
+    if (ipmEps) {
+        for (const string& uuid : *ipmEps) {
+            std::shared_ptr<const Endpoint> ep = epMgr.getEndpoint(uuid);
+            if (!ep) continue;
+            const boost::optional<opflex::modb::URI>& egURI = ep->getEgURI();
+            if (!egURI) continue;
+            boost::optional<std::shared_ptr<modelgbp::gbp::RoutingDomain> > rd =
+                polMgr.getRDForGroup(egURI.get());
+            if (rd)
+                ipmRds.insert(rd.get()->getURI());
+        }
     }
     for (const URI& rdURI : ipmRds) {
         // update routing domains that have references to the
@@ -5087,11 +5302,20 @@ void IntFlowManager::handleEndpointGroupDomainUpdate(const URI& epgURI) {
         rdConfigUpdated(rdURI);
     }
 
-    // note this combines with the IPM group endpoints from above:
-    epMgr.getEndpointsForGroup(epgURI, epUuids);
-    for (const string& uuid : epUuids) {
-        advertManager.scheduleEndpointAdv(uuid);
-        endpointUpdated(uuid);
+    // update the group endpoints along with the IPM group endpoints
+    // from above, visiting each endpoint once
+    if (groupEps) {
+        for (const string& uuid : *groupEps) {
+            advertManager.scheduleEndpointAdv(uuid);
+            endpointUpdated(uuid);
+        }
+    }
+    if (ipmEps) {
+        for (const string& uuid : *ipmEps) {
+            if (groupEps && groupEps->count(uuid)) continue;
+            advertManager.scheduleEndpointAdv(uuid);
+            endpointUpdated(uuid);
+        }
     }
 
     PolicyManager::uri_set_t contractURIs;
@@ -5199,12 +5423,12 @@ void IntFlowManager::handleLocalExternalDomainUpdated(const opflex::modb::URI &e
 
     switchManager.writeFlow(epgId, OUT_TABLE_ID, egOutFlows);
 
-    unordered_set<string> epUuids;
-    // note this combines with the IPM group endpoints from above:
-    epMgr.getEndpointsForGroup(epgURI, epUuids);
-    for (const string& uuid : epUuids) {
-        advertManager.scheduleEndpointAdv(uuid);
-        endpointUpdated(uuid);
+    ep_set_view_t epUuids = epMgr.getEndpointsForGroup(epgURI);
+    if (epUuids) {
+        for (const string& uuid : *epUuids) {
+            advertManager.scheduleEndpointAdv(uuid);
+            endpointUpdated(uuid);
+        }
     }
 
 }
@@ -5567,6 +5791,183 @@ IntFlowManager::createGroupMod(uint16_t type, uint32_t groupId,
     return entry;
 }
 
+GroupEdit::Entry
+IntFlowManager::createBucketMod(uint16_t type, uint32_t groupId,
+                                const std::unordered_set<uint32_t>& ports) {
+    GroupEdit::Entry entry(new GroupEdit::GroupMod());
+    entry->mod->command = type;
+    entry->mod->group_id = groupId;
+
+    if (type == OFPGC15_REMOVE_BUCKET) {
+        // bucket IDs are the port numbers
+        entry->mod->command_bucket_id = *ports.begin();
+        return entry;
+    }
+    entry->mod->command_bucket_id = OFPG15_BUCKET_LAST;
+    for (uint32_t port : ports) {
+        ofputil_bucket *bkt = createBucket(port);
+        ActionBuilder().output(port).build(bkt);
+        ovs_list_push_back(&entry->mod->buckets, &bkt->list_node);
+    }
+    return entry;
+}
+
+uint32_t IntFlowManager::getServiceGroupId(const std::string& uuid,
+                                           const std::string& smKey) {
+    return idGen.getId(ID_NMSPC_SVCGROUP, uuid + ":" + smKey) |
+        SERVICE_GROUP_FLAG;
+}
+
+uint32_t IntFlowManager::getServiceBucketId(const std::string& uuid,
+                                            const std::string& smKey,
+                                            const std::string& nextHop) {
+    ServiceGroup& sg = serviceGroups[uuid][smKey];
+    auto it = sg.buckets.find(nextHop);
+    if (it != sg.buckets.end())
+        return it->second;
+    uint32_t bucketId = sg.nextBucketId++;
+    sg.buckets.emplace(nextHop, bucketId);
+    return bucketId;
+}
+
+GroupEdit::Entry
+IntFlowManager::createServiceGroupMod(uint16_t type, uint32_t groupId,
+                                      const ServiceGroup* sg,
+                                      const std::unordered_set<uint32_t>* bucketIds) {
+    GroupEdit::Entry entry(new GroupEdit::GroupMod());
+    entry->mod->command = type;
+    entry->mod->group_id = groupId;
+    entry->mod->type = OFPGT11_SELECT;
+    if (type == OFPGC15_INSERT_BUCKET)
+        entry->mod->command_bucket_id = OFPG15_BUCKET_LAST;
+    if (type == OFPGC11_DELETE || sg == NULL)
+        return entry;
+
+    // order the buckets by ID so the group compares equal to what
+    // is read back from the switch
+    std::vector<uint32_t> ids;
+    for (const auto& kv : sg->buckets) {
+        if (bucketIds == NULL || bucketIds->count(kv.second))
+            ids.push_back(kv.second);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (uint32_t bucketId : ids) {
+        ofputil_bucket *bkt = createBucket(bucketId);
+        bkt->weight = 1;
+        ActionBuilder()
+            .reg(MFF_REG7, bucketId)
+            .resubmit(OFPP_IN_PORT, SERVICE_NEXTHOP_TABLE_ID)
+            .build(bkt);
+        ovs_list_push_back(&entry->mod->buckets, &bkt->list_node);
+    }
+    return entry;
+}
+
+void IntFlowManager::
+writeServiceGroups(const std::string& uuid,
+                   const std::unordered_map<std::string,
+                   std::vector<std::string> >& active) {
+    auto sit = serviceGroups.find(uuid);
+    if (sit == serviceGroups.end() && active.empty())
+        return;
+
+    SwitchConnection* conn = switchManager.getConnection();
+    bool bucketMods =
+        conn != NULL && conn->GetProtocolVersion() >= OFP15_VERSION;
+
+    ServiceGroupMap& groups = serviceGroups[uuid];
+    for (auto it = groups.begin(); it != groups.end(); ) {
+        if (active.find(it->first) != active.end()) {
+            ++it;
+            continue;
+        }
+        const string groupStr = uuid + ":" + it->first;
+        if (it->second.written) {
+            uint32_t groupId =
+                idGen.getId(ID_NMSPC_SVCGROUP, groupStr) | SERVICE_GROUP_FLAG;
+            switchManager.writeGroupMod(createServiceGroupMod(OFPGC11_DELETE,
+                                                              groupId, NULL));
+        }
+        idGen.erase(ID_NMSPC_SVCGROUP, groupStr);
+        it = groups.erase(it);
+    }
+
+    for (const auto& kv : active) {
+        ServiceGroup& sg = groups[kv.first];
+        uint32_t groupId = getServiceGroupId(uuid, kv.first);
+
+        std::unordered_set<string> nextHops(kv.second.begin(),
+                                            kv.second.end());
+        for (auto bit = sg.buckets.begin(); bit != sg.buckets.end(); ) {
+            if (nextHops.count(bit->first))
+                ++bit;
+            else
+                bit = sg.buckets.erase(bit);
+        }
+
+        // the next hop flows may already have allocated the bucket
+        // IDs, so compare with the buckets installed on the switch
+        std::unordered_set<uint32_t> current;
+        for (const string& nextHop : kv.second)
+            current.insert(getServiceBucketId(uuid, kv.first, nextHop));
+        std::unordered_set<uint32_t> removed;
+        for (uint32_t bucketId : sg.installed) {
+            if (!current.count(bucketId))
+                removed.insert(bucketId);
+        }
+        std::unordered_set<uint32_t> added;
+        for (uint32_t bucketId : current) {
+            if (!sg.installed.count(bucketId))
+                added.insert(bucketId);
+        }
+        sg.installed.swap(current);
+
+        if (!sg.written) {
+            switchManager.writeGroupMod(createServiceGroupMod(OFPGC11_ADD,
+                                                              groupId, &sg));
+            sg.written = true;
+        } else if (!bucketMods) {
+            if (!removed.empty() || !added.empty())
+                switchManager.writeGroupMod(
+                    createServiceGroupMod(OFPGC11_MODIFY, groupId, &sg));
+        } else {
+            for (uint32_t bucketId : removed) {
+                GroupEdit::Entry e =
+                    createServiceGroupMod(OFPGC15_REMOVE_BUCKET, groupId, NULL);
+                e->mod->command_bucket_id = bucketId;
+                switchManager.writeGroupMod(e);
+            }
+            if (!added.empty())
+                switchManager.writeGroupMod(
+                    createServiceGroupMod(OFPGC15_INSERT_BUCKET, groupId,
+                                          &sg, &added));
+        }
+    }
+
+    if (groups.empty())
+        serviceGroups.erase(uuid);
+}
+
+void IntFlowManager::addFloodGroupPort(const URI& fgrpURI,
+                                       FloodGroup& fgrp, uint32_t port) {
+    FloodGroupDelta& delta = dirtyFloodGroups[fgrpURI];
+    if (fgrp.portRefs[port]++ == 0 && delta.removed.erase(port) == 0)
+        delta.added.insert(port);
+    floodGroupsUpdated();
+}
+
+void IntFlowManager::removeFloodGroupPort(const URI& fgrpURI,
+                                          FloodGroup& fgrp, uint32_t port) {
+    FloodGroupDelta& delta = dirtyFloodGroups[fgrpURI];
+    auto it = fgrp.portRefs.find(port);
+    if (it != fgrp.portRefs.end() && --it->second == 0) {
+        fgrp.portRefs.erase(it);
+        if (delta.added.erase(port) == 0)
+            delta.removed.insert(port);
+    }
+    floodGroupsUpdated();
+}
+
 void
 IntFlowManager::
 updateEndpointFloodGroup(const opflex::modb::URI& fgrpURI,
@@ -5581,31 +5982,40 @@ updateEndpointFloodGroup(const opflex::modb::URI& fgrpURI,
         localExternalFdSet.insert(fgrpId);
     }
     if (fgrpItr != floodGroupMap.end()) {
-        Ep2PortMap& epMap = fgrpItr->second;
-        Ep2PortMap::iterator epItr = epMap.find(epUUID);
+        FloodGroup& fgrp = fgrpItr->second;
+        Ep2PortMap::iterator epItr = fgrp.eps.find(epUUID);
 
-        if (epItr == epMap.end()) {
+        if (epItr == fgrp.eps.end()) {
             /* EP not attached to this flood-group, check and remove
              * if it was attached to a different one */
             removeEndpointFromFloodGroup(epUUID);
-        }
-        if (epItr == epMap.end() || epItr->second != epPort) {
             LOG(DEBUG) << "Adding " << epUUID << " to group " << fgrpId;
-            epMap[epUUID] = epPort;
-            GroupEdit::Entry e = createGroupMod(OFPGC11_MODIFY, fgrpId, epMap);
-            switchManager.writeGroupMod(e);
+            fgrp.eps[epUUID] = epPort;
+            epFloodGroupMap[epUUID] = fgrpURI;
+            addFloodGroupPort(fgrpURI, fgrp, epPort);
+        } else if (epItr->second != epPort) {
+            LOG(DEBUG) << "Moving " << epUUID << " in group " << fgrpId
+                       << " to port " << epPort;
+            removeFloodGroupPort(fgrpURI, fgrp, epItr->second);
+            epItr->second = epPort;
+            addFloodGroupPort(fgrpURI, fgrp, epPort);
         } else if(endPoint.isExternal()) {
             /* Uplink could've come up.
              * When uplink goes down, it is handled in the domain change*/
-            GroupEdit::Entry e = createGroupMod(OFPGC11_MODIFY, fgrpId, epMap);
-            switchManager.writeGroupMod(e);
-	}
+            dirtyFloodGroups[fgrpURI].full = true;
+            floodGroupsUpdated();
+        }
     } else {
         /* Remove EP attachment to old floodgroup, if any */
         removeEndpointFromFloodGroup(epUUID);
-        floodGroupMap[fgrpURI][epUUID] = epPort;
+        FloodGroup& fgrp = floodGroupMap[fgrpURI];
+        fgrp.eps[epUUID] = epPort;
+        fgrp.portRefs[epPort] = 1;
+        epFloodGroupMap[epUUID] = fgrpURI;
+        // the add carries the full bucket list
+        dirtyFloodGroups.erase(fgrpURI);
         GroupEdit::Entry e =
-            createGroupMod(OFPGC11_ADD, fgrpId, floodGroupMap[fgrpURI]);
+            createGroupMod(OFPGC11_ADD, fgrpId, fgrp.eps);
         switchManager.writeGroupMod(e);
     }
 
@@ -5623,40 +6033,48 @@ updateEndpointFloodGroup(const opflex::modb::URI& fgrpURI,
 }
 
 void IntFlowManager::removeEndpointFromFloodGroup(const std::string& epUUID) {
-    for (FloodGroupMap::iterator itr = floodGroupMap.begin();
-         itr != floodGroupMap.end();
-         ++itr) {
-        const URI& fgrpURI = itr->first;
-        Ep2PortMap& epMap = itr->second;
-        if (epMap.erase(epUUID) == 0) {
-            continue;
-        }
-        uint32_t fgrpId = getId(FloodDomain::CLASS_ID, fgrpURI);
-        uint16_t type = epMap.empty() ?
-                OFPGC11_DELETE : OFPGC11_MODIFY;
-        GroupEdit::Entry e0 =
-                createGroupMod(type, fgrpId, epMap);
-        if (epMap.empty()) {
-            string fgrpStrId = "fd:" + fgrpURI.toString();
-            switchManager.clearFlows(fgrpStrId, OUT_TABLE_ID);
-            switchManager.clearFlows(fgrpStrId, BRIDGE_TABLE_ID);
-            floodGroupMap.erase(fgrpURI);
-        }
-        switchManager.writeGroupMod(e0);
-        break;
+    auto efIt = epFloodGroupMap.find(epUUID);
+    if (efIt == epFloodGroupMap.end())
+        return;
+    const URI fgrpURI = efIt->second;
+    epFloodGroupMap.erase(efIt);
+
+    FloodGroupMap::iterator itr = floodGroupMap.find(fgrpURI);
+    if (itr == floodGroupMap.end())
+        return;
+    FloodGroup& fgrp = itr->second;
+    Ep2PortMap::iterator epItr = fgrp.eps.find(epUUID);
+    if (epItr == fgrp.eps.end())
+        return;
+    uint32_t epPort = epItr->second;
+    fgrp.eps.erase(epItr);
+
+    if (!fgrp.eps.empty()) {
+        removeFloodGroupPort(fgrpURI, fgrp, epPort);
+        return;
     }
+
+    uint32_t fgrpId = getId(FloodDomain::CLASS_ID, fgrpURI);
+    GroupEdit::Entry e0 =
+        createGroupMod(OFPGC11_DELETE, fgrpId, fgrp.eps);
+    string fgrpStrId = "fd:" + fgrpURI.toString();
+    switchManager.clearFlows(fgrpStrId, OUT_TABLE_ID);
+    switchManager.clearFlows(fgrpStrId, BRIDGE_TABLE_ID);
+    floodGroupMap.erase(itr);
+    dirtyFloodGroups.erase(fgrpURI);
+    switchManager.writeGroupMod(e0);
 }
 
 void IntFlowManager::addContractRules(FlowEntryList& entryList,
                              const uint32_t pvnid,
                              const uint32_t cvnid,
                              bool allowBidirectional,
-                             const PolicyManager::rule_list_t& rules) {
-    for (const shared_ptr<PolicyRule>& pc : rules) {
+                             const PolicyRuleSet& rules,
+                             const std::vector<uint64_t>& cookies) {
+    auto ci = cookies.begin();
+    for (const shared_ptr<PolicyRule>& pc : rules.getRules()) {
         uint8_t dir = pc->getDirection();
-        const shared_ptr<L24Classifier>& cls = pc->getL24Classifier();
-        const opflex::modb::URI& ruleURI = cls.get()->getURI();
-        uint64_t cookie = getId(L24Classifier::CLASS_ID, ruleURI);
+        uint64_t cookie = *ci++;
         flowutils::ClassAction act = flowutils::CA_DENY;
         if (pc->getAllow())
             act = flowutils::CA_ALLOW;
@@ -5667,11 +6085,10 @@ void IntFlowManager::addContractRules(FlowEntryList& entryList,
         }
         if (dir == DirectionEnumT::CONST_IN ||
             dir == DirectionEnumT::CONST_BIDIRECTIONAL) {
-            flowutils::add_classifier_entries(*cls, act,
+            flowutils::add_classifier_entries(*pc, act,
                                               boost::none,
                                               boost::none,
                                               IntFlowManager::STATS_TABLE_ID,
-                                              pc->getPriority(),
                                               OFPUTIL_FF_SEND_FLOW_REM,
                                               cookie,
                                               cvnid, pvnid,
@@ -5679,11 +6096,10 @@ void IntFlowManager::addContractRules(FlowEntryList& entryList,
         }
         if (dir == DirectionEnumT::CONST_OUT ||
             dir == DirectionEnumT::CONST_BIDIRECTIONAL) {
-            flowutils::add_classifier_entries(*cls, act,
+            flowutils::add_classifier_entries(*pc, act,
                                               boost::none,
                                               boost::none,
                                               IntFlowManager::STATS_TABLE_ID,
-                                              pc->getPriority(),
                                               OFPUTIL_FF_SEND_FLOW_REM,
                                               cookie,
                                               pvnid, cvnid,
@@ -5717,16 +6133,33 @@ IntFlowManager::handleContractUpdate(const opflex::modb::URI& contractURI) {
     getGroupVnid(consURIs, consIds);
     getGroupVnid(intraURIs, intraIds);
 
-    PolicyManager::rule_list_t rules;
-    polMgr.getContractRules(contractURI, rules);
+    PolicyManager::rule_snapshot_t rules =
+        polMgr.getContractRuleSnapshot(contractURI);
 
     LOG(DEBUG) << "Update for contract " << contractURI
                << ", #prov=" << provIds.size()
                << ", #cons=" << consIds.size()
                << ", #intra=" << intraIds.size()
-               << ", #rules=" << rules.size();
+               << ", #rules=" << (rules ? rules->getRules().size() : 0)
+               << ", version=" << (rules ? rules->getVersion() : 0);
 
     FlowEntryList entryList;
+    if (!rules) {
+        switchManager.writeFlow(contractId, POL_TABLE_ID, entryList);
+        return;
+    }
+
+    // look up the cookies once rather than for every group pair
+    std::vector<uint64_t> cookies;
+    auto getCookies = [&]() -> const std::vector<uint64_t>& {
+        if (cookies.empty()) {
+            for (const shared_ptr<PolicyRule>& pc : rules->getRules()) {
+                cookies.push_back(getId(L24Classifier::CLASS_ID,
+                                        pc->getL24Classifier()->getURI()));
+            }
+        }
+        return cookies;
+    };
 
     for (const uint32_t& pvnid : provIds) {
         for (const uint32_t& cvnid : consIds) {
@@ -5745,11 +6178,12 @@ IntFlowManager::handleContractUpdate(const opflex::modb::URI& contractURI) {
 
             addContractRules(entryList, pvnid, cvnid,
                              allowBidirectional,
-                             rules);
+                             *rules, getCookies());
         }
     }
     for (const uint32_t& ivnid : intraIds) {
-        addContractRules(entryList, ivnid, ivnid, false, rules);
+        addContractRules(entryList, ivnid, ivnid, false, *rules,
+                         getCookies());
     }
 
     switchManager.writeFlow(contractId, POL_TABLE_ID, entryList);
@@ -5805,13 +6239,50 @@ void IntFlowManager::handleConfigUpdate(const opflex::modb::URI& configURI) {
 
 void IntFlowManager::updateGroupTable() {
     for (FloodGroupMap::value_type& kv : floodGroupMap) {
-        const URI& fgrpURI = kv.first;
-        uint32_t fgrpId = getId(FloodDomain::CLASS_ID, fgrpURI);
-        Ep2PortMap& epMap = kv.second;
+        dirtyFloodGroups[kv.first].full = true;
+    }
+    writeFloodGroups();
+}
+
+static const std::string FLOOD_GROUP_QUEUE_ITEM("flood-groups");
+
+void IntFlowManager::floodGroupsUpdated() {
+    taskQueue.dispatch(FLOOD_GROUP_QUEUE_ITEM,
+                       [this]() { writeFloodGroups(); });
+}
+
+void IntFlowManager::writeFloodGroups() {
+    SwitchConnection* conn = switchManager.getConnection();
+    bool bucketMods =
+        conn != NULL && conn->GetProtocolVersion() >= OFP15_VERSION;
 
-        GroupEdit::Entry e1 = createGroupMod(OFPGC11_MODIFY, fgrpId, epMap);
-        switchManager.writeGroupMod(e1);
+    for (const auto& kv : dirtyFloodGroups) {
+        const FloodGroupDelta& delta = kv.second;
+        if (!delta.full && delta.added.empty() && delta.removed.empty())
+            continue;
+        FloodGroupMap::const_iterator fit = floodGroupMap.find(kv.first);
+        if (fit == floodGroupMap.end())
+            continue;
+        uint32_t fgrpId = getId(FloodDomain::CLASS_ID, kv.first);
+
+        if (!bucketMods || delta.full) {
+            GroupEdit::Entry e =
+                createGroupMod(OFPGC11_MODIFY, fgrpId, fit->second.eps);
+            switchManager.writeGroupMod(e);
+            continue;
+        }
+        for (uint32_t port : delta.removed) {
+            GroupEdit::Entry e =
+                createBucketMod(OFPGC15_REMOVE_BUCKET, fgrpId, {port});
+            switchManager.writeGroupMod(e);
+        }
+        if (!delta.added.empty()) {
+            GroupEdit::Entry e =
+                createBucketMod(OFPGC15_INSERT_BUCKET, fgrpId, delta.added);
+            switchManager.writeGroupMod(e);
+        }
     }
+    dirtyFloodGroups.clear();
 }
 
 void IntFlowManager::handleDropLogPortUpdate() {
@@ -5942,6 +6413,13 @@ static bool serviceIdGarbageCb(ServiceManager& serviceManager,
     return (bool)serviceManager.getService(str);
 }
 
+static bool serviceGroupIdGarbageCb(ServiceManager& serviceManager,
+                                    const std::string& nmspc,
+                                    const std::string& str) {
+    // service group strings are svc-uuid:service-mapping-key
+    return (bool)serviceManager.getService(str.substr(0, str.find(':')));
+}
+
 static bool svcStatsIdGarbageCb(EndpointManager& epManager,
                               ServiceManager& serviceManager,
                               opflex::ofcore::OFFramework& framework,
@@ -5990,9 +6468,7 @@ static bool svcStatsIdGarbageCb(EndpointManager& epManager,
 
         // Ensure vethhostac is present
         if ((statType == "notosvc") || (statType == "svctono")) {
-            unordered_set<std::string> eps;
-            epManager.getEndpointsByAccessIface("veth_host_ac", eps);
-            if (!eps.size())
+            if (!epManager.getEndpointsByAccessIface("veth_host_ac"))
                 return false;
         }
 
@@ -6027,6 +6503,16 @@ void IntFlowManager::cleanup() {
                 idGen.collectGarbage(ID_NMSPC_SERVICE, sgcb);
             });
 
+    agent.getAgentIOService()
+        .dispatch([=]() {
+                auto sggcb = [this](const std::string& ns,
+                                    const std::string& str) -> bool {
+                    return serviceGroupIdGarbageCb(agent.getServiceManager(),
+                                                   ns, str);
+                };
+                idGen.collectGarbage(ID_NMSPC_SVCGROUP, sggcb);
+            });
+
     agent.getAgentIOService()
         .dispatch([=]() {
                 auto ssgcb = [this](const std::string& ns,
@@ -6085,21 +6571,17 @@ void IntFlowManager::updateMulticastList(const optional<string>& mcastIp,
                 "subscription IP: " << mcastIp.get();
             return;
         }
-        MulticastMap::iterator itr = mcastMap.find(mcastIp.get());
-        if (itr != mcastMap.end()) {
-            UriSet& uris = itr->second;
-            UriSet::iterator jtr = uris.find(uri);
-            if (jtr == uris.end()) {
-                // remove old association, if any
-                update |= removeFromMulticastList(uri);
-                uris.insert(uri);
-            }
-        } else {
-            // remove old association, if any
-            update |= removeFromMulticastList(uri);
-            mcastMap[mcastIp.get()].insert(uri);
+        auto uit = mcastUriMap.find(uri);
+        if (uit != mcastUriMap.end() && uit->second == mcastIp.get())
+            return;
+
+        // remove old association, if any
+        update |= removeFromMulticastList(uri);
+        UriSet& uris = mcastMap[mcastIp.get()];
+        if (uris.empty())
             update |= !isSyncing;
-        }
+        uris.insert(uri);
+        mcastUriMap[uri] = mcastIp.get();
     }
 
     if (update)
@@ -6107,12 +6589,15 @@ void IntFlowManager::updateMulticastList(const optional<string>& mcastIp,
 }
 
 bool IntFlowManager::removeFromMulticastList(const URI& uri) {
-    for (MulticastMap::value_type& kv : mcastMap) {
-        UriSet& uris = kv.second;
-        if (uris.erase(uri) > 0 && uris.empty()) {
-            mcastMap.erase(kv.first);
-            return !isSyncing;
-        }
+    auto uit = mcastUriMap.find(uri);
+    if (uit == mcastUriMap.end())
+        return false;
+    MulticastMap::iterator itr = mcastMap.find(uit->second);
+    mcastUriMap.erase(uit);
+    if (itr != mcastMap.end() && itr->second.erase(uri) > 0 &&
+        itr->second.empty()) {
+        mcastMap.erase(itr);
+        return !isSyncing;
     }
     return false;
 }
@@ -6183,11 +6668,35 @@ GroupEdit IntFlowManager::reconcileGroups(GroupMap& recvGroups) {
     GroupEdit ge;
     for (FloodGroupMap::value_type& kv : floodGroupMap) {
         const URI& fgrpURI = kv.first;
-        Ep2PortMap& epMap = kv.second;
+        Ep2PortMap& epMap = kv.second.eps;
 
         uint32_t fgrpId = getId(FloodDomain::CLASS_ID, fgrpURI);
         checkGroupEntry(recvGroups, fgrpId, epMap, ge);
     }
+    // the reconciled groups carry the full bucket lists
+    dirtyFloodGroups.clear();
+
+    for (auto& svc : serviceGroups) {
+        for (auto& kv : svc.second) {
+            uint32_t groupId = getServiceGroupId(svc.first, kv.first);
+            GroupMap::iterator itr = recvGroups.find(groupId);
+            uint16_t comm = OFPGC11_ADD;
+            GroupEdit::Entry recv;
+            if (itr != recvGroups.end()) {
+                comm = OFPGC11_MODIFY;
+                recv = itr->second;
+                recvGroups.erase(itr);
+            }
+            GroupEdit::Entry e0 =
+                createServiceGroupMod(comm, groupId, &kv.second);
+            if (!GroupEdit::groupEq(e0, recv))
+                ge.edits.push_back(e0);
+            kv.second.written = true;
+            kv.second.installed.clear();
+            for (const auto& bkt : kv.second.buckets)
+                kv.second.installed.insert(bkt.second);
+        }
+    }
     Ep2PortMap tmp;
     for (const GroupMap::value_type& kv : recvGroups) {
         GroupEdit::Entry e0 = createGroupMod(OFPGC11_DELETE, kv.first, tmp);
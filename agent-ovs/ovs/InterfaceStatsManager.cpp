@@ -191,16 +191,16 @@ void InterfaceStatsManager::Handle(SwitchConnection* connection,
         counters.txDrop = ps.stats.tx_dropped;
         counters.rxDrop = ps.stats.rx_dropped;
         EndpointManager& epMgr = agent->getEndpointManager();
-        std::unordered_set<std::string> endpoints;
+        ep_set_view_t endpoints;
         try {
             if (connection == intConnection) {
                 const std::string& intPortName = intPortMapper.
                                        FindPort(ps.port_no);
-                epMgr.getEndpointsByIface(intPortName, endpoints);
+                endpoints = epMgr.getEndpointsByIface(intPortName);
             } else {
                 const std::string& accessPortName = accessPortMapper.
                                        FindPort(ps.port_no);
-                epMgr.getEndpointsByAccessIface(accessPortName, endpoints);
+                endpoints = epMgr.getEndpointsByAccessIface(accessPortName);
             }
         } catch (std::out_of_range& e) {
             LOG(DEBUG) << "OpenFlow port on bridge "
@@ -210,8 +210,10 @@ void InterfaceStatsManager::Handle(SwitchConnection* connection,
                        << " not found: "
                        << ps.port_no;
         }
+        if (!endpoints)
+            continue;
 
-        for (const std::string& uuid : endpoints) {
+        for (const std::string& uuid : *endpoints) {
             if ((counters.rxDrop == std::numeric_limits<uint64_t>::max()) ||
                 (counters.txDrop == std::numeric_limits<uint64_t>::max()))
             // set value to 0 if counter is not supported by OVS
@@ -73,11 +73,17 @@ OVSRenderer::OVSRenderer(Agent& agent_)
       virtualRouter(true), routerAdv(true),
       endpointAdvMode(AdvertManager::EPADV_GRATUITOUS_BROADCAST),
       tunnelEndpointAdvMode(AdvertManager::EPADV_RARP_BROADCAST),
-      tunnelEndpointAdvIntvl(300),
+      tunnelEndpointAdvIntvl(300), endpointAdvMaxPps(0),
+      endpointAdvBundles(false),
       virtualDHCP(true), connTrack(true), ctZoneRangeStart(0),
-      ctZoneRangeEnd(0), ovsdbUseLocalTcpPort(false), ifaceStatsEnabled(true), ifaceStatsInterval(0),
+      ctZoneRangeEnd(0), secGroupSharedFlows(false),
+      serviceSelectGroups(false),
+      pktInWorkers(0), pktInQueueDepth(1024), pktInRateLimit(0),
+      pktInBurst(0),
+      ovsdbUseLocalTcpPort(false), ifaceStatsEnabled(true), ifaceStatsInterval(0),
       contractStatsEnabled(true), contractStatsInterval(0),
-      serviceStatsFlowDisabled(false), serviceStatsEnabled(true), serviceStatsInterval(0),
+      serviceStatsFlowDisabled(false), serviceStatsAggregated(false),
+      serviceStatsEnabled(true), serviceStatsInterval(0),
       secGroupStatsEnabled(true), secGroupStatsInterval(0),
       tableDropStatsEnabled(true), tableDropStatsInterval(0),
       spanRenderer(agent_), netflowRenderer(agent_), started(false),
@@ -130,6 +136,12 @@ void OVSRenderer::start() {
         intFlowManager.enableConnTrack();
         accessFlowManager.enableConnTrack();
     }
+    if (secGroupSharedFlows)
+        accessFlowManager.enableSecGroupConjunction();
+    if (serviceSelectGroups)
+        intFlowManager.enableServiceSelectGroups();
+    if (serviceStatsAggregated)
+        intFlowManager.enableServiceStatsAggregation();
 
     intFlowManager.setEncapType(encapType);
     intFlowManager.setEncapIface(encapIface);
@@ -145,6 +157,8 @@ void OVSRenderer::start() {
     intFlowManager.setMulticastGroupFile(mcastGroupFile);
     intFlowManager.setEndpointAdv(endpointAdvMode, tunnelEndpointAdvMode,
             tunnelEndpointAdvIntvl);
+    intFlowManager.setEndpointAdvRate(endpointAdvMaxPps,
+                                      endpointAdvBundles);
     if(!dropLogIntIface.empty()) {
         intFlowManager.setDropLog(dropLogIntIface, dropLogRemoteIp,
                 dropLogRemotePort);
@@ -176,6 +190,8 @@ void OVSRenderer::start() {
                                ? &accessSwitchManager.getPortMapper()
                                : NULL);
     pktInHandler.setFlowReader(&intSwitchManager.getFlowReader());
+    pktInHandler.setPipeline(pktInWorkers, pktInQueueDepth,
+                             pktInRateLimit, pktInBurst);
     pktInHandler.start();
 
     if (ifaceStatsEnabled) {
@@ -340,6 +356,10 @@ void OVSRenderer::setProperties(const ptree& properties) {
                                "endpoint-advertisements.tunnel-endpoint-mode");
     static const std::string ENDPOINT_TNL_ADV_INTVL("forwarding."
                                    "endpoint-advertisements.tunnel-endpoint-interval");
+    static const std::string ENDPOINT_ADV_MAX_PPS("forwarding."
+                                   "endpoint-advertisements.max-pps");
+    static const std::string ENDPOINT_ADV_BUNDLES("forwarding."
+                                   "endpoint-advertisements.bundles");
 
     static const std::string FLOWID_CACHE_DIR("flowid-cache-dir");
     static const std::string MCAST_GROUP_FILE("mcast-group-file");
@@ -353,6 +373,19 @@ void OVSRenderer::setProperties(const ptree& properties) {
                                                   "connection-tracking."
                                                   "zone-range.end");
 
+    static const std::string SECGROUP_SHARED_FLOWS("forwarding."
+                                                   "security-group."
+                                                   "shared-flows");
+
+    static const std::string SERVICE_SELECT_GROUPS("forwarding."
+                                                   "service."
+                                                   "select-groups");
+
+    static const std::string PKTIN_WORKERS("packet-in.worker-threads");
+    static const std::string PKTIN_QUEUE_DEPTH("packet-in.queue-depth");
+    static const std::string PKTIN_RATE_LIMIT("packet-in.rate-limit");
+    static const std::string PKTIN_BURST("packet-in.burst");
+
     static const std::string STATS_INTERFACE_ENABLED("statistics"
                                                      ".interface.enabled");
     static const std::string STATS_INTERFACE_INTERVAL("statistics"
@@ -363,6 +396,8 @@ void OVSRenderer::setProperties(const ptree& properties) {
                                                     ".contract.interval");
     static const std::string STATS_SERVICE_FLOWDISABLED("statistics"
                                                         ".service.flow-disabled");
+    static const std::string STATS_SERVICE_AGGREGATED("statistics"
+                                                      ".service.aggregated");
     static const std::string STATS_SERVICE_ENABLED("statistics"
                                                   ".service.enabled");
     static const std::string STATS_SERVICE_INTERVAL("statistics"
@@ -473,11 +508,23 @@ void OVSRenderer::setProperties(const ptree& properties) {
     tunnelEndpointAdvIntvl =
         properties.get<uint64_t>(ENDPOINT_TNL_ADV_INTVL,
                                     300);
+    endpointAdvMaxPps =
+        properties.get<uint32_t>(ENDPOINT_ADV_MAX_PPS, 0);
+    endpointAdvBundles =
+        properties.get<bool>(ENDPOINT_ADV_BUNDLES, false);
 
     connTrack = properties.get<bool>(CONN_TRACK, true);
     ctZoneRangeStart = properties.get<uint16_t>(CONN_TRACK_RANGE_START, 1);
     ctZoneRangeEnd = properties.get<uint16_t>(CONN_TRACK_RANGE_END, 65534);
 
+    secGroupSharedFlows = properties.get<bool>(SECGROUP_SHARED_FLOWS, false);
+    serviceSelectGroups = properties.get<bool>(SERVICE_SELECT_GROUPS, false);
+
+    pktInWorkers = properties.get<size_t>(PKTIN_WORKERS, 0);
+    pktInQueueDepth = properties.get<size_t>(PKTIN_QUEUE_DEPTH, 1024);
+    pktInRateLimit = properties.get<uint64_t>(PKTIN_RATE_LIMIT, 0);
+    pktInBurst = properties.get<uint64_t>(PKTIN_BURST, 0);
+
     flowIdCache = properties.get<std::string>(FLOWID_CACHE_DIR,
                                               DEF_FLOWID_CACHEDIR);
 
@@ -489,6 +536,7 @@ void OVSRenderer::setProperties(const ptree& properties) {
     ifaceStatsEnabled = properties.get<bool>(STATS_INTERFACE_ENABLED, true);
     contractStatsEnabled = properties.get<bool>(STATS_CONTRACT_ENABLED, true);
     serviceStatsFlowDisabled = properties.get<bool>(STATS_SERVICE_FLOWDISABLED, false);
+    serviceStatsAggregated = properties.get<bool>(STATS_SERVICE_AGGREGATED, false);
     serviceStatsEnabled = properties.get<bool>(STATS_SERVICE_ENABLED, true);
     secGroupStatsEnabled = properties.get<bool>(STATS_SECGROUP_ENABLED, true);
     ifaceStatsInterval = properties.get<long>(STATS_INTERFACE_INTERVAL, 30000);
@@ -55,7 +55,52 @@ PacketInHandler::PacketInHandler(Agent& agent_,
     : agent(agent_), intFlowManager(intFlowManager_),
       intPortMapper(NULL), accessPortMapper(NULL),
       intFlowReader(NULL),
-      intSwConnection(NULL), accSwConnection(NULL) {}
+      intSwConnection(NULL), accSwConnection(NULL),
+      nWorkers(0), queueDepth(1024), stopping(false), lastStatsUpdate(0) {
+}
+
+void PacketInHandler::setPipeline(size_t nWorkers_, size_t queueDepth_,
+                                  uint64_t rate, uint64_t burst) {
+    nWorkers = nWorkers_;
+    queueDepth = queueDepth_ ? queueDepth_ : 1;
+    admission.setRate(rate, burst);
+}
+
+void PacketInHandler::
+getDropCounts(uint64_t (&rateLimited)[PKTIN_TYPE_MAX],
+              uint64_t (&queueFull)[PKTIN_TYPE_MAX]) const {
+    for (size_t i = 0; i < PKTIN_TYPE_MAX; i++) {
+        rateLimited[i] = 0;
+        queueFull[i] = 0;
+    }
+    for (auto& w : workers) {
+        std::lock_guard<std::mutex> guard(w->mtx);
+        for (size_t i = 0; i < PKTIN_TYPE_MAX; i++) {
+            rateLimited[i] += w->rateLimitedDrops[i];
+            queueFull[i] += w->queueFullDrops[i];
+        }
+    }
+}
+
+uint64_t PacketInHandler::getRateLimitedDrops() const {
+    uint64_t rateLimited[PKTIN_TYPE_MAX];
+    uint64_t queueFull[PKTIN_TYPE_MAX];
+    getDropCounts(rateLimited, queueFull);
+    uint64_t total = 0;
+    for (size_t i = 0; i < PKTIN_TYPE_MAX; i++)
+        total += rateLimited[i];
+    return total;
+}
+
+uint64_t PacketInHandler::getQueueFullDrops() const {
+    uint64_t rateLimited[PKTIN_TYPE_MAX];
+    uint64_t queueFull[PKTIN_TYPE_MAX];
+    getDropCounts(rateLimited, queueFull);
+    uint64_t total = 0;
+    for (size_t i = 0; i < PKTIN_TYPE_MAX; i++)
+        total += queueFull[i];
+    return total;
+}
 
 void PacketInHandler::registerConnection(SwitchConnection* intConnection,
                                          SwitchConnection* accessConnection) {
@@ -70,6 +115,14 @@ void PacketInHandler::setPortMapper(PortMapper* intMapper,
 }
 
 void PacketInHandler::start() {
+    agent.getEndpointManager().registerListener(this);
+
+    stopping = false;
+    for (size_t i = 0; i < nWorkers; i++) {
+        workers.emplace_back(new Worker());
+        Worker& w = *workers.back();
+        w.thread = std::thread([this, &w]() { workerLoop(w); });
+    }
     if (intSwConnection)
         intSwConnection->RegisterMessageHandler(OFPTYPE_PACKET_IN, this);
 }
@@ -77,6 +130,73 @@ void PacketInHandler::start() {
 void PacketInHandler::stop() {
     if (intSwConnection)
         intSwConnection->UnregisterMessageHandler(OFPTYPE_PACKET_IN, this);
+
+    stopping = true;
+    for (auto& w : workers) {
+        {
+            std::lock_guard<std::mutex> guard(w->mtx);
+        }
+        w->cond.notify_all();
+    }
+    for (auto& w : workers) {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+    workers.clear();
+
+    agent.getEndpointManager().unregisterListener(this);
+    std::lock_guard<std::mutex> guard(templateMutex);
+    replyTemplates.clear();
+}
+
+void PacketInHandler::endpointUpdated(const std::string& uuid) {
+    std::lock_guard<std::mutex> guard(templateMutex);
+    replyTemplates.erase(uuid);
+}
+
+PacketInHandler::ReplyTemplates&
+PacketInHandler::getReplyTemplates(const shared_ptr<const Endpoint>& ep) {
+    ReplyTemplates& t = replyTemplates[ep->getUUID()];
+    if (t.ep.lock() != ep) {
+        // built from an older version of the endpoint
+        t.ep = ep;
+        t.dhcpv4.reset();
+        t.dhcpv6.reset();
+    }
+    return t;
+}
+
+shared_ptr<const packets::DHCPv4ReplyTemplate>
+PacketInHandler::getDHCPv4Template(const shared_ptr<const Endpoint>& ep) {
+    std::lock_guard<std::mutex> guard(templateMutex);
+    ReplyTemplates& t = getReplyTemplates(ep);
+    if (!t.dhcpv4) {
+        const Endpoint::DHCPv4Config& v4c = ep->getDHCPv4Config().get();
+        t.dhcpv4 = std::make_shared<const packets::DHCPv4ReplyTemplate>
+            (packets::build_dhcpv4_reply_template
+             (v4c.getPrefixLen().get_value_or(32),
+              v4c.getServerIp(),
+              v4c.getRouters(),
+              v4c.getDnsServers(),
+              v4c.getDomain(),
+              v4c.getStaticRoutes(),
+              v4c.getInterfaceMtu(),
+              v4c.getLeaseTime()));
+    }
+    return t.dhcpv4;
+}
+
+shared_ptr<const packets::DHCPv6ReplyTemplate>
+PacketInHandler::getDHCPv6Template(const shared_ptr<const Endpoint>& ep) {
+    std::lock_guard<std::mutex> guard(templateMutex);
+    ReplyTemplates& t = getReplyTemplates(ep);
+    if (!t.dhcpv6) {
+        const Endpoint::DHCPv6Config& v6c = ep->getDHCPv6Config().get();
+        t.dhcpv6 = std::make_shared<const packets::DHCPv6ReplyTemplate>
+            (packets::build_dhcpv6_reply_template(v6c.getDnsServers(),
+                                                  v6c.getSearchList()));
+    }
+    return t.dhcpv6;
 }
 
 typedef std::function<void (ActionBuilder&)> output_act_t;
@@ -160,18 +280,18 @@ static void send_packet_out(Agent& agent,
         else
             iface = intPortMapper->FindPort(out_port);
 
-        unordered_set<string> eps;
-        agent.getEndpointManager().getEndpointsByIface(iface, eps);
-        if (eps.size() == 0) {
+        ep_set_view_t eps =
+            agent.getEndpointManager().getEndpointsByIface(iface);
+        if (!eps) {
             LOG(WARNING) << "No endpoint found for output packet"
                          << " on " << iface;
             return;
         }
-        if (eps.size() > 1)
+        if (eps->size() > 1)
             LOG(WARNING) << "Multiple possible endpoints for output packet "
                          << " on " << iface;
 
-        ep = agent.getEndpointManager().getEndpoint(*eps.begin());
+        ep = agent.getEndpointManager().getEndpoint(*eps->begin());
         if (ep && ep->getAccessInterface() && ep->getAccessUplinkInterface()) {
             if (!accConn || !accPortMapper) {
                 return;
@@ -213,6 +333,7 @@ static void send_packet_out(Agent& agent,
  * reply is written as a packet-out to the connection
  *
  * @param agent the agent object
+ * @param pktInHandler the packet-in handler holding the reply templates
  * @param intFlowManager the flow manager
  * @param intConn the openflow switch connection
  * @param accConn the openflow switch connection
@@ -298,6 +419,7 @@ static void handleNDPktIn(Agent& agent,
 }
 
 static void handleDHCPv4PktIn(Agent& agent,
+                              PacketInHandler& pktInHandler,
                               IntFlowManager& intFlowManager,
                               PortMapper* intPortMapper,
                               PortMapper* accPortMapper,
@@ -373,7 +495,6 @@ static void handleDHCPv4PktIn(Agent& agent,
 
     MAC srcMac(flow.dl_src.ea);
 
-    uint8_t prefixLen = v4c.get().getPrefixLen().get_value_or(32);
     uint8_t reply_type = message_type::NAK;
 
     switch(message_type) {
@@ -410,14 +531,7 @@ static void handleDHCPv4PktIn(Agent& agent,
                                            serverMac,
                                            flow.dl_src.ea,
                                            dhcpIp.to_ulong(),
-                                           prefixLen,
-                                           v4c.get().getServerIp(),
-                                           v4c.get().getRouters(),
-                                           v4c.get().getDnsServers(),
-                                           v4c.get().getDomain(),
-                                           v4c.get().getStaticRoutes(),
-                                           v4c.get().getInterfaceMtu(),
-                                           v4c.get().getLeaseTime()));
+                                           *pktInHandler.getDHCPv4Template(ep)));
 
     send_packet_out(agent, intConn, accConn, intFlowManager,
                     intPortMapper, accPortMapper, URI::ROOT, b,
@@ -426,6 +540,7 @@ static void handleDHCPv4PktIn(Agent& agent,
 }
 
 static void handleDHCPv6PktIn(Agent& agent,
+                              PacketInHandler& pktInHandler,
                               IntFlowManager& intFlowManager,
                               PortMapper* intPortMapper,
                               PortMapper* accPortMapper,
@@ -543,8 +658,7 @@ static void handleDHCPv6PktIn(Agent& agent,
                                            client_id_len,
                                            iaid,
                                            v6addresses,
-                                           v6c.get().getDnsServers(),
-                                           v6c.get().getSearchList(),
+                                           *pktInHandler.getDHCPv6Template(ep),
                                            temporary,
                                            rapid_commit,
                                            v6c.get().getT1(),
@@ -566,10 +680,10 @@ static unordered_set<ep_ptr> findEpsForIface(EndpointManager& epMgr,
                                              std::string iface,
                                              ep_pred pred) {
     unordered_set<ep_ptr> eps;
-    unordered_set<string> try_uuids;
-    epMgr.getEndpointsByIface(iface, try_uuids);
+    ep_set_view_t try_uuids = epMgr.getEndpointsByIface(iface);
+    if (!try_uuids) return eps;
 
-    for (const string& epUuid : try_uuids) {
+    for (const string& epUuid : *try_uuids) {
         ep_ptr try_ep = epMgr.getEndpoint(epUuid);
         if (!try_ep) continue;
         if (pred(*try_ep)) {
@@ -597,6 +711,7 @@ static unordered_set<ep_ptr> findEpsForIface(EndpointManager& epMgr,
  */
 static void handleDHCPPktIn(bool v4,
                             Agent& agent,
+                            PacketInHandler& pktInHandler,
                             IntFlowManager& intFlowManager,
                             PortMapper* intPortMapper,
                             PortMapper* accPortMapper,
@@ -648,11 +763,11 @@ static void handleDHCPPktIn(bool v4,
     const shared_ptr<const Endpoint> ep = *eps.begin();
 
     if (v4)
-        handleDHCPv4PktIn(agent, intFlowManager,
+        handleDHCPv4PktIn(agent, pktInHandler, intFlowManager,
                           intPortMapper, accPortMapper, intConn, accConn,
                           ep, iface, pi, proto, pkt, flow);
     else
-        handleDHCPv6PktIn(agent, intFlowManager,
+        handleDHCPv6PktIn(agent, pktInHandler, intFlowManager,
                           intPortMapper, accPortMapper, intConn, accConn,
                           ep, pi, proto, pkt, flow);
 
@@ -891,6 +1006,105 @@ static void handleICMPEchoPktIn(bool v4,
 /**
  * Dispatch packet-in messages to the appropriate handlers
  */
+PacketInHandler::PktInType PacketInHandler::getPktInType(uint64_t cookie) {
+    if (cookie == flow::cookie::NEIGH_DISC)
+        return PKTIN_ND;
+    else if (cookie == flow::cookie::DHCP_V4)
+        return PKTIN_DHCPV4;
+    else if (cookie == flow::cookie::DHCP_V6)
+        return PKTIN_DHCPV6;
+    else if (cookie == flow::cookie::VIRTUAL_IP_V4)
+        return PKTIN_VIP_V4;
+    else if (cookie == flow::cookie::VIRTUAL_IP_V6)
+        return PKTIN_VIP_V6;
+    else if (cookie == flow::cookie::ICMP_ERROR_V4)
+        return PKTIN_ICMP_ERR_V4;
+    else if (cookie == flow::cookie::ICMP_ECHO_V4)
+        return PKTIN_ICMP_ECHO_V4;
+    else if (cookie == flow::cookie::ICMP_ECHO_V6)
+        return PKTIN_ICMP_ECHO_V6;
+    return PKTIN_OTHER;
+}
+
+const char* PacketInHandler::getPktInTypeName(PktInType type) {
+    switch (type) {
+    case PKTIN_ND: return "nd";
+    case PKTIN_DHCPV4: return "dhcpv4";
+    case PKTIN_DHCPV6: return "dhcpv6";
+    case PKTIN_VIP_V4: return "vip_v4";
+    case PKTIN_VIP_V6: return "vip_v6";
+    case PKTIN_ICMP_ERR_V4: return "icmp_err_v4";
+    case PKTIN_ICMP_ECHO_V4: return "icmp_echo_v4";
+    case PKTIN_ICMP_ECHO_V6: return "icmp_echo_v6";
+    default: return "other";
+    }
+}
+
+bool PacketInHandler::isSerialPktInType(PktInType type) {
+    switch (type) {
+    case PKTIN_ND:
+    case PKTIN_DHCPV4:
+    case PKTIN_DHCPV6:
+    case PKTIN_VIP_V4:
+    case PKTIN_VIP_V6:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void PacketInHandler::updateDropStats() {
+#ifdef HAVE_PROMETHEUS_SUPPORT
+    uint64_t rateLimited[PKTIN_TYPE_MAX];
+    uint64_t queueFull[PKTIN_TYPE_MAX];
+    getDropCounts(rateLimited, queueFull);
+    PrometheusManager& prometheusManager = agent.getPrometheusManager();
+    for (size_t i = 0; i < PKTIN_TYPE_MAX; i++) {
+        prometheusManager.addNUpdatePacketInDrops
+            (getPktInTypeName(PktInType(i)), rateLimited[i], queueFull[i]);
+    }
+#endif
+}
+
+void PacketInHandler::workerLoop(Worker& w) {
+    std::unique_lock<std::mutex> guard(w.mtx);
+    while (true) {
+        // service the per-type queues round-robin so that one type of
+        // packet-in cannot starve the others
+        bool found = false;
+        for (size_t i = 0; i < PKTIN_TYPE_MAX; i++) {
+            std::deque<PktIn>& q = w.queues[(w.next + i) % PKTIN_TYPE_MAX];
+            if (q.empty()) continue;
+
+            PktIn pktIn(std::move(q.front()));
+            q.pop_front();
+            w.next = (w.next + i + 1) % PKTIN_TYPE_MAX;
+            found = true;
+
+            guard.unlock();
+            processPacketIn(pktIn.conn, *pktIn.pi);
+            guard.lock();
+            break;
+        }
+
+        // Any worker can publish the drop counts, summed across all
+        // the workers, so they stay current while one worker is busy
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>
+            (std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t last = lastStatsUpdate;
+        if (now > last &&
+            lastStatsUpdate.compare_exchange_strong(last, now)) {
+            guard.unlock();
+            updateDropStats();
+            guard.lock();
+        }
+
+        if (found) continue;
+        if (stopping) break;
+        w.cond.wait_for(guard, std::chrono::seconds(1));
+    }
+}
+
 void PacketInHandler::Handle(SwitchConnection* conn,
                              int msgType, ofpbuf *msg,
                              struct ofputil_flow_removed* fentry) {
@@ -911,6 +1125,59 @@ void PacketInHandler::Handle(SwitchConnection* conn,
     if (pi.reason != OFPR_ACTION)
         return;
 
+    if (workers.empty() || stopping) {
+        processPacketIn(conn, pi);
+        return;
+    }
+
+    // Admission is per packet-in type and source MAC, so that one
+    // noisy endpoint only exhausts its own bucket
+    uint64_t srcMac = 0;
+    if (pi.packet_len >= 12) {
+        const uint8_t* mac = (const uint8_t*)pi.packet + 6;
+        for (size_t i = 0; i < 6; i++)
+            srcMac = (srcMac << 8) | mac[i];
+    }
+    PktInType type = getPktInType(pi.cookie);
+
+    // Select the worker using the source MAC so that packet-ins from
+    // a given endpoint are always processed in order.  The handlers
+    // that are not reentrant all run on the first worker.
+    Worker& w = isSerialPktInType(type)
+        ? *workers[0]
+        : *workers[std::hash<uint64_t>()(srcMac) % workers.size()];
+
+    if (!admission.event(((uint64_t)type << 48) | srcMac)) {
+        std::lock_guard<std::mutex> guard(w.mtx);
+        w.rateLimitedDrops[type]++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(w.mtx);
+        std::deque<PktIn>& q = w.queues[type];
+        if (q.size() >= queueDepth) {
+            w.queueFullDrops[type]++;
+            return;
+        }
+        // Keep the decoded packet-in, pointing it into the copy of
+        // the message that is queued
+        OfpBuf copy(ofpbuf_clone(msg));
+        std::shared_ptr<ofputil_packet_in> qpi =
+            std::make_shared<ofputil_packet_in>(pi);
+        const uint8_t* base = (const uint8_t*)msg->data;
+        uint8_t* copyBase = (uint8_t*)copy.data();
+        qpi->packet = copyBase + ((const uint8_t*)pi.packet - base);
+        if (pi.userdata)
+            qpi->userdata =
+                copyBase + ((const uint8_t*)pi.userdata - base);
+        q.push_back(PktIn{conn, std::move(copy), qpi});
+    }
+    w.cond.notify_one();
+}
+
+void PacketInHandler::processPacketIn(SwitchConnection* conn,
+                                      const ofputil_packet_in& pi) {
     DpPacketP pkt;
     struct flow flow;
 
@@ -926,11 +1193,11 @@ void PacketInHandler::Handle(SwitchConnection* conn,
                       intPortMapper, accessPortMapper,
                       pi, proto, pkt.get(), flow);
     else if (pi.cookie == flow::cookie::DHCP_V4)
-        handleDHCPPktIn(true, agent, intFlowManager, intPortMapper,
+        handleDHCPPktIn(true, agent, *this, intFlowManager, intPortMapper,
                         accessPortMapper, conn, accSwConnection,
                         pi, proto, pkt.get(), flow);
     else if (pi.cookie == flow::cookie::DHCP_V6)
-        handleDHCPPktIn(false, agent, intFlowManager,
+        handleDHCPPktIn(false, agent, *this, intFlowManager,
                         intPortMapper, accessPortMapper,
                         conn, accSwConnection, pi, proto, pkt.get(), flow);
     else if (pi.cookie == flow::cookie::VIRTUAL_IP_V4)
@@ -17,6 +17,10 @@
 #include <boost/asio/socket_base.hpp>
 #include <boost/asio/ip/v6_only.hpp>
 #include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
 #include <thread>
 #include <chrono>
 
@@ -140,13 +144,43 @@ void PacketLogHandler::stopExporter()
     }
 }
 
+void UdpServer::initRecvBatch() {
+    memset(recv_msgs, 0, sizeof(recv_msgs));
+    for (unsigned i = 0; i < recvBatchSize; i++) {
+        recv_iovecs[i].iov_base = recv_buffers[i].data();
+        recv_iovecs[i].iov_len = recvBufferSize;
+        recv_msgs[i].msg_hdr.msg_iov = &recv_iovecs[i];
+        recv_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
 void UdpServer::handleReceive(const boost::system::error_code& error,
       std::size_t bytes_transferred) {
 
-    if (!error || error == boost::asio::error::message_size)
-    {
-        uint32_t length = (bytes_transferred > 4096) ? 4096: bytes_transferred;
-        this->pktLogger.parseLog(recv_buffer.data(), length);
+    if (!error) {
+        int fd = serverSocket.native_handle();
+        if (useRecvmmsg) {
+            int n = recvmmsg(fd, recv_msgs, recvBatchSize, MSG_DONTWAIT,
+                             NULL);
+            if (n < 0 && errno == ENOSYS) {
+                LOG(INFO) << "recvmmsg not supported, "
+                          << "falling back to single receive";
+                useRecvmmsg = false;
+            }
+            for (int i = 0; i < n; i++) {
+                std::size_t length =
+                    std::min<std::size_t>(recv_msgs[i].msg_len,
+                                          recvBufferSize);
+                this->pktLogger.parseLog(recv_buffers[i].data(), length);
+            }
+        }
+        if (!useRecvmmsg) {
+            ssize_t len = recv(fd, recv_buffers[0].data(), recvBufferSize,
+                               MSG_DONTWAIT);
+            if (len > 0) {
+                this->pktLogger.parseLog(recv_buffers[0].data(), len);
+            }
+        }
     }
     if(!stopped) {
         startReceive();
@@ -154,20 +188,25 @@ void UdpServer::handleReceive(const boost::system::error_code& error,
 }
 
 void PacketLogHandler::getDropReason(ParseInfo &p, std::string &dropReason) {
-    std::string bridge = ((p.meta[0] ==1)? "Int-" :
-            ((p.meta[0] ==2)? "Acc-" :""));
-    if((p.meta[0] == 1) &&
-            (intTableDescMap.find(p.meta[1])!= intTableDescMap.end())) {
-        dropReason = bridge + intTableDescMap[p.meta[1]].first;
-    } else if((p.meta[0] == 2) &&
-            (accTableDescMap.find(p.meta[1]) != accTableDescMap.end())) {
-        dropReason = bridge + accTableDescMap[p.meta[1]].first;
+    getDropReason(p.meta, dropReason);
+}
+
+void PacketLogHandler::getDropReason(const uint32_t (&meta)[2],
+                                     std::string &dropReason) {
+    std::string bridge = ((meta[0] ==1)? "Int-" :
+            ((meta[0] ==2)? "Acc-" :""));
+    if((meta[0] == 1) &&
+            (intTableDescMap.find(meta[1])!= intTableDescMap.end())) {
+        dropReason = bridge + intTableDescMap[meta[1]].first;
+    } else if((meta[0] == 2) &&
+            (accTableDescMap.find(meta[1]) != accTableDescMap.end())) {
+        dropReason = bridge + accTableDescMap[meta[1]].first;
     }
 }
 
 void PacketLogHandler::parseLog(unsigned char *buf , std::size_t length) {
-    ParseInfo p(&pktDecoder);
-    int ret = pktDecoder.decode(buf, length, p);
+    CompactPacketTuple t;
+    int ret = compiledDecoder.decode(buf, length, t);
     if(ret) {
         LOG(ERROR) << "Error parsing packet " << ret;
         std::stringstream str;
@@ -185,16 +224,32 @@ void PacketLogHandler::parseLog(unsigned char *buf , std::size_t length) {
          * a generic criterion
          * */
         /* Skip logging/events for LLDP packets*/
-        #define LLDP_MAC "01:80:c2:00:00:0e"
-        std::string dstMac;
-        p.packetTuple.getField(2, dstMac);
-        if(dstMac == LLDP_MAC) {
+        static const uint8_t LLDP_MAC[6] = {0x01, 0x80, 0xc2, 0x00, 0x00, 0x0e};
+        if(t.has(CompactPacketTuple::LAYER_ETHERNET) &&
+           memcmp(t.dstMac, LLDP_MAC, sizeof(LLDP_MAC)) == 0) {
             return;
         }
         std::string dropReason;
-        getDropReason(p, dropReason);
-        p.packetTuple.setField(0, dropReason);
-        LOG(INFO)<< dropReason << " " << p.parsedString;
+        getDropReason(t.meta, dropReason);
+        // Log at most maxLogsPerSec packets each second at INFO, so a
+        // flood of drops doesn't flood the log; the rest go to DEBUG
+        auto now = std::chrono::steady_clock::now();
+        if (now - logWindow >= std::chrono::seconds(1)) {
+            if (logSuppressed) {
+                LOG(INFO) << logSuppressed
+                          << " logged packets not shown at info level";
+            }
+            logWindow = now;
+            logCount = 0;
+            logSuppressed = 0;
+        }
+        if (logCount < maxLogsPerSec) {
+            logCount += 1;
+            LOG(INFO)<< dropReason << " " << t;
+        } else {
+            logSuppressed += 1;
+            LOG(DEBUG)<< dropReason << " " << t;
+        }
         if(!packetEventNotifSock.empty())
         {
             {
@@ -204,7 +259,10 @@ void PacketLogHandler::parseLog(unsigned char *buf , std::size_t length) {
                         LOG(ERROR) << "Queueing packet events";
                         throttleActive = false;
                     }
-                    packetTupleQ.push(p.packetTuple);
+                    PacketTuple packetTuple;
+                    t.toPacketTuple(packetTuple);
+                    packetTuple.setField(0, dropReason);
+                    packetTupleQ.push(std::move(packetTuple));
                     if(packetTupleQ.size()  == maxOutstandingEvents) {
                         LOG(ERROR) << "Max Event queue size ("
                                    << maxOutstandingEvents
@@ -22,7 +22,6 @@
 #include <boost/lexical_cast.hpp>
 #include <modelgbp/gbp/AutoconfigEnumT.hpp>
 
-#include <sstream>
 #include <netinet/ip.h>
 #include <netinet/ip6.h>
 #include <netinet/icmp6.h>
@@ -45,7 +44,6 @@ const uint8_t MAC_ADDR_FILTERED_MASK[6] =
 const boost::asio::ip::address_v4 LINK_LOCAL_DHCP(0xa9fe2020);
 
 using std::string;
-using std::stringbuf;
 using std::vector;
 using std::shared_ptr;
 using boost::optional;
@@ -407,79 +405,79 @@ OfpBuf compose_icmp6_neigh_solit(const uint8_t* srcMac,
 static const size_t MAX_IP = 32;
 static const size_t MAX_ROUTE = 16;
 
-class Routev4 {
-public:
-    Routev4(address_v4 dest_, uint8_t prefixLen_, address_v4 nextHop_)
-        : dest(dest_), prefixLen(prefixLen_), nextHop(nextHop_) {}
-    address_v4 dest;
-    uint8_t prefixLen;
-    address_v4 nextHop;
-};
+static void put_dhcp_opt(string& opts, uint8_t code, const void* data,
+                         size_t len) {
+    opts.push_back((char)code);
+    opts.push_back((char)len);
+    opts.append((const char*)data, len);
+}
 
-OfpBuf compose_dhcpv4_reply(uint8_t message_type,
-                             uint32_t xid,
-                             const uint8_t* srcMac,
-                             const uint8_t* clientMac,
-                             uint32_t clientIp,
-                             uint8_t prefixLen,
-                             const optional<string>& serverIpStr,
-                             const vector<string>& routers,
-                             const vector<string>& dnsServers,
-                             const optional<string>& domain,
-                             const vector<static_route_t>& staticRoutes,
-                             const optional<uint16_t>& interfaceMtu,
-                             const optional<uint32_t>& leaseTime) {
+DHCPv4ReplyTemplate
+build_dhcpv4_reply_template(uint8_t prefixLen,
+                            const optional<string>& serverIpStr,
+                            const vector<string>& routers,
+                            const vector<string>& dnsServers,
+                            const optional<string>& domain,
+                            const vector<static_route_t>& staticRoutes,
+                            const optional<uint16_t>& interfaceMtu,
+                            const optional<uint32_t>& leaseTime) {
     using namespace dhcp;
-    using namespace udp;
-
-    eth::eth_header* eth = NULL;
-    struct iphdr* ip = NULL;
-    struct udp_hdr* udp = NULL;
-    struct dhcp_hdr* dhcp = NULL;
-    struct dhcp_option_hdr* message_type_opt = NULL;
-    struct dhcp_option_hdr* subnet_mask = NULL;
-    struct dhcp_option_hdr* routers_opt = NULL;
-    struct dhcp_option_hdr* dns = NULL;
-    struct dhcp_option_hdr* domain_opt = NULL;
-    struct dhcp_option_hdr* lease_time = NULL;
-    struct dhcp_option_hdr* server_identifier = NULL;
-    struct dhcp_option_hdr* static_routes = NULL;
-    struct dhcp_option_hdr* iface_mtu = NULL;
-    struct dhcp_option_hdr_base* end = NULL;
 
+    DHCPv4ReplyTemplate tmpl;
     boost::system::error_code ec;
 
-    // Compute size of reply and options
-    size_t router_len = 0;
-    size_t dns_len = 0;
-    size_t domain_len = 0;
-    size_t static_route_len = 0;
-    size_t iface_mtu_len = 0;
+    tmpl.serverIp = LINK_LOCAL_DHCP.to_ulong();
+    if (serverIpStr) {
+        address_v4 sip = address_v4::from_string(serverIpStr.get(), ec);
+        if (ec) {
+            LOG(WARNING) << "Invalid DHCP server IP: " << serverIpStr.get();
+        } else  {
+            tmpl.serverIp = sip.to_ulong();
+        }
+    }
 
-    vector<address_v4> routerIps;
+    string& opts = tmpl.options;
+
+    if (prefixLen > 32) prefixLen = 32;
+    uint32_t maskVal = htonl(0xffffffff << (32-prefixLen));
+    put_dhcp_opt(opts, option::SUBNET_MASK, &maskVal, option::IP_LEN);
+
+    vector<uint32_t> routerIps;
     for (const string& ipstr : routers) {
         address_v4 ip = address_v4::from_string(ipstr, ec);
         if (ec) continue;
-        routerIps.push_back(ip);
+        routerIps.push_back(htonl(ip.to_ulong()));
         if (routerIps.size() >= MAX_IP) break;
     }
     if (!routerIps.empty())
-        router_len = 2 + 4*routerIps.size();
+        put_dhcp_opt(opts, option::ROUTER, routerIps.data(),
+                     4 * routerIps.size());
 
-    vector<address_v4> dnsIps;
+    vector<uint32_t> dnsIps;
     for (const string& ipstr : dnsServers) {
         address_v4 ip = address_v4::from_string(ipstr, ec);
         if (ec) continue;
-        dnsIps.push_back(ip);
+        dnsIps.push_back(htonl(ip.to_ulong()));
         if (dnsIps.size() >= MAX_IP) break;
     }
     if (!dnsIps.empty())
-        dns_len = 2 + 4*dnsIps.size();
+        put_dhcp_opt(opts, option::DNS, dnsIps.data(), 4 * dnsIps.size());
 
+    // the option length is a single byte
     if (domain && domain.get().size() <= 255)
-        domain_len = 2 + domain.get().size();
+        put_dhcp_opt(opts, option::DOMAIN_NAME, domain.get().c_str(),
+                     domain.get().size());
+
+    uint32_t leaseTimeVal = htonl(leaseTime ? leaseTime.get() : 86400);
+    put_dhcp_opt(opts, option::LEASE_TIME, &leaseTimeVal,
+                 option::LEASE_TIME_LEN);
+
+    uint32_t serverIpVal = htonl(tmpl.serverIp);
+    put_dhcp_opt(opts, option::SERVER_IDENTIFIER, &serverIpVal,
+                 option::IP_LEN);
 
-    vector<Routev4> routes;
+    string routeBuf;
+    size_t nRoutes = 0;
     for (const static_route_t& route : staticRoutes) {
         address_v4 dst = address_v4::from_string(route.dest, ec);
         if (ec) continue;
@@ -488,27 +486,47 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
         uint8_t prefix = route.prefixLen;
         if (prefix > 32) prefix = 32;
 
-        static_route_len += (prefix / 8) + (prefix % 8 != 0) + 5;
-        routes.emplace_back(Routev4(dst, prefix, nextHop));
-        if (routes.size() >= MAX_ROUTE) break;
+        uint8_t octets = (prefix / 8) + (prefix % 8 != 0);
+        uint32_t destVal = htonl(dst.to_ulong());
+        uint32_t nextHopVal = htonl(nextHop.to_ulong());
+        routeBuf.push_back((char)prefix);
+        routeBuf.append((const char*)&destVal, octets);
+        routeBuf.append((const char*)&nextHopVal, sizeof(nextHopVal));
+        if (++nRoutes >= MAX_ROUTE) break;
+    }
+    if (!routeBuf.empty())
+        put_dhcp_opt(opts, option::CLASSLESS_STATIC_ROUTE,
+                     routeBuf.data(), routeBuf.size());
+
+    if (interfaceMtu) {
+        uint16_t mtuVal = htons(interfaceMtu.get());
+        put_dhcp_opt(opts, option::INTERFACE_MTU, &mtuVal, sizeof(mtuVal));
     }
-    if (static_route_len > 0) static_route_len += 2;
 
-    if (interfaceMtu)
-        iface_mtu_len = 4;
+    opts.push_back((char)option::END);
+
+    return tmpl;
+}
+
+OfpBuf compose_dhcpv4_reply(uint8_t message_type,
+                            uint32_t xid,
+                            const uint8_t* srcMac,
+                            const uint8_t* clientMac,
+                            uint32_t clientIp,
+                            const DHCPv4ReplyTemplate& tmpl) {
+    using namespace dhcp;
+    using namespace udp;
+
+    eth::eth_header* eth = NULL;
+    struct iphdr* ip = NULL;
+    struct udp_hdr* udp = NULL;
+    struct dhcp_hdr* dhcp = NULL;
+    struct dhcp_option_hdr* message_type_opt = NULL;
 
     size_t payloadLen =
         sizeof(struct dhcp_hdr) +
         option::MESSAGE_TYPE_LEN + 2 +
-        option::IP_LEN + 2 + /* subnet mask */
-        router_len +
-        dns_len +
-        domain_len +
-        option::LEASE_TIME_LEN + 2 +
-        option::IP_LEN + 2 + /* server identifier */
-        static_route_len +
-        iface_mtu_len +
-        1 /* end */;
+        tmpl.options.size();
     size_t len = sizeof(eth::eth_header) +
         sizeof(struct iphdr) +
         sizeof(struct udp_hdr) +
@@ -530,34 +548,6 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
     buf += sizeof(struct dhcp_hdr);
     message_type_opt = (struct dhcp_option_hdr*)buf;
     buf += option::MESSAGE_TYPE_LEN + 2;
-    subnet_mask = (struct dhcp_option_hdr*)buf;
-    buf += option::IP_LEN + 2;
-    if (router_len > 0) {
-        routers_opt = (struct dhcp_option_hdr*)buf;
-        buf += router_len;
-    }
-    if (dns_len > 0) {
-        dns = (struct dhcp_option_hdr*)buf;
-        buf += dns_len;
-    }
-    if (domain_len > 0) {
-        domain_opt = (struct dhcp_option_hdr*)buf;
-        buf += domain_len;
-    }
-    lease_time = (struct dhcp_option_hdr*)buf;
-    buf += option::LEASE_TIME_LEN + 2;
-    server_identifier = (struct dhcp_option_hdr*)buf;
-    buf += option::IP_LEN + 2;
-    if (static_route_len > 0) {
-        static_routes = (struct dhcp_option_hdr*)buf;
-        buf += static_route_len;
-    }
-    if (iface_mtu_len > 0) {
-        iface_mtu = (struct dhcp_option_hdr*)buf;
-        buf += iface_mtu_len;
-    }
-    end = (struct dhcp_option_hdr_base*)buf;
-    buf += 1;
 
     // initialize ethernet header
     memcpy(eth->eth_src, srcMac, eth::ADDR_LEN);
@@ -574,17 +564,7 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
                         sizeof(struct udp_hdr));
     tmpIp.ttl = 64;
     tmpIp.protocol = 17;
-
-    uint32_t serverIp = LINK_LOCAL_DHCP.to_ulong();
-    if (serverIpStr) {
-        address_v4 sip = address_v4::from_string(serverIpStr.get(), ec);
-        if (ec) {
-            LOG(WARNING) << "Invalid DHCP server IP: " << serverIpStr.get();
-        } else  {
-            serverIp = sip.to_ulong();
-        }
-    }
-    tmpIp.saddr = htonl(serverIp);
+    tmpIp.saddr = htonl(tmpl.serverIp);
     tmpIp.daddr = 0xffffffff;
 
     // compute IP header checksum
@@ -606,7 +586,7 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
     tmpDhcp.hlen = 6;
     tmpDhcp.xid = xid;
     tmpDhcp.yiaddr = htonl(clientIp);
-    tmpDhcp.siaddr = htonl(serverIp);
+    tmpDhcp.siaddr = htonl(tmpl.serverIp);
     memcpy(tmpDhcp.chaddr, clientMac, eth::ADDR_LEN);
     tmpDhcp.cookie[0] = 99;
     tmpDhcp.cookie[1] = 130;
@@ -614,81 +594,12 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
     tmpDhcp.cookie[3] = 99;
     memcpy(dhcp, &tmpDhcp, sizeof(tmpDhcp));
 
-    // initialize DHCP options
+    // initialize DHCP options; everything after the message type
+    // comes from the pre-encoded template
     message_type_opt->code = option::MESSAGE_TYPE;
     message_type_opt->len = option::MESSAGE_TYPE_LEN;
     ((char*)message_type_opt)[2] = message_type;
-
-    subnet_mask->code = option::SUBNET_MASK;
-    subnet_mask->len = option::IP_LEN;
-    if (prefixLen > 32) prefixLen = 32;
-    uint32_t maskVal = htonl(0xffffffff << (32-prefixLen));
-    memcpy((char*)subnet_mask + 2, &maskVal, sizeof(maskVal));
-
-    if (router_len > 0) {
-        routers_opt->code = option::ROUTER;
-        routers_opt->len = 4 * routerIps.size();
-        char* ipptr = (char*)routers_opt + 2;
-        for (const address_v4& ip : routerIps) {
-            uint32_t ipval = htonl(ip.to_ulong());
-            memcpy(ipptr, &ipval, sizeof(ipval));
-            ipptr += sizeof(ipval);
-        }
-    }
-
-    if (dns_len > 0) {
-        dns->code = option::DNS;
-        dns->len = 4 * dnsIps.size();
-        char* ipptr = (char*)dns + 2;
-        for (const address_v4& ip : dnsIps) {
-            uint32_t ipval = htonl(ip.to_ulong());
-            memcpy(ipptr, &ipval, sizeof(ipval));
-            ipptr += sizeof(ipval);
-        }
-    }
-
-    if (domain_len > 0) {
-        domain_opt->code = option::DOMAIN_NAME;
-        domain_opt->len = domain.get().size();
-        memcpy(((char*)domain_opt + 2), domain.get().c_str(),
-               domain.get().size());
-    }
-
-    lease_time->code = option::LEASE_TIME;
-    lease_time->len = option::LEASE_TIME_LEN;
-    uint32_t leaseTimeVal = htonl(leaseTime ? leaseTime.get() : 86400);
-    memcpy((char*)lease_time + 2, &leaseTimeVal, sizeof(leaseTimeVal));
-
-    server_identifier->code = option::SERVER_IDENTIFIER;
-    server_identifier->len = option::IP_LEN;
-    uint32_t serverIpVal = htonl(serverIp);
-    memcpy((char*)server_identifier + 2, &serverIpVal, sizeof(serverIp));
-
-    if (static_route_len > 0) {
-        static_routes->code = option::CLASSLESS_STATIC_ROUTE;
-        static_routes->len = static_route_len - 2;
-        char* cur = (char*)static_routes + 2;
-        for (const Routev4& route : routes) {
-            uint8_t octets = (route.prefixLen / 8) + (route.prefixLen % 8 != 0);
-            uint32_t dest = htonl(route.dest.to_ulong());
-            uint32_t nexthop = htonl(route.nextHop.to_ulong());
-            *cur++ = route.prefixLen;
-            for (uint8_t i = 0; i < octets; i++) {
-                *cur++ = ((char*)&dest)[i];
-            }
-            memcpy(cur, &nexthop, sizeof(nexthop));
-            cur += 4;
-        }
-    }
-
-    if (iface_mtu_len > 0) {
-        iface_mtu->code = option::INTERFACE_MTU;
-        iface_mtu->len = 2;
-        uint16_t mtuVal = htons(interfaceMtu.get());
-        memcpy((char*)iface_mtu + 2, &mtuVal, sizeof(mtuVal));
-    }
-
-    end->code = option::END;
+    memcpy(buf, tmpl.options.data(), tmpl.options.size());
 
     // compute UDP checksum
     chksum = 0;
@@ -708,46 +619,39 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
     return b;
 }
 
-OfpBuf compose_dhcpv6_reply(uint8_t message_type,
-                             const uint8_t* xid,
+OfpBuf compose_dhcpv4_reply(uint8_t message_type,
+                             uint32_t xid,
                              const uint8_t* srcMac,
                              const uint8_t* clientMac,
-                             const struct in6_addr* dstIp,
-                             uint8_t* client_id,
-                             uint16_t client_id_len,
-                             uint8_t* iaid,
-                             const vector<address_v6>& ips,
+                             uint32_t clientIp,
+                             uint8_t prefixLen,
+                             const optional<string>& serverIpStr,
+                             const vector<string>& routers,
                              const vector<string>& dnsServers,
-                             const vector<string>& searchList,
-                             bool temporary,
-                             bool rapid,
-                             const boost::optional<uint32_t>& t1,
-                             const boost::optional<uint32_t>& t2,
-                             const boost::optional<uint32_t>& preferredLifetime,
-                             const boost::optional<uint32_t>& validLifetime) {
-    using namespace dhcp6;
-    using namespace udp;
+                             const optional<string>& domain,
+                             const vector<static_route_t>& staticRoutes,
+                             const optional<uint16_t>& interfaceMtu,
+                             const optional<uint32_t>& leaseTime) {
+    return compose_dhcpv4_reply(message_type, xid, srcMac, clientMac,
+                                clientIp,
+                                build_dhcpv4_reply_template(prefixLen,
+                                                            serverIpStr,
+                                                            routers,
+                                                            dnsServers,
+                                                            domain,
+                                                            staticRoutes,
+                                                            interfaceMtu,
+                                                            leaseTime));
+}
 
-    eth::eth_header* eth = NULL;
-    struct ip6_hdr* ip6 = NULL;
-    struct udp_hdr* udp = NULL;
-    struct dhcp6_hdr* dhcp = NULL;
-    struct dhcp6_opt_hdr* client_id_opt = NULL;
-    struct dhcp6_opt_hdr* server_id_opt = NULL;
-    struct dhcp6_opt_hdr* ia = NULL;
-    struct dhcp6_opt_hdr* dns = NULL;
-    struct dhcp6_opt_hdr* domain_list = NULL;
-    struct dhcp6_opt_hdr* rapid_opt = NULL;
+DHCPv6ReplyTemplate
+build_dhcpv6_reply_template(const vector<string>& dnsServers,
+                            const vector<string>& searchList) {
+    using namespace dhcp6;
 
+    DHCPv6ReplyTemplate tmpl;
     boost::system::error_code ec;
 
-    // Compute size of reply and options
-    size_t dns_len = 0;
-    size_t domain_list_len = 0;
-    size_t ia_len = 0;
-
-    const size_t opt_hdr_len = sizeof(struct dhcp6_opt_hdr);
-
     vector<address_v6> dnsIps;
     for (const string& ipstr : dnsServers) {
         address_v6 ip = address_v6::from_string(ipstr, ec);
@@ -755,14 +659,21 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
         dnsIps.push_back(ip);
         if (dnsIps.size() >= MAX_IP) break;
     }
-    if (!dnsIps.empty())
-        dns_len = opt_hdr_len + sizeof(struct in6_addr) * dnsIps.size();
+    if (!dnsIps.empty()) {
+        struct dhcp6_opt_hdr hdr;
+        hdr.option_code = htons(option::DNS_SERVERS);
+        hdr.option_len = htons(sizeof(struct in6_addr) * dnsIps.size());
+        tmpl.options.append((const char*)&hdr, sizeof(hdr));
+        for (const address_v6& ip : dnsIps) {
+            address_v6::bytes_type bytes = ip.to_bytes();
+            tmpl.options.append((const char*)bytes.data(), bytes.size());
+        }
+    }
 
-    stringbuf domain_opt_buf;
-    size_t domain_opt_len = 0;
+    string domainBuf;
     for (const string& domain : searchList) {
         if (domain.size() > 255) continue;
-        if (domain_opt_len > 512) break;
+        if (domainBuf.size() > 512) break;
 
         vector<string> dchunks;
         split(dchunks, domain, is_any_of("."), token_compress_on);
@@ -777,17 +688,56 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
         if (!validdomain || dchunks.empty()) continue;
 
         for (const string& dchunk : dchunks) {
-            domain_opt_buf.sputc((uint8_t)dchunk.size());
-            domain_opt_buf.sputn(dchunk.c_str(), dchunk.size());
-            domain_opt_len += dchunk.size() + 1;
+            domainBuf.push_back((char)dchunk.size());
+            domainBuf.append(dchunk);
         }
-        domain_opt_buf.sputc(0);
-        domain_opt_len += 1;
+        domainBuf.push_back(0);
     }
-    if (domain_opt_len > 0) {
-        domain_list_len = domain_opt_len + opt_hdr_len;
+    if (!domainBuf.empty()) {
+        struct dhcp6_opt_hdr hdr;
+        hdr.option_code = htons(option::DOMAIN_LIST);
+        hdr.option_len = htons(domainBuf.size());
+        tmpl.options.append((const char*)&hdr, sizeof(hdr));
+        tmpl.options.append(domainBuf);
     }
 
+    return tmpl;
+}
+
+OfpBuf compose_dhcpv6_reply(uint8_t message_type,
+                             const uint8_t* xid,
+                             const uint8_t* srcMac,
+                             const uint8_t* clientMac,
+                             const struct in6_addr* dstIp,
+                             uint8_t* client_id,
+                             uint16_t client_id_len,
+                             uint8_t* iaid,
+                             const vector<address_v6>& ips,
+                             const DHCPv6ReplyTemplate& tmpl,
+                             bool temporary,
+                             bool rapid,
+                             const boost::optional<uint32_t>& t1,
+                             const boost::optional<uint32_t>& t2,
+                             const boost::optional<uint32_t>& preferredLifetime,
+                             const boost::optional<uint32_t>& validLifetime) {
+    using namespace dhcp6;
+    using namespace udp;
+
+    eth::eth_header* eth = NULL;
+    struct ip6_hdr* ip6 = NULL;
+    struct udp_hdr* udp = NULL;
+    struct dhcp6_hdr* dhcp = NULL;
+    struct dhcp6_opt_hdr* client_id_opt = NULL;
+    struct dhcp6_opt_hdr* server_id_opt = NULL;
+    struct dhcp6_opt_hdr* ia = NULL;
+    char* tmpl_opts = NULL;
+    struct dhcp6_opt_hdr* rapid_opt = NULL;
+
+    // Compute size of reply and options
+    size_t ia_len = 0;
+
+    const size_t opt_hdr_len = sizeof(struct dhcp6_opt_hdr);
+
     if (!ips.empty() && iaid != NULL) {
         ia_len = opt_hdr_len + 4 + ips.size() * (24 + opt_hdr_len);
         if (!temporary) ia_len += 8;
@@ -797,8 +747,7 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
         sizeof(struct dhcp6_hdr) +
         opt_hdr_len + client_id_len + /* client id */
         opt_hdr_len + 10 + /* server id */
-        dns_len +
-        domain_list_len +
+        tmpl.options.size() +
         ia_len +
         (rapid ? opt_hdr_len : 0);
     size_t len = sizeof(eth::eth_header) +
@@ -828,14 +777,8 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
         ia = (struct dhcp6_opt_hdr*)buf;
         buf += ia_len;
     }
-    if (dns_len > 0) {
-        dns = (struct dhcp6_opt_hdr*)buf;
-        buf += dns_len;
-    }
-    if (domain_list_len > 0) {
-        domain_list = (struct dhcp6_opt_hdr*)buf;
-        buf += domain_list_len;
-    }
+    tmpl_opts = buf;
+    buf += tmpl.options.size();
     if (rapid) {
         rapid_opt = (struct dhcp6_opt_hdr*)buf;
         buf += opt_hdr_len;
@@ -922,26 +865,8 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
         }
     }
 
-    // DNS servers
-    if (dns_len > 0) {
-        dns->option_code = htons(option::DNS_SERVERS);
-        dns->option_len = htons(sizeof(struct in6_addr) * dnsIps.size());
-        struct in6_addr* ipptr =
-            (struct in6_addr*)((char*)dns + opt_hdr_len);
-        for (const address_v6& ip : dnsIps) {
-            address_v6::bytes_type bytes = ip.to_bytes();
-            std::memcpy(ipptr, bytes.data(), bytes.size());
-            ipptr += 1;
-        }
-    }
-
-    // Domain search list
-    if (domain_list_len > 0) {
-        domain_list->option_code = htons(option::DOMAIN_LIST);
-        domain_list->option_len = htons(domain_opt_len);
-        char* dbuf = (char*)domain_list + opt_hdr_len;
-        domain_opt_buf.sgetn(dbuf, domain_opt_len);
-    }
+    // DNS servers and domain search list from the pre-encoded template
+    memcpy(tmpl_opts, tmpl.options.data(), tmpl.options.size());
 
     // Rapid commit option
     if (rapid) {
@@ -970,6 +895,31 @@ OfpBuf compose_dhcpv6_reply(uint8_t message_type,
     return b;
 }
 
+OfpBuf compose_dhcpv6_reply(uint8_t message_type,
+                             const uint8_t* xid,
+                             const uint8_t* srcMac,
+                             const uint8_t* clientMac,
+                             const struct in6_addr* dstIp,
+                             uint8_t* client_id,
+                             uint16_t client_id_len,
+                             uint8_t* iaid,
+                             const vector<address_v6>& ips,
+                             const vector<string>& dnsServers,
+                             const vector<string>& searchList,
+                             bool temporary,
+                             bool rapid,
+                             const boost::optional<uint32_t>& t1,
+                             const boost::optional<uint32_t>& t2,
+                             const boost::optional<uint32_t>& preferredLifetime,
+                             const boost::optional<uint32_t>& validLifetime) {
+    return compose_dhcpv6_reply(message_type, xid, srcMac, clientMac, dstIp,
+                                client_id, client_id_len, iaid, ips,
+                                build_dhcpv6_reply_template(dnsServers,
+                                                            searchList),
+                                temporary, rapid, t1, t2,
+                                preferredLifetime, validLifetime);
+}
+
 OfpBuf compose_arp(uint16_t op,
                     const uint8_t* srcMac,
                     const uint8_t* dstMac,
@@ -56,6 +56,7 @@ PolicyStatsManager::PolicyStatsManager(Agent* agent_, IdGenerator& idGen_,
       switchManager(switchManager_),
       connection(NULL),
       timer_interval(timer_interval_),
+      pollBackoff(1),
       stopping(false) {}
 
 PolicyStatsManager::~PolicyStatsManager() {}
@@ -123,6 +124,7 @@ void PolicyStatsManager::updateFlowEntryMap(flowCounterState_t& counterState,
     }
 
     /* Add the flow entry to newmap */
+    counterState.changed = true;
     FlowCounters_t& flowCounters =
         counterState.newFlowCounterMap[flowEntryKey];
     flowCounters.visited = false;
@@ -224,25 +226,25 @@ on_timer_base(const error_code& ec,
             FlowStats_t& newClassCounters =
                 newClassCountersMap[flowMatchKey];
 
-            uint64_t packet_count = 0;
-            uint64_t byte_count = 0;
-            if (newClassCounters.packet_count) {
-                // get existing packet_count and byte_count
-                packet_count = newClassCounters.packet_count.get();
-                byte_count = newClassCounters.byte_count.get();
-            }
+            // get existing packet_count and byte_count
+            uint64_t packet_count =
+                (newClassCounters.packet_count)
+                ? newClassCounters.packet_count.get() : 0;
+            uint64_t byte_count =
+                (newClassCounters.byte_count)
+                ? newClassCounters.byte_count.get() : 0;
 
             // Add counters for flow entry to be removed
             newClassCounters.packet_count =
                 make_optional(true,
-                              (remFlowCounters.diff_packet_count)
-                              ? remFlowCounters.diff_packet_count.get()
-                              : 0 + packet_count);
+                              ((remFlowCounters.diff_packet_count)
+                               ? remFlowCounters.diff_packet_count.get()
+                               : 0) + packet_count);
             newClassCounters.byte_count =
                 make_optional(true,
-                              (remFlowCounters.diff_byte_count)
-                              ? remFlowCounters.diff_byte_count.get()
-                              : 0 + byte_count);
+                              ((remFlowCounters.diff_byte_count)
+                               ? remFlowCounters.diff_byte_count.get()
+                               : 0) + byte_count);
         }
     }
 
@@ -338,6 +340,7 @@ void PolicyStatsManager::updateNewFlowCounters(uint32_t cookie,
 
         oldFlowCounters.visited = true;
         if ((flow_packet_count - packet_count) > 0) {
+            counterState.changed = true;
             oldFlowCounters.diff_packet_count =
                 flow_packet_count - packet_count;
             oldFlowCounters.diff_byte_count =
@@ -346,6 +349,7 @@ void PolicyStatsManager::updateNewFlowCounters(uint32_t cookie,
             oldFlowCounters.last_byte_count = flow_byte_count;
         }
         if (flowRemoved) {
+            counterState.changed = true;
             // Move the entry to removedFlowCounterMap
             FlowCounters_t & newFlowCounters =
                 counterState.removedFlowCounterMap[flowEntryKey];
@@ -363,6 +367,7 @@ void PolicyStatsManager::updateNewFlowCounters(uint32_t cookie,
             // the flow entry probably got removed even before Policy Stats
             // manager could process its FLOW_STATS_REPLY
             if (flowRemoved) {
+                counterState.changed = true;
                 FlowCounters_t & remFlowCounters =
                     counterState.removedFlowCounterMap[flowEntryKey];
                 remFlowCounters.diff_byte_count =
@@ -682,6 +687,7 @@ void PolicyStatsManager::clearOldCounters(const std::string& key,
         genIdList_[key] =
             std::unique_ptr<CircularBuffer>(new CircularBuffer());
     }
+    genIdList_[key]->idle = 0;
     if (genIdList_[key]->count == MAX_COUNTER_LIMIT) {
         genIdList_[key]->count = 0;
     }
@@ -694,6 +700,36 @@ void PolicyStatsManager::clearOldCounters(const std::string& key,
     genIdList_[key]->count++;
 }
 
+void PolicyStatsManager::removeIdleCounterObjects() {
+    // Counter objects are deltas that have already been reported, so
+    // once a classifier goes quiet its window only takes up space in
+    // the observer store.  Drop it rather than keeping it forever.
+    std::vector<std::string> idleKeys;
+    for (auto& g : genIdList_) {
+        if (++g.second->idle >= MAX_IDLE_POLLS)
+            idleKeys.push_back(g.first);
+    }
+    if (idleKeys.empty())
+        return;
+
+    Mutator mutator(agent->getFramework(), "policyelement");
+    for (const std::string& key : idleKeys) {
+        LOG(DEBUG) << "Removing counters of idle classifier " << key;
+        for (size_t i = 0; i < genIdList_[key]->uidList.size(); i++)
+            clearCounterObject(key, i);
+        genIdList_.erase(key);
+    }
+    mutator.commit();
+}
+
+long PolicyStatsManager::getNextPollInterval(bool changed) {
+    if (changed)
+        pollBackoff = 1;
+    else if (pollBackoff < MAX_POLL_BACKOFF)
+        pollBackoff *= 2;
+    return timer_interval * pollBackoff;
+}
+
 bool PolicyStatsManager::PolicyFlowMatchKey_t::
 operator==(const PolicyFlowMatchKey_t &other) const {
     return (cookie == other.cookie
@@ -85,6 +85,7 @@ void SecGrpStatsManager::on_timer(const error_code& ec) {
     };
 
     // Request Switch Manager to provide flow entries
+    long interval;
     {
         std::lock_guard<std::mutex> lock(pstatMtx);
         switchManager.
@@ -105,6 +106,12 @@ void SecGrpStatsManager::on_timer(const error_code& ec) {
         on_timer_base(ec, secGrpOutState, newClassCountersMap2);
         generatePolicyStatsObjects(&newClassCountersMap1,
                                    &newClassCountersMap2);
+        removeIdleCounterObjects();
+
+        interval = getNextPollInterval(secGrpInState.changed ||
+                                       secGrpOutState.changed);
+        secGrpInState.changed = false;
+        secGrpOutState.changed = false;
     }
 
     sendRequest(AccessFlowManager::SEC_GROUP_IN_TABLE_ID);
@@ -112,7 +119,7 @@ void SecGrpStatsManager::on_timer(const error_code& ec) {
     if (!stopping) {
         std::lock_guard<std::mutex> lock(timer_mutex);
         if (timer) {
-            timer->expires_from_now(milliseconds(timer_interval));
+            timer->expires_from_now(milliseconds(interval));
             timer->async_wait(bind(&SecGrpStatsManager::on_timer, this, error));
         }
     }
@@ -61,77 +61,38 @@ void ServiceStatsManager::stop() {
 
 void ServiceStatsManager::update_state (const error_code& ec)
 {
-    // Request Switch Manager to provide flow entries
-    {
+    // Pod <--> Svc and * <--> svc-tgt stats are spread across the
+    // STATS, SERVICE_NEXTHOP (svc-tgt rx) and SERVICE_REV (svc-tgt
+    // tx) tables. All of them carry a "svcstat" idgen cookie, so fold
+    // the deltas of the three tables into a single counter map keyed
+    // by cookie and publish it as one batch.
+    std::lock_guard<std::mutex> lock(pstatMtx);
+    ServiceCounterMap_t countersMap;
+
+    const std::pair<uint8_t, flowCounterState_t*> tables[] = {
+        {IntFlowManager::STATS_TABLE_ID, &statsState},
+        {IntFlowManager::SERVICE_NEXTHOP_TABLE_ID, &svhState},
+        {IntFlowManager::SERVICE_REV_TABLE_ID, &svrState},
+    };
+    for (auto& t : tables) {
+        flowCounterState_t& counterState = *t.second;
         TableState::cookie_callback_t cb_func;
-        cb_func = [this](uint64_t cookie, uint16_t priority,
-                         const struct match& match) {
-            updateFlowEntryMap(statsState, cookie, priority, match);
+        cb_func = [this, &counterState](uint64_t cookie, uint16_t priority,
+                                        const struct match& match) {
+            updateFlowEntryMap(counterState, cookie, priority, match);
         };
 
-        // Pod <--> Svc and * <--> svc-tgt stats handling based
-        // on flows in STATS table
-        std::lock_guard<std::mutex> lock(pstatMtx);
-
         // create flowcountermap entries for new flows
-        switchManager.forEachCookieMatch(IntFlowManager::STATS_TABLE_ID,
-                                         cb_func);
+        switchManager.forEachCookieMatch(t.first, cb_func);
 
-        // aggregate statsCounterMap based on FlowCounterState
-        ServiceCounterMap_t statsCountersMap;
-        on_timer_base(ec, statsState, statsCountersMap);
-
-        // Update service stats objects. IntFlowManager/ServiceManager would
-        // have already created the objects. If its not resolved,
-        // then new objects will get created 
-        updateServiceStatsObjects(&statsCountersMap);
+        // aggregate countersMap based on FlowCounterState
+        on_timer_base(ec, counterState, countersMap);
     }
 
-    {
-        TableState::cookie_callback_t cb_func;
-        cb_func = [this](uint64_t cookie, uint16_t priority,
-                         const struct match& match) {
-            updateFlowEntryMap(svhState, cookie, priority, match);
-        };
-
-        // svc-tgt rx stats handling based on flows in SERVICE_NEXTHOP table
-        std::lock_guard<std::mutex> lock(pstatMtx);
-
-        // create flowcountermap entries for new flows
-        switchManager.forEachCookieMatch(IntFlowManager::SERVICE_NEXTHOP_TABLE_ID,
-                                         cb_func);
-
-        // aggregate statsCounterMap based on FlowCounterState
-        ServiceCounterMap_t svhCountersMap;
-        on_timer_base(ec, svhState, svhCountersMap);
-
-        // Update service stats objects. ServiceManager would
-        // have already created the objects.
-        updateServiceStatsObjects(&svhCountersMap);
-    }
-
-    {
-        TableState::cookie_callback_t cb_func;
-        cb_func = [this](uint64_t cookie, uint16_t priority,
-                         const struct match& match) {
-            updateFlowEntryMap(svrState, cookie, priority, match);
-        };
-
-        // svc-tgt tx stats handling based on flows in SERVICE_REV table
-        std::lock_guard<std::mutex> lock(pstatMtx);
-
-        // create flowcountermap entries for new flows
-        switchManager.forEachCookieMatch(IntFlowManager::SERVICE_REV_TABLE_ID,
-                                         cb_func);
-
-        // aggregate svrCounterMap based on FlowCounterState
-        ServiceCounterMap_t svrCountersMap;
-        on_timer_base(ec, svrState, svrCountersMap);
-
-        // Update service stats objects. ServiceManager would
-        // have already created the objects.
-        updateServiceStatsObjects(&svrCountersMap);
-    }
+    // Update service stats objects. IntFlowManager/ServiceManager would
+    // have already created the objects. If its not resolved,
+    // then new objects will get created
+    updateServiceStatsObjects(&countersMap);
 }
 
 void ServiceStatsManager::on_timer(const error_code& ec) {
@@ -245,25 +206,25 @@ on_timer_base(const error_code& ec,
             FlowStats_t& newStatsCounters =
                 statsCountersMap[flowMatchKey];
 
-            uint64_t packet_count = 0;
-            uint64_t byte_count = 0;
-            if (newStatsCounters.packet_count) {
-                // get existing packet_count and byte_count
-                packet_count = newStatsCounters.packet_count.get();
-                byte_count = newStatsCounters.byte_count.get();
-            }
+            // get existing packet_count and byte_count
+            uint64_t packet_count =
+                (newStatsCounters.packet_count)
+                ? newStatsCounters.packet_count.get() : 0;
+            uint64_t byte_count =
+                (newStatsCounters.byte_count)
+                ? newStatsCounters.byte_count.get() : 0;
 
             // Add counters for flow entry to be removed
             newStatsCounters.packet_count =
                 make_optional(true,
-                              (remFlowCounters.diff_packet_count)
-                              ? remFlowCounters.diff_packet_count.get()
-                              : 0 + packet_count);
+                              ((remFlowCounters.diff_packet_count)
+                               ? remFlowCounters.diff_packet_count.get()
+                               : 0) + packet_count);
             newStatsCounters.byte_count =
                 make_optional(true,
-                              (remFlowCounters.diff_byte_count)
-                              ? remFlowCounters.diff_byte_count.get()
-                              : 0 + byte_count);
+                              ((remFlowCounters.diff_byte_count)
+                               ? remFlowCounters.diff_byte_count.get()
+                               : 0) + byte_count);
         }
     }
 
@@ -303,21 +264,20 @@ on_timer_base(const error_code& ec,
 // Generate/update Pod <--> Svc stats objects
 void ServiceStatsManager::
 updateServiceStatsObjects(ServiceCounterMap_t *newCountersMap) {
-    
-    // walk through newCountersMap to update new set of MOs
-    for (ServiceCounterMap_t:: iterator itr = newCountersMap->begin();
-         itr != newCountersMap->end();
-         itr++) {
-        
-        const ServiceFlowMatchKey_t& flowKey = itr->first;
-        FlowStats_t&  newCounters = itr->second;
-        if (newCounters.packet_count.get() != 0) {
-            intFlowManager.updateSvcStatsCounters(
-                                     flowKey.cookie,
-                                     newCounters.packet_count.get(),
-                                     newCounters.byte_count.get());
-        } 
+    IntFlowManager::SvcStatsCounterMap counters;
+    counters.reserve(newCountersMap->size());
+    for (auto& c : *newCountersMap) {
+        FlowStats_t& newCounters = c.second;
+        if (!newCounters.packet_count ||
+            newCounters.packet_count.get() == 0)
+            continue;
+        counters.emplace(c.first.cookie,
+                         IntFlowManager::SvcStatsCounter(
+                             newCounters.packet_count.get(),
+                             newCounters.byte_count.get()));
     }
+    if (!counters.empty())
+        intFlowManager.updateSvcStatsCounters(counters);
 }
 
 bool ServiceStatsManager::ServiceFlowMatchKey_t::
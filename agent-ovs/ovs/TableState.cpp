@@ -178,10 +178,22 @@ ostream & operator<<(ostream& os, const GroupEdit::Entry& ge) {
     case OFPGC11_ADD:      os << "ADD"; break;
     case OFPGC11_MODIFY:   os << "MOD"; break;
     case OFPGC11_DELETE:   os << "DEL"; break;
+    case OFPGC15_INSERT_BUCKET: os << "INSERT_BUCKET"; break;
+    case OFPGC15_REMOVE_BUCKET: os << "REMOVE_BUCKET"; break;
     default:               os << "Unknown";
     }
     os << "|group_id=" << mod.group_id << ",type="
        << groupTypeStr[std::min<uint8_t>(4, mod.type)];
+    if (mod.command == OFPGC15_INSERT_BUCKET ||
+        mod.command == OFPGC15_REMOVE_BUCKET) {
+        os << ",command_bucket_id=";
+        switch (mod.command_bucket_id) {
+        case OFPG15_BUCKET_FIRST: os << "first"; break;
+        case OFPG15_BUCKET_LAST:  os << "last"; break;
+        case OFPG15_BUCKET_ALL:   os << "all"; break;
+        default:                  os << mod.command_bucket_id;
+        }
+    }
 
     ofputil_bucket *bkt;
     LIST_FOR_EACH (bkt, list_node, &mod.buckets) {
@@ -13,6 +13,12 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <opflexagent/Agent.h>
 #include <opflexagent/EndpointManager.h>
 #include <opflexagent/PolicyListener.h>
@@ -56,6 +62,15 @@ public:
      */
     void enableConnTrack();
 
+    /**
+     * Enable shared security group flows.  In this mode each
+     * security group is compiled once into conjunctive matches and a
+     * security group set only contributes flows that mark its member
+     * groups, so the flow count scales with the number of distinct
+     * security groups rather than the number of distinct sets.
+     */
+    void enableSecGroupConjunction();
+
     /**
      * Start the access flow manager
      */
@@ -160,6 +175,45 @@ private:
     void handlePortStatusUpdate(const std::string& portName, uint32_t portNo);
     void handleSecGrpSetUpdate(const EndpointListener::uri_set_t& secGrps,
                                const std::string& secGrpsId);
+    void buildSecGrpRules(const opflex::modb::URI& secGrp,
+                          uint32_t secGrpSetId,
+                          FlowEntryList& secGrpIn,
+                          FlowEntryList& secGrpOut);
+
+    /*
+     * Shared security group flows using conjunctive matches.  The
+     * first clause of each conjunction matches the security group
+     * set ID in REG0 and is written per set; the second clause
+     * matches the classifier and is written once for all groups that
+     * share an identical match.  The flow executed on a match is
+     * written once per conjunction ID and keeps the rule cookie, so
+     * the statistics for the rule are attributed by classifier.
+     */
+    typedef std::pair<uint8_t, uint16_t> conj_prio_t;
+    typedef std::map<conj_prio_t, std::vector<uint32_t> > conj_prio_map_t;
+
+    struct SecGrpConj {
+        /** conjunction IDs by table and priority */
+        conj_prio_map_t conjIds;
+        /** keys for the clause flows this group contributes to */
+        std::unordered_set<std::string> clauses;
+        /** keys used to allocate the conjunction IDs */
+        std::unordered_set<std::string> idKeys;
+    };
+
+    struct ConjClause {
+        /** flow entry with the match for the clause */
+        FlowEntryPtr match;
+        /** conjunction IDs for the clause by security group */
+        std::unordered_map<opflex::modb::URI,
+                           std::vector<uint32_t> > members;
+    };
+
+    void handleSecGrpSetConjUpdate(const EndpointListener::uri_set_t& secGrps,
+                                   const std::string& secGrpsId);
+    void updateSecGrpConj(const opflex::modb::URI& secGrp);
+    void removeSecGrpConj(const opflex::modb::URI& secGrp);
+    void writeConjClause(const std::string& clauseKey);
 
     Agent& agent;
     SwitchManager& switchManager;
@@ -168,6 +222,10 @@ private:
     TaskQueue taskQueue;
 
     bool conntrackEnabled;
+    bool secGroupConjunction;
+    std::mutex secGrpConjMutex;
+    std::unordered_map<opflex::modb::URI, SecGrpConj> secGrpConjMap;
+    std::unordered_map<std::string, ConjClause> conjClauseMap;
     std::atomic<bool> stopping;
     std::string dropLogIface;
     boost::asio::ip::address dropLogDst;
@@ -377,6 +377,19 @@ public:
                              uint32_t arg,
                              mf_field_id dst);
 
+    /**
+     * Conjunction action.  The flow matches one dimension of the
+     * conjunctive match with the given ID; the flow matching
+     * conj_id=id is executed once a packet matches every dimension.
+     *
+     * @param id the conjunction ID
+     * @param clause the index of the clause, from 1 to nClauses
+     * @param nClauses the total number of clauses in the conjunction
+     * @return this action builder for chaining
+     */
+    ActionBuilder& conjunction(uint32_t id, uint8_t clause,
+                               uint8_t nClauses);
+
     /**
      * Perform a MAC/VLAN learning action and write the result to the
      * specified table with the specified priority and cookie.
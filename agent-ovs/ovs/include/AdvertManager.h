@@ -16,10 +16,19 @@
 #include "PortMapper.h"
 
 #include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <boost/asio/deadline_timer.hpp>
 
 #include <mutex>
 #include <random>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
 
 namespace opflexagent {
 
@@ -30,7 +39,8 @@ class IntFlowManager;
  * packet-out.  This includes router advertisements, and gratuituous
  * and/or reverse ARP/NDP.
  */
-class AdvertManager : private boost::noncopyable {
+class AdvertManager : public MessageHandler,
+                      private boost::noncopyable {
 public:
     /**
      * Construct a AdvertManager
@@ -105,6 +115,32 @@ public:
     { tunnelEndpointAdv = tunnelMode;
       tunnelEpAdvInterval = delay;}
 
+    /**
+     * Set the maximum rate at which endpoint and service
+     * advertisements are sent
+     *
+     * @param pps the number of advertisement packets per second, or
+     * zero for no limit
+     */
+    void setAdvRateLimit(uint32_t pps) { advRateLimit = pps; }
+
+    /**
+     * Get the time until the advertisement scheduler next runs.
+     * Useful for testing.
+     *
+     * @return the delay in milliseconds, or boost::none if the
+     * scheduler is idle
+     */
+    boost::optional<uint64_t> getAdvTickDelay();
+
+    /**
+     * Send each batch of endpoint and service advertisements in an
+     * OpenFlow bundle
+     *
+     * @param enabled true to send advertisement batches in bundles
+     */
+    void enableAdvBundles(bool enabled) { advBundles = enabled; }
+
     /**
      * Module start
      */
@@ -149,6 +185,20 @@ public:
      */
     void scheduleTunnelEpAdv(const std::string& uuid);
 
+    // **************
+    // MessageHandler
+    // **************
+
+    /**
+     * Handle the bundle control replies and errors for advertisement
+     * bundles.  If a bundle fails, its advertisements are sent again
+     * as individual packet-outs and bundles are no longer used.
+     */
+    virtual void Handle(SwitchConnection* swConn,
+                        int msgType,
+                        ofpbuf* msg,
+                        struct ofputil_flow_removed* fentry = NULL);
+
 private:
     std::random_device rng;
     std::mt19937 urng;
@@ -174,27 +224,39 @@ private:
      * specified endpoint
      *
      * @param uuid the UUID of the endpoint
+     * @param bundleId the bundle to add the packet-outs to, or zero
+     * @return the number of packets sent
      */
-    void sendEndpointAdvs(const std::string& uuid);
+    size_t sendEndpointAdvs(const std::string& uuid, uint32_t bundleId = 0);
 
     /**
-     * Synchronously send endpoint gratuitous advertisements for all
-     * active endpoints.
+     * Queue endpoint gratuitous advertisements for all active
+     * endpoints in the advertisement scheduler
+     *
+     * @param immediate true to send the advertisements as soon as
+     * the rate limit allows, or false to spread them over the
+     * refresh interval
      */
-    void sendAllEndpointAdvs();
+    void queueAllEndpointAdvs(bool immediate);
 
     /**
-     * Synchronously send service gratuitous advertisements for all
-     * active endpoints.
+     * Queue service gratuitous advertisements for all active
+     * services in the advertisement scheduler
+     *
+     * @param immediate true to send the advertisements as soon as
+     * the rate limit allows, or false to spread them over the
+     * refresh interval
      */
-    void sendAllServiceAdvs();
+    void queueAllServiceAdvs(bool immediate);
 
     /**
      * Synchronously send service advertisements for service endpoints
      *
      * @param uuid the UUID of the service
+     * @param bundleId the bundle to add the packet-outs to, or zero
+     * @return the number of packets sent
      */
-    void sendServiceAdvs(const std::string& uuid);
+    size_t sendServiceAdvs(const std::string& uuid, uint32_t bundleId = 0);
 
     /**
      * Synchronously send GARP for tunnel endpoints
@@ -222,7 +284,8 @@ private:
     EndpointAdvMode tunnelEndpointAdv;
     uint64_t tunnelEpAdvInterval;
     void onEndpointAdvTimer(const boost::system::error_code& ec);
-    void onAllEndpointAdvTimer(const boost::system::error_code& ec);
+    void onAllEndpointAdvTimer(const boost::system::error_code& ec,
+                               bool initial);
     void doScheduleEpAdv(uint64_t time = 250);
     void onTunnelEpAdvTimer(const boost::system::error_code& ec);
     void doScheduleTunnelEpAdv(uint64_t time = 1);
@@ -237,6 +300,85 @@ private:
     pending_ep_map_t pendingServices;
     pending_ep_map_t pendingTunnelEps;
 
+    /*
+     * Paced advertisement scheduler.  Every endpoint and service has
+     * its own refresh deadline, kept in a hashed timing wheel.  On
+     * each tick the items that are due are moved to a ready queue,
+     * which is drained subject to a global packets-per-second budget.
+     * Ticks are numbered from advEpoch, and the timer only runs while
+     * items are ready or to wake up for the next occupied slot.  All
+     * state is protected by ep_mutex.
+     */
+    enum AdvType {
+        ADV_ENDPOINT,
+        ADV_SERVICE
+    };
+    typedef std::pair<uint8_t, std::string> adv_key_t;
+    typedef std::unordered_set<adv_key_t,
+                               boost::hash<adv_key_t>> adv_key_set_t;
+
+    uint32_t advRateLimit;
+    std::atomic<bool> advBundles;
+    uint32_t advBundleId;
+    /** the items sent in each bundle not yet committed, by bundle ID */
+    std::map<uint32_t, std::vector<adv_key_t>> advPendingBundles;
+    /** the bundle for the xid of each open and commit request */
+    std::unordered_map<uint32_t, uint32_t> advBundleXids;
+    std::vector<adv_key_set_t> advWheel;
+    std::unordered_map<adv_key_t, uint64_t,
+                       boost::hash<adv_key_t>> advDeadlines;
+    std::deque<adv_key_t> advReady;
+    adv_key_set_t advReadySet;
+    std::chrono::steady_clock::time_point advEpoch;
+    uint64_t advTick;
+    double advTokens;
+    bool advTickScheduled;
+    std::chrono::steady_clock::time_point advTickExpiry;
+    std::unique_ptr<boost::asio::deadline_timer> advTickTimer;
+
+    /**
+     * Get the tick for the current time
+     */
+    uint64_t currentAdvTick() const;
+
+    /**
+     * Schedule an advertisement in the timing wheel.  If the item is
+     * already scheduled, the earlier of the two deadlines is kept.
+     * Must be called with ep_mutex held.
+     *
+     * @param key the item to schedule
+     * @param delay the delay in milliseconds
+     */
+    void wheelSchedule(const adv_key_t& key, uint64_t delay);
+
+    /**
+     * Forget a pending bundle and any bundle opened before it.  Must
+     * be called with ep_mutex held.
+     *
+     * @param bundleId the bundle ID
+     */
+    void clearPendingBundles(uint32_t bundleId);
+
+    /**
+     * Send a batch of advertisements, optionally in a bundle
+     *
+     * @param batch the items to send
+     * @param rearm the items that should be scheduled for refresh
+     * @return the number of packets sent
+     */
+    size_t sendAdvBatch(const std::vector<adv_key_t>& batch,
+                        std::vector<adv_key_t>& rearm);
+
+    /**
+     * Run the scheduler tick after the given delay, unless it is
+     * already due to run earlier.  Must not be called with ep_mutex
+     * held.
+     *
+     * @param delay the delay in milliseconds
+     */
+    void scheduleAdvTick(uint64_t delay);
+    void onAdvTickTimer(const boost::system::error_code& ec);
+
     Agent& agent;
     IntFlowManager& intFlowManager;
     PortMapper* portMapper;
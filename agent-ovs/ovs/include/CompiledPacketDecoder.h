@@ -0,0 +1,123 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*
+ * Include file for CompiledPacketDecoder
+ *
+ * Copyright (c) 2020 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+#ifndef OPFLEXAGENT_COMPILEDPACKETDECODER_H
+#define OPFLEXAGENT_COMPILEDPACKETDECODER_H
+
+#include "PacketDecoder.h"
+
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+namespace opflexagent {
+
+/**
+ * Raw header values for a packet decoded by CompiledPacketDecoder.
+ * Nothing is formatted while decoding; the printable forms are only
+ * produced by toPacketTuple() or the stream operator when a consumer
+ * actually needs them.
+ */
+struct CompactPacketTuple {
+    /**
+     * Layers present in the decoded packet
+     */
+    enum Layer {
+        LAYER_ETHERNET = 1 << 0,
+        LAYER_QTAG = 1 << 1,
+        LAYER_IPV4 = 1 << 2,
+        LAYER_IPV6 = 1 << 3,
+        LAYER_ARP = 1 << 4,
+        LAYER_ICMP = 1 << 5,
+        LAYER_TCP = 1 << 6,
+        LAYER_UDP = 1 << 7
+    };
+
+    /**
+     * Check whether the given layer was decoded
+     * @param layer the layer to check
+     * @return true if present
+     */
+    bool has(Layer layer) const { return (layers & layer) != 0; }
+
+    /**
+     * Convert to the string based tuple used for packet events
+     * @param pt the tuple to fill in; the drop reason is left untouched
+     */
+    void toPacketTuple(PacketTuple &pt) const;
+
+    ///@{
+    /** Header values, in host byte order where applicable */
+    time_t timeStamp = 0;
+    uint32_t layers = 0;
+    uint32_t meta[2] = {0, 0};
+    uint8_t dstMac[6] = {0};
+    uint8_t srcMac[6] = {0};
+    uint16_t outerEtherType = 0;
+    uint16_t etherType = 0;
+    uint16_t vlan = 0;
+    uint8_t srcIp[16] = {0};
+    uint8_t dstIp[16] = {0};
+    uint16_t l3Length = 0;
+    uint8_t dscp = 0;
+    uint8_t ttl = 0;
+    uint16_t ipId = 0;
+    uint8_t ipFlags = 0;
+    uint16_t fragOffset = 0;
+    uint32_t flowLabel = 0;
+    uint8_t ipProto = 0;
+    uint16_t arpOp = 0;
+    uint16_t srcPort = 0;
+    uint16_t dstPort = 0;
+    uint32_t tcpSeq = 0;
+    uint32_t tcpAck = 0;
+    uint8_t tcpDataOffset = 0;
+    uint16_t tcpFlags = 0;
+    uint16_t tcpWindow = 0;
+    uint16_t tcpUrgent = 0;
+    uint16_t udpLength = 0;
+    uint8_t icmpType = 0;
+    uint8_t icmpCode = 0;
+    uint16_t icmpId = 0;
+    uint16_t icmpSeq = 0;
+    ///@}
+};
+
+/**
+ * Write the tuple in the same format as the parsed string produced
+ * by PacketDecoder
+ * @param os the output stream
+ * @param t the tuple to write
+ * @return os
+ */
+std::ostream& operator<<(std::ostream &os, const CompactPacketTuple &t);
+
+/**
+ * Fixed-layout decoder for the Geneve encapsulated packets sent to
+ * the packet logging socket.  It decodes the same layers as the
+ * table driven PacketDecoder, but uses static per-layer offsets and
+ * fills in a CompactPacketTuple without building any strings.
+ */
+class CompiledPacketDecoder {
+public:
+    /**
+     * Decode the given buffer
+     * @param buf packet buffer to decode, starting at the Geneve header
+     * @param length length of the buffer
+     * @param t the tuple to fill in
+     * @return 0 if decoding was error free
+     */
+    int decode(const unsigned char *buf, std::size_t length,
+               CompactPacketTuple &t) const;
+};
+
+} /* namespace opflexagent */
+
+#endif /* OPFLEXAGENT_COMPILEDPACKETDECODER_H */
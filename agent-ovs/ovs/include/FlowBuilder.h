@@ -310,6 +310,13 @@ public:
         CT_TRACKED     = 0x20,
     };
 
+    /**
+     * Match against the conjunction ID of a conjunctive match
+     * @param conjId the conjunction ID to match
+     * @return this flow builder for chaining
+     */
+    FlowBuilder& conjId(uint32_t conjId);
+
     /**
      * Match against the connection tracking state for the packet
      * @param ctState the value of the connection tracking state
@@ -14,6 +14,7 @@
 
 #include "TableState.h"
 #include <opflexagent/Network.h>
+#include <opflexagent/PolicyManager.h>
 
 #include <modelgbp/gbpe/L24Classifier.hpp>
 
@@ -118,6 +119,32 @@ void add_classifier_entries(modelgbp::gbpe::L24Classifier& clsfr,
                             uint32_t svnid, uint32_t dvnid,
                             /* out */ FlowEntryList& entries);
 
+/**
+ * Create flow entries for a policy rule and append them to the
+ * provided list.  Uses the port masks and priority compiled into
+ * the rule rather than recomputing them from the classifier.
+ *
+ * @param rule the rule to get the classifier, priority and port
+ * masks from
+ * @param act an action to take for the flows
+ * @param sourceSub A set of source networks to which the rule should apply
+ * @param destSub A set of dest networks to which the rule should apply
+ * @param nextTable the table to send to if the traffic is allowed
+ * @param flags the flow flags to use
+ * @param cookie Cookie of the entry created
+ * @param svnid VNID of the source endpoint group for the entry
+ * @param dvnid VNID of the destination endpoint group for the entry
+ * @param entries List to append entry to
+ */
+void add_classifier_entries(const PolicyRule& rule,
+                            ClassAction act,
+                            boost::optional<const network::subnets_t&> sourceSub,
+                            boost::optional<const network::subnets_t&> destSub,
+                            uint8_t nextTable,
+                            uint32_t flags, uint64_t cookie,
+                            uint32_t svnid, uint32_t dvnid,
+                            /* out */ FlowEntryList& entries);
+
 /**
  * Create L2 flow entries for the classifier specified and append them
  * to the provided list.
@@ -148,6 +175,33 @@ void add_l2classifier_entries(modelgbp::gbpe::L24Classifier& clsfr,
  */
 FlowBuilder& match_dhcp_req(FlowBuilder& fb, bool v4);
 
+/**
+ * Create a clause flow for a conjunctive match from an existing flow
+ * entry.  The new entry keeps the table, priority and match of the
+ * original entry and replaces its actions with a conjunction action
+ * for each of the specified conjunction IDs.
+ *
+ * @param fe the flow entry to copy the match from
+ * @param conjIds the conjunction IDs the clause contributes to
+ * @param clause the index of the clause, from 1 to nClauses
+ * @param nClauses the number of clauses in each conjunction
+ * @return the new flow entry
+ */
+FlowEntryPtr conjunction_clause(const FlowEntry& fe,
+                                const std::vector<uint32_t>& conjIds,
+                                uint8_t clause, uint8_t nClauses);
+
+/**
+ * Create the flow executed when a conjunctive match succeeds.  The
+ * new entry keeps the table, priority, cookie, flags and actions of
+ * the original entry but matches only on the conjunction ID.
+ *
+ * @param fe the flow entry to copy the actions from
+ * @param conjId the conjunction ID to match
+ * @return the new flow entry
+ */
+FlowEntryPtr conjunction_action(const FlowEntry& fe, uint32_t conjId);
+
 } // namespace flowutils
 } // namespace opflexagent
 
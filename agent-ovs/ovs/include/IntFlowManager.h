@@ -174,6 +174,29 @@ public:
      */
     void enableConnTrack();
 
+    /**
+     * Load balance service traffic using a select group per service
+     * mapping instead of a multipath action.  Each next hop is a
+     * bucket with a stable bucket ID, so adding or removing a next
+     * hop only changes its own bucket and next hop flows, and the
+     * switch's hash over the bucket IDs keeps connections to the
+     * other next hops in place.
+     */
+    void enableServiceSelectGroups();
+
+    /**
+     * Collect service target stats from the service next hop and
+     * reverse flows, which already carry the per (service, target)
+     * stats cookie, instead of installing a dedicated pair of stats
+     * flows per local target.
+     *
+     * The stats flows match the target IP and port, so they count all
+     * traffic to the target.  The next hop and reverse flows only see
+     * traffic load balanced through the service IP, so in this mode
+     * traffic sent to the target IP directly is not counted.
+     */
+    void enableServiceStatsAggregation();
+
     /**
      * Enable or disable the virtual routing
      *
@@ -207,6 +230,16 @@ public:
             AdvertManager::EndpointAdvMode tunnelMode,
             uint64_t tunnelAdvIntvl=600);
 
+    /**
+     * Set the pacing for endpoint and service advertisements
+     *
+     * @param pps the maximum number of advertisement packets per
+     * second, or zero for no limit
+     * @param bundles true to send each batch of advertisements in an
+     * OpenFlow bundle
+     */
+    void setEndpointAdvRate(uint32_t pps, bool bundles);
+
     /**
      * Set the multicast group file
      * @param mcastGroupFile The file where multicast group
@@ -486,6 +519,40 @@ public:
     void updateSvcStatsCounters(const uint64_t &cookie,
                                 const uint64_t &pkts,
                                 const uint64_t &bytes);
+
+    /**
+     * Packet and byte counts collected for a "svcstat" cookie
+     */
+    struct SvcStatsCounter {
+        /**
+         * Construct a counter
+         *
+         * @param pkts_ packet count
+         * @param bytes_ byte count
+         */
+        SvcStatsCounter(uint64_t pkts_ = 0, uint64_t bytes_ = 0)
+            : pkts(pkts_), bytes(bytes_) {}
+
+        /** packet count */
+        uint64_t pkts;
+        /** byte count */
+        uint64_t bytes;
+    };
+
+    /**
+     * Map of "svcstat" cookie to the counts collected for it
+     */
+    typedef std::unordered_map<uint64_t, SvcStatsCounter> SvcStatsCounterMap;
+
+    /**
+     * Calls by ServiceStatsManager to update stats for all the
+     * cookies collected in a polling interval.  The counts are
+     * folded per observer object first, so each object is updated
+     * once and all of them are committed together.
+     *
+     * @param counters aggregated counts per cookie
+     */
+    void updateSvcStatsCounters(const SvcStatsCounterMap& counters);
     /**
      * Get the cookie used for PodSvc Flows.
      * @param uuid UUID of the Ep
@@ -552,6 +619,39 @@ private:
      */
     void programServiceSnatDnatFlows(const std::string& uuid);
 
+    /**
+     * Get the group ID of the select group for a service mapping
+     *
+     * @param uuid UUID of the service
+     * @param smKey key of the service mapping
+     */
+    uint32_t getServiceGroupId(const std::string& uuid,
+                               const std::string& smKey);
+
+    /**
+     * Get the bucket ID of a next hop in the select group for a
+     * service mapping, allocating one if needed.  The bucket ID is
+     * also the value of reg7 that selects the next hop flow.
+     *
+     * @param uuid UUID of the service
+     * @param smKey key of the service mapping
+     * @param nextHop the next hop IP
+     */
+    uint32_t getServiceBucketId(const std::string& uuid,
+                                const std::string& smKey,
+                                const std::string& nextHop);
+
+    /**
+     * Write the select groups of a service, adding, updating or
+     * deleting groups and buckets so they match the given next hops
+     *
+     * @param uuid UUID of the service
+     * @param active map of service mapping key to its next hop IPs
+     */
+    void writeServiceGroups(const std::string& uuid,
+                            const std::unordered_map<std::string,
+                            std::vector<std::string> >& active);
+
     /**
      * Update service stats flows for metric collection
      *
@@ -663,6 +763,31 @@ private:
                                    const uint64_t &pkts,
                                    const uint64_t &bytes);
 
+    /*
+     * Rx and tx counts of a svc or svc-tgt counter object
+     */
+    struct SvcStatsDirCounter {
+        SvcStatsCounter rx;
+        SvcStatsCounter tx;
+    };
+
+    /*
+     * Add rx/tx counts to a svctgt counter object. Must be called
+     * with a mutator in scope.
+     */
+    void addSvcTgtStatsCounters(const string& svcUuid,
+                                const string& nhipStr,
+                                const bool isNodePort,
+                                const SvcStatsDirCounter& counts);
+
+    /*
+     * Add rx/tx counts to a svc counter object. Must be called with
+     * a mutator in scope.
+     */
+    void addSvcStatsCounters(const string& svcUuid,
+                             const bool isNodePort,
+                             const SvcStatsDirCounter& counts);
+
     /*
      * Update svc counter objects
      */
@@ -792,6 +917,19 @@ private:
      */
     void updateGroupTable();
 
+    /**
+     * Queue a write of the flood groups with pending bucket changes
+     */
+    void floodGroupsUpdated();
+
+    /**
+     * Write the pending bucket changes of all dirty flood groups to
+     * the switch.  Bucket insert and remove commands are used when
+     * the switch connection supports them; otherwise the full bucket
+     * list of each dirty group is rewritten once.
+     */
+    void writeFloodGroups();
+
     /**
      * Update flow-tables to associate an endpoint with a flood-group.
      *
@@ -829,6 +967,36 @@ private:
     GroupEdit::Entry createGroupMod(uint16_t type, uint32_t groupId,
                                     const Ep2PortMap& ep2port);
 
+    /**
+     * Construct a group-table modification that inserts or removes
+     * endpoint buckets without touching the rest of the group.
+     *
+     * @param type OFPGC15_INSERT_BUCKET or OFPGC15_REMOVE_BUCKET
+     * @param groupId Identifier for the flow group to edit
+     * @param ports Ports of the buckets to insert, or the single
+     * port of the bucket to remove
+     * @return Group-table modification entry
+     */
+    GroupEdit::Entry createBucketMod(uint16_t type, uint32_t groupId,
+                                     const std::unordered_set<uint32_t>& ports);
+
+    struct ServiceGroup;
+
+    /**
+     * Construct a group-table modification for a service select group
+     *
+     * @param type The modification type
+     * @param groupId Identifier for the group to edit
+     * @param sg The service group, or NULL for a delete
+     * @param bucketIds If set, only include the buckets with these
+     * IDs
+     * @return Group-table modification entry
+     */
+    GroupEdit::Entry
+    createServiceGroupMod(uint16_t type, uint32_t groupId,
+                          const ServiceGroup* sg,
+                          const std::unordered_set<uint32_t>* bucketIds = NULL);
+
     void checkGroupEntry(GroupMap& recvGroups,
                          uint32_t groupId, const Ep2PortMap& epMap,
                          GroupEdit& ge);
@@ -861,6 +1029,7 @@ private:
     boost::asio::ip::address dropLogDst;
     uint16_t dropLogRemotePort;
     bool serviceStatsFlowDisabled;
+    bool serviceStatsAggregated;
 
     /* Map containing ingress and egress cookie: Flows generated out
      * of same pod<-->svc uuid will use these cookies */
@@ -883,13 +1052,74 @@ private:
     // Lock to safe guard svcstat related state
     std::mutex svcStatMutex;
 
+    /*
+     * The endpoints associated with a flood-group
+     */
+    struct FloodGroup {
+        /* Map of endpoint to its port */
+        Ep2PortMap eps;
+        /* Number of endpoints using each port */
+        std::unordered_map<uint32_t, uint32_t> portRefs;
+    };
+
     /*
      * Map of flood-group URI to the endpoints associated with it.
      * The flood-group can either be a flood-domain or an endpoint-group
      */
-    typedef std::unordered_map<opflex::modb::URI, Ep2PortMap> FloodGroupMap;
+    typedef std::unordered_map<opflex::modb::URI, FloodGroup> FloodGroupMap;
     FloodGroupMap floodGroupMap;
 
+    /*
+     * Map of endpoint UUID to the flood-group it is attached to
+     */
+    std::unordered_map<std::string, opflex::modb::URI> epFloodGroupMap;
+
+    /*
+     * Select group of a service mapping
+     */
+    struct ServiceGroup {
+        /* Bucket ID of each next hop IP */
+        std::unordered_map<std::string, uint32_t> buckets;
+        /* Next bucket ID to allocate */
+        uint32_t nextBucketId = 1;
+        /* Bucket IDs in the group on the switch */
+        std::unordered_set<uint32_t> installed;
+        /* Whether the group has been added to the switch */
+        bool written = false;
+    };
+    /* Map of service mapping key to its select group */
+    typedef std::unordered_map<std::string, ServiceGroup> ServiceGroupMap;
+    /* Map of service UUID to the select groups of its mappings */
+    std::unordered_map<std::string, ServiceGroupMap> serviceGroups;
+    bool serviceSelectGroups;
+
+    /*
+     * Bucket changes to a flood-group not yet written to the switch
+     */
+    struct FloodGroupDelta {
+        /* Ports whose buckets must be inserted */
+        std::unordered_set<uint32_t> added;
+        /* Ports whose buckets must be removed */
+        std::unordered_set<uint32_t> removed;
+        /* The full bucket list must be rewritten */
+        bool full = false;
+    };
+    std::unordered_map<opflex::modb::URI, FloodGroupDelta> dirtyFloodGroups;
+
+    /**
+     * Attach an endpoint port to a flood-group and record the bucket
+     * change
+     */
+    void addFloodGroupPort(const opflex::modb::URI& fgrpURI,
+                           FloodGroup& fgrp, uint32_t port);
+
+    /**
+     * Detach an endpoint port from a flood-group and record the
+     * bucket change
+     */
+    void removeFloodGroupPort(const opflex::modb::URI& fgrpURI,
+                              FloodGroup& fgrp, uint32_t port);
+
     uint32_t getExtNetVnid(const opflex::modb::URI& uri);
 
     AdvertManager advertManager;
@@ -904,6 +1134,8 @@ private:
     /* Map of multi-cast IP addresses to associated managed objects */
     typedef std::unordered_map<std::string, UriSet> MulticastMap;
     MulticastMap mcastMap;
+    /* Map of managed object to its associated multi-cast IP address */
+    std::unordered_map<opflex::modb::URI, std::string> mcastUriMap;
     /* Set of external flood domain Ids*/
     std::unordered_set<uint32_t> localExternalFdSet;
 
@@ -934,13 +1166,23 @@ private:
      */
     void writeMulticastGroups();
     /**
+     * Add the flows for a contract's rules between a provider and a
+     * consumer group
      *
+     * @param entryList the list to append the flows to
+     * @param pvnid the provider group ID
+     * @param cvnid the consumer group ID
+     * @param allowBidirectional false to program bidirectional rules
+     * in the consumer to provider direction only
+     * @param rules the compiled rules of the contract
+     * @param cookies the flow cookie for each rule, in rule order
      */
     void addContractRules(FlowEntryList& entryList,
                                  const uint32_t pvnid,
                                  const uint32_t cvnid,
                                  bool allowBidirectional,
-                                 const PolicyManager::rule_list_t& rules);
+                                 const PolicyRuleSet& rules,
+                                 const std::vector<uint64_t>& cookies);
     /**
      * Handle if the droplog port name is read later
      */
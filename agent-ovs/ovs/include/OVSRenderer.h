@@ -105,6 +105,8 @@ private:
     AdvertManager::EndpointAdvMode endpointAdvMode;
     AdvertManager::EndpointAdvMode tunnelEndpointAdvMode;
     uint64_t tunnelEndpointAdvIntvl;
+    uint32_t endpointAdvMaxPps;
+    bool endpointAdvBundles;
     bool virtualDHCP;
     std::string virtualDHCPMac;
     std::string flowIdCache;
@@ -112,6 +114,12 @@ private:
     bool connTrack;
     uint16_t ctZoneRangeStart;
     uint16_t ctZoneRangeEnd;
+    bool secGroupSharedFlows;
+    bool serviceSelectGroups;
+    size_t pktInWorkers;
+    size_t pktInQueueDepth;
+    uint64_t pktInRateLimit;
+    uint64_t pktInBurst;
     bool ovsdbUseLocalTcpPort;
 
     bool ifaceStatsEnabled;
@@ -119,6 +127,7 @@ private:
     bool contractStatsEnabled;
     long contractStatsInterval;
     bool serviceStatsFlowDisabled;
+    bool serviceStatsAggregated;
     bool serviceStatsEnabled;
     long serviceStatsInterval;
     bool secGroupStatsEnabled;
@@ -18,7 +18,20 @@
 #include "PortMapper.h"
 #include "FlowReader.h"
 #include "TableState.h"
+#include "Packets.h"
+#include "ovs-ofpbuf.h"
 #include <opflexagent/Agent.h>
+#include <opflexagent/EndpointListener.h>
+#include <opflexagent/KeyedRateLimiter.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 struct dp_packet;
 struct flow;
@@ -32,6 +45,7 @@ class IntFlowManager;
  * Handler for packet-in messages arriving from the switch
  */
 class PacketInHandler : public MessageHandler,
+                        public EndpointListener,
                         private boost::noncopyable {
 public:
     /**
@@ -61,6 +75,46 @@ public:
     void registerConnection(SwitchConnection* intConnection,
                             SwitchConnection* accessConnection);
 
+    /**
+     * Configure the packet-in processing pipeline.  By default
+     * packet-ins are handled inline on the switch connection thread.
+     * When worker threads are configured, packet-ins are instead
+     * queued to a worker chosen by the source MAC address of the
+     * packet, so that packets from the same endpoint are handled in
+     * order, and each worker services its per-type queues round-robin
+     * so a flood of one type cannot starve the others.  Neighbor
+     * discovery, DHCP and virtual IP packet-ins update shared agent
+     * state, so they are always queued to the first worker and never
+     * handled concurrently.  Must be called before start().
+     *
+     * @param nWorkers the number of worker threads, or zero to
+     * handle packet-ins inline
+     * @param queueDepth the maximum number of packet-ins queued per
+     * type on each worker
+     * @param rate the number of packet-ins per second to admit for
+     * each packet-in type from each source MAC address, or zero for
+     * no limit
+     * @param burst the maximum burst of packet-ins to admit for each
+     * packet-in type from each source MAC address
+     */
+    void setPipeline(size_t nWorkers, size_t queueDepth,
+                     uint64_t rate, uint64_t burst);
+
+    /**
+     * Get the number of packet-ins dropped by admission control
+     *
+     * @return the drop count across all packet-in types
+     */
+    uint64_t getRateLimitedDrops() const;
+
+    /**
+     * Get the number of packet-ins dropped because the worker queue
+     * was full
+     *
+     * @return the drop count across all packet-in types
+     */
+    uint64_t getQueueFullDrops() const;
+
     /**
      * Start the packet in handler
      */
@@ -71,6 +125,34 @@ public:
      */
     void stop();
 
+    /**
+     * Get the DHCPv4 reply template for the endpoint, building and
+     * caching it if needed.  The template is rebuilt whenever the
+     * endpoint is updated.
+     *
+     * @param ep the endpoint, which must have a DHCPv4 configuration
+     * @return the reply template
+     */
+    std::shared_ptr<const packets::DHCPv4ReplyTemplate>
+    getDHCPv4Template(const std::shared_ptr<const Endpoint>& ep);
+
+    /**
+     * Get the DHCPv6 reply template for the endpoint, building and
+     * caching it if needed.  The template is rebuilt whenever the
+     * endpoint is updated.
+     *
+     * @param ep the endpoint, which must have a DHCPv6 configuration
+     * @return the reply template
+     */
+    std::shared_ptr<const packets::DHCPv6ReplyTemplate>
+    getDHCPv6Template(const std::shared_ptr<const Endpoint>& ep);
+
+    // ****************
+    // EndpointListener
+    // ****************
+
+    virtual void endpointUpdated(const std::string& uuid);
+
     // **************
     // MessageHandler
     // **************
@@ -88,6 +170,74 @@ private:
     FlowReader* intFlowReader;
     SwitchConnection* intSwConnection;
     SwitchConnection* accSwConnection;
+
+    /**
+     * Packet-in types, used to select the queue and drop counters
+     */
+    enum PktInType {
+        PKTIN_ND,
+        PKTIN_DHCPV4,
+        PKTIN_DHCPV6,
+        PKTIN_VIP_V4,
+        PKTIN_VIP_V6,
+        PKTIN_ICMP_ERR_V4,
+        PKTIN_ICMP_ECHO_V4,
+        PKTIN_ICMP_ECHO_V6,
+        PKTIN_OTHER,
+        PKTIN_TYPE_MAX
+    };
+
+    struct PktIn {
+        SwitchConnection* conn;
+        /** the message that holds the packet data */
+        OfpBuf msg;
+        /** the packet-in decoded from msg */
+        std::shared_ptr<const ofputil_packet_in> pi;
+    };
+
+    struct Worker {
+        std::mutex mtx;
+        std::condition_variable cond;
+        std::deque<PktIn> queues[PKTIN_TYPE_MAX];
+        size_t next = 0;
+        std::thread thread;
+        /** drops by admission control for packet-ins for this worker */
+        uint64_t rateLimitedDrops[PKTIN_TYPE_MAX] = {};
+        /** drops because a queue of this worker was full */
+        uint64_t queueFullDrops[PKTIN_TYPE_MAX] = {};
+    };
+
+    size_t nWorkers;
+    size_t queueDepth;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping;
+    KeyedTokenBucket<uint64_t> admission;
+    std::atomic<int64_t> lastStatsUpdate;
+
+    /**
+     * Cached reply templates for an endpoint.  The templates are
+     * only valid for the endpoint object they were built from.
+     */
+    struct ReplyTemplates {
+        std::weak_ptr<const Endpoint> ep;
+        std::shared_ptr<const packets::DHCPv4ReplyTemplate> dhcpv4;
+        std::shared_ptr<const packets::DHCPv6ReplyTemplate> dhcpv6;
+    };
+
+    std::mutex templateMutex;
+    std::unordered_map<std::string, ReplyTemplates> replyTemplates;
+
+    ReplyTemplates& getReplyTemplates(const std::shared_ptr<const Endpoint>& ep);
+
+    static PktInType getPktInType(uint64_t cookie);
+    static const char* getPktInTypeName(PktInType type);
+    static bool isSerialPktInType(PktInType type);
+    void processPacketIn(SwitchConnection* conn,
+                         const ofputil_packet_in& pi);
+    void workerLoop(Worker& worker);
+    void getDropCounts(uint64_t (&rateLimited)[PKTIN_TYPE_MAX],
+                       uint64_t (&queueFull)[PKTIN_TYPE_MAX]) const;
+    void updateDropStats();
 };
 } /* namespace opflexagent */
 
@@ -17,9 +17,12 @@
 #include <boost/bind.hpp>
 #include <opflexagent/logging.h>
 #include "PacketDecoderLayers.h"
+#include "CompiledPacketDecoder.h"
+#include <sys/socket.h>
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <chrono>
 
 #pragma once
 #ifndef OPFLEXAGENT_PACKETLOGHANDLER_H_
@@ -46,7 +49,8 @@ public:
             boost::asio::io_service& io_service_,
                boost::asio::ip::address &addr, uint16_t port)
     : pktLogger(logHandler), serverSocket(io_service_),
-            localEndpoint(addr, port), stopped(false) {
+            localEndpoint(addr, port), stopped(false), useRecvmmsg(true) {
+        initRecvBatch();
     }
     /**
      * Start UDP listener
@@ -69,11 +73,12 @@ public:
         return !(ec);
     }
     /**
-     * Start UDP receive
+     * Start UDP receive.  Waits for the socket to become readable and
+     * then drains up to recvBatchSize datagrams with a single
+     * recvmmsg call.
      */
     void startReceive() {
-        serverSocket.async_receive_from(
-            boost::asio::buffer(recv_buffer, 4096), remoteEndpoint,
+        serverSocket.async_receive(boost::asio::null_buffers(),
             boost::bind(&UdpServer::handleReceive, this,
               boost::asio::placeholders::error,
               boost::asio::placeholders::bytes_transferred));
@@ -90,16 +95,25 @@ public:
     }
 private:
     /**
-     * Handle received UDP packets
+     * Handle a readable UDP socket
      */
     void handleReceive(const boost::system::error_code& error,
       std::size_t bytes_transferred);
+    /**
+     * Point the recvmmsg headers at the receive buffers
+     */
+    void initRecvBatch();
+    static const unsigned recvBatchSize = 32;
+    static const unsigned recvBufferSize = 4096;
     PacketLogHandler &pktLogger;
     boost::asio::ip::udp::socket serverSocket;
     boost::asio::ip::udp::endpoint localEndpoint;
-    boost::asio::ip::udp::endpoint remoteEndpoint;
-    boost::array<unsigned char, 4096> recv_buffer;
+    boost::array<boost::array<unsigned char, recvBufferSize>, recvBatchSize>
+        recv_buffers;
+    struct iovec recv_iovecs[recvBatchSize];
+    struct mmsghdr recv_msgs[recvBatchSize];
     bool stopped;
+    bool useRecvmmsg;
 };
 
 /**
@@ -156,7 +170,8 @@ public:
      */
     PacketLogHandler(boost::asio::io_service &_io,
             boost::asio::io_service &_clientio):server_io(_io),
-            client_io(_clientio), port(0), stopped(false), throttleActive(false){}
+            client_io(_clientio), port(0), stopped(false), throttleActive(false),
+            logCount(0), logSuppressed(0) {}
     /**
      * set IPv4 listening address for the socket
      * @param _addr IPv4 address
@@ -212,6 +227,12 @@ public:
      * @param dropReason extracted drop reason
      */
     void getDropReason(ParseInfo &p, std::string &dropReason);
+    /**
+     * extract drop reason from the source bridge and table id
+     * @param meta source bridge and table id
+     * @param dropReason extracted drop reason
+     */
+    void getDropReason(const uint32_t (&meta)[2], std::string &dropReason);
     /**
      * Call packet decoder as an async callback
      * @param buf packet buffer
@@ -227,6 +248,7 @@ protected:
     std::unique_ptr<UdpServer> socketListener;
     std::unique_ptr<LocalClient> exporter;
     PacketDecoder pktDecoder;
+    CompiledPacketDecoder compiledDecoder;
     boost::asio::ip::address addr;
     std::string packetEventNotifSock;
     uint16_t port;
@@ -235,8 +257,12 @@ protected:
     std::condition_variable cond;
     std::queue<PacketTuple> packetTupleQ;
     bool throttleActive;
+    std::chrono::steady_clock::time_point logWindow;
+    unsigned logCount;
+    uint64_t logSuppressed;
     TableDescriptionMap intTableDescMap, accTableDescMap;
     static const unsigned maxOutstandingEvents=30;
+    static const unsigned maxLogsPerSec=100;
     friend UdpServer;
     friend LocalClient;
     ///@}
@@ -13,6 +13,8 @@
 #define OPFLEXAGENT_PACKETS_H
 
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <arpa/inet.h>
 
 #include <boost/asio/ip/address.hpp>
@@ -140,6 +142,68 @@ OfpBuf compose_icmp6_router_ad(const uint8_t* srcMac,
  */
 typedef Endpoint::DHCPv4Config::static_route_t static_route_t;
 
+/**
+ * The parts of a DHCPv4 reply that depend only on the endpoint's
+ * DHCP configuration, pre-encoded so that they can be reused for
+ * each request from the endpoint
+ */
+struct DHCPv4ReplyTemplate {
+    /**
+     * The IP address of the DHCP server in host byte order
+     */
+    uint32_t serverIp;
+
+    /**
+     * The encoded options that follow the message type option,
+     * including the end option
+     */
+    std::string options;
+};
+
+/**
+ * Build a DHCPv4 reply template from an endpoint's DHCP
+ * configuration
+ *
+ * @param prefixLen the length of the prefix for use in the subnet
+ * mask
+ * @param serverIp the apparent IP address to use when sending the
+ * reply.  Defaults to a link-local IP 169.254.32.32
+ * @param routers the list of routers to return to the client
+ * @param dnsServers the list of DNS servers to return to the client
+ * @param domain The domain to return to the client
+ * @param staticRoutes classless static routes to return to the client
+ * @param interfaceMtu value of interface MTU to return to the client
+ * @param leaseTime the lease time to send to the client
+ * @return the reply template
+ */
+DHCPv4ReplyTemplate
+build_dhcpv4_reply_template(uint8_t prefixLen,
+                            const boost::optional<std::string>& serverIp,
+                            const std::vector<std::string>& routers,
+                            const std::vector<std::string>& dnsServers,
+                            const boost::optional<std::string>& domain,
+                            const std::vector<static_route_t>& staticRoutes,
+                            const boost::optional<uint16_t>& interfaceMtu,
+                            const boost::optional<uint32_t>& leaseTime);
+
+/**
+ * Compose a DHCPv4 offer, ACK, or NACK using a pre-encoded reply
+ * template
+ *
+ * @param message_type the message type of the reply
+ * @param xid the transaction ID for the message
+ * @param srcMac the MAC address for the DHCP server
+ * @param clientMac the MAC address for the requesting client
+ * @param clientIp the IP address to return to the client
+ * @param tmpl the reply template for the endpoint
+ */
+OfpBuf compose_dhcpv4_reply(uint8_t message_type,
+                            uint32_t xid,
+                            const uint8_t* srcMac,
+                            const uint8_t* clientMac,
+                            uint32_t clientIp,
+                            const DHCPv4ReplyTemplate& tmpl);
+
 /**
  * Compose a DHCPv4 offer, ACK, or NACK
  *
@@ -173,6 +237,69 @@ OfpBuf compose_dhcpv4_reply(uint8_t message_type,
                             const boost::optional<uint16_t>& interfaceMtu,
                             const boost::optional<uint32_t>& leaseTime);
 
+/**
+ * The parts of a DHCPv6 reply that depend only on the endpoint's
+ * DHCP configuration, pre-encoded so that they can be reused for
+ * each request from the endpoint
+ */
+struct DHCPv6ReplyTemplate {
+    /**
+     * The encoded DNS server and domain search list options
+     */
+    std::string options;
+};
+
+/**
+ * Build a DHCPv6 reply template from an endpoint's DHCP
+ * configuration
+ *
+ * @param dnsServers the list of DNS servers to return to the client
+ * @param searchList the DNS search path to return to the client
+ * @return the reply template
+ */
+DHCPv6ReplyTemplate
+build_dhcpv6_reply_template(const std::vector<std::string>& dnsServers,
+                            const std::vector<std::string>& searchList);
+
+/**
+ * Compose a DHCPv6 Advertise or Reply message using a pre-encoded
+ * reply template
+ *
+ * @param message_type the message type to send
+ * @param xid the transaction ID for the message
+ * @param srcMac the MAC address for the DHCP server
+ * @param clientMac the MAC address for the requesting client
+ * @param dstIp the destination IP for the reply
+ * @param client_id the client ID to include in the reply
+ * @param client_id_len the length of the client ID
+ * @param iaid the IA ID for the identity association
+ * @param ips the list of IP addresses to return to the client
+ * @param tmpl the reply template for the endpoint
+ * @param temporary true if the client requested a temporary address
+ * @param rapid true if this is a rapid commit reply
+ * @param t1 the time before client should contact dhcp server to renew
+ * @param t2 the time before client should broadcast renewal attempt
+ * @param preferredLifetime The preferred lifetime for the IPv6
+ * addresses
+ * @param validLifetime the valid lifetime for the IPv6 addresses
+ */
+OfpBuf compose_dhcpv6_reply(uint8_t message_type,
+                            const uint8_t* xid,
+                            const uint8_t* srcMac,
+                            const uint8_t* clientMac,
+                            const struct in6_addr* dstIp,
+                            uint8_t* client_id,
+                            uint16_t client_id_len,
+                            uint8_t* iaid,
+                            const std::vector<boost::asio::ip::address_v6>& ips,
+                            const DHCPv6ReplyTemplate& tmpl,
+                            bool temporary,
+                            bool rapid,
+                            const boost::optional<uint32_t>& t1,
+                            const boost::optional<uint32_t>& t2,
+                            const boost::optional<uint32_t>& preferredLifetime,
+                            const boost::optional<uint32_t>& validLifetime);
+
 /**
  * Compose a DHCPv6 Advertise or Reply message
  *
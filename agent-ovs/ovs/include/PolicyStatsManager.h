@@ -141,6 +141,18 @@ public:
      */
     static const int MAX_AGE = 9;
 
+    /**
+     * Maximum factor by which the polling interval is stretched
+     * while none of the polled flows see any traffic
+     */
+    static const int MAX_POLL_BACKOFF = 8;
+
+    /**
+     * Number of polling intervals a classifier can go without
+     * traffic before its window of counter objects is removed
+     */
+    static const int MAX_IDLE_POLLS = 30;
+
 protected:
     /**
      * Type used as a key for Policy counter maps
@@ -297,6 +309,11 @@ protected:
          * Removed flow entries
          */
         FlowEntryCounterMap_t removedFlowCounterMap;
+        /**
+         * Set when a flow stats reply or flow removed message carried
+         * new counts for any flow entry since the last poll
+         */
+        bool changed = false;
     };
 
     /** map flow to Policy counters */
@@ -316,11 +333,15 @@ protected:
          * Current index
          */
         uint64_t count;
+        /**
+         * Polling intervals since a counter was last added
+         */
+        uint32_t idle;
 
         /**
          * Initialize the buffer
          */
-        CircularBuffer() : count(0) {}
+        CircularBuffer() : count(0), idle(0) {}
     };
 
     /**
@@ -385,6 +406,11 @@ protected:
      */
     std::atomic<uint64_t> clsfrGenId{0};
 
+    /**
+     * Current factor applied to timer_interval
+     */
+    long pollBackoff;
+
     /**
      * Update a the flow entry maps from the given entry
      */
@@ -408,6 +434,23 @@ protected:
      */
     void removeAllCounterObjects(const std::string& key);
 
+    /**
+     * Remove the counter objects of classifiers that have not seen
+     * any traffic for MAX_IDLE_POLLS polling intervals.  Call once
+     * per polling interval holding pstatMtx.
+     */
+    void removeIdleCounterObjects();
+
+    /**
+     * Get the interval until the next poll.  The interval doubles,
+     * up to MAX_POLL_BACKOFF times timer_interval, for each poll in
+     * which no flow changed and is reset as soon as one does.
+     *
+     * @param changed true if any polled flow saw traffic
+     * @return the interval in milliseconds
+     */
+    long getNextPollInterval(bool changed);
+
     /**
      * A functor that maps a table ID to a flow counter state object
      */
@@ -18,6 +18,7 @@ extern "C" {
 #include <openvswitch/ofp-group.h>
 #include <openvswitch/ofp-flow.h>
 #include <openvswitch/ofp-match.h>
+#include <openvswitch/ofp-bundle.h>
 #undef public
 
 #ifdef __cplusplus
@@ -319,6 +319,16 @@ void act_multipath(struct ofpbuf* buf,
     initSubField(&act->dst, dst);
 }
 
+void act_conjunction(struct ofpbuf* buf,
+                     uint32_t id,
+                     uint8_t clause,
+                     uint8_t nClauses) {
+    struct ofpact_conjunction* act = ofpact_put_CONJUNCTION(buf);
+    act->id = id;
+    act->clause = clause;
+    act->n_clauses = nClauses;
+}
+
 void act_macvlan_learn(struct ofpbuf* ofpacts,
                        uint16_t prio,
                        uint64_t cookie,
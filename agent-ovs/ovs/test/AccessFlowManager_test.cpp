@@ -337,6 +337,107 @@ enum TABLE {
     DROP_LOG=0, GRP = 1, IN_POL = 2, OUT_POL = 3, OUT = 4, EXP_DROP=5
 };
 
+BOOST_FIXTURE_TEST_CASE(secGrpShared, AccessFlowManagerFixture) {
+    accessFlowManager.enableSecGroupConjunction();
+    createObjects();
+    createPolicyObjects();
+    {
+        Mutator mutator(framework, "policyreg");
+        secGrp1 = space->addGbpSecGroup("secgrp1");
+        secGrp1->addGbpSecGroupSubject("1_subject1")
+            ->addGbpSecGroupRule("1_1_rule1")
+            ->setDirection(DirectionEnumT::CONST_BIDIRECTIONAL).setOrder(10)
+            .addGbpRuleToClassifierRSrc(classifier5->getURI().toString());
+        secGrp2 = space->addGbpSecGroup("secgrp2");
+        secGrp2->addGbpSecGroupSubject("2_subject1")
+            ->addGbpSecGroupRule("2_1_rule1")
+            ->setDirection(DirectionEnumT::CONST_BIDIRECTIONAL).setOrder(10)
+            .addGbpRuleToClassifierRSrc(classifier5->getURI().toString());
+        mutator.commit();
+    }
+
+    ep0.reset(new Endpoint("0-0-0-0"));
+    ep0->addSecurityGroup(secGrp1->getURI());
+    epSrc.updateEndpoint(*ep0);
+    ep1.reset(new Endpoint("0-0-0-1"));
+    ep1->addSecurityGroup(secGrp1->getURI());
+    ep1->addSecurityGroup(secGrp2->getURI());
+    epSrc.updateEndpoint(*ep1);
+
+    uint16_t prio = PolicyManager::MAX_POLICY_RULE_PRIORITY;
+    uint32_t ruleId = idGen.getId("l24classifierRule",
+                                  classifier5->getURI().toString());
+    const string sg1 = secGrp1->getURI().toString();
+    const string sg2 = secGrp2->getURI().toString();
+    uint32_t set1 = idGen.getId("secGroupSet", sg1);
+    uint32_t set12 = idGen.getId("secGroupSet", sg1 + "," + sg2);
+    auto conjId = [&](const string& sg, uint8_t t, uint16_t p) {
+        return idGen.getId("secGroupConj",
+                           sg + "#" + std::to_string(t) + ":" +
+                           std::to_string(p) + ":" +
+                           std::to_string(ruleId) + ":0");
+    };
+    uint32_t in1 = conjId(sg1, IN_POL, prio);
+    uint32_t out1 = conjId(sg1, OUT_POL, prio);
+    uint32_t in2 = conjId(sg2, IN_POL, prio);
+    uint32_t out2 = conjId(sg2, OUT_POL, prio);
+
+    auto initExpShared = [&]() {
+        for (uint8_t t : {IN_POL, OUT_POL}) {
+            uint32_t c1 = (t == IN_POL) ? in1 : out1;
+            uint32_t c2 = (t == IN_POL) ? in2 : out2;
+            /* each group is compiled once, whatever sets use it */
+            ADDF(Bldr(SEND_FLOW_REM).table(t).priority(prio).cookie(ruleId)
+                 .isConjId(c1).actions().go(OUT).done());
+            ADDF(Bldr(SEND_FLOW_REM).table(t).priority(prio).cookie(ruleId)
+                 .isConjId(c2).actions().go(OUT).done());
+            /* the identical classifier match is shared between groups */
+            ADDF(Bldr().table(t).priority(prio).isEth(0x8906)
+                 .actions().conjunction(c1, 2, 2)
+                 .conjunction(c2, 2, 2).done());
+            /* the sets only select the conjunctions of their groups */
+            ADDF(Bldr().table(t).priority(prio).reg(SEPG, set1)
+                 .actions().conjunction(c1, 1, 2).done());
+            ADDF(Bldr().table(t).priority(prio).reg(SEPG, set12)
+                 .actions().conjunction(c1, 1, 2)
+                 .conjunction(c2, 1, 2).done());
+        }
+    };
+
+    clearExpFlowTables();
+    initExpStatic();
+    initExpShared();
+    WAIT_FOR_TABLES("shared-secgrp", 500);
+
+    // a new rule gets new conjunctions without renumbering the
+    // conjunctions of the existing rules
+    {
+        Mutator mutator(framework, "policyreg");
+        secGrp1->addGbpSecGroupSubject("1_subject1")
+            ->addGbpSecGroupRule("1_1_rule2")
+            ->setDirection(DirectionEnumT::CONST_BIDIRECTIONAL).setOrder(20)
+            .addGbpRuleToClassifierRSrc(classifier5->getURI().toString());
+        mutator.commit();
+    }
+
+    uint16_t prio2 = prio - 128;
+    clearExpFlowTables();
+    initExpStatic();
+    initExpShared();
+    for (uint8_t t : {IN_POL, OUT_POL}) {
+        uint32_t c = conjId(sg1, t, prio2);
+        ADDF(Bldr(SEND_FLOW_REM).table(t).priority(prio2).cookie(ruleId)
+             .isConjId(c).actions().go(OUT).done());
+        ADDF(Bldr().table(t).priority(prio2).isEth(0x8906)
+             .actions().conjunction(c, 2, 2).done());
+        ADDF(Bldr().table(t).priority(prio2).reg(SEPG, set1)
+             .actions().conjunction(c, 1, 2).done());
+        ADDF(Bldr().table(t).priority(prio2).reg(SEPG, set12)
+             .actions().conjunction(c, 1, 2).done());
+    }
+    WAIT_FOR_TABLES("shared-secgrp-add-rule", 500);
+}
+
 void AccessFlowManagerFixture::initExpStatic() {
     ADDF(Bldr().table(OUT).priority(1).isMdAct(0)
          .actions().out(OUTPORT).done());
@@ -11,6 +11,9 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/asio/ip/address.hpp>
 
+#include <thread>
+#include <chrono>
+
 #include <netinet/icmp6.h>
 #include <netinet/ip.h>
 
@@ -27,9 +30,11 @@
 #include <opflexagent/logging.h>
 #include "Packets.h"
 #include "ovs-shim.h"
+#include "ovs-ofputil.h"
 
 extern "C" {
 #include <openvswitch/flow.h>
+#include <openvswitch/ofp-msgs.h>
 }
 
 using std::string;
@@ -210,6 +215,73 @@ public:
     }
 };
 
+class EpAdvertFixtureRate : public AdvertManagerFixture {
+public:
+    EpAdvertFixtureRate()
+        : AdvertManagerFixture() {
+        advertManager.
+            enableEndpointAdv(AdvertManager::EPADV_GRATUITOUS_BROADCAST);
+        advertManager.setAdvRateLimit(10);
+        start();
+        advertManager.scheduleInitialEndpointAdv(10);
+    }
+
+    ~EpAdvertFixtureRate() {
+        stop();
+    }
+};
+
+class EpAdvertFixtureBundle : public AdvertManagerFixture {
+public:
+    EpAdvertFixtureBundle()
+        : AdvertManagerFixture() {
+        advertManager.
+            enableEndpointAdv(AdvertManager::EPADV_GRATUITOUS_BROADCAST);
+        advertManager.enableAdvBundles(true);
+        start();
+        advertManager.scheduleInitialEndpointAdv(10);
+    }
+
+    ~EpAdvertFixtureBundle() {
+        stop();
+    }
+
+    /**
+     * Count the packet-outs sent directly, and the packet-outs added
+     * to the first committed bundle.  Returns the index of the
+     * commit request, or -1 if no bundle was committed yet.
+     */
+    int countBundle(size_t& direct, size_t& bundled) {
+        direct = bundled = 0;
+        int commit = -1;
+        uint32_t bundleId = 0;
+        int count = conn->getSentMsgCount();
+        for (int i = 0; i < count; i++) {
+            const ofp_header* oh =
+                (const ofp_header*)conn->getSentMsg(i).data();
+            enum ofptype type;
+            ofptype_decode(&type, oh);
+            if (type == OFPTYPE_PACKET_OUT) {
+                direct += 1;
+            } else if (type == OFPTYPE_BUNDLE_ADD_MESSAGE) {
+                struct ofputil_bundle_add_msg bam;
+                ofputil_decode_bundle_add(oh, &bam, NULL);
+                if (commit < 0 && (bundleId == 0 || bam.bundle_id == bundleId))
+                    bundled += 1;
+            } else if (type == OFPTYPE_BUNDLE_CONTROL) {
+                struct ofputil_bundle_ctrl_msg bc;
+                ofputil_decode_bundle_ctrl(oh, &bc);
+                if (bc.type == OFPBCT_OPEN_REQUEST && bundleId == 0)
+                    bundleId = bc.bundle_id;
+                else if (bc.type == OFPBCT_COMMIT_REQUEST && commit < 0 &&
+                         bc.bundle_id == bundleId)
+                    commit = i;
+            }
+        }
+        return commit;
+    }
+};
+
 class RouterAdvertFixture : public AdvertManagerFixture {
 public:
     RouterAdvertFixture()
@@ -339,6 +411,44 @@ BOOST_FIXTURE_TEST_CASE(endpointAdvertGB, EpAdvertFixtureGB) {
     testEpAdvert(AdvertManager::EPADV_GRATUITOUS_BROADCAST);
 }
 
+BOOST_FIXTURE_TEST_CASE(endpointAdvertRate, EpAdvertFixtureRate) {
+    // advertisements are paced at 10 packets per second
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    BOOST_CHECK(conn->getSentMsgCount() < 11);
+
+    WAIT_FOR(conn->getSentMsgCount() == 11, 3000);
+    BOOST_CHECK_EQUAL(11, conn->getSentMsgCount());
+
+    // once everything is sent the scheduler sleeps until the next
+    // refresh rather than ticking
+    WAIT_FOR(advertManager.getAdvTickDelay() &&
+             advertManager.getAdvTickDelay().get() > 1000, 1000);
+}
+
+BOOST_FIXTURE_TEST_CASE(endpointAdvertBundle, EpAdvertFixtureBundle) {
+    size_t direct, bundled;
+    WAIT_FOR(countBundle(direct, bundled) >= 0, 1000);
+    int commit = countBundle(direct, bundled);
+    BOOST_CHECK(bundled > 1);
+
+    // the switch rejects the bundle, so its advertisements are sent
+    // again as individual packet-outs
+    OfpBuf err(ofperr_encode_reply(OFPERR_OFPBRC_EPERM,
+                                   (const ofp_header*)
+                                   conn->getSentMsg(commit).data()));
+    advertManager.Handle(conn, OFPTYPE_ERROR, err.get());
+
+    size_t expected = direct + bundled;
+    WAIT_FOR(countBundle(direct, bundled) >= 0 && direct == expected, 1000);
+
+    // later batches are no longer bundled
+    conn->clear();
+    advertManager.scheduleInitialEndpointAdv(10);
+    WAIT_FOR(conn->getSentMsgCount() == 11, 1000);
+    BOOST_CHECK_EQUAL(-1, countBundle(direct, bundled));
+    BOOST_CHECK_EQUAL(11, direct);
+}
+
 BOOST_FIXTURE_TEST_CASE(routerAdvert, RouterAdvertFixture) {
     WAIT_FOR(conn->getSentMsgCount() == 1, 1000);
     BOOST_CHECK_EQUAL(1, conn->getSentMsgCount());
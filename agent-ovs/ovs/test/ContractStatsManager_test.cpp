@@ -8,6 +8,7 @@
  * and is available at http://www.eclipse.org/legal/epl-v10.html
  */
 
+#include <algorithm>
 #include <sstream>
 #include <boost/test/unit_test.hpp>
 #include <boost/assign/list_of.hpp>
@@ -21,7 +22,7 @@
 #include "ContractStatsManager.h"
 #include "TableState.h"
 #include "ActionBuilder.h"
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 #include "FlowConstants.h"
 #include "PolicyStatsManagerFixture.h"
 #include <opflex/modb/Mutator.h>
@@ -60,6 +61,11 @@ public:
         std::lock_guard<mutex> lock(txnMtx);
         txns.insert(txn_id);
     }
+
+    long getPollBackoff() {
+        std::lock_guard<mutex> lock(pstatMtx);
+        return pollBackoff;
+    }
 };
 
 class ContractStatsManagerFixture : public PolicyStatsManagerFixture {
@@ -548,6 +554,112 @@ BOOST_FIXTURE_TEST_CASE(testContractDelete, ContractStatsManagerFixture) {
     contractStatsManager.stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(testIdleCounterRemoval, ContractStatsManagerFixture) {
+    MockConnection integrationPortConn(TEST_CONN_TYPE_INT);
+    contractStatsManager.registerConnection(&integrationPortConn);
+    contractStatsManager.start();
+    LOG(DEBUG) << "### Contract idle counter removal Start";
+
+    testOneFlow<MockContractStatsManager>(integrationPortConn,
+                classifier3,
+                IntFlowManager::POL_TABLE_ID,
+                1,
+                false,
+                &contractStatsManager,
+                &policyManager,
+                epg1,
+                epg2);
+
+    // no further traffic on the classifier; its counters go away
+    // after MAX_IDLE_POLLS polling intervals
+    boost::system::error_code ec;
+    ec = make_error_code(boost::system::errc::success);
+    for (int i = 0; i < PolicyStatsManager::MAX_IDLE_POLLS; i++)
+        contractStatsManager.on_timer(ec);
+
+    optional<shared_ptr<PolicyStatUniverse> > su =
+        PolicyStatUniverse::resolve(agent.getFramework());
+    auto uuid =
+        boost::lexical_cast<std::string>(contractStatsManager.getAgentUUID());
+    WAIT_FOR_DO_ONFAIL(!(su.get()->resolveGbpeL24ClassifierCounter(uuid,
+                        contractStatsManager.getCurrClsfrGenId(),
+                        epg1->getURI().toString(),
+                        epg2->getURI().toString(),
+                        classifier3->getURI().toString()))
+                        ,500
+                        ,
+                        ,LOG(ERROR) << "Obj still present";);
+    LOG(DEBUG) << "### Contract idle counter removal End";
+    contractStatsManager.stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(testPollBackoff, ContractStatsManagerFixture) {
+    MockConnection integrationPortConn(TEST_CONN_TYPE_INT);
+    // the timer is not started, so only the polls made here move the
+    // back-off
+    contractStatsManager.registerConnection(&integrationPortConn);
+    LOG(DEBUG) << "### Contract poll backoff Start";
+
+    FlowEntryList classifierFlows;
+    writeClassifierFlows(classifierFlows, IntFlowManager::POL_TABLE_ID, 1,
+                         classifier3, epg1, epg2, &policyManager);
+
+    // like the switch, answer each poll with every flow in the table
+    FlowEntryList entryList;
+    TableState::cookie_callback_t cb_func =
+        [&] (uint64_t cookie, uint16_t priority, const struct match& match) {
+        FlowEntryPtr fe(new FlowEntry());
+        fe->entry->cookie = ovs_htonll(cookie);
+        fe->entry->priority = priority;
+        fe->entry->match = match;
+        entryList.push_back(fe);
+    };
+    switchManager.forEachCookieMatch(IntFlowManager::POL_TABLE_ID, cb_func);
+    BOOST_REQUIRE(!entryList.empty());
+
+    boost::system::error_code ec;
+    ec = make_error_code(boost::system::errc::success);
+    auto poll = [&] (uint32_t pkts) {
+        struct ofpbuf *res_msg =
+            makeFlowStatReplyMessage_2(&integrationPortConn, pkts,
+                                       IntFlowManager::POL_TABLE_ID,
+                                       entryList);
+        BOOST_REQUIRE(res_msg!=0);
+        ofp_header *msgHdr = (ofp_header *)res_msg->data;
+        contractStatsManager.testInjectTxnId(msgHdr->xid);
+        contractStatsManager.Handle(&integrationPortConn,
+                                    OFPTYPE_FLOW_STATS_REPLY, res_msg);
+        ofpbuf_delete(res_msg);
+        contractStatsManager.on_timer(ec);
+    };
+
+    contractStatsManager.on_timer(ec);
+    poll(INITIAL_PACKET_COUNT);
+
+    // traffic on the flows keeps the configured interval
+    poll(FINAL_PACKET_COUNT);
+    BOOST_CHECK_EQUAL(1, contractStatsManager.getPollBackoff());
+
+    // each poll with unchanged counters doubles the interval, up to
+    // MAX_POLL_BACKOFF times the configured one
+    long backoff = 1;
+    for (int i = 0; i < 5; i++) {
+        poll(FINAL_PACKET_COUNT);
+        backoff = std::min<long>(backoff * 2,
+                                 PolicyStatsManager::MAX_POLL_BACKOFF);
+        BOOST_CHECK_EQUAL(backoff, contractStatsManager.getPollBackoff());
+    }
+
+    // new counts reset it, and it backs off again once they stop
+    poll(FINAL_PACKET_COUNT + 100);
+    BOOST_CHECK_EQUAL(1, contractStatsManager.getPollBackoff());
+    poll(FINAL_PACKET_COUNT + 100);
+    BOOST_CHECK_EQUAL(2, contractStatsManager.getPollBackoff());
+
+    LOG(DEBUG) << "### Contract poll backoff End";
+    contractStatsManager.stop();
+}
+
 BOOST_FIXTURE_TEST_CASE(testSEpgDelete, ContractStatsManagerFixture) {
     MockConnection integrationPortConn(TEST_CONN_TYPE_INT);
     contractStatsManager.registerConnection(&integrationPortConn);
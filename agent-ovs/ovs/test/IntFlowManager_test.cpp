@@ -34,7 +34,7 @@
 #include "MockSwitchManager.h"
 #include "TableState.h"
 #include "ActionBuilder.h"
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 #include "FlowConstants.h"
 #include "FlowUtils.h"
 #include "FlowManagerFixture.h"
@@ -233,10 +233,12 @@ public:
     void routeModeTest();
     void arpModeTest();
     void fdTest();
+    void fdBucketTest(bool bucketMods);
     void groupFloodTest();
     void connectTest();
     void portStatusTest();
     void loadBalancedServiceTest();
+    void serviceSelectGroupTest(bool bucketMods);
     void remoteEndpointTest();
 
     IntFlowManager intFlowManager;
@@ -752,6 +754,119 @@ BOOST_FIXTURE_TEST_CASE(fd_vlan, VlanIntFlowManagerFixture) {
     fdTest();
 }
 
+/*
+ * Flood group membership changes use bucket commands when the switch
+ * connection supports OpenFlow 1.5, and full group rewrites otherwise
+ */
+void BaseIntFlowManagerFixture::fdBucketTest(bool bucketMods) {
+    static_cast<MockSwitchConnection*>(switchManager.getConnection())
+        ->protocolVersion = bucketMods ? OFP15_VERSION : OFP13_VERSION;
+    setConnected();
+
+    /* create */
+    portmapper.setPort(ep2->getInterfaceName().get(), ep2_port);
+    intFlowManager.endpointUpdated(ep0->getUUID());
+    intFlowManager.endpointUpdated(ep2->getUUID());
+
+    initExpStatic();
+    initExpEp(ep0, epg0);
+    initExpEp(ep2, epg0);
+    WAIT_FOR_TABLES("create", 500);
+
+    {
+        Mutator m1(framework, policyOwner);
+        epg0->addGbpEpGroupToNetworkRSrc()
+            ->setTargetFloodDomain(fd0->getURI());
+        m1.commit();
+    }
+    WAIT_FOR(policyMgr.getFDForGroup(epg0->getURI()) != boost::none, 500);
+
+    exec.Clear();
+    exec.ExpectGroup(FlowEdit::ADD, ge_fd0 + ge_bkt_ep0 + ge_bkt_tun);
+    intFlowManager.endpointUpdated(ep0->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* add ep2 */
+    exec.Clear();
+    if (bucketMods)
+        exec.ExpectGroup("INSERT_BUCKET|" + ge_fd0 +
+                         ",command_bucket_id=last" + ge_bkt_ep2);
+    else
+        exec.ExpectGroup(FlowEdit::MOD, ge_fd0 + ge_bkt_ep0 + ge_bkt_ep2
+                         + ge_bkt_tun);
+    intFlowManager.endpointUpdated(ep2->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* remove port-mapping for ep2 */
+    portmapper.erasePort(ep2->getInterfaceName().get());
+    exec.Clear();
+    if (bucketMods)
+        exec.ExpectGroup("REMOVE_BUCKET|" + ge_fd0 +
+                         ",command_bucket_id=" +
+                         boost::lexical_cast<string>(ep2_port));
+    else
+        exec.ExpectGroup(FlowEdit::MOD, ge_fd0 + ge_bkt_ep0 + ge_bkt_tun);
+    intFlowManager.endpointUpdated(ep2->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* restore it */
+    portmapper.setPort(ep2->getInterfaceName().get(), ep2_port);
+    exec.Clear();
+    if (bucketMods)
+        exec.ExpectGroup("INSERT_BUCKET|" + ge_fd0 +
+                         ",command_bucket_id=last" + ge_bkt_ep2);
+    else
+        exec.ExpectGroup(FlowEdit::MOD, ge_fd0 + ge_bkt_ep0 + ge_bkt_ep2
+                         + ge_bkt_tun);
+    intFlowManager.endpointUpdated(ep2->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* a tunnel port change rewrites the whole group in both modes */
+    exec.Clear();
+    exec.ExpectGroup(FlowEdit::MOD, ge_fd0 + ge_bkt_ep0 + ge_bkt_ep2
+                     + ge_bkt_tun_new);
+    portmapper.setPort(tunIf, tun_port_new);
+    intFlowManager.portStatusUpdate(tunIf, tun_port_new, false);
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* move ep2 to the flood domain of another group */
+    WAIT_FOR(policyMgr.getFDForGroup(epg3->getURI()) != boost::none, 500);
+    ep2->setEgURI(epg3->getURI());
+    epSrc.updateEndpoint(*ep2);
+    exec.Clear();
+    exec.ExpectGroup(FlowEdit::ADD, ge_fd1 + ge_bkt_ep2 + ge_bkt_tun_new);
+    if (bucketMods)
+        exec.ExpectGroup("REMOVE_BUCKET|" + ge_fd0 +
+                         ",command_bucket_id=" +
+                         boost::lexical_cast<string>(ep2_port));
+    else
+        exec.ExpectGroup(FlowEdit::MOD, ge_fd0 + ge_bkt_ep0
+                         + ge_bkt_tun_new);
+    intFlowManager.endpointUpdated(ep2->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* removing the last endpoint deletes the group and its index */
+    epSrc.removeEndpoint(ep2->getUUID());
+    exec.Clear();
+    exec.ExpectGroup(FlowEdit::DEL, ge_fd1);
+    intFlowManager.endpointUpdated(ep2->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    epSrc.removeEndpoint(ep0->getUUID());
+    exec.Clear();
+    exec.ExpectGroup(FlowEdit::DEL, ge_fd0);
+    intFlowManager.endpointUpdated(ep0->getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+}
+
+BOOST_FIXTURE_TEST_CASE(fd_bucket_mods, VxlanIntFlowManagerFixture) {
+    fdBucketTest(true);
+}
+
+BOOST_FIXTURE_TEST_CASE(fd_bucket_mods_of13, VxlanIntFlowManagerFixture) {
+    fdBucketTest(false);
+}
+
 void BaseIntFlowManagerFixture::groupFloodTest() {
     intFlowManager.setFloodScope(IntFlowManager::ENDPOINT_GROUP);
     setConnected();
@@ -1670,6 +1785,96 @@ void BaseIntFlowManagerFixture::loadBalancedServiceTest() {
     WAIT_FOR_TABLES("delete", 500);
 }
 
+BOOST_FIXTURE_TEST_CASE(serviceSelectGroup, VxlanIntFlowManagerFixture) {
+    serviceSelectGroupTest(true);
+}
+
+BOOST_FIXTURE_TEST_CASE(serviceSelectGroup_of13, VxlanIntFlowManagerFixture) {
+    serviceSelectGroupTest(false);
+}
+
+/*
+ * A next hop added to a service gets a bucket in the select group of
+ * its service mapping
+ */
+void BaseIntFlowManagerFixture::serviceSelectGroupTest(bool bucketMods) {
+    static_cast<MockSwitchConnection*>(switchManager.getConnection())
+        ->protocolVersion = bucketMods ? OFP15_VERSION : OFP13_VERSION;
+    intFlowManager.enableServiceSelectGroups();
+    setConnected();
+
+    intFlowManager.egDomainUpdated(epg0->getURI());
+    intFlowManager.domainUpdated(RoutingDomain::CLASS_ID, rd0->getURI());
+
+    Service as;
+    as.setUUID("ed84daef-1696-4b98-8c80-6b22d85f4dc2");
+    as.setDomainURI(URI(rd0->getURI()));
+    as.setServiceMode(Service::LOADBALANCER);
+
+    Service::ServiceMapping sm;
+    sm.setServiceIP("169.254.169.254");
+    sm.setServiceProto("udp");
+    sm.addNextHopIP("10.20.44.2");
+    sm.setServicePort(53);
+    sm.setNextHopPort(5353);
+    as.addServiceMapping(sm);
+
+    const string groupStr = "|group_id=2147483649,type=select";
+    boost::format bktFormat(",bucket=bucket_id:%1%,"
+                            "actions=load:%2%->NXM_NX_REG7[],"
+                            "resubmit(,%3%)");
+    const int svh = IntFlowManager::SERVICE_NEXTHOP_TABLE_ID;
+    const string bkt1 = (bktFormat % 1 % "0x1" % svh).str();
+    const string bkt2 = (bktFormat % 2 % "0x2" % svh).str();
+
+    exec.Clear();
+    exec.ExpectGroup("ADD" + groupStr + bkt1);
+    servSrc.updateService(as);
+    intFlowManager.serviceUpdated(as.getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* the next hop flows allocate the new bucket ID before the group
+       is written */
+    as.clearServiceMappings();
+    sm.addNextHopIP("10.20.44.3");
+    as.addServiceMapping(sm);
+    exec.Clear();
+    if (bucketMods)
+        exec.ExpectGroup("INSERT_BUCKET" + groupStr +
+                         ",command_bucket_id=last" + bkt2);
+    else
+        exec.ExpectGroup("MOD" + groupStr + bkt1 + bkt2);
+    servSrc.updateService(as);
+    intFlowManager.serviceUpdated(as.getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* the remaining next hop keeps its bucket */
+    as.clearServiceMappings();
+    Service::ServiceMapping sm2;
+    sm2.setServiceIP("169.254.169.254");
+    sm2.setServiceProto("udp");
+    sm2.addNextHopIP("10.20.44.3");
+    sm2.setServicePort(53);
+    sm2.setNextHopPort(5353);
+    as.addServiceMapping(sm2);
+    exec.Clear();
+    if (bucketMods)
+        exec.ExpectGroup("REMOVE_BUCKET" + groupStr +
+                         ",command_bucket_id=1");
+    else
+        exec.ExpectGroup("MOD" + groupStr + bkt2);
+    servSrc.updateService(as);
+    intFlowManager.serviceUpdated(as.getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+
+    /* removing the service deletes its group */
+    exec.Clear();
+    exec.ExpectGroup("DEL" + groupStr);
+    servSrc.removeService(as.getUUID());
+    intFlowManager.serviceUpdated(as.getUUID());
+    WAIT_FOR(exec.IsGroupEmpty(), 500);
+}
+
 BOOST_FIXTURE_TEST_CASE(vip, VxlanIntFlowManagerFixture) {
     setConnected();
     intFlowManager.egDomainUpdated(epg0->getURI());
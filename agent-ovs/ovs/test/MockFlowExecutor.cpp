@@ -139,6 +139,11 @@ void MockFlowExecutor::ExpectGroup(FlowEdit::type mod, const string& ge) {
     groupMods.push_back(canonicalizeGroupEntryStr(string(modStr[mod]) + "|" +
                                                   ge));
 }
+void MockFlowExecutor::ExpectGroup(const string& ge) {
+    std::lock_guard<std::mutex> guard(group_mod_mutex);
+    ignoreGroupMods = false;
+    groupMods.push_back(canonicalizeGroupEntryStr(ge));
+}
 void MockFlowExecutor::Expect(TlvEdit::type mod, const string& te) {
     ignoreTlvMods = false;
     tlvMods.push_back(tlv_mod_t(mod, te));
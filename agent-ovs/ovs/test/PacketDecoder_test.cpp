@@ -9,6 +9,10 @@
  */
 #include <boost/test/unit_test.hpp>
 #include "MockPacketLogHandler.h"
+
+#include <ctime>
+#include <sstream>
+
 BOOST_AUTO_TEST_SUITE(PacketDecoder_test)
 
 using namespace opflexagent;
@@ -152,4 +156,50 @@ BOOST_FIXTURE_TEST_CASE(tcp_over_v6_test, PacketDecoderFixture) {
     BOOST_CHECK(p.packetTuple == expectedTuple);
 }
 
+BOOST_FIXTURE_TEST_CASE(compiled_decoder_test, PacketDecoderFixture) {
+    auto pktDecoder = pktLogger.getDecoder();
+    CompiledPacketDecoder compiledDecoder;
+    const std::vector<std::pair<const uint8_t *, std::size_t>> bufs = {
+        {arp_buf, 66}, {icmp_buf, 66}, {tcp_buf, 98}, {udp_buf, 66},
+        {udpv6_buf, 86}, {tcpv6_buf, 118}
+    };
+    for (auto& b : bufs) {
+        ParseInfo p(&pktDecoder);
+        BOOST_CHECK_EQUAL(0, pktDecoder.decode(b.first, b.second, p));
+        std::string dropReason;
+        pktLogger.getDropReason(p, dropReason);
+        p.packetTuple.setField(0, dropReason);
+
+        CompactPacketTuple t;
+        BOOST_CHECK_EQUAL(0, compiledDecoder.decode(b.first, b.second, t));
+        BOOST_CHECK_EQUAL(p.meta[0], t.meta[0]);
+        BOOST_CHECK_EQUAL(p.meta[1], t.meta[1]);
+        std::stringstream str;
+        str << t;
+        BOOST_CHECK_EQUAL(p.parsedString, str.str());
+        PacketTuple pt;
+        t.toPacketTuple(pt);
+        std::string compiledDropReason;
+        pktLogger.getDropReason(t.meta, compiledDropReason);
+        pt.setField(0, compiledDropReason);
+        BOOST_CHECK(pt == p.packetTuple);
+    }
+
+    // the time stamp is formatted from the decode time; use a fixed
+    // value rather than comparing wall clock readings
+    CompactPacketTuple t;
+    BOOST_CHECK_EQUAL(0, compiledDecoder.decode(tcp_buf, 98, t));
+    t.timeStamp = 1577836800;
+    char expected[256];
+    struct tm tp;
+    std::strftime(expected, sizeof(expected), "%a %b %d %H:%M:%S %Z %Y",
+                  localtime_r(&t.timeStamp, &tp));
+    PacketTuple pt;
+    t.toPacketTuple(pt);
+    BOOST_CHECK_EQUAL(std::string(expected), pt.TimeStamp);
+
+    BOOST_CHECK(compiledDecoder.decode(tcp_buf, 60, t) != 0);
+    BOOST_CHECK(compiledDecoder.decode(tcp_buf, 4, t) != 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -692,6 +692,69 @@ BOOST_FIXTURE_TEST_CASE(dhcpv4_discover, PacketInHandlerFixture) {
     testDhcpv4Discover(intConn);
 }
 
+BOOST_FIXTURE_TEST_CASE(dhcpv4_pipeline, PacketInHandlerFixture) {
+    setDhcpv4Config();
+    pktInHandler.setPipeline(2, 16, 1, 1);
+    pktInHandler.start();
+
+    ofputil_packet_in_private pin;
+    init_packet_in(pin, &pkt_dhcpv4_discover, sizeof(pkt_dhcpv4_discover),
+                   opflexagent::flow::cookie::DHCP_V4, IntFlowManager::SEC_TABLE_ID,
+                   80);
+
+    OfpBuf b(ofputil_encode_packet_in_private(&pin,
+                                              OFPUTIL_P_OF13_OXM,
+                                              OFPUTIL_PACKET_IN_NXT));
+
+    // the second packet-in exceeds the burst and is dropped
+    pktInHandler.Handle(&intConn, OFPTYPE_PACKET_IN, b.get());
+    pktInHandler.Handle(&intConn, OFPTYPE_PACKET_IN, b.get());
+    WAIT_FOR(intConn.getSentMsgCount() == 1, 500);
+    BOOST_CHECK_EQUAL(1, pktInHandler.getRateLimitedDrops());
+    BOOST_CHECK_EQUAL(0, pktInHandler.getQueueFullDrops());
+
+    // a packet-in from another source has its own bucket
+    uint8_t other[sizeof(pkt_dhcpv4_discover)];
+    memcpy(other, pkt_dhcpv4_discover, sizeof(other));
+    other[11] = 0x01;
+    ofputil_packet_in_private pin2;
+    init_packet_in(pin2, other, sizeof(other),
+                   opflexagent::flow::cookie::DHCP_V4, IntFlowManager::SEC_TABLE_ID,
+                   80);
+    OfpBuf b2(ofputil_encode_packet_in_private(&pin2,
+                                               OFPUTIL_P_OF13_OXM,
+                                               OFPUTIL_PACKET_IN_NXT));
+    pktInHandler.Handle(&intConn, OFPTYPE_PACKET_IN, b2.get());
+    BOOST_CHECK_EQUAL(1, pktInHandler.getRateLimitedDrops());
+
+    pktInHandler.stop();
+    verify_dhcpv4(intConn.getSentMsg(0), opflexagent::dhcp::message_type::OFFER);
+}
+
+BOOST_FIXTURE_TEST_CASE(dhcp_template_cache, PacketInHandlerFixture) {
+    setDhcpv4Config();
+    EndpointManager& epMgr = agent.getEndpointManager();
+
+    auto ep = epMgr.getEndpoint(ep0->getUUID());
+    BOOST_REQUIRE(ep);
+    auto t1 = pktInHandler.getDHCPv4Template(ep);
+    BOOST_CHECK(t1 == pktInHandler.getDHCPv4Template(ep));
+
+    // a new version of the endpoint gets a new template
+    Endpoint::DHCPv4Config c(ep0->getDHCPv4Config().get());
+    c.setInterfaceMtu(1500);
+    ep0->setDHCPv4Config(c);
+    epSrc.updateEndpoint(*ep0);
+    WAIT_FOR(epMgr.getEndpoint(ep0->getUUID()) != ep, 500);
+    pktInHandler.endpointUpdated(ep0->getUUID());
+
+    auto t2 = pktInHandler.getDHCPv4Template
+        (epMgr.getEndpoint(ep0->getUUID()));
+    BOOST_CHECK(t1 != t2);
+    BOOST_CHECK(t1->options != t2->options);
+    BOOST_CHECK_EQUAL(t1->serverIp, t2->serverIp);
+}
+
 BOOST_FIXTURE_TEST_CASE(dhcpv4_request, PacketInHandlerFixture) {
     setDhcpv4Config();
 
@@ -20,7 +20,7 @@
 #include "SecGrpStatsManager.h"
 #include "TableState.h"
 #include "ActionBuilder.h"
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 #include "FlowConstants.h"
 #include "PolicyStatsManagerFixture.h"
 
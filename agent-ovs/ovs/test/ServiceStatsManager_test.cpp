@@ -23,7 +23,7 @@
 #include "ServiceStatsManager.h"
 #include "TableState.h"
 #include "ActionBuilder.h"
-#include "RangeMask.h"
+#include <opflexagent/RangeMask.h>
 #include "FlowConstants.h"
 #include "PolicyStatsManagerFixture.h"
 #include "eth.h"
@@ -63,15 +63,19 @@ public:
 class ServiceStatsManagerFixture : public PolicyStatsManagerFixture {
 
 public:
-    ServiceStatsManagerFixture() : PolicyStatsManagerFixture(),
+    ServiceStatsManagerFixture(bool aggregated_ = false)
+                                  : PolicyStatsManagerFixture(),
                                     intFlowManager(agent, switchManager, idGen,
                                                    ctZoneManager, tunnelEpManager),
                                     pktInHandler(agent, intFlowManager),
                                     serviceStatsManager(&agent, idGen,
                                                        switchManager,
-                                                       intFlowManager, 300) {
+                                                       intFlowManager, 300),
+                                    aggregated(aggregated_) {
         createObjects();
         switchManager.setMaxFlowTables(IntFlowManager::NUM_FLOW_TABLES);
+        if (aggregated)
+            intFlowManager.enableServiceStatsAggregation();
         intFlowManager.start();
 
         // cloud nodeport tests need veth_host_ac
@@ -123,12 +127,20 @@ public:
     void checkNewFlowMapInitialized();
     void testFlowAge(PolicyStatsManager *statsManager,
                      bool isOld, bool isFlowStateReAdd);
+    void testFlowStatsAggSvcTgt(MockConnection& portConn,
+                                PolicyStatsManager *statsManager,
+                                const string& nhip);
+    void testBatchSvcStatsCounters(void);
+    void testSvcTgtStatsFlowSources(void);
+    bool findCookieFlow(int tableId, uint64_t cookie,
+                        FlowEntryList& entryList);
 
 #ifdef HAVE_PROMETHEUS_SUPPORT
     void checkSvcTgtPromMetrics(uint64_t pkts, uint64_t bytes, const string& ip, bool isNodePort=false);
     void checkPodSvcPromMetrics(uint64_t pkts, uint64_t bytes);
 #endif
 private:
+    bool aggregated;
     Service as;
     Service::ServiceMapping sm1;
     Service::ServiceMapping sm2;
@@ -148,6 +160,11 @@ private:
     bool checkNewFlowMapSize(void);
 };
 
+class AggServiceStatsManagerFixture : public ServiceStatsManagerFixture {
+public:
+    AggServiceStatsManagerFixture() : ServiceStatsManagerFixture(true) {}
+};
+
 /*
  * Service delete
  * - delete svc objects
@@ -763,6 +780,183 @@ ServiceStatsManagerFixture::testFlowRemovedSvcTgt (MockConnection& portConn,
         checkAnySvcTgtObjectStats(svcUuid, nhip, expPkts, expBytes);
 }
 
+// pick up the first flow carrying the cookie from the given table
+bool ServiceStatsManagerFixture::findCookieFlow(int tableId, uint64_t cookie,
+                                                FlowEntryList& entryList) {
+    entryList.clear();
+    TableState::cookie_callback_t cb_func =
+        [&] (uint64_t c, uint16_t priority, const struct match& match) {
+        if (c != cookie || !entryList.empty())
+            return;
+        FlowEntryPtr fe(new FlowEntry());
+        fe->entry->cookie = ovs_htonll(c);
+        fe->entry->priority = priority;
+        fe->entry->flags = OFPUTIL_FF_SEND_FLOW_REM;
+        fe->entry->match = match;
+        entryList.push_back(fe);
+    };
+    switchManager.forEachCookieMatch(tableId, cb_func);
+    return !entryList.empty();
+}
+
+/*
+ * The two modes count a svc-tgt on different flows.  The stats table
+ * flow matches the target IP, so it counts all traffic to the target,
+ * including traffic sent to the pod IP directly.  The service next
+ * hop flow matches the service IP, so in aggregated mode only traffic
+ * load balanced through the service is counted.
+ */
+void ServiceStatsManagerFixture::testSvcTgtStatsFlowSources (void)
+{
+    const auto& svcUuid = as.getUUID();
+    const string nhip = "10.20.44.2";
+    uint32_t iSvcCk =
+        idGen.getId(IntFlowManager::getIdNamespace(SvcTargetCounter::CLASS_ID),
+                    "antosvc:svc-tgt:"+svcUuid+":"+nhip);
+    ovs_be32 nhAddr =
+        htonl(boost::asio::ip::address_v4::from_string(nhip).to_ulong());
+    ovs_be32 svcAddr =
+        htonl(boost::asio::ip::address_v4::from_string(
+                  sm1.getServiceIP().get()).to_ulong());
+
+    FlowEntryList rxList;
+    WAIT_FOR(findCookieFlow(IntFlowManager::SERVICE_NEXTHOP_TABLE_ID,
+                            iSvcCk, rxList), 500);
+    BOOST_CHECK_EQUAL(svcAddr, rxList.front()->entry->match.flow.nw_dst);
+
+    FlowEntryList statsList;
+    bool hasStatsFlow =
+        findCookieFlow(IntFlowManager::STATS_TABLE_ID, iSvcCk, statsList);
+    BOOST_CHECK_EQUAL(!aggregated, hasStatsFlow);
+    if (hasStatsFlow)
+        BOOST_CHECK_EQUAL(nhAddr, statsList.front()->entry->match.flow.nw_dst);
+}
+
+/*
+ * In aggregated mode the * <--> svc-tgt counts come from the service
+ * next hop (rx) and reverse (tx) flows. Both tables are folded into
+ * one cookie keyed counter map per poll, so a single update_state()
+ * must account for both directions.
+ */
+void
+ServiceStatsManagerFixture::testFlowStatsAggSvcTgt (MockConnection& portConn,
+                                                   PolicyStatsManager *statsManager,
+                                                   const string& nhip)
+{
+    const auto& svcUuid = as.getUUID();
+    uint32_t iSvcCk =
+        idGen.getId(IntFlowManager::getIdNamespace(SvcTargetCounter::CLASS_ID),
+                    "antosvc:svc-tgt:"+svcUuid+":"+nhip);
+    uint32_t eSvcCk =
+        idGen.getId(IntFlowManager::getIdNamespace(SvcTargetCounter::CLASS_ID),
+                    "svctoan:svc-tgt:"+svcUuid+":"+nhip);
+
+    // the svc-tgt cookies must not be on any stats table flow
+    FlowEntryList statsList;
+    BOOST_CHECK(!findCookieFlow(IntFlowManager::STATS_TABLE_ID,
+                                iSvcCk, statsList));
+    BOOST_CHECK(!findCookieFlow(IntFlowManager::STATS_TABLE_ID,
+                                eSvcCk, statsList));
+
+    FlowEntryList rxList, txList;
+    WAIT_FOR(findCookieFlow(IntFlowManager::SERVICE_NEXTHOP_TABLE_ID,
+                            iSvcCk, rxList), 500);
+    WAIT_FOR(findCookieFlow(IntFlowManager::SERVICE_REV_TABLE_ID,
+                            eSvcCk, txList), 500);
+
+    auto sendReply = [&] (uint32_t pkts, int tableId,
+                          FlowEntryList& entryList) -> void {
+        struct ofpbuf *res_msg = makeFlowStatReplyMessage_2(&portConn,
+                                                            pkts,
+                                                            tableId,
+                                                            entryList);
+        BOOST_REQUIRE(res_msg!=0);
+        ofp_header *msgHdr = (ofp_header *)res_msg->data;
+        serviceStatsManager.testInjectTxnId(msgHdr->xid);
+        statsManager->Handle(&portConn,
+                             OFPTYPE_FLOW_STATS_REPLY, res_msg);
+        ofpbuf_delete(res_msg);
+    };
+
+    boost::system::error_code ec;
+    ec = make_error_code(boost::system::errc::success);
+    // Call update_state() function to setup flow stat state.
+    serviceStatsManager.update_state(ec);
+
+    sendReply(INITIAL_PACKET_COUNT,
+              IntFlowManager::SERVICE_NEXTHOP_TABLE_ID, rxList);
+    sendReply(INITIAL_PACKET_COUNT,
+              IntFlowManager::SERVICE_REV_TABLE_ID, txList);
+    serviceStatsManager.update_state(ec);
+    checkAnySvcTgtObjectStats(svcUuid, nhip, 0, 0);
+
+    sendReply(FINAL_PACKET_COUNT,
+              IntFlowManager::SERVICE_NEXTHOP_TABLE_ID, rxList);
+    sendReply(FINAL_PACKET_COUNT,
+              IntFlowManager::SERVICE_REV_TABLE_ID, txList);
+    serviceStatsManager.update_state(ec);
+
+    uint32_t expPkts = FINAL_PACKET_COUNT - INITIAL_PACKET_COUNT;
+    uint32_t expBytes = expPkts * PACKET_SIZE;
+    checkAnySvcTgtObjectStats(svcUuid, nhip, expPkts, expBytes);
+}
+
+/*
+ * A batch of counters is folded per observer object: the rx and tx
+ * cookies of a svc-tgt land on the same target counter, the targets
+ * of a service add up on the service counter, and cookies with no
+ * packets or no idgen string are skipped.
+ */
+void ServiceStatsManagerFixture::testBatchSvcStatsCounters (void)
+{
+    const auto& svcUuid = as.getUUID();
+    const char* ns = IntFlowManager::getIdNamespace(SvcTargetCounter::CLASS_ID);
+    const string nh1 = "10.20.44.2";
+    const string nh2 = "2001:db8::2";
+
+    IntFlowManager::SvcStatsCounterMap counters;
+    counters.emplace(idGen.getId(ns, "antosvc:svc-tgt:"+svcUuid+":"+nh1),
+                     IntFlowManager::SvcStatsCounter(10, 1000));
+    counters.emplace(idGen.getId(ns, "svctoan:svc-tgt:"+svcUuid+":"+nh1),
+                     IntFlowManager::SvcStatsCounter(20, 2000));
+    counters.emplace(idGen.getId(ns, "antosvc:svc-tgt:"+svcUuid+":"+nh2),
+                     IntFlowManager::SvcStatsCounter(30, 3000));
+    counters.emplace(idGen.getId(ns, "svctoan:svc-tgt:"+svcUuid+":"+nh2),
+                     IntFlowManager::SvcStatsCounter(0, 4000));
+    counters.emplace(0xdeadbeef, IntFlowManager::SvcStatsCounter(50, 5000));
+
+    // apply the batch twice: the counts are deltas, so they add up
+    intFlowManager.updateSvcStatsCounters(counters);
+    intFlowManager.updateSvcStatsCounters(counters);
+
+    optional<shared_ptr<SvcStatUniverse> > su =
+        SvcStatUniverse::resolve(agent.getFramework());
+    BOOST_REQUIRE(su);
+    optional<shared_ptr<SvcCounter> > svc =
+        su.get()->resolveGbpeSvcCounter(svcUuid);
+    BOOST_REQUIRE(svc);
+    BOOST_CHECK_EQUAL(80, svc.get()->getRxpackets(0));
+    BOOST_CHECK_EQUAL(8000, svc.get()->getRxbytes(0));
+    BOOST_CHECK_EQUAL(40, svc.get()->getTxpackets(0));
+    BOOST_CHECK_EQUAL(4000, svc.get()->getTxbytes(0));
+
+    optional<shared_ptr<SvcTargetCounter> > tgt1 =
+        svc.get()->resolveGbpeSvcTargetCounter(nh1);
+    BOOST_REQUIRE(tgt1);
+    BOOST_CHECK_EQUAL(20, tgt1.get()->getRxpackets(0));
+    BOOST_CHECK_EQUAL(2000, tgt1.get()->getRxbytes(0));
+    BOOST_CHECK_EQUAL(40, tgt1.get()->getTxpackets(0));
+    BOOST_CHECK_EQUAL(4000, tgt1.get()->getTxbytes(0));
+
+    optional<shared_ptr<SvcTargetCounter> > tgt2 =
+        svc.get()->resolveGbpeSvcTargetCounter(nh2);
+    BOOST_REQUIRE(tgt2);
+    BOOST_CHECK_EQUAL(60, tgt2.get()->getRxpackets(0));
+    BOOST_CHECK_EQUAL(6000, tgt2.get()->getRxbytes(0));
+    BOOST_CHECK_EQUAL(0, tgt2.get()->getTxpackets(0));
+    BOOST_CHECK_EQUAL(0, tgt2.get()->getTxbytes(0));
+}
+
 void
 ServiceStatsManagerFixture::testFlowRemovedPodSvc (MockConnection& portConn,
                                                   PolicyStatsManager *statsManager,
@@ -1309,7 +1503,11 @@ bool ServiceStatsManagerFixture::checkNewFlowMapSize (void)
 
     // Also there are 2 default entries but only 1 has send_flow_rem
     // So totally we have 17 flows in STATS table for which we collect stats
-    if (serviceStatsManager.statsState.newFlowCounterMap.size() == 17)
+
+    // In aggregated mode the 4 any <--> svc-tgt flows are not created
+    // and those stats come from the service next hop and reverse flows
+    size_t expected = aggregated ? 13 : 17;
+    if (serviceStatsManager.statsState.newFlowCounterMap.size() == expected)
         return true;
     return false;
 }
@@ -1611,6 +1809,51 @@ BOOST_FIXTURE_TEST_CASE(testFlowRemovedNodeSvcTgtOld, ServiceStatsManagerFixture
     serviceStatsManager.stop();
 }
 
+// Verify * <--> svc-tgt stats collected from the next hop and
+// reverse flows in aggregated mode
+BOOST_FIXTURE_TEST_CASE(testFlowMatchStatsAggSvcTgtV4,
+                        AggServiceStatsManagerFixture) {
+    MockConnection integrationPortConn(TEST_CONN_TYPE_INT);
+    serviceStatsManager.registerConnection(&integrationPortConn);
+    serviceStatsManager.start();
+    checkNewFlowMapInitialized();
+    LOG(DEBUG) << "############# aggregated SVC-TGT stats v4 START ############";
+    testFlowStatsAggSvcTgt(integrationPortConn, &serviceStatsManager,
+                           "10.20.44.2");
+    LOG(DEBUG) << "############# aggregated SVC-TGT stats v4 END ############";
+    serviceStatsManager.stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(testFlowMatchStatsAggSvcTgtV6,
+                        AggServiceStatsManagerFixture) {
+    MockConnection integrationPortConn(TEST_CONN_TYPE_INT);
+    serviceStatsManager.registerConnection(&integrationPortConn);
+    serviceStatsManager.start();
+    checkNewFlowMapInitialized();
+    LOG(DEBUG) << "############# aggregated SVC-TGT stats v6 START ############";
+    testFlowStatsAggSvcTgt(integrationPortConn, &serviceStatsManager,
+                           "2001:db8::2");
+    LOG(DEBUG) << "############# aggregated SVC-TGT stats v6 END ############";
+    serviceStatsManager.stop();
+}
+
+// Compare the flows that count a svc-tgt with and without aggregation
+BOOST_FIXTURE_TEST_CASE(testSvcTgtStatsFlowSourcesNoAgg,
+                        ServiceStatsManagerFixture) {
+    testSvcTgtStatsFlowSources();
+}
+
+BOOST_FIXTURE_TEST_CASE(testSvcTgtStatsFlowSourcesAgg,
+                        AggServiceStatsManagerFixture) {
+    testSvcTgtStatsFlowSources();
+}
+
+// Verify the batch counter update folds counts per observer object
+BOOST_FIXTURE_TEST_CASE(testBatchSvcStatsCounters,
+                        AggServiceStatsManagerFixture) {
+    testBatchSvcStatsCounters();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
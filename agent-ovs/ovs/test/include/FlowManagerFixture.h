@@ -209,6 +209,7 @@ public:
         return *this;
     }
     Bldr& isMd(const std::string& md) { m("metadata", md); return *this; }
+    Bldr& isConjId(uint32_t id) { m("conj_id", str(id)); return *this; }
     Bldr& isPktMark(uint32_t mark) {
         m("pkt_mark", str(mark, true)); return *this;
     }
@@ -277,6 +278,10 @@ public:
         a() << "multipath(" << s << ")"; return *this;
     }
     Bldr& polApplied() { a("write_metadata", "0x100/0x100"); return *this; }
+    Bldr& conjunction(uint32_t id, uint8_t clause, uint8_t n) {
+        a("conjunction(" + str(id) + "," + str(clause) + "/" + str(n) + ")");
+        return *this;
+    }
     Bldr& resubmit(uint8_t t) {
         a() << "resubmit(," << str(t) << ")"; return *this;
     }
@@ -35,6 +35,9 @@ public:
     virtual void Expect(FlowEdit::type mod, const std::vector<std::string>& fe);
     virtual void Expect(TlvEdit::type mod, const std::string& te);
     virtual void ExpectGroup(FlowEdit::type mod, const std::string& ge);
+    // expect a group mod that starts with its command, such as
+    // "INSERT_BUCKET|group_id=..."
+    virtual void ExpectGroup(const std::string& ge);
     virtual void IgnoreFlowMods();
     virtual void IgnoreGroupMods();
     virtual void IgnoreTlvMods();
@@ -21,7 +21,8 @@ namespace opflexagent {
 class MockSwitchConnection : public SwitchConnection {
 public:
     MockSwitchConnection()
-        : SwitchConnection("mockBridge"), connected(false) {
+        : SwitchConnection("mockBridge"), connected(false),
+          protocolVersion(OFP13_VERSION) {
     }
     virtual ~MockSwitchConnection() {
         clear();
@@ -38,7 +39,7 @@ public:
         return 0;
     }
 
-    virtual int GetProtocolVersion() { return OFP13_VERSION; }
+    virtual int GetProtocolVersion() { return protocolVersion; }
 
     virtual int SendMessage(OfpBuf& msg) {
         std::lock_guard<std::mutex> guard(sentMsgMutex);
@@ -49,6 +50,7 @@ public:
     virtual bool IsConnected() { return connected; }
 
     bool connected;
+    int protocolVersion;
 
     int getSentMsgCount() {
         std::lock_guard<std::mutex> guard(sentMsgMutex);
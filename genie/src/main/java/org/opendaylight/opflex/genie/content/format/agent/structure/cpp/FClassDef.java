@@ -277,6 +277,35 @@ public class FClassDef extends ItemFormatterTask
         genRefDefaultedAccessors(aInIndent, aInComments);
         genRefMutators(aInIndent, aInClass, aInPropIdx, aInComments);
         genRefUnset(aInIndent, aInClass, aInPropIdx, aInComments);
+        if (aInClass.isConcrete())
+        {
+            genRefResolver(aInIndent, aInClass, aInPropIdx);
+        }
+    }
+
+    private void genRefResolver(int aInIndent, MClass aInClass, int aInPropIdx)
+    {
+        String lFullyQualifiedClassName = getClassName(aInClass, true);
+        String lClassName = getClassName(aInClass, false);
+        String[] lComment =
+            {"Retrieve the instances of " + lClassName + " whose target refers",
+             "to the given URI from the managed object store.  This uses the",
+             "reference index, so the cost is proportional to the number of",
+             "references to the target.",
+             "",
+             "@param framework the framework instance to use",
+             "@param target the URI of the referenced object",
+             "@param out the referencing objects will be appended to this vector"};
+        out.printHeaderComment(aInIndent,lComment);
+        out.println(aInIndent, "static void resolveByTarget(");
+        out.println(aInIndent + 1, "opflex::ofcore::OFFramework& framework,");
+        out.println(aInIndent + 1, "const opflex::modb::URI& target,");
+        out.println(aInIndent + 1, "/* out */ std::vector<OF_SHARED_PTR<" + lFullyQualifiedClassName + "> >& out)");
+        out.println(aInIndent, "{");
+        out.println(aInIndent + 1, "opflex::modb::mointernal::MO::resolveReferences<" + lFullyQualifiedClassName + ">(");
+        out.println(aInIndent + 2, "framework, CLASS_ID, " + toUnsignedStr(aInPropIdx) + ", target, out);");
+        out.println(aInIndent, "}");
+        out.println();
     }
     
     private void genPropCheck(
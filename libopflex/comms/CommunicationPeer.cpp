@@ -130,7 +130,7 @@ void CommunicationPeer::onDisconnect() {
 
     if (connected_) {
         /* wipe deque out and reset pendingBytes_ */
-        s_.deque_.clear();
+        s_.Clear();
         pendingBytes_ = 0;
         connected_ = 0;
 
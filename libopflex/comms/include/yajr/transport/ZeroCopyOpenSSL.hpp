@@ -11,6 +11,7 @@
 #define _____COMMS__INCLUDE__YAJR__TRANSPORT__ZEROCOPYOPENSSL_H
 
 #include <opflex/yajr/transport/engine.hpp>
+#include <opflex/yajr/rpc/send_handler.hpp>
 
 #include <openssl/bio.h>
 
@@ -18,6 +19,8 @@
 
 #include <deque>
 
+#include <map>
+
 #include <string>
 
 namespace yajr {
@@ -58,13 +61,33 @@ struct ZeroCopyOpenSSL : public Transport::Engine {
              *        method Ctx::createCtx(). Can be shared across multiple
              *        peers.
              */
-            bool inverted_roles = false
+            bool inverted_roles = false,
             /**< [in] whether to have the server connect and the client accept,
              *        so as to save CPU on the server at the price of losing
              *        interoperability. Don't use it unless you control both
              *        clients and servers and want to push the heavy asymmetric
              *        crypto operations from the servers to the clients.
              */
+            char const * sessionKey = NULL
+            /**< [in] for active peers, the name of the remote endpoint under
+             *        which the TLS session is cached in the context, so that
+             *        a reconnect to the same endpoint can resume the session
+             *        instead of doing a full handshake. NULL disables
+             *        resumption.
+             */
+    );
+
+    /**
+     * @brief Create the transport engine for one connection. Normally
+     * done by attachTransport().
+     */
+    ZeroCopyOpenSSL(
+            ZeroCopyOpenSSL::Ctx * ctx,
+            /**< [in] the context for this connection */
+            bool passive,
+            /**< [in] whether this side accepts the TLS handshake */
+            char const * sessionKey
+            /**< [in] see attachTransport() */
     );
 
     ~ZeroCopyOpenSSL();
@@ -73,16 +96,52 @@ struct ZeroCopyOpenSSL : public Transport::Engine {
     BIO * bioExternal_;
     BIO * bioSSL_;
     char * lastOutBuf_;
+    /* set when the BIO pair filled up and should be grown once drained */
+    bool growBio_;
     static std::string const dumpOpenSslErrorStackAsString();
+
+    /**
+     * @brief Write plaintext to the SSL BIO in full TLS records
+     *
+     * @return the number of bytes from the front of the queue that were
+     * taken
+     */
+    ssize_t encrypt(
+            ::yajr::internal::StringQueue const & queue,
+            /**< [in] the plaintext to send */
+            ssize_t & lastWrite
+            /**< [out] the result of the last BIO write */
+    );
+
+    /**
+     * @brief Grow the BIO pair if it was found full and is now empty
+     *
+     * The pair can only be resized while no data is buffered in either
+     * direction, so this must be called when no write is in flight.
+     *
+     * @return false if the BIO pair could not be rebuilt
+     */
+    bool adaptBioPair();
+
+    /**
+     * @brief Get the current size of each BIO pair buffer
+     */
+    size_t getBioBufSize() const {
+        return bioBufSize_;
+    }
   private:
     SSL* ssl_;
     bool ready_;
+    Ctx * ctx_;
+    std::string sessionKey_;
+    size_t bioBufSize_;
+    bool sessionOffered_;
+    bool handshakeCounted_;
     static uv_rwlock_t * rwlock;
 #if (OPENSSL_VERSION_NUMBER < 0x10100000L)
     static void lockingCallback(int, int, const char *, int);
 #endif
     static void infoCallback(SSL const *, int, int);
-    ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive);
 };
 
 class ZeroCopyOpenSSL::Ctx {
@@ -167,12 +226,63 @@ class ZeroCopyOpenSSL::Ctx {
     SSL_CTX * getSslCtx() const {
         return sslCtx_;
     }
+
+    /**
+     * @brief Offer the session cached for an endpoint, if any, to a
+     * new client connection
+     *
+     * @return true if a cached session was set on the connection
+     */
+    bool resumeSession(
+        SSL * ssl,
+        /**< [in] the connection, before its handshake has started */
+        std::string const & key
+        /**< [in] the name of the remote endpoint */
+    );
+
+    /**
+     * @brief Cache a session for an endpoint, replacing any previous one
+     */
+    void storeSession(
+        std::string const & key,
+        /**< [in] the name of the remote endpoint */
+        SSL_SESSION * session
+        /**< [in] the session. The reference passes to the context. */
+    );
+
+    /**
+     * @brief Drop the session cached for an endpoint
+     */
+    void forgetSession(
+        std::string const & key
+        /**< [in] the name of the remote endpoint */
+    );
+
+    /**
+     * @brief Get the number of completed full and resumed handshakes
+     * with an endpoint
+     */
+    void getHandshakeCounts(
+        std::string const & key,
+        /**< [in] the name of the remote endpoint */
+        uint64_t & full,
+        /**< [out] the number of full handshakes */
+        uint64_t & resumed
+        /**< [out] the number of abbreviated handshakes */
+    ) const;
+
     ~Ctx();
   private:
+    friend struct ZeroCopyOpenSSL;
     Ctx(SSL_CTX * c, char const * passphrase);
     static int pwdCb(char *, int, int, void *);
+    static int newSessionCb(SSL *, SSL_SESSION *);
     SSL_CTX * sslCtx_;
     std::string passphrase_;
+    std::map<std::string, SSL_SESSION *> sessions_;
+    mutable uv_mutex_t sessionMutex_;
+    /* full and resumed handshake counts per endpoint */
+    std::map<std::string, std::pair<uint64_t, uint64_t> > handshakes_;
 };
 
 } /* yajr::transport namespace */
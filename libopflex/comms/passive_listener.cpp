@@ -16,8 +16,11 @@
 
 #include <opflex/logging/internal/logging.hpp>
 
+#include <sys/socket.h>
 #include <sys/un.h>
 
+#include <cerrno>
+
 /*
                          ____               _
                         |  _ \ __ _ ___ ___(_)_   _____
@@ -51,7 +54,8 @@
         ::yajr::Listener::AcceptCb acceptHandler,
         void * data,
         uv_loop_t * listenerUvLoop,
-        ::yajr::Peer::UvLoopSelector uvLoopSelector
+        ::yajr::Peer::UvLoopSelector uvLoopSelector,
+        bool reusePort
     ) {
 
     LOG(INFO) << ip_address << ":" << port;
@@ -65,7 +69,8 @@
             acceptHandler,
             data,
             listenerUvLoop,
-            uvLoopSelector);
+            uvLoopSelector,
+            reusePort);
 #if __cpp_exceptions || __EXCEPTIONS
     } catch(const std::bad_alloc&) {
     }
@@ -144,8 +149,16 @@ void ::yajr::comms::internal::ListeningTcpPeer::retry() {
 
     int rc;
 
-    if ((rc = uv_tcp_init(_.listener_.uvLoop_,
-                    reinterpret_cast<uv_tcp_t *>(getHandle())))) {
+    if (reusePort_) {
+        /* the socket has to exist before bind to set SO_REUSEPORT */
+        rc = uv_tcp_init_ex(_.listener_.uvLoop_,
+                reinterpret_cast<uv_tcp_t *>(getHandle()),
+                listen_on_.ss_family);
+    } else {
+        rc = uv_tcp_init(_.listener_.uvLoop_,
+                reinterpret_cast<uv_tcp_t *>(getHandle()));
+    }
+    if (rc) {
         LOG(WARNING)
             << "uv_tcp_init: ["
             << uv_err_name(rc)
@@ -157,6 +170,29 @@ void ::yajr::comms::internal::ListeningTcpPeer::retry() {
 
     up();
 
+    if (reusePort_) {
+#ifdef SO_REUSEPORT
+        uv_os_fd_t fd;
+        int on = 1;
+        if (!(rc = uv_fileno(getHandle(), &fd)) &&
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on))) {
+            rc = -errno;
+        }
+        if (rc) {
+            LOG(WARNING)
+                << "SO_REUSEPORT: ["
+                << uv_err_name(rc)
+                << "] "
+                << uv_strerror(rc)
+            ;
+            status_ = Peer::kPS_FAILED_BINDING;
+            goto failed_after_init;
+        }
+#else
+        LOG(WARNING) << "SO_REUSEPORT is not supported on this platform";
+#endif
+    }
+
     if ((rc = uv_tcp_bind(reinterpret_cast<uv_tcp_t *>(getHandle()),
                 (struct sockaddr *) &listen_on_,
                 0))) {
@@ -67,6 +67,11 @@ void RpcConnection::processWriteQueue() {
     }
 }
 
+size_t RpcConnection::getWriteQueueDepth() {
+    util::LockGuard guard(&queue_mutex);
+    return write_queue.size();
+}
+
 void RpcConnection::doWrite(JsonRpcMessage* message) {
     if (getPeer() == NULL) return;
 
@@ -31,7 +31,11 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <string>
 #include <utility>
+#include <vector>
 
 #define DEFAULT_COMMSTEST_TIMEOUT 7200
 const uint16_t kPortOffset = 1;
@@ -1768,6 +1772,205 @@ BOOST_FIXTURE_TEST_CASE( STABLE_test_several_SSL_peers, CommsFixture ) {
     loop_until_final(range_t(401,401), pc_successful_connect200, range_t(0,0), true, 800); // 401 is to cause a timeout
 
 }
+
+/* move the TLS bytes waiting on the network side of one engine to the other */
+static size_t pumpTls(ZeroCopyOpenSSL & from, ZeroCopyOpenSSL & to) {
+    size_t moved = 0;
+    char buf[4096];
+    int n;
+    size_t room;
+    while ((room = std::min(sizeof(buf),
+                    BIO_ctrl_get_write_guarantee(to.bioExternal_))) &&
+           (n = BIO_read(from.bioExternal_, buf, room)) > 0) {
+        BOOST_REQUIRE_EQUAL(n, BIO_write(to.bioExternal_, buf, n));
+        moved += n;
+    }
+    return moved;
+}
+
+/* pump and decrypt until len bytes of plaintext have reached the receiver */
+static std::string receiveTls(ZeroCopyOpenSSL & from, ZeroCopyOpenSSL & to,
+                              size_t len) {
+    std::string plain;
+    char buf[4096];
+    int n;
+    bool progress = true;
+    while (plain.size() < len && progress) {
+        progress = (pumpTls(from, to) > 0);
+        while ((n = BIO_read(to.bioSSL_, buf, sizeof(buf))) > 0) {
+            plain.append(buf, n);
+            progress = true;
+        }
+    }
+    return plain;
+}
+
+static bool handshakeInMemory(ZeroCopyOpenSSL & client,
+                              ZeroCopyOpenSSL & server) {
+    bool clientDone = false, serverDone = false;
+    for (int i = 0; i < 20 && !(clientDone && serverDone); ++i) {
+        clientDone = (1 == BIO_do_handshake(client.bioSSL_));
+        pumpTls(client, server);
+        serverDone = (1 == BIO_do_handshake(server.bioSSL_));
+        pumpTls(server, client);
+    }
+    /* let the client take the session tickets sent after the handshake */
+    char c;
+    (void) BIO_read(client.bioSSL_, &c, 1);
+    return clientDone && serverDone;
+}
+
+static ZeroCopyOpenSSL::Ctx * createServerCtx() {
+    return ZeroCopyOpenSSL::Ctx::createCtx(
+            NULL,
+            SRCDIR"/test/server.pem",
+            "password123");
+}
+
+static ZeroCopyOpenSSL::Ctx * createClientCtx() {
+    return ZeroCopyOpenSSL::Ctx::createCtx(
+            SRCDIR"/test/ca.pem",
+            NULL);
+}
+
+static bool hasCachedSession(ZeroCopyOpenSSL::Ctx * ctx,
+                             std::string const & key) {
+    SSL * ssl = SSL_new(ctx->getSslCtx());
+    bool cached = ctx->resumeSession(ssl, key);
+    SSL_free(ssl);
+    return cached;
+}
+
+BOOST_FIXTURE_TEST_CASE( STABLE_test_SSL_session_resumption, CommsFixture ) {
+
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> serverCtx(createServerCtx());
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> clientCtx(createClientCtx());
+    BOOST_REQUIRE(serverCtx && clientCtx);
+
+    uint64_t full, resumed;
+    BOOST_CHECK(!hasCachedSession(clientCtx.get(), "peer:1"));
+
+    {
+        ZeroCopyOpenSSL server(serverCtx.get(), true, NULL);
+        ZeroCopyOpenSSL client(clientCtx.get(), false, "peer:1");
+        BOOST_CHECK(handshakeInMemory(client, server));
+    }
+    clientCtx->getHandshakeCounts("peer:1", full, resumed);
+    BOOST_CHECK_EQUAL(1u, full);
+    BOOST_CHECK_EQUAL(0u, resumed);
+
+    /* the new session callback cached the session for the endpoint */
+    BOOST_CHECK(hasCachedSession(clientCtx.get(), "peer:1"));
+    BOOST_CHECK(!hasCachedSession(clientCtx.get(), "peer:2"));
+
+    {
+        ZeroCopyOpenSSL server(serverCtx.get(), true, NULL);
+        ZeroCopyOpenSSL client(clientCtx.get(), false, "peer:1");
+        BOOST_CHECK(handshakeInMemory(client, server));
+    }
+    clientCtx->getHandshakeCounts("peer:1", full, resumed);
+    BOOST_CHECK_EQUAL(1u, full);
+    BOOST_CHECK_EQUAL(1u, resumed);
+    BOOST_CHECK(hasCachedSession(clientCtx.get(), "peer:1"));
+
+    /* a handshake that does not complete drops the session it offered */
+    {
+        ZeroCopyOpenSSL client(clientCtx.get(), false, "peer:1");
+        (void) BIO_do_handshake(client.bioSSL_);
+    }
+    BOOST_CHECK(!hasCachedSession(clientCtx.get(), "peer:1"));
+
+    loop_until_final(range_t(0,0), NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE( STABLE_test_SSL_bio_growth, CommsFixture ) {
+
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> serverCtx(createServerCtx());
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> clientCtx(createClientCtx());
+    BOOST_REQUIRE(serverCtx && clientCtx);
+
+    {
+        ZeroCopyOpenSSL server(serverCtx.get(), true, NULL);
+        ZeroCopyOpenSSL client(clientCtx.get(), false, NULL);
+        BOOST_REQUIRE(handshakeInMemory(client, server));
+
+        /* nothing happens until the pair has been found full */
+        BOOST_CHECK(client.adaptBioPair());
+        BOOST_CHECK_EQUAL(24576u, client.getBioBufSize());
+
+        /* and the resize waits for buffered data to drain */
+        std::deque<char> queue(100, 'x');
+        ssize_t lastWrite;
+        BOOST_CHECK_EQUAL(100, client.encrypt(queue, lastWrite));
+        client.growBio_ = true;
+        BOOST_CHECK(client.adaptBioPair());
+        BOOST_CHECK_EQUAL(24576u, client.getBioBufSize());
+        BOOST_CHECK_EQUAL(std::string(100, 'x'),
+                          receiveTls(client, server, 100));
+
+        size_t expected = 24576;
+        for (int i = 0; i < 5; ++i) {
+            BOOST_CHECK(client.adaptBioPair());
+            expected = std::min<size_t>(expected * 2, 262144);
+            BOOST_CHECK_EQUAL(expected, client.getBioBufSize());
+            client.growBio_ = true;
+        }
+        BOOST_CHECK_EQUAL(262144u, client.getBioBufSize());
+
+        /* the connection still works over the rebuilt pair */
+        std::deque<char> big(100000, 'y');
+        BOOST_CHECK_EQUAL(100000, client.encrypt(big, lastWrite));
+        BOOST_CHECK_EQUAL(std::string(big.begin(), big.end()),
+                          receiveTls(client, server, 100000));
+    }
+
+    loop_until_final(range_t(0,0), NULL);
+}
+
+BOOST_FIXTURE_TEST_CASE( STABLE_test_SSL_record_coalescing, CommsFixture ) {
+
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> serverCtx(createServerCtx());
+    boost::scoped_ptr<ZeroCopyOpenSSL::Ctx> clientCtx(createClientCtx());
+    BOOST_REQUIRE(serverCtx && clientCtx);
+
+    {
+        ZeroCopyOpenSSL server(serverCtx.get(), true, NULL);
+        ZeroCopyOpenSSL client(clientCtx.get(), false, NULL);
+        BOOST_REQUIRE(handshakeInMemory(client, server));
+
+        /* many small chunks become full records */
+        std::deque<char> queue;
+        for (size_t i = 0; i < 20000; ++i) {
+            queue.push_back('a' + i % 26);
+        }
+        ssize_t lastWrite;
+        BOOST_CHECK_EQUAL(20000, client.encrypt(queue, lastWrite));
+
+        std::vector<unsigned char> wire;
+        unsigned char buf[4096];
+        int n;
+        while ((n = BIO_read(client.bioExternal_, buf, sizeof(buf))) > 0) {
+            wire.insert(wire.end(), buf, buf + n);
+        }
+
+        size_t records = 0;
+        size_t off = 0;
+        while (off + 5 <= wire.size()) {
+            BOOST_CHECK_EQUAL(23, wire[off]); /* application data */
+            off += 5 + ((wire[off + 3] << 8) | wire[off + 4]);
+            ++records;
+        }
+        BOOST_CHECK_EQUAL(wire.size(), off);
+        BOOST_CHECK_EQUAL(2u, records);
+
+        BOOST_REQUIRE_EQUAL(static_cast<int>(wire.size()),
+                BIO_write(server.bioExternal_, &wire[0], wire.size()));
+        BOOST_CHECK_EQUAL(std::string(queue.begin(), queue.end()),
+                          receiveTls(client, server, queue.size()));
+    }
+
+    loop_until_final(range_t(0,0), NULL);
+}
 #endif
 
 
@@ -33,7 +33,7 @@ TransportEngine< PlainText > & PlainText::getPlainTextTransport() {
 template<>
 int Cb< PlainText >::send_cb(CommunicationPeer * peer) {
     assert(!peer->getPendingBytes());
-    peer->setPendingBytes(peer->getStringQueue().deque_.size());
+    peer->setPendingBytes(peer->getStringQueue().GetSize());
 
     if (!peer->getPendingBytes()) {
         /* great success! */
@@ -41,11 +41,8 @@ int Cb< PlainText >::send_cb(CommunicationPeer * peer) {
         return 0;
     }
 
-    std::vector<iovec> iov =
-        ::yajr::comms::internal::get_iovec(
-                peer->getStringQueue().deque_.begin(),
-                peer->getStringQueue().deque_.end()
-        );
+    /* shared payload chunks are written straight from their buffers */
+    std::vector<iovec> iov = peer->getStringQueue().GetIovec();
 
     assert (iov.size());
 
@@ -54,10 +51,7 @@ int Cb< PlainText >::send_cb(CommunicationPeer * peer) {
 
 template<>
 void Cb< PlainText >::on_sent(CommunicationPeer const * peer) {
-    peer->getStringQueue().deque_.erase(
-            peer->getStringQueue().deque_.begin(),
-            peer->getStringQueue().deque_.begin() + peer->getPendingBytes()
-    );
+    peer->getStringQueue().Consume(peer->getPendingBytes());
 }
 
 template<>
@@ -20,12 +20,25 @@
 
 #include <openssl/err.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace {
 
     bool const SSL_ERROR = true;
 
+    /* initial size of each BIO pair buffer: one full TLS record with room
+     * to spare */
+    size_t const BIO_BUF_SIZE = 24576;
+
+    /* the BIO pair is doubled under pressure up to this size */
+    size_t const BIO_BUF_MAX_SIZE = 262144;
+
+    /* largest plaintext that fits a single TLS record */
+    size_t const MAX_RECORD_PLAINTEXT = 16384;
+
+    unsigned char const SESSION_ID_CONTEXT[] = "opflex";
+
 }
 
 #define                                                           \
@@ -127,45 +140,16 @@ ssize_t Cb< ZeroCopyOpenSSL >::StaticHelpers::tryToEncrypt(
     }
 
     /* we have to encrypt the plaintext data, if any is available */
-    if (peer->getStringQueue().deque_.empty()) {
+    if (peer->getStringQueue().Empty()) {
         LOG(DEBUG4) << peer << " has no data to send";
         return 0;
     }
 
     ZeroCopyOpenSSL * e = peer->getEngine<ZeroCopyOpenSSL>();
 
-    ssize_t totalWrite = 0;
     ssize_t nwrite = 0;
-    ssize_t tryWrite;
-
-    std::vector<iovec> iovIn =
-        ::yajr::comms::internal::get_iovec(
-                peer->getStringQueue().deque_.begin(),
-                peer->getStringQueue().deque_.end()
-        );
-
-    std::vector<iovec>::iterator iovInIt;
-    for (iovInIt = iovIn.begin(); iovInIt != iovIn.end(); ++iovInIt) {
-
-        tryWrite = iovInIt->iov_len;
-
-        assert(tryWrite);
-
-        nwrite = BIO_write(
-                e->bioSSL_,
-                iovInIt->iov_base,
-                tryWrite);
-
-        if (nwrite > 0) {
-            totalWrite += nwrite;
-        }
-
-        if (nwrite < tryWrite) {
-            /* includes case in which (nwrite <= 0) */
-            break;
-        }
+    ssize_t totalWrite = e->encrypt(peer->getStringQueue(), nwrite);
 
-    }
     IF_SSL_EMIT_ERRORS(peer) {
         IF_SSL_ERROR(sslErr, nwrite <= 0) {
             LOG(ERROR) << peer << " Failed to encrypt output: " << sslErr;
@@ -175,10 +159,7 @@ ssize_t Cb< ZeroCopyOpenSSL >::StaticHelpers::tryToEncrypt(
         return 0;
     }
 
-    peer->getStringQueue().deque_.erase(
-            peer->getStringQueue().deque_.begin(),
-            peer->getStringQueue().deque_.begin() + totalWrite
-    );
+    peer->getStringQueue().Consume(totalWrite);
 
     /* short-circuit a single non-positive nread */
     return totalWrite ?: nwrite;
@@ -220,6 +201,12 @@ int Cb< ZeroCopyOpenSSL >::send_cb(CommunicationPeer* peer) {
 
     assert(!peer->getPendingBytes());
 
+    /* nothing is in flight, so this is when the BIO pair can be resized */
+    if (!peer->getEngine<ZeroCopyOpenSSL>()->adaptBioPair()) {
+        peer->onDisconnect();
+        return 0;
+    }
+
     (void) Cb< ZeroCopyOpenSSL >::StaticHelpers::tryToEncrypt(peer);
     return Cb< ZeroCopyOpenSSL >::StaticHelpers::tryToSend(peer);
 }
@@ -303,6 +290,7 @@ void Cb< ZeroCopyOpenSSL >::alloc_cb(
      */
     if (!size) {
         LOG(WARNING) << peer << " BIO pair is full, have to choke sender";
+        e->growBio_ = true;
         peer->choke();
     }
 
@@ -534,18 +522,25 @@ void ZeroCopyOpenSSL::finiOpenSSL() {
 #endif
 }
 
-ZeroCopyOpenSSL::ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive)
+ZeroCopyOpenSSL::ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive,
+                                 char const * sessionKey)
     :
         bioInternal_(BIO_new(BIO_s_bio())),
         bioExternal_(BIO_new(BIO_s_bio())),
         bioSSL_(BIO_new(BIO_f_ssl())),
         lastOutBuf_(NULL),
+        growBio_(false),
         ssl_(NULL),
-        ready_(false)
+        ready_(false),
+        ctx_(ctx),
+        sessionKey_(sessionKey ?: ""),
+        bioBufSize_(BIO_BUF_SIZE),
+        sessionOffered_(false),
+        handshakeCounted_(false)
     {
 
-    if(bioInternal_ && BIO_set_write_buf_size(bioInternal_, 24576) &&
-       bioExternal_ && BIO_set_write_buf_size(bioExternal_, 24576) &&
+    if(bioInternal_ && BIO_set_write_buf_size(bioInternal_, bioBufSize_) &&
+       bioExternal_ && BIO_set_write_buf_size(bioExternal_, bioBufSize_) &&
        BIO_make_bio_pair(bioInternal_, bioExternal_) && bioSSL_ &&
        (ssl_ = SSL_new(ctx->getSslCtx())) &&
        BIO_set_ssl(bioSSL_, ssl_, BIO_CLOSE)) {
@@ -559,6 +554,7 @@ ZeroCopyOpenSSL::ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive)
     }
 
     SSL_set_bio           (ssl_, bioInternal_, bioInternal_);
+    SSL_set_app_data      (ssl_, this);
 
     SSL_set_mode(ssl_, SSL_MODE_AUTO_RETRY);
     SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE);
@@ -576,6 +572,10 @@ ZeroCopyOpenSSL::ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive)
 
         SSL_set_connect_state(ssl_);
 
+        if (!sessionKey_.empty()) {
+            sessionOffered_ = ctx_->resumeSession(ssl_, sessionKey_);
+        }
+
     }
 
     /* This is the best way I found to do nothing visible yet trigger the SSL
@@ -590,6 +590,12 @@ ZeroCopyOpenSSL::ZeroCopyOpenSSL(ZeroCopyOpenSSL::Ctx * ctx, bool passive)
 
 ZeroCopyOpenSSL::~ZeroCopyOpenSSL() {
 
+    /* a cached session the peer would not complete a handshake with is not
+     * worth offering again */
+    if (sessionOffered_ && ssl_ && !SSL_is_init_finished(ssl_)) {
+        ctx_->forgetSession(sessionKey_);
+    }
+
     if (bioSSL_) {
         BIO_free_all(bioSSL_);
     }
@@ -600,16 +606,115 @@ ZeroCopyOpenSSL::~ZeroCopyOpenSSL() {
 
 }
 
-void ZeroCopyOpenSSL::infoCallback(SSL const *, int where, int ret) {
+void ZeroCopyOpenSSL::infoCallback(SSL const * ssl, int where, int ret) {
 
     switch (where) {
         case SSL_CB_HANDSHAKE_START:
             LOG(DEBUG2) << " Handshake start!";
             break;
-        case SSL_CB_HANDSHAKE_DONE:
-            LOG(DEBUG2) << " Handshake done!";
+        case SSL_CB_HANDSHAKE_DONE: {
+            SSL * s = const_cast<SSL *>(ssl);
+            bool resumed = SSL_session_reused(s);
+            LOG(DEBUG2) << " Handshake done!" << (resumed ? " (resumed)" : "");
+
+            /* TLS 1.3 also reports post-handshake messages as handshakes */
+            ZeroCopyOpenSSL * e =
+                static_cast<ZeroCopyOpenSSL *>(SSL_get_app_data(s));
+            if (e && !e->handshakeCounted_ && !e->sessionKey_.empty()) {
+                e->handshakeCounted_ = true;
+                uv_mutex_lock(&e->ctx_->sessionMutex_);
+                std::pair<uint64_t, uint64_t> & counts =
+                    e->ctx_->handshakes_[e->sessionKey_];
+                ++(resumed ? counts.second : counts.first);
+                uv_mutex_unlock(&e->ctx_->sessionMutex_);
+            }
+            break;
+        }
+    }
+}
+
+ssize_t ZeroCopyOpenSSL::encrypt(
+        ::yajr::internal::StringQueue const & queue,
+        ssize_t & lastWrite) {
+
+    ssize_t totalWrite = 0;
+    ssize_t tryWrite;
+
+    /* The queue is made of small non-contiguous chunks. Writing them one by
+     * one would emit one short TLS record per chunk, so gather them into full
+     * records instead. A retried write always starts with the same bytes and
+     * is never shorter than the previous attempt, as OpenSSL requires.
+     */
+    size_t const queued = queue.GetSize();
+    char record[MAX_RECORD_PLAINTEXT];
+
+    lastWrite = 0;
+    while (static_cast<size_t>(totalWrite) < queued) {
+
+        tryWrite = std::min(queued - totalWrite, sizeof(record));
+
+        queue.Copy(record, totalWrite, tryWrite);
+
+        lastWrite = BIO_write(
+                bioSSL_,
+                record,
+                tryWrite);
+
+        if (lastWrite > 0) {
+            totalWrite += lastWrite;
+        }
+
+        if (lastWrite < tryWrite) {
+            /* includes case in which (lastWrite <= 0) */
+            if (BIO_should_retry(bioSSL_)) {
+                /* the BIO pair is full: grow it once it has drained */
+                growBio_ = true;
+            }
             break;
+        }
+
     }
+
+    return totalWrite;
+}
+
+bool ZeroCopyOpenSSL::adaptBioPair() {
+
+    if (!growBio_) {
+        return true;
+    }
+
+    if (bioBufSize_ >= BIO_BUF_MAX_SIZE || !SSL_is_init_finished(ssl_)) {
+        growBio_ = false;
+        return true;
+    }
+
+    /* wait for both directions to drain */
+    if (BIO_ctrl_pending(bioInternal_) || BIO_ctrl_pending(bioExternal_)) {
+        return true;
+    }
+
+    growBio_ = false;
+    size_t newSize = std::min(bioBufSize_ * 2, BIO_BUF_MAX_SIZE);
+
+    BIO_destroy_bio_pair(bioInternal_);
+    if (BIO_set_write_buf_size(bioInternal_, newSize) &&
+        BIO_set_write_buf_size(bioExternal_, newSize)) {
+        bioBufSize_ = newSize;
+    } else {
+        (void) BIO_set_write_buf_size(bioInternal_, bioBufSize_);
+        (void) BIO_set_write_buf_size(bioExternal_, bioBufSize_);
+    }
+
+    if (!BIO_make_bio_pair(bioInternal_, bioExternal_)) {
+        LOG(ERROR) << "Failed to rebuild BIO pair: "
+                   << ZeroCopyOpenSSL::dumpOpenSslErrorStackAsString();
+        return false;
+    }
+
+    LOG(DEBUG) << "BIO pair grown to " << bioBufSize_ << " bytes";
+
+    return true;
 }
 
 int ZeroCopyOpenSSL::Ctx::pwdCb(
@@ -677,9 +782,17 @@ ZeroCopyOpenSSL::Ctx::Ctx(
         :
             sslCtx_(c),
             passphrase_(passphrase?:"")
-        {};
+        {
+    uv_mutex_init(&sessionMutex_);
+};
 
 ZeroCopyOpenSSL::Ctx::~Ctx(){
+    for (std::map<std::string, SSL_SESSION *>::iterator it = sessions_.begin();
+         it != sessions_.end(); ++it) {
+        SSL_SESSION_free(it->second);
+    }
+    uv_mutex_destroy(&sessionMutex_);
+
     if (!sslCtx_) {
         return;
     }
@@ -688,6 +801,84 @@ ZeroCopyOpenSSL::Ctx::~Ctx(){
 
 }
 
+int ZeroCopyOpenSSL::Ctx::newSessionCb(SSL * ssl, SSL_SESSION * session) {
+
+    ZeroCopyOpenSSL * e = static_cast<ZeroCopyOpenSSL *>(SSL_get_app_data(ssl));
+
+    if (!e || e->sessionKey_.empty()) {
+        return 0;
+    }
+
+    e->ctx_->storeSession(e->sessionKey_, session);
+
+    /* we keep the reference */
+    return 1;
+}
+
+bool ZeroCopyOpenSSL::Ctx::resumeSession(
+        SSL * ssl,
+        std::string const & key
+    ) {
+
+    bool offered = false;
+
+    uv_mutex_lock(&sessionMutex_);
+    std::map<std::string, SSL_SESSION *>::iterator it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        offered = (1 == SSL_set_session(ssl, it->second));
+    }
+    uv_mutex_unlock(&sessionMutex_);
+
+    LOG(DEBUG2) << (offered ? "Resuming" : "No") << " TLS session for " << key;
+
+    return offered;
+}
+
+void ZeroCopyOpenSSL::Ctx::storeSession(
+        std::string const & key,
+        SSL_SESSION * session
+    ) {
+
+    uv_mutex_lock(&sessionMutex_);
+    SSL_SESSION * & slot = sessions_[key];
+    if (slot) {
+        SSL_SESSION_free(slot);
+    }
+    slot = session;
+    uv_mutex_unlock(&sessionMutex_);
+}
+
+void ZeroCopyOpenSSL::Ctx::forgetSession(
+        std::string const & key
+    ) {
+
+    uv_mutex_lock(&sessionMutex_);
+    std::map<std::string, SSL_SESSION *>::iterator it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        SSL_SESSION_free(it->second);
+        sessions_.erase(it);
+    }
+    uv_mutex_unlock(&sessionMutex_);
+}
+
+void ZeroCopyOpenSSL::Ctx::getHandshakeCounts(
+        std::string const & key,
+        uint64_t & full,
+        uint64_t & resumed
+    ) const {
+
+    full = resumed = 0;
+
+    uv_mutex_lock(&sessionMutex_);
+    std::map<std::string, std::pair<uint64_t, uint64_t> >::const_iterator it =
+        handshakes_.find(key);
+    if (it != handshakes_.end()) {
+        full = it->second.first;
+        resumed = it->second.second;
+    }
+    uv_mutex_unlock(&sessionMutex_);
+}
+
 size_t ZeroCopyOpenSSL::Ctx::addCaFileOrDirectory(
         char const * caFileOrDirectory
     ) {
@@ -853,6 +1044,18 @@ ZeroCopyOpenSSL::Ctx * ZeroCopyOpenSSL::Ctx::createCtx(
 
             SSL_CTX_set_info_callback(sslCtx, infoCallback);
 
+            /* Resume sessions on reconnect. Servers keep their own cache and
+             * issue tickets; clients cache the last session per endpoint
+             * through the new session callback.
+             */
+            SSL_CTX_set_session_cache_mode(sslCtx,
+                    SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_CLIENT);
+            SSL_CTX_sess_set_new_cb(sslCtx, newSessionCb);
+            (void) SSL_CTX_set_session_id_context(
+                    sslCtx,
+                    SESSION_ID_CONTEXT,
+                    sizeof(SESSION_ID_CONTEXT) - 1);
+
             /* just ask for a certificate from the peer anyway */
             (void) SSL_CTX_set_verify(
                     sslCtx,
@@ -895,7 +1098,8 @@ void ZeroCopyOpenSSL::Ctx::setNoVerify(
 bool ZeroCopyOpenSSL::attachTransport(
         yajr::Peer * p,
         ZeroCopyOpenSSL::Ctx * ctx,
-        bool inverted_roles) {
+        bool inverted_roles,
+        char const * sessionKey) {
 
     if (!ctx) {
         return false;
@@ -908,7 +1112,7 @@ bool ZeroCopyOpenSSL::attachTransport(
     }
 
     ZeroCopyOpenSSL * const e = new (std::nothrow)
-        ZeroCopyOpenSSL(ctx, peer->passive_ ^ inverted_roles);
+        ZeroCopyOpenSSL(ctx, peer->passive_ ^ inverted_roles, sessionKey);
 
     if (!e) {
         return false;
@@ -46,6 +46,9 @@ void GbpOpflexServer::enableSSL(const std::string& caStorePath,
     pimpl->enableSSL(caStorePath, serverKeyPath,
                      serverKeyPass, verifyPeers);
 }
+void GbpOpflexServer::setListenerLoops(size_t loops) {
+    pimpl->setListenerLoops(loops);
+}
 void GbpOpflexServer::start() {
     pimpl->start();
 }
@@ -111,6 +114,10 @@ void GbpOpflexServerImpl::enableSSL(const std::string& caStorePath,
                        serverKeyPass, verifyPeers);
 }
 
+void GbpOpflexServerImpl::setListenerLoops(size_t loops) {
+    listener.setListenerLoops(loops);
+}
+
 void GbpOpflexServerImpl::start() {
     db.start();
     prr_timer.reset(new deadline_timer(io, seconds(prr_interval_secs)));
@@ -184,12 +191,15 @@ public:
     PolicyUpdateReq(GbpOpflexServerImpl& server_,
                     const std::vector<modb::reference_t>& replace_,
                     const std::vector<modb::reference_t>& merge_children_,
-                    const std::vector<modb::reference_t>& del_)
+                    const std::vector<modb::reference_t>& del_,
+                    const OpflexServerConnection::delta_map_t& update_ =
+                    OpflexServerConnection::delta_map_t())
         : OpflexMessage("policy_update", REQUEST),
           server(server_),
           replace(replace_),
           merge_children(merge_children_),
-          del(del_) {}
+          del(del_),
+          update(update_) {}
 
     virtual void serializePayload(yajr::rpc::SendHandler& writer) const {
         (*this)(writer);
@@ -238,6 +248,22 @@ public:
         }
         writer.EndArray();
 
+        // only sent to peers that advertised policyDelta
+        if (!update.empty()) {
+            writer.String("update_properties");
+            writer.StartArray();
+            BOOST_FOREACH(const OpflexServerConnection::delta_map_t::value_type& p,
+                          update) {
+                try {
+                    serializer.serializeDelta(p.first.first, p.first.second,
+                                              *client, writer, p.second);
+                } catch (const std::out_of_range& e) {
+                    // removed since the update was queued
+                }
+            }
+            writer.EndArray();
+        }
+
         writer.EndObject();
         writer.EndArray();
         return true;
@@ -248,6 +274,7 @@ protected:
     std::vector<modb::reference_t> replace;
     std::vector<modb::reference_t> merge_children;
     std::vector<modb::reference_t> del;
+    OpflexServerConnection::delta_map_t update;
 };
 
 void GbpOpflexServerImpl::policyUpdate(const std::vector<modb::reference_t>& replace,
@@ -261,9 +288,10 @@ void GbpOpflexServerImpl::policyUpdate(const std::vector<modb::reference_t>& rep
 void GbpOpflexServerImpl::policyUpdate(OpflexServerConnection* conn,
                                        const std::vector<modb::reference_t>& replace,
                                        const std::vector<modb::reference_t>& merge_children,
-                                       const std::vector<modb::reference_t>& del) {
+                                       const std::vector<modb::reference_t>& del,
+                                       const OpflexServerConnection::delta_map_t& delta) {
     PolicyUpdateReq* req =
-        new PolicyUpdateReq(*this, replace, merge_children, del);
+        new PolicyUpdateReq(*this, replace, merge_children, del, delta);
     listener.sendToOne(conn, req);
 }
 
@@ -338,6 +366,13 @@ void GbpOpflexServerImpl::remoteObjectUpdated(modb::class_id_t class_id,
     listener.addPendingUpdate(class_id, uri, op);
 }
 
+void GbpOpflexServerImpl::remotePropertiesUpdated(modb::class_id_t class_id,
+                                                  const modb::URI& uri,
+                                                  gbp::PolicyUpdateOp op,
+                                                  const OF_UNORDERED_SET<modb::prop_id_t>& props) {
+    listener.addPendingDelta(class_id, uri, op, props);
+}
+
 } /* namespace internal */
 } /* namespace engine */
 } /* namespace opflex */
@@ -107,6 +107,132 @@ void MOSerializer::deserialize_enum(modb::mointernal::StoreClient& client,
     }
 }
 
+void MOSerializer::deserialize_props(const ClassInfo& ci,
+                                     const rapidjson::Value& properties,
+                                     StoreClient& client,
+                                     ObjectInstance& oi,
+                                     bool replace) {
+    if (!properties.IsArray()) return;
+    for (SizeType i = 0; i < properties.Size(); ++i) {
+        const Value& prop = properties[i];
+        if (!prop.IsObject() ||
+            !prop.HasMember("name") ||
+            !prop.HasMember("data"))
+            continue;
+
+        const Value& pname = prop["name"];
+        if (!pname.IsString())
+            continue;
+        const Value& pvalue = prop["data"];
+
+        try {
+            const PropertyInfo& pinfo =
+                ci.getProperty(pname.GetString());
+            if (replace)
+                oi.unset(pinfo.getId(), pinfo.getType(),
+                         pinfo.getCardinality());
+            switch (pinfo.getType()) {
+            case PropertyInfo::STRING:
+                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                    if (!pvalue.IsArray()) continue;
+                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                        const Value& v = pvalue[j];
+                        if (!v.IsString()) continue;
+                        oi.addString(pinfo.getId(), v.GetString());
+                    }
+                } else {
+                    if (!pvalue.IsString()) continue;
+                    oi.setString(pinfo.getId(),
+                                 pvalue.GetString());
+                }
+                break;
+            case PropertyInfo::REFERENCE:
+                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                    if (!pvalue.IsArray()) continue;
+                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                        const Value& v = pvalue[j];
+                        deserialize_ref(client, pinfo, v, oi, false);
+                    }
+                } else {
+                    deserialize_ref(client, pinfo, pvalue, oi, true);
+                }
+                break;
+            case PropertyInfo::S64:
+                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                    if (!pvalue.IsArray()) continue;
+                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                        const Value& v = pvalue[j];
+                        if (!v.IsInt64()) continue;
+                        oi.addInt64(pinfo.getId(), v.GetInt64());
+                    }
+                } else {
+                    if (!pvalue.IsInt64()) continue;
+                    oi.setInt64(pinfo.getId(),
+                                pvalue.GetInt64());
+                }
+                break;
+            case PropertyInfo::ENUM8:
+            case PropertyInfo::ENUM16:
+            case PropertyInfo::ENUM32:
+            case PropertyInfo::ENUM64:
+                {
+                    if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                        if (!pvalue.IsArray()) continue;
+                        for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                            const Value& v = pvalue[j];
+                            deserialize_enum(client, pinfo, v, oi, false);
+                        }
+                    } else {
+                        deserialize_enum(client, pinfo, pvalue, oi, true);
+                    }
+                }
+                break;
+            case PropertyInfo::U64:
+                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                    if (!pvalue.IsArray()) continue;
+                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                        const Value& v = pvalue[j];
+                        if (!v.IsUint64()) continue;
+                        oi.addUInt64(pinfo.getId(), v.GetUint64());
+                    }
+                } else {
+                    if (!pvalue.IsUint64()) continue;
+                    oi.setUInt64(pinfo.getId(),
+                                 pvalue.GetUint64());
+                }
+                break;
+            case PropertyInfo::MAC:
+                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
+                    if (!pvalue.IsArray()) continue;
+                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
+                        const Value& v = pvalue[j];
+                        if (!v.IsString()) continue;
+                        oi.addMAC(pinfo.getId(), MAC(v.GetString()));
+                    }
+                } else {
+                    oi.setMAC(pinfo.getId(),
+                              MAC(pvalue.GetString()));
+                }
+                break;
+            case PropertyInfo::COMPOSITE:
+                // do nothing;
+                break;
+            }
+        } catch (const std::invalid_argument& e) {
+            LOG(DEBUG) << "Invalid property "
+                       << pname.GetString()
+                       << " in class "
+                       << ci.getName();
+        } catch (const std::out_of_range& e) {
+            LOG(DEBUG) << "Unknown property "
+                       << pname.GetString()
+                       << " in class "
+                       << ci.getName();
+            // ignore property
+        }
+    }
+}
+
 void MOSerializer::deserialize(const rapidjson::Value& mo,
                                modb::mointernal::StoreClient& client,
                                bool replaceChildren,
@@ -127,126 +253,20 @@ void MOSerializer::deserialize(const rapidjson::Value& mo,
             OF_MAKE_SHARED<ObjectInstance>(ci.getId(), false);
         if (mo.HasMember("properties")) {
             const Value& properties = mo["properties"];
-            if (properties.IsArray()) {
-                for (SizeType i = 0; i < properties.Size(); ++i) {
-                    const Value& prop = properties[i];
-                    if (!prop.IsObject() ||
-                        !prop.HasMember("name") ||
-                        !prop.HasMember("data"))
-                        continue;
-
-                    const Value& pname = prop["name"];
-                    if (!pname.IsString())
-                        continue;
-                    const Value& pvalue = prop["data"];
+            deserialize_props(ci, properties, client, *oi, false);
+        }
 
-                    try {
-                        const PropertyInfo& pinfo =
-                            ci.getProperty(pname.GetString());
-                        switch (pinfo.getType()) {
-                        case PropertyInfo::STRING:
-                            if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                if (!pvalue.IsArray()) continue;
-                                for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                    const Value& v = pvalue[j];
-                                    if (!v.IsString()) continue;
-                                    oi->addString(pinfo.getId(), v.GetString());
-                                }
-                            } else {
-                                if (!pvalue.IsString()) continue;
-                                oi->setString(pinfo.getId(),
-                                              pvalue.GetString());
-                            }
-                            break;
-                        case PropertyInfo::REFERENCE:
-                            if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                if (!pvalue.IsArray()) continue;
-                                for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                    const Value& v = pvalue[j];
-                                    deserialize_ref(client, pinfo, v, *oi, false);
-                                }
-                            } else {
-                                deserialize_ref(client, pinfo, pvalue, *oi, true);
-                            }
-                            break;
-                        case PropertyInfo::S64:
-                            if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                if (!pvalue.IsArray()) continue;
-                                for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                    const Value& v = pvalue[j];
-                                    if (!v.IsInt64()) continue;
-                                    oi->addInt64(pinfo.getId(), v.GetInt64());
-                                }
-                            } else {
-                                if (!pvalue.IsInt64()) continue;
-                                oi->setInt64(pinfo.getId(),
-                                             pvalue.GetInt64());
-                            }
-                            break;
-                        case PropertyInfo::ENUM8:
-                        case PropertyInfo::ENUM16:
-                        case PropertyInfo::ENUM32:
-                        case PropertyInfo::ENUM64:
-                            {
-                                if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                    if (!pvalue.IsArray()) continue;
-                                    for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                        const Value& v = pvalue[j];
-                                        deserialize_enum(client, pinfo, v, *oi, false);
-                                    }
-                                } else {
-                                    deserialize_enum(client, pinfo, pvalue, *oi, true);
-                                }
-                            }
-                            break;
-                        case PropertyInfo::U64:
-                            if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                if (!pvalue.IsArray()) continue;
-                                for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                    const Value& v = pvalue[j];
-                                    if (!v.IsUint64()) continue;
-                                    oi->addUInt64(pinfo.getId(), v.GetUint64());
-                                }
-                            } else {
-                                if (!pvalue.IsUint64()) continue;
-                                oi->setUInt64(pinfo.getId(),
-                                              pvalue.GetUint64());
-                            }
-                            break;
-                        case PropertyInfo::MAC:
-                            if (pinfo.getCardinality() == PropertyInfo::VECTOR) {
-                                if (!pvalue.IsArray()) continue;
-                                for (SizeType j = 0; j < pvalue.Size(); ++j) {
-                                    const Value& v = pvalue[j];
-                                    if (!v.IsString()) continue;
-                                    oi->addMAC(pinfo.getId(), MAC(v.GetString()));
-                                }
-                            } else {
-                                oi->setMAC(pinfo.getId(),
-                                           MAC(pvalue.GetString()));
-                            }
-                            break;
-                        case PropertyInfo::COMPOSITE:
-                            // do nothing;
-                            break;
-                        }
-                    } catch (const std::invalid_argument& e) {
-                        LOG(DEBUG) << "Invalid property "
-                                   << pname.GetString()
-                                   << " in class "
-                                   << ci.getName();
-                    } catch (const std::out_of_range& e) {
-                        LOG(DEBUG) << "Unknown property "
-                                   << pname.GetString()
-                                   << " in class "
-                                   << ci.getName();
-                        // ignore property
-                    }
-                }
-            }
+        // keep the previous version so the listener can be told
+        // which properties changed
+        OF_SHARED_PTR<const ObjectInstance> prevoi;
+        if (listener) {
+            try {
+                prevoi = client.get(ci.getId(), uri);
+            } catch (const std::out_of_range& e) {}
         }
 
         bool remoteUpdated = false;
+        bool childrenRemoved = false;
         if (client.putIfModified(ci.getId(), uri, oi)) {
             remoteUpdated = true;
         }
@@ -323,6 +343,7 @@ void MOSerializer::deserialize(const rapidjson::Value& mo,
                                 if (notifs)
                                     (*notifs)[child] = it->second.getClassId();
                                 remoteUpdated = true;
+                                childrenRemoved = true;
                             } catch (const std::out_of_range& e) {
                                 // most likely already removed by
                                 // another thread
@@ -339,10 +360,91 @@ void MOSerializer::deserialize(const rapidjson::Value& mo,
                 client.queueNotification(ci.getId(), uri, *notifs);
             PolicyUpdateOp op = replaceChildren ? PolicyUpdateOp::REPLACE
                                                 : PolicyUpdateOp::ADD;
-            if (listener)
-                listener->remoteObjectUpdated(ci.getId(), uri, op);
+            if (listener) {
+                if (prevoi && !childrenRemoved) {
+                    OF_UNORDERED_SET<modb::prop_id_t> changed;
+                    oi->getChangedProperties(*prevoi, changed);
+                    listener->remotePropertiesUpdated(ci.getId(), uri,
+                                                      op, changed);
+                } else {
+                    listener->remoteObjectUpdated(ci.getId(), uri, op);
+                }
+            }
+        }
+
+    } catch (const std::invalid_argument& e) {
+        // ignore invalid URIs
+        LOG(DEBUG) << "Could not deserialize invalid object of class "
+                   << classv.GetString();
+    } catch (const std::out_of_range& e) {
+        // ignore unknown class
+        LOG(DEBUG) << "Could not deserialize object of unknown class "
+                   << classv.GetString();
+    }
+}
+
+bool MOSerializer::deserializeDelta(const rapidjson::Value& mo,
+                                    StoreClient& client,
+                                    /* out */ StoreClient::notif_t* notifs) {
+    if (!mo.IsObject()
+        || !mo.HasMember("uri")
+        || !mo.HasMember("subject")) return true;
+
+    const Value& uriv = mo["uri"];
+    if (!uriv.IsString()) return true;
+    const Value& classv = mo["subject"];
+    if (!classv.IsString()) return true;
+
+    try {
+        URI uri(uriv.GetString());
+        const ClassInfo& ci = store->getClassInfo(classv.GetString());
+        OF_SHARED_PTR<const ObjectInstance> prevoi;
+        try {
+            prevoi = client.get(ci.getId(), uri);
+        } catch (const std::out_of_range& e) {
+            LOG(DEBUG) << "Cannot apply property update to missing object "
+                       << uri;
+            return false;
         }
 
+        // start from the current object so the children and any
+        // properties not in the update are kept
+        OF_SHARED_PTR<ObjectInstance> oi =
+            OF_MAKE_SHARED<ObjectInstance>(*prevoi);
+        if (mo.HasMember("unset")) {
+            const Value& unset = mo["unset"];
+            if (unset.IsArray()) {
+                for (SizeType i = 0; i < unset.Size(); ++i) {
+                    const Value& pname = unset[i];
+                    if (!pname.IsString()) continue;
+                    try {
+                        const PropertyInfo& pinfo =
+                            ci.getProperty(pname.GetString());
+                        oi->unset(pinfo.getId(), pinfo.getType(),
+                                  pinfo.getCardinality());
+                    } catch (const std::out_of_range& e) {
+                        // ignore unknown property
+                    }
+                }
+            }
+        }
+        if (mo.HasMember("properties")) {
+            const Value& properties = mo["properties"];
+            deserialize_props(ci, properties, client, *oi, true);
+        }
+
+        if (client.putIfModified(ci.getId(), uri, oi)) {
+            LOG(DEBUG2) << "Updated properties of object " << uri;
+            if (notifs)
+                client.queueNotification(ci.getId(), uri, *notifs);
+            if (listener) {
+                OF_UNORDERED_SET<modb::prop_id_t> changed;
+                oi->getChangedProperties(*prevoi, changed);
+                listener->remotePropertiesUpdated(ci.getId(), uri,
+                                                  PolicyUpdateOp::ADD,
+                                                  changed);
+            }
+        }
     } catch (const std::invalid_argument& e) {
         // ignore invalid URIs
         LOG(DEBUG) << "Could not deserialize invalid object of class "
@@ -352,6 +454,7 @@ void MOSerializer::deserialize(const rapidjson::Value& mo,
         LOG(DEBUG) << "Could not deserialize object of unknown class "
                    << classv.GetString();
     }
+    return true;
 }
 
 static void getRoots(ObjectStore* store, Region::obj_set_t& roots) {
@@ -412,6 +515,93 @@ void MOSerializer::dumpMODB(const std::string& file) {
     LOG(INFO) << "Wrote MODB to " << file;
 }
 
+template <typename T>
+void MOSerializer::serializeRemote(modb::class_id_t class_id,
+                                  const URI& uri,
+                                  StoreClient& client,
+                                  T& writer,
+                                  size_t& count) {
+    const ClassInfo& ci = store->getClassInfo(class_id);
+    OF_SHARED_PTR<const ObjectInstance> oi = client.get(class_id, uri);
+    if (!oi->isLocal()) {
+        serialize(class_id, uri, client, writer, false);
+        count += 1;
+    }
+
+    // nonlocal objects can live under local parents such as the
+    // universes, so always descend
+    BOOST_FOREACH(const ClassInfo::property_map_t::value_type& p,
+                  ci.getProperties()) {
+        if (p.second.getType() != PropertyInfo::COMPOSITE)
+            continue;
+        vector<URI> children;
+        client.getChildren(class_id, uri, p.first,
+                           p.second.getClassId(), children);
+        BOOST_FOREACH(const URI& child, children) {
+            try {
+                serializeRemote(p.second.getClassId(), child,
+                                client, writer, count);
+            } catch (const std::out_of_range& e) {
+                // removed while we were walking the tree
+            }
+        }
+    }
+}
+
+size_t MOSerializer::dumpSnapshot(FILE* pfile) {
+    Region::obj_set_t roots;
+    getRoots(store, roots);
+    char buffer[4096];
+    rapidjson::FileWriteStream ws(pfile, buffer, sizeof(buffer));
+    rapidjson::Writer<rapidjson::FileWriteStream> writer(ws);
+    writer.StartArray();
+    StoreClient& client = store->getReadOnlyStoreClient();
+    size_t count = 0;
+    BOOST_FOREACH(Region::obj_set_t::value_type r, roots) {
+        try {
+            serializeRemote(r.first, r.second, client, writer, count);
+        } catch (const std::out_of_range& e) { }
+    }
+    writer.EndArray();
+    ws.Flush();
+    fwrite("\n", 1, 1, pfile);
+    return count;
+}
+
+size_t MOSerializer::readSnapshot(FILE* pfile, StoreClient& client,
+                                  StoreClient::notif_t& notifs,
+                                  vector<modb::reference_t>& loaded) {
+    char buffer[4096];
+    rapidjson::FileReadStream f(pfile, buffer, sizeof(buffer));
+    rapidjson::Document d;
+    d.ParseStream<0, rapidjson::UTF8<>, rapidjson::FileReadStream>(f);
+    if (!d.IsArray()) {
+        LOG(ERROR) << "Malformed snapshot file: not an array";
+        return 0;
+    }
+    rapidjson::Value::ConstValueIterator moit;
+    for (moit = d.Begin(); moit != d.End(); ++ moit) {
+        const rapidjson::Value& mo = *moit;
+        if (!mo.IsObject() ||
+            !mo.HasMember("uri") || !mo["uri"].IsString() ||
+            !mo.HasMember("subject") || !mo["subject"].IsString())
+            continue;
+        try {
+            URI uri(mo["uri"].GetString());
+            const ClassInfo& ci = store->getClassInfo(mo["subject"].GetString());
+            if (client.isPresent(ci.getId(), uri))
+                continue;
+            deserialize(mo, client, false, &notifs);
+            if (client.isPresent(ci.getId(), uri))
+                loaded.emplace_back(ci.getId(), uri);
+        } catch (const std::invalid_argument& e) {
+        } catch (const std::out_of_range& e) {
+            // class no longer in the model
+        }
+    }
+    return loaded.size();
+}
+
 size_t MOSerializer::readMOs(FILE* pfile, StoreClient& client) {
     char buffer[1024];
     rapidjson::FileReadStream f(pfile, buffer, sizeof(buffer));
@@ -40,7 +40,7 @@ OpflexClientConnection::OpflexClientConnection(HandlerFactory& handlerFactory,
     : OpflexConnection(handlerFactory),
       pool(pool_), hostname(hostname_), port(port_), role(0), peer(NULL),
       started(false), active(false), closing(false), ready(false),
-      failureCount(0), handshake_timer(NULL) {
+      failureCount(0), loop_index(0), handshake_timer(NULL) {
     opflexStats = OF_MAKE_SHARED<OFStats>();
 }
 
@@ -73,7 +73,7 @@ void OpflexClientConnection::connect() {
     ready = false;
 
     handshake_timer = new uv_timer_t;
-    uv_timer_init(pool->client_loop, handshake_timer);
+    uv_timer_init(pool->getLoop(this), handshake_timer);
     handshake_timer->data = this;
 
     pool->updatePeerStatus(hostname, port, PeerStatusListener::CONNECTING);
@@ -120,7 +120,7 @@ void OpflexClientConnection::close() {
 
 uv_loop_t* OpflexClientConnection::loop_selector(void * data) {
     auto conn = (OpflexClientConnection*)data;
-    return conn->getPool()->getLoop();
+    return conn->getPool()->getLoop(conn);
 }
 
 void OpflexClientConnection::on_handshake_timer(uv_timer_t* handle) {
@@ -149,8 +149,13 @@ void OpflexClientConnection::on_state_change(Peer * p, void * data,
         uv_timer_start(conn->handshake_timer,
                        on_handshake_timer, conn->getHandshakeTimeout(), 0);
 
-        if (conn->pool->clientCtx.get())
-            ZeroCopyOpenSSL::attachTransport(p, conn->pool->clientCtx.get());
+        if (conn->pool->clientCtx.get()) {
+            // cache the TLS session per peer so reconnects can resume it
+            const std::string sessionKey =
+                conn->hostname + ":" + std::to_string(conn->port);
+            ZeroCopyOpenSSL::attachTransport(p, conn->pool->clientCtx.get(),
+                                             false, sessionKey.c_str());
+        }
         p->startKeepAlive(10000, 15000, 60000);
 
         conn->pool->updatePeerStatus(conn->hostname, conn->port,
@@ -211,7 +216,7 @@ void OpflexClientConnection::connectionFailure() {
 }
 
 void OpflexClientConnection::messagesReady() {
-    pool->messagesReady();
+    pool->messagesReady(this);
 }
 
 } /* namespace internal */
@@ -19,6 +19,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/filesystem.hpp>
 
 #include "opflex/engine/internal/OpflexListener.h"
 #include "opflex/engine/internal/OpflexPool.h"
@@ -40,7 +41,7 @@ OpflexListener::OpflexListener(HandlerFactory& handlerFactory_,
                                const std::string& name_,
                                const std::string& domain_)
     : handlerFactory(handlerFactory_), port(port_),
-      name(name_), domain(domain_), active(true) {
+      name(name_), domain(domain_), active(true), nloops(1) {
     uv_mutex_init(&conn_mutex);
     uv_key_create(&conn_mutex_key);
 }
@@ -50,7 +51,7 @@ OpflexListener::OpflexListener(HandlerFactory& handlerFactory_,
                                const std::string& name_,
                                const std::string& domain_)
     : handlerFactory(handlerFactory_), socketName(socketName_),
-      port(0), name(name_), domain(domain_), active(true) {
+      port(0), name(name_), domain(domain_), active(true), nloops(1) {
     uv_mutex_init(&conn_mutex);
     uv_key_create(&conn_mutex_key);
 }
@@ -76,64 +77,91 @@ void OpflexListener::enableSSL(const std::string& caStorePath,
 }
 
 void OpflexListener::on_cleanup_async(uv_async_t* handle) {
-    OpflexListener* listener = (OpflexListener*)handle->data;
+    ListenerLoop* loop = (ListenerLoop*)handle->data;
+    OpflexListener* listener = loop->owner;
 
     {
         util::RecursiveLockGuard guard(&listener->conn_mutex,
                                        &listener->conn_mutex_key);
-        conn_set_t conns(listener->conns);
+        conn_set_t conns(loop->conns);
         BOOST_FOREACH(OpflexServerConnection* conn, conns) {
             conn->close();
         }
-        if (!listener->conns.empty()) return;
+        if (!loop->conns.empty()) return;
     }
 
-    uv_close((uv_handle_t*)&listener->writeq_async, NULL);
+    uv_close((uv_handle_t*)&loop->writeq_async, NULL);
     uv_close((uv_handle_t*)handle, NULL);
-    yajr::finiLoop(&listener->server_loop);
+    yajr::finiLoop(&loop->server_loop);
 }
 
 void OpflexListener::on_writeq_async(uv_async_t* handle) {
-    OpflexListener* listener = (OpflexListener*)handle->data;
+    ListenerLoop* loop = (ListenerLoop*)handle->data;
+    OpflexListener* listener = loop->owner;
     util::RecursiveLockGuard guard(&listener->conn_mutex,
                                    &listener->conn_mutex_key);
-    BOOST_FOREACH(OpflexServerConnection* conn, listener->conns) {
+    BOOST_FOREACH(OpflexServerConnection* conn, loop->conns) {
         conn->processWriteQueue();
     }
 }
 
+void OpflexListener::setListenerLoops(size_t loops_) {
+    nloops = loops_ > 0 ? loops_ : 1;
+}
+
 void OpflexListener::listen() {
     int rc;
-    uv_loop_init(&server_loop);
-    cleanup_async.data = this;
-    writeq_async.data = this;
-    uv_async_init(&server_loop, &cleanup_async, on_cleanup_async);
-    uv_async_init(&server_loop, &writeq_async, on_writeq_async);
-
-    yajr::initLoop(&server_loop);
-
-    if (!socketName.empty()) {
-        listener =
-            yajr::Listener::create(socketName,
-                                   OpflexServerConnection::on_state_change,
-                                   on_new_connection,
-                                   this,
-                                   &server_loop,
-                                   OpflexServerConnection::loop_selector);
-    } else {
-        listener =
-            yajr::Listener::create("0.0.0.0", port,
-                                   OpflexServerConnection::on_state_change,
-                                   on_new_connection,
-                                   this,
-                                   &server_loop,
-                                   OpflexServerConnection::loop_selector);
-    }
-
-    rc = uv_thread_create(&server_thread, server_thread_func, this);
-    if (rc < 0) {
-        throw std::runtime_error(string("Could not create server thread: ") +
-                                 uv_strerror(rc));
+
+    if (!socketName.empty() && nloops > 1) {
+        LOG(WARNING) << "Multiple listener loops are only supported "
+                     << "for TCP listeners; using one loop for "
+                     << socketName;
+        nloops = 1;
+    }
+
+    for (size_t i = 0; i < nloops; ++i) {
+        boost::shared_ptr<ListenerLoop> loop(new ListenerLoop());
+        loop->owner = this;
+        loop->index = i;
+        loop->listener = NULL;
+        uv_loop_init(&loop->server_loop);
+        loop->cleanup_async.data = loop.get();
+        loop->writeq_async.data = loop.get();
+        uv_async_init(&loop->server_loop, &loop->cleanup_async,
+                      on_cleanup_async);
+        uv_async_init(&loop->server_loop, &loop->writeq_async,
+                      on_writeq_async);
+
+        yajr::initLoop(&loop->server_loop);
+
+        if (!socketName.empty()) {
+            loop->listener =
+                yajr::Listener::create(socketName,
+                                       OpflexServerConnection::on_state_change,
+                                       on_new_connection,
+                                       loop.get(),
+                                       &loop->server_loop,
+                                       OpflexServerConnection::loop_selector);
+        } else {
+            loop->listener =
+                yajr::Listener::create("0.0.0.0", port,
+                                       OpflexServerConnection::on_state_change,
+                                       on_new_connection,
+                                       loop.get(),
+                                       &loop->server_loop,
+                                       OpflexServerConnection::loop_selector,
+                                       nloops > 1);
+        }
+        loops.push_back(loop);
+    }
+
+    BOOST_FOREACH(boost::shared_ptr<ListenerLoop>& loop, loops) {
+        rc = uv_thread_create(&loop->server_thread, server_thread_func,
+                              loop.get());
+        if (rc < 0) {
+            throw std::runtime_error(string("Could not create server thread: ") +
+                                     uv_strerror(rc));
+        }
     }
 }
 
@@ -141,14 +169,18 @@ void OpflexListener::disconnect() {
     if (!active) return;
     active = false;
 
-    uv_async_send(&cleanup_async);
-    uv_thread_join(&server_thread);
-    uv_loop_close(&server_loop);
+    BOOST_FOREACH(boost::shared_ptr<ListenerLoop>& loop, loops) {
+        uv_async_send(&loop->cleanup_async);
+    }
+    BOOST_FOREACH(boost::shared_ptr<ListenerLoop>& loop, loops) {
+        uv_thread_join(&loop->server_thread);
+        uv_loop_close(&loop->server_loop);
+    }
 }
 
-void OpflexListener::server_thread_func(void* listener_) {
-    OpflexListener* processor = (OpflexListener*)listener_;
-    uv_run(&processor->server_loop, UV_RUN_DEFAULT);
+void OpflexListener::server_thread_func(void* loop_) {
+    ListenerLoop* loop = (ListenerLoop*)loop_;
+    uv_run(&loop->server_loop, UV_RUN_DEFAULT);
 }
 
 void* OpflexListener::on_new_connection(yajr::Listener* ylistener,
@@ -159,31 +191,41 @@ void* OpflexListener::on_new_connection(yajr::Listener* ylistener,
         return NULL;
     }
 
-    OpflexListener* listener = (OpflexListener*)data;
+    ListenerLoop* loop = (ListenerLoop*)data;
+    OpflexListener* listener = loop->owner;
     util::RecursiveLockGuard guard(&listener->conn_mutex,
                                    &listener->conn_mutex_key);
     boost::unique_lock<boost::mutex> serverConnGuard(serverConnectionMutex);
     OpflexServerConnection* conn = new OpflexServerConnection(listener);
+    conn->loop_index = loop->index;
     listener->conns.insert(conn);
+    loop->conns.insert(conn);
     return conn;
 }
 
 void OpflexListener::connectionClosed(OpflexServerConnection* conn) {
     util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
+    ListenerLoop* loop = loops[conn->loop_index].get();
+    conn->clearSubscriptions();
     conns.erase(conn);
+    loop->conns.erase(conn);
+    pending_conns.erase(conn);
     delete conn;
     guard.release();
     if (!active)
-        uv_async_send(&cleanup_async);
+        uv_async_send(&loop->cleanup_async);
 }
 
 void OpflexListener::sendToAll(OpflexMessage* message) {
     boost::scoped_ptr<OpflexMessage> messagep(message);
     util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
     if (!active) return;
+    if (conns.size() > 1) {
+        // Serialize the payload once and share it between the clones
+        messagep.reset(new PreparedOpflexMessage(*message));
+    }
     BOOST_FOREACH(OpflexServerConnection* conn, conns) {
-        // this is inefficient but we only use this for testing
-        conn->sendMessage(message->clone());
+        conn->sendMessage(messagep->clone());
     }
 }
 
@@ -194,23 +236,84 @@ void OpflexListener::sendToOne(OpflexServerConnection* conn, OpflexMessage* mess
     conn->sendMessage(message->clone());
 }
 
+void OpflexListener::subscribe(const modb::URI& uri,
+                               OpflexServerConnection* conn) {
+    std::lock_guard<std::mutex> lock(sub_mutex);
+    subscriptions[uri].insert(conn);
+}
+
+void OpflexListener::unsubscribe(const modb::URI& uri,
+                                 OpflexServerConnection* conn) {
+    std::lock_guard<std::mutex> lock(sub_mutex);
+    sub_map_t::iterator it = subscriptions.find(uri);
+    if (it == subscriptions.end()) return;
+    it->second.erase(conn);
+    if (it->second.empty())
+        subscriptions.erase(it);
+}
+
+void OpflexListener::getSubscribers(const modb::URI& uri,
+                                    conn_set_t& subscribers) {
+    std::lock_guard<std::mutex> lock(sub_mutex);
+    if (subscriptions.empty()) return;
+
+    sub_map_t::const_iterator it = subscriptions.find(uri);
+    if (it != subscriptions.end())
+        subscribers.insert(it->second.begin(), it->second.end());
+
+    // A subscription to an ancestor covers the whole subtree
+    boost::filesystem::path puri(uri.toString());
+    puri = puri.parent_path();
+    while (!puri.empty() && puri != "/") {
+        it = subscriptions.find(modb::URI(puri.string() + "/"));
+        if (it != subscriptions.end())
+            subscribers.insert(it->second.begin(), it->second.end());
+        puri = puri.parent_path();
+    }
+}
+
 void OpflexListener::addPendingUpdate(opflex::modb::class_id_t class_id,
                                       const opflex::modb::URI& uri,
                                       opflex::gbp::PolicyUpdateOp op) {
     if (!active) return;
-    BOOST_FOREACH(OpflexServerConnection* conn, conns) {
-        if (conn->getUri(uri))
-            conn->addPendingUpdate(class_id, uri, op);
-        else
-            LOG(DEBUG) << "could not find uri " << uri;
+    util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
+    conn_set_t subscribers;
+    getSubscribers(uri, subscribers);
+    if (subscribers.empty()) {
+        LOG(DEBUG) << "could not find uri " << uri;
+        return;
+    }
+    BOOST_FOREACH(OpflexServerConnection* conn, subscribers) {
+        conn->addPendingUpdate(class_id, uri, op);
+        pending_conns.insert(conn);
+    }
+}
+
+void OpflexListener::addPendingDelta(opflex::modb::class_id_t class_id,
+                                     const opflex::modb::URI& uri,
+                                     opflex::gbp::PolicyUpdateOp op,
+                                     const OF_UNORDERED_SET<modb::prop_id_t>& props) {
+    if (!active) return;
+    util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
+    conn_set_t subscribers;
+    getSubscribers(uri, subscribers);
+    if (subscribers.empty()) {
+        LOG(DEBUG) << "could not find uri " << uri;
+        return;
+    }
+    BOOST_FOREACH(OpflexServerConnection* conn, subscribers) {
+        conn->addPendingDelta(class_id, uri, op, props);
+        pending_conns.insert(conn);
     }
 }
 
 void OpflexListener::sendUpdates() {
     if (!active) return;
-    BOOST_FOREACH(OpflexServerConnection* conn, conns) {
+    util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
+    BOOST_FOREACH(OpflexServerConnection* conn, pending_conns) {
         conn->sendUpdates();
     }
+    pending_conns.clear();
 }
 
 void OpflexListener::sendTimeouts() {
@@ -228,13 +331,19 @@ bool OpflexListener::applyConnPred(conn_pred_t pred, void* user) {
     return true;
 }
 
-void OpflexListener::messagesReady() {
-    uv_async_send(&writeq_async);
+void OpflexListener::messagesReady(OpflexServerConnection* conn) {
+    uv_async_send(&loops[conn->loop_index]->writeq_async);
 }
 
 bool OpflexListener::isListening() {
     using yajr::comms::internal::Peer;
-    return Peer::LoopData::getPeerCount(&server_loop, Peer::LoopData::LISTENING) != 0;
+    if (loops.empty()) return false;
+    BOOST_FOREACH(boost::shared_ptr<ListenerLoop>& loop, loops) {
+        if (Peer::LoopData::getPeerCount(&loop->server_loop,
+                                         Peer::LoopData::LISTENING) == 0)
+            return false;
+    }
+    return true;
 }
 
 boost::mutex OpflexListener::serverConnectionMutex{};
@@ -30,6 +30,39 @@ void GenericOpflexMessage::serializePayload(yajr::rpc::SendHandler& writer) cons
     (*this)(writer);
 }
 
+namespace {
+/*
+ * Gives access to the output stream of a writer, so that a prepared
+ * payload can be queued by reference once the writer has emitted
+ * the separator in front of it
+ */
+struct WriterStream : public yajr::rpc::SendHandler {
+    static yajr::internal::StringQueue* yajr::rpc::SendHandler::* stream() {
+        return &WriterStream::os_;
+    }
+};
+}
+
+PreparedOpflexMessage::PreparedOpflexMessage(const OpflexMessage& message)
+    : OpflexMessage(message.getMethod(), message.getType(),
+                    message.getType() == REQUEST ? NULL : &message.getId()),
+      xid(message.getReqXid()) {
+    yajr::internal::StringQueue sq;
+    yajr::rpc::SendHandler writer(sq);
+    message.serializePayload(writer);
+    payload.reset(new std::string(sq.GetString()));
+}
+
+void PreparedOpflexMessage::serializePayload(yajr::rpc::SendHandler& writer) const {
+    // Write an empty raw value so the writer emits the separator and
+    // counts the value, then queue the shared payload without copying
+    // it into the connection's buffer
+    writer.RawValue("", 0,
+                    (!payload->empty() && (*payload)[0] == '{')
+                    ? rapidjson::kObjectType : rapidjson::kArrayType);
+    (writer.*WriterStream::stream())->PutShared(payload);
+}
+
 } /* namespace internal */
 } /* namespace engine */
 } /* namespace opflex */
@@ -105,6 +105,7 @@ public:
             writer.String("features");
             writer.StartArray();
             writer.String("anycastFallback");
+            writer.String("policyDelta");
             writer.EndArray();
             writer.EndObject();
         }
@@ -357,6 +358,7 @@ void OpflexPEHandler::handlePolicyResolveRes(uint64_t reqId,
     StoreClient* client = getProcessor()->getSystemClient();
     MOSerializer& serializer = getProcessor()->getSerializer();
     StoreClient::notif_t notifs;
+    OF_UNORDERED_SET<URI> returned;
     if (payload.HasMember("policy")) {
         const Value& policy = payload["policy"];
         if (!policy.IsArray()) {
@@ -376,10 +378,12 @@ void OpflexPEHandler::handlePolicyResolveRes(uint64_t reqId,
                 const Value& uriv = mo["uri"];
                 OpflexPool& pool = getProcessor()->getPool();
                 pool.removePendingItem(conn, uriv.GetString());
+                returned.insert(URI(uriv.GetString()));
             } 
         }
     }
     client->deliverNotifications(notifs);
+    getProcessor()->revalidateStale(reqId, returned);
 }
 
 void OpflexPEHandler::handlePolicyResolveErr(uint64_t reqId,
@@ -387,6 +391,7 @@ void OpflexPEHandler::handlePolicyResolveErr(uint64_t reqId,
     auto conn = (OpflexClientConnection*)getConnection();
     conn->getOpflexStats()->incrPolResolveErrs();
     handleError(reqId, payload, "Policy Resolve");
+    getProcessor()->clearStale(reqId);
 }
 
 void OpflexPEHandler::handlePolicyUpdateReq(const rapidjson::Value& id,
@@ -431,6 +436,30 @@ void OpflexPEHandler::handlePolicyUpdateReq(const rapidjson::Value& id,
                 serializer.deserialize(mo, *client, false, &notifs);
             }
         }
+        if (it->HasMember("update_properties")) {
+            const Value& update = (*it)["update_properties"];
+            if (!update.IsArray()) {
+                sendErrorRes(id, "ERROR",
+                             "Malformed message: update_properties is not an array");
+                return;
+            }
+            Value::ConstValueIterator it;
+            for (it = update.Begin(); it != update.End(); ++it) {
+                const Value& mo = *it;
+                if (serializer.deserializeDelta(mo, *client, &notifs))
+                    continue;
+
+                // we are missing the object the update applies to, so
+                // fetch all of it
+                const modb::ClassInfo& ci =
+                    getProcessor()->getStore()->getClassInfo(mo["subject"].GetString());
+                modb::URI uri(mo["uri"].GetString());
+                LOG(WARNING) << "[" << conn->getRemotePeer() << "] "
+                             << "Property update for missing object "
+                             << uri << "; resolving it again";
+                getProcessor()->resolveAgain(ci.getId(), uri);
+            }
+        }
         if (it->HasMember("delete")) {
             const Value& del = (*it)["delete"];
             if (!del.IsArray()) {
@@ -535,6 +564,7 @@ void OpflexPEHandler::handleEPResolveRes(uint64_t reqId,
     StoreClient* client = getProcessor()->getSystemClient();
     MOSerializer& serializer = getProcessor()->getSerializer();
     StoreClient::notif_t notifs;
+    OF_UNORDERED_SET<URI> returned;
     if (payload.HasMember("endpoint")) {
         const Value& endpoint = payload["endpoint"];
         if (!endpoint.IsArray()) {
@@ -547,9 +577,12 @@ void OpflexPEHandler::handleEPResolveRes(uint64_t reqId,
         for (it = endpoint.Begin(); it != endpoint.End(); ++it) {
             const Value& mo = *it;
             serializer.deserialize(mo, *client, true, &notifs);
+            if (mo.HasMember("uri") && mo["uri"].IsString())
+                returned.insert(URI(mo["uri"].GetString()));
         }
     }
     client->deliverNotifications(notifs);
+    getProcessor()->revalidateStale(reqId, returned);
 }
 
 void OpflexPEHandler::handleEPUnresolveRes(uint64_t reqId,
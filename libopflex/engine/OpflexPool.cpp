@@ -39,7 +39,7 @@ OpflexPool::OpflexPool(HandlerFactory& factory_,
       client_mode(OFConstants::OpflexElementMode::STITCHED_MODE),
       transport_state(OFConstants::OpflexTransportModeState::SEEKING_PROXIES),
       ipv4_proxy(0), ipv6_proxy(0),
-      mac_proxy(0), curHealth(PeerStatusListener::DOWN)
+      mac_proxy(0), nloops(1), curHealth(PeerStatusListener::DOWN)
 {
     uv_mutex_init(&conn_mutex);
     uv_key_create(&conn_mutex_key);
@@ -109,67 +109,139 @@ void OpflexPool::enableSSL(const string& caStorePath,
 }
 
 void OpflexPool::on_conn_async(uv_async_t* handle) {
-    OpflexPool* pool = (OpflexPool*)handle->data;
+    ClientLoop* loop = (ClientLoop*)handle->data;
+    OpflexPool* pool = loop->pool;
     if (pool->active) {
         util::RecursiveLockGuard guard(&pool->conn_mutex,
                                        &pool->conn_mutex_key);
         BOOST_FOREACH(conn_map_t::value_type& v, pool->connections) {
-            v.second.conn->connect();
+            if (v.second.conn->loop_index == loop->index)
+                v.second.conn->connect();
         }
     }
 }
 
 void OpflexPool::on_cleanup_async(uv_async_t* handle) {
-    OpflexPool* pool = (OpflexPool*)handle->data;
+    ClientLoop* loop = (ClientLoop*)handle->data;
+    OpflexPool* pool = loop->pool;
     {
         util::RecursiveLockGuard guard(&pool->conn_mutex,
                                        &pool->conn_mutex_key);
         conn_map_t conns(pool->connections);
         BOOST_FOREACH(conn_map_t::value_type& v, conns) {
-            v.second.conn->close();
+            if (v.second.conn->loop_index == loop->index)
+                v.second.conn->close();
         }
-        if (!pool->connections.empty())
+        if (loop->nconns > 0)
             return;
     }
 
-    uv_close((uv_handle_t*)&pool->writeq_async, NULL);
-    uv_close((uv_handle_t*)&pool->conn_async, NULL);
+    uv_prepare_stop(&loop->cpu_prepare);
+    uv_close((uv_handle_t*)&loop->cpu_prepare, NULL);
+    uv_close((uv_handle_t*)&loop->writeq_async, NULL);
+    uv_close((uv_handle_t*)&loop->conn_async, NULL);
     uv_close((uv_handle_t*)handle, NULL);
-    yajr::finiLoop(pool->client_loop);
+    yajr::finiLoop(loop->loop);
 }
 
 void OpflexPool::on_writeq_async(uv_async_t* handle) {
-    OpflexPool* pool = (OpflexPool*)handle->data;
+    ClientLoop* loop = (ClientLoop*)handle->data;
+    OpflexPool* pool = loop->pool;
     util::RecursiveLockGuard guard(&pool->conn_mutex,
                                    &pool->conn_mutex_key);
     BOOST_FOREACH(conn_map_t::value_type& v, pool->connections) {
-        v.second.conn->processWriteQueue();
+        if (v.second.conn->loop_index == loop->index)
+            v.second.conn->processWriteQueue();
     }
 }
 
+void OpflexPool::on_cpu_prepare(uv_prepare_t* handle) {
+    ClientLoop* loop = (ClientLoop*)handle->data;
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        loop->cpuNs = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void OpflexPool::setClientLoops(size_t loops_) {
+    nloops = loops_ > 0 ? loops_ : 1;
+}
+
 void OpflexPool::start() {
     if (active) return;
     active = true;
 
-    client_loop = threadManager.initTask("connection_pool");
-    yajr::initLoop(client_loop);
+    if (nloops > 1 && threadManager.hasAdaptor()) {
+        LOG(WARNING) << "Connection loops cannot be sharded when using "
+                     << "a main loop adaptor; using one connection loop";
+        nloops = 1;
+    }
 
-    conn_async.data = this;
-    cleanup_async.data = this;
-    writeq_async.data = this;
-    uv_async_init(client_loop, &conn_async, on_conn_async);
-    uv_async_init(client_loop, &cleanup_async, on_cleanup_async);
-    uv_async_init(client_loop, &writeq_async, on_writeq_async);
+    util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
+    loops.clear();
+    for (size_t i = 0; i < nloops; ++i) {
+        OF_SHARED_PTR<ClientLoop> loop = OF_MAKE_SHARED<ClientLoop>();
+        loop->pool = this;
+        loop->index = i;
+        loop->nconns = 0;
+        loop->cpuNs = 0;
+        loop->taskName = "connection_pool";
+        if (i > 0)
+            loop->taskName += "_" + std::to_string(i);
+
+        loop->loop = threadManager.initTask(loop->taskName);
+        yajr::initLoop(loop->loop);
+
+        loop->conn_async.data = loop.get();
+        loop->cleanup_async.data = loop.get();
+        loop->writeq_async.data = loop.get();
+        loop->cpu_prepare.data = loop.get();
+        uv_async_init(loop->loop, &loop->conn_async, on_conn_async);
+        uv_async_init(loop->loop, &loop->cleanup_async, on_cleanup_async);
+        uv_async_init(loop->loop, &loop->writeq_async, on_writeq_async);
+        uv_prepare_init(loop->loop, &loop->cpu_prepare);
+        uv_prepare_start(&loop->cpu_prepare, on_cpu_prepare);
+        loops.push_back(loop);
+    }
+    // pin any peers that were added before the loops existed
+    BOOST_FOREACH(conn_map_t::value_type& v, connections) {
+        assignLoop(v.second.conn);
+    }
+    guard.release();
 
-    threadManager.startTask("connection_pool");
+    BOOST_FOREACH(OF_SHARED_PTR<ClientLoop>& loop, loops) {
+        threadManager.startTask(loop->taskName);
+    }
 }
 
 void OpflexPool::stop() {
     if (!active) return;
     active = false;
 
-    uv_async_send(&cleanup_async);
-    threadManager.stopTask("connection_pool");
+    BOOST_FOREACH(OF_SHARED_PTR<ClientLoop>& loop, loops) {
+        uv_async_send(&loop->cleanup_async);
+    }
+    BOOST_FOREACH(OF_SHARED_PTR<ClientLoop>& loop, loops) {
+        threadManager.stopTask(loop->taskName);
+    }
+}
+
+// must be called with conn_mutex held
+void OpflexPool::assignLoop(OpflexClientConnection* conn) {
+    if (loops.empty()) return;
+    ClientLoop* best = loops[0].get();
+    BOOST_FOREACH(OF_SHARED_PTR<ClientLoop>& loop, loops) {
+        if (loop->nconns < best->nconns)
+            best = loop.get();
+    }
+    conn->loop_index = best->index;
+    best->nconns += 1;
+}
+
+OpflexPool::ClientLoop*
+OpflexPool::getClientLoop(OpflexClientConnection* conn) {
+    if (conn->loop_index < loops.size())
+        return loops[conn->loop_index].get();
+    return loops.empty() ? NULL : loops[0].get();
 }
 
 void OpflexPool::setOpflexIdentity(const string& name,
@@ -251,7 +323,11 @@ void OpflexPool::addPeer(const string& hostname, int port,
     if (configured)
         configured_peers.insert(make_pair(hostname, port));
     doAddPeer(hostname, port);
-    uv_async_send(&conn_async);
+    auto it = connections.find(make_pair(hostname, port));
+    if (it != connections.end() && it->second.conn != NULL) {
+        ClientLoop* loop = getClientLoop(it->second.conn);
+        if (loop) uv_async_send(&loop->conn_async);
+    }
 }
 
 void OpflexPool::doAddPeer(const string& hostname, int port) {
@@ -268,6 +344,7 @@ void OpflexPool::doAddPeer(const string& hostname, int port) {
         OpflexClientConnection* conn =
             new OpflexClientConnection(factory, this, hostname, port);
         cd.conn = conn;
+        assignLoop(conn);
     }
 }
 
@@ -280,6 +357,7 @@ void OpflexPool::addPeer(OpflexClientConnection* conn) {
                    << " already exists";
     }
     cd.conn = conn;
+    assignLoop(conn);
 }
 
 void OpflexPool::doRemovePeer(const string& hostname, int port) {
@@ -372,20 +450,25 @@ OpflexPool::getMasterForRole(OFConstants::OpflexRole role) {
 void OpflexPool::connectionClosed(OpflexClientConnection* conn) {
     util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
 
+    ClientLoop* loop = getClientLoop(conn);
     doConnectionClosed(conn);
 
     guard.release();
-    if (!active)
-        uv_async_send(&cleanup_async);
+    if (!active && loop)
+        uv_async_send(&loop->cleanup_async);
 }
 
 void OpflexPool::doConnectionClosed(OpflexClientConnection* conn) {
+    ClientLoop* loop = getClientLoop(conn);
+    if (loop && loop->nconns > 0)
+        loop->nconns -= 1;
     doRemovePeer(conn->getHostname(), conn->getPort());
     delete conn;
 }
 
-void OpflexPool::messagesReady() {
-    uv_async_send(&writeq_async);
+void OpflexPool::messagesReady(OpflexClientConnection* conn) {
+    ClientLoop* loop = getClientLoop(conn);
+    if (loop) uv_async_send(&loop->writeq_async);
 }
 
 void incrementMsgCounter(OpflexClientConnection* conn, OpflexMessage* msg)
@@ -435,6 +518,14 @@ size_t OpflexPool::sendToRole(OpflexMessage* message,
         if (!conn->isReady()) continue;
         ready.push_back(conn);
     }
+    if (ready.size() > 1) {
+        // Serialize the payload once and share the rendered buffer
+        // between the connections rather than serializing a clone
+        // for each of them
+        PreparedOpflexMessage* prepared = new PreparedOpflexMessage(*message);
+        messagep.reset(prepared);
+        message = prepared;
+    }
     BOOST_FOREACH(OpflexClientConnection* conn, ready) {
         if (i < (ready.size() - 1)) {
             m_copy = message->clone();
@@ -492,7 +583,21 @@ void OpflexPool::getOpflexPeerStats(std::unordered_map<string, OF_SHARED_PTR<OFS
     util::RecursiveLockGuard guard(&conn_mutex, &conn_mutex_key);
     BOOST_FOREACH(conn_map_t::value_type& v, connections) {
         const string peername = v.first.first + ":" + std::to_string(v.first.second);
-        stats.emplace(std::make_pair(peername, v.second.conn->getOpflexStats()));
+        OpflexClientConnection* conn = v.second.conn;
+        OF_SHARED_PTR<OFStats> connStats = conn->getOpflexStats();
+        ClientLoop* loop = getClientLoop(conn);
+        if (loop) {
+            connStats->setLoopId(loop->index);
+            connStats->setLoopCpuMs(loop->cpuNs / 1000000);
+        }
+        connStats->setWriteQueueDepth(conn->getWriteQueueDepth());
+        if (clientCtx.get()) {
+            uint64_t full, resumed;
+            clientCtx->getHandshakeCounts(peername, full, resumed);
+            connStats->setTlsFullHandshakes(full);
+            connStats->setTlsResumedHandshakes(resumed);
+        }
+        stats.emplace(std::make_pair(peername, connStats));
     }
 }
 
@@ -35,7 +35,8 @@ using opflex::gbp::PolicyUpdateOp;
 
 OpflexServerConnection::OpflexServerConnection(OpflexListener* listener_)
     : OpflexConnection(listener_->handlerFactory),
-      listener(listener_), peer(NULL) {
+      listener(listener_), loop_index(0), prr_tick(0),
+      policyDelta(false), peer(NULL) {
 
       uv_loop_init(&server_loop);
       policy_update_async.data = this;
@@ -99,7 +100,7 @@ const std::string& OpflexServerConnection::getDomain() {
 
 uv_loop_t* OpflexServerConnection::loop_selector(void * data) {
     OpflexServerConnection* conn = (OpflexServerConnection*)data;
-    return conn->getListener()->getLoop();
+    return conn->getListener()->getLoop(conn);
 }
 
 void OpflexServerConnection::on_state_change(yajr::Peer * p, void * data,
@@ -156,15 +157,23 @@ void OpflexServerConnection::disconnect() {
 }
 
 void OpflexServerConnection::messagesReady() {
-    listener->messagesReady();
+    listener->messagesReady(this);
 }
 
 void OpflexServerConnection::addUri(const opflex::modb::URI& uri,
                                     int64_t lifetime) {
     LOG(DEBUG) << "AGENT->SERVER ADD " << uri;
-    std::lock_guard<std::mutex> lock(uri_map_mutex);
+    GbpOpflexServerImpl* server = dynamic_cast<GbpOpflexServerImpl*>
+        (listener->getHandlerFactory());
+    int64_t interval = server ? server->getPrrIntervalSecs() : 1;
+    if (interval <= 0) interval = 1;
+    uint64_t ticks = lifetime <= 0 ? 1 : (lifetime + interval - 1) / interval;
 
-    uri_map[uri] = lifetime;
+    std::lock_guard<std::mutex> lock(uri_map_mutex);
+    uint64_t deadline = prr_tick + ticks;
+    uri_map[uri] = deadline;
+    expiry_wheel[deadline % EXPIRY_WHEEL_SLOTS].emplace_back(uri, deadline);
+    listener->subscribe(uri, this);
 }
 
 bool OpflexServerConnection::getUri(const opflex::modb::URI& uri) {
@@ -200,7 +209,16 @@ bool OpflexServerConnection::clearUri(const opflex::modb::URI& uri) {
     LOG(DEBUG) << "AGENT->SERVER CLEAR " << uri;
     std::lock_guard<std::mutex> lock(uri_map_mutex);
 
-    return (0 != uri_map.erase(uri));
+    if (0 == uri_map.erase(uri))
+        return false;
+    listener->unsubscribe(uri, this);
+    return true;
+}
+
+void OpflexServerConnection::clearSubscriptions() {
+    std::lock_guard<std::mutex> lock(uri_map_mutex);
+    for (const auto& u : uri_map)
+        listener->unsubscribe(u.first, this);
 }
 
 void OpflexServerConnection::addPendingUpdate(opflex::modb::class_id_t class_id,
@@ -223,6 +241,20 @@ void OpflexServerConnection::addPendingUpdate(opflex::modb::class_id_t class_id,
     }
 }
 
+void OpflexServerConnection::addPendingDelta(opflex::modb::class_id_t class_id,
+                                             const opflex::modb::URI& uri,
+                                             PolicyUpdateOp op,
+                                             const OF_UNORDERED_SET<opflex::modb::prop_id_t>& props) {
+    if (!policyDelta) {
+        addPendingUpdate(class_id, uri, op);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(uri_map_mutex);
+    OF_UNORDERED_SET<opflex::modb::prop_id_t>& pending =
+        delta[std::make_pair(class_id, uri)];
+    pending.insert(props.begin(), props.end());
+}
+
 void OpflexServerConnection::sendUpdates() {
     uv_async_send(&policy_update_async);
 }
@@ -237,30 +269,50 @@ void OpflexServerConnection::on_policy_update_async(uv_async_t* handle) {
         (conn->listener->getHandlerFactory());
     std::lock_guard<std::mutex> lock(conn->uri_map_mutex);
 
-    if (conn->replace.empty() && conn->merge.empty() && conn->deleted.empty())
+    if (conn->replace.empty() && conn->merge.empty() &&
+        conn->deleted.empty() && conn->delta.empty())
         return;
 
-    server->policyUpdate(conn, conn->replace, conn->merge, conn->deleted);
+    // objects sent in full don't need a property update as well
+    if (!conn->delta.empty()) {
+        for (const auto& r : conn->replace)
+            conn->delta.erase(r);
+        for (const auto& r : conn->merge)
+            conn->delta.erase(r);
+    }
+
+    server->policyUpdate(conn, conn->replace, conn->merge, conn->deleted,
+                         conn->delta);
 
     conn->replace.clear();
     conn->merge.clear();
     conn->deleted.clear();
+    conn->delta.clear();
 }
 
 void OpflexServerConnection::on_prr_timer_async(uv_async_t* handle) {
     OpflexServerConnection* conn = (OpflexServerConnection *)handle->data;
-    GbpOpflexServerImpl* server = dynamic_cast<GbpOpflexServerImpl*>
-        (conn->listener->getHandlerFactory());
     std::lock_guard<std::mutex> lock(conn->uri_map_mutex);
 
-    auto it = conn->uri_map.begin();
-    while (it != conn->uri_map.end()) {
-        it->second -= server->getPrrIntervalSecs();
-        if (it->second <= 0)
-            it = conn->uri_map.erase(it);
-        else
-            it++;
+    // Only the slot for the current tick needs to be examined
+    conn->prr_tick += 1;
+    wheel_slot_t& slot =
+        conn->expiry_wheel[conn->prr_tick % EXPIRY_WHEEL_SLOTS];
+    size_t keep = 0;
+    for (size_t i = 0; i < slot.size(); i++) {
+        auto it = conn->uri_map.find(slot[i].first);
+        if (it == conn->uri_map.end() || it->second != slot[i].second)
+            continue;
+        if (slot[i].second <= conn->prr_tick) {
+            conn->listener->unsubscribe(it->first, conn);
+            conn->uri_map.erase(it);
+            continue;
+        }
+        if (keep != i)
+            slot[keep] = std::move(slot[i]);
+        keep += 1;
     }
+    slot.erase(slot.begin() + keep, slot.end());
 }
 
 void OpflexServerConnection::on_cleanup_async(uv_async_t* handle) {
@@ -36,6 +36,25 @@ using modb::mointernal::StoreClient;
 using ofcore::OFConstants;
 using test::GbpOpflexServer;
 
+OpflexServerHandler::~OpflexServerHandler() {
+    BOOST_FOREACH(OpflexMessage* res, heldResponses) {
+        delete res;
+    }
+}
+
+void OpflexServerHandler::setHoldStateReports(bool hold) {
+    std::vector<OpflexMessage*> held;
+    {
+        boost::lock_guard<boost::mutex> guard(reportMutex);
+        holdStateReports = hold;
+        if (!hold)
+            held.swap(heldResponses);
+    }
+    BOOST_FOREACH(OpflexMessage* res, held) {
+        getConnection()->sendMessage(res);
+    }
+}
+
 void OpflexServerHandler::connected() {
 
 }
@@ -234,6 +253,27 @@ protected:
 void OpflexServerHandler::handleSendIdentityReq(const rapidjson::Value& id,
                                                 const Value& payload) {
     LOG(DEBUG) << "Got send_identity req";
+
+    // check whether the peer accepts property updates
+    OpflexServerConnection* conn =
+        dynamic_cast<OpflexServerConnection*>(getConnection());
+    if (conn && payload.IsArray()) {
+        Value::ConstValueIterator it;
+        for (it = payload.Begin(); it != payload.End(); ++it) {
+            if (!it->IsObject() || !it->HasMember("data")) continue;
+            const Value& data = (*it)["data"];
+            if (!data.IsObject() || !data.HasMember("features")) continue;
+            const Value& features = data["features"];
+            if (!features.IsArray()) continue;
+            Value::ConstValueIterator fit;
+            for (fit = features.Begin(); fit != features.End(); ++fit) {
+                if (fit->IsString() &&
+                    std::string("policyDelta") == fit->GetString())
+                    conn->setPolicyDelta(true);
+            }
+        }
+    }
+
     std::stringstream sb;
     sb << "127.0.0.1:" << server->getPort();
     SendIdentityRes* res =
@@ -324,6 +364,10 @@ void OpflexServerHandler::handlePolicyResolveReq(const rapidjson::Value& id,
         LOG(INFO) << "Flaking out";
         return;
     }
+    if (resolveErrors) {
+        sendErrorRes(id, "ERROR", "Policy resolution failed");
+        return;
+    }
 
     PolicyResolveRes* res =
         new PolicyResolveRes(id, *server, mos);
@@ -638,6 +682,7 @@ void OpflexServerHandler::handleStateReportReq(const rapidjson::Value& id,
     StoreClient::notif_t notifs;
     StoreClient& client = *server->getSystemClient();
     MOSerializer& serializer = server->getSerializer();
+    std::vector<std::string> uris;
 
     Value::ConstValueIterator it;
     for (it = payload.Begin(); it != payload.End(); ++it) {
@@ -661,6 +706,8 @@ void OpflexServerHandler::handleStateReportReq(const rapidjson::Value& id,
         Value::ConstValueIterator ep_it;
         for (ep_it = observable.Begin(); ep_it != observable.End(); ++ep_it) {
             const Value& mo = *ep_it;
+            if (mo.IsObject() && mo.HasMember("uri") && mo["uri"].IsString())
+                uris.push_back(mo["uri"].GetString());
             serializer.deserialize(mo, client, true, &notifs);
         }
     }
@@ -669,6 +716,14 @@ void OpflexServerHandler::handleStateReportReq(const rapidjson::Value& id,
     OpflexMessage* res =
         new GenericOpflexMessage("state_report",
                                  OpflexMessage::RESPONSE, &id);
+    {
+        boost::lock_guard<boost::mutex> guard(reportMutex);
+        stateReports.push_back(uris);
+        if (holdStateReports) {
+            heldResponses.push_back(res);
+            return;
+        }
+    }
     getConnection()->sendMessage(res, true);
 }
 
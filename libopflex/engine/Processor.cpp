@@ -15,6 +15,7 @@
 #endif
 
 
+#include <cstdio>
 #include <ctime>
 #include <uv.h>
 #include <limits>
@@ -54,6 +55,13 @@ static const uint64_t DEFAULT_PROC_DELAY = 250;
 static const uint64_t DEFAULT_RETRY_DELAY = 1000*60*2;
 static const uint64_t FIRST_XID = (uint64_t)1 << 63;
 static const uint32_t MAX_PROCESS = 1024;
+// how often to check whether the snapshot needs writing
+static const uint64_t SNAPSHOT_CHECK_INTERVAL = 1000;
+// how long resolved objects must be quiet before writing a snapshot
+static const uint64_t SNAPSHOT_QUIESCENCE = 5000;
+
+const size_t Processor::MAX_REPORT_BATCH;
+const size_t Processor::MAX_OUTSTANDING_REPORTS;
 
 std::random_device rd;
 std::mt19937 gen(rd());
@@ -66,13 +74,18 @@ Processor::Processor(ObjectStore* store_, ThreadManager& threadManager_)
       reportObservables(true),
       processingDelay(DEFAULT_PROC_DELAY),
       retryDelay(DEFAULT_RETRY_DELAY),
-      proc_active(false) {
+      proc_active(false),
+      snapshotInterval(0), snapshotHold(0), staleUntil(0),
+      snapshotChanges(0), snapshotWrittenChanges(0),
+      lastChangeTime(0), lastSnapshotTime(0) {
     uv_mutex_init(&item_mutex);
+    uv_mutex_init(&snapshot_mutex);
 }
 
 Processor::~Processor() {
     stop();
     uv_mutex_destroy(&item_mutex);
+    uv_mutex_destroy(&snapshot_mutex);
 }
 
 // get the current time in milliseconds since something
@@ -175,6 +188,19 @@ bool Processor::isObjNew(const URI& uri) {
     return true;
 }
 
+size_t Processor::getPendingReportCount() {
+    util::LockGuard guard(&item_mutex);
+    size_t count = 0;
+    for (const auto& p : pendingReports)
+        count += p.second.size();
+    return count;
+}
+
+size_t Processor::getOutstandingReportCount() {
+    util::LockGuard guard(&item_mutex);
+    return outstandingReports.size();
+}
+
 // check if the object has a zero refcount and it has no remote
 // ancestor that has a zero refcount.
 bool Processor::isOrphan(const item& item) {
@@ -228,6 +254,11 @@ void Processor::sendToRole(const item& i, uint64_t& newexp,
                            ofcore::OFConstants::OpflexRole role) {
     uint64_t xid = req->getReqXid();
     size_t pending = pool.sendToRole(req, role, false, i.uri.toString());
+    setPending(i, xid, pending, newexp);
+}
+
+void Processor::setPending(const item& i, uint64_t xid, size_t pending,
+                           uint64_t& newexp) {
     i.details->pending_reqs = pending;
 
     obj_state_by_uri& uri_index = obj_state.get<uri_tag>();
@@ -318,6 +349,20 @@ void Processor::disableObservableReporting() {
     reportObservables = false;
 }
 
+void Processor::setObservablePriority(class_id_t class_id, int priority) {
+    util::LockGuard guard(&item_mutex);
+    observablePriority[class_id] = priority;
+}
+
+int Processor::getObservablePriority(class_id_t class_id) {
+    util::LockGuard guard(&item_mutex);
+    auto iter = observablePriority.find(class_id);
+    if (iter != observablePriority.end()) {
+        return iter->second;
+    }
+    return 0;
+}
+
 bool Processor::declareObj(ClassInfo::class_type_t type, const item& i,
                            uint64_t& newexp) {
     uint64_t curTime = now(proc_loop);
@@ -337,10 +382,13 @@ bool Processor::declareObj(ClassInfo::class_type_t type, const item& i,
         if (isParentSyncObject(i) && reportObservables && isObservableReportable(i.details->class_id)) {
             LOG(DEBUG3) << "Declaring local observable " << i.uri;
             i.details->resolve_time = curTime;
-            vector<reference_t> refs;
-            refs.emplace_back(i.details->class_id, i.uri);
-            StateReportReq* req = new StateReportReq(this, nextXid++, refs);
-            sendToRole(i, newexp, req, OFConstants::OBSERVER);
+            // queue the observable; it is sent with the other changes
+            // from this pass by flushReports()
+            int priority = 0;
+            auto pit = observablePriority.find(i.details->class_id);
+            if (pit != observablePriority.end())
+                priority = pit->second;
+            pendingReports[priority][i.uri] = i.details->class_id;
         }
         return true;
     default:
@@ -405,8 +453,13 @@ void Processor::processItem(obj_state_by_exp::iterator& it) {
         }
     }
 
-    // Check whether this item needs to be garbage collected
-    if (oi && isOrphan(*it)) {
+    // Check whether this item needs to be garbage collected.  Stale
+    // items from the snapshot get some time for their references to
+    // be declared again before they are collected.
+    if (oi && it->details->stale && now(proc_loop) < staleUntil &&
+        isOrphan(*it)) {
+        newexp = staleUntil;
+    } else if (oi && isOrphan(*it)) {
         switch (curState) {
         case NEW:
         case REMOTE:
@@ -533,6 +586,59 @@ void Processor::processItem(obj_state_by_exp::iterator& it) {
         client->deliverNotifications(notifs);
 }
 
+// Send the queued observables to the observers, highest priority
+// first, batching them into as few state reports as possible while
+// keeping the number of unacknowledged reports bounded.  Whatever
+// doesn't fit in the window stays queued, so further changes to those
+// objects replace the stale state instead of adding to the backlog.
+// Must be called with item_mutex held.
+void Processor::flushReports() {
+    if (pendingReports.empty()) return;
+
+    // Don't let a report that will never be acknowledged hold the
+    // window closed; its items are retried on their own expiration
+    uint64_t curTime = now(proc_loop);
+    auto oit = outstandingReports.begin();
+    while (oit != outstandingReports.end()) {
+        if (curTime > oit->second.second + retryDelay)
+            oit = outstandingReports.erase(oit);
+        else
+            ++oit;
+    }
+
+    obj_state_by_uri& uri_index = obj_state.get<uri_tag>();
+    while (!pendingReports.empty() &&
+           outstandingReports.size() < MAX_OUTSTANDING_REPORTS) {
+        report_set_t& reports = pendingReports.begin()->second;
+        vector<reference_t> refs;
+        auto rit = reports.begin();
+        while (rit != reports.end() && refs.size() < MAX_REPORT_BATCH) {
+            // skip objects that were removed after they were queued
+            if (uri_index.find(rit->first) != uri_index.end())
+                refs.emplace_back(rit->second, rit->first);
+            rit = reports.erase(rit);
+        }
+        if (reports.empty())
+            pendingReports.erase(pendingReports.begin());
+        if (refs.empty())
+            continue;
+
+        uint64_t xid = nextXid++;
+        LOG(DEBUG2) << "Reporting " << refs.size() << " observables";
+        StateReportReq* req = new StateReportReq(this, xid, refs);
+        size_t pending = pool.sendToRole(req, OFConstants::OBSERVER);
+        if (pending > 0)
+            outstandingReports[xid] = make_pair(pending, curTime);
+
+        BOOST_FOREACH(const reference_t& ref, refs) {
+            obj_state_by_uri::iterator uit = uri_index.find(ref.second);
+            uint64_t newexp = uit->expiration;
+            setPending(*uit, xid, pending, newexp);
+            uri_index.modify(uit, change_expiration(newexp));
+        }
+    }
+}
+
 void Processor::doProcess() {
     obj_state_by_exp::iterator it;
     uint32_t proc_count = 0;
@@ -549,6 +655,10 @@ void Processor::doProcess() {
             break;
         }
     }
+
+    util::LockGuard guard(&item_mutex);
+    if (proc_active)
+        flushReports();
 }
 
 void Processor::proc_async_cb(uv_async_t* handle) {
@@ -571,8 +681,28 @@ void Processor::timer_callback(uv_timer_t* handle) {
     processor->doProcess();
 }
 
+void Processor::snapshot_timer_cb(uv_timer_t* handle) {
+    Processor* processor = (Processor*)handle->data;
+    uint64_t curtime = now(processor->proc_loop);
+    {
+        util::LockGuard guard(&processor->item_mutex);
+        if (processor->snapshotChanges == processor->snapshotWrittenChanges)
+            return;
+        if (curtime < processor->lastChangeTime + SNAPSHOT_QUIESCENCE &&
+            curtime < processor->lastSnapshotTime + processor->snapshotInterval)
+            return;
+        processor->snapshotWrittenChanges = processor->snapshotChanges;
+        processor->lastSnapshotTime = curtime;
+    }
+    processor->writeSnapshot();
+}
+
 void Processor::cleanup_async_cb(uv_async_t* handle) {
     Processor* processor = (Processor*)handle->data;
+    if (!processor->snapshotFile.empty()) {
+        uv_timer_stop(&processor->snapshot_timer);
+        uv_close((uv_handle_t*)&processor->snapshot_timer, NULL);
+    }
     uv_timer_stop(&processor->proc_timer);
     uv_close((uv_handle_t*)&processor->proc_timer, NULL);
     uv_close((uv_handle_t*)&processor->proc_async, NULL);
@@ -605,6 +735,12 @@ void Processor::start(ofcore::OFConstants::OpflexElementMode agent_mode) {
     proc_timer.data = this;
     uv_timer_start(&proc_timer, &timer_callback,
                    processingDelay, processingDelay);
+    if (!snapshotFile.empty()) {
+        uv_timer_init(proc_loop, &snapshot_timer);
+        snapshot_timer.data = this;
+        uv_timer_start(&snapshot_timer, &snapshot_timer_cb,
+                       SNAPSHOT_CHECK_INTERVAL, SNAPSHOT_CHECK_INTERVAL);
+    }
     threadManager.startTask("processor");
 
     pool.start();
@@ -643,6 +779,10 @@ void Processor::objectUpdated(modb::class_id_t class_id,
     if ((present = client->get(class_id, uri, oi))) {
         local = oi->isLocal();
     }
+    if (!local && (present || uit != uri_index.end())) {
+        snapshotChanges += 1;
+        lastChangeTime = curtime;
+    }
 
     if (uit == uri_index.end()) {
         if (present) {
@@ -672,6 +812,161 @@ void Processor::objectUpdated(modb::class_id_t class_id,
     uv_async_send(&proc_async);
 }
 
+void Processor::setSnapshot(const std::string& file, uint64_t interval,
+                            uint64_t holdTime) {
+    snapshotFile = file;
+    snapshotInterval = interval;
+    snapshotHold = holdTime;
+}
+
+size_t Processor::loadSnapshot() {
+    if (snapshotFile.empty() || !proc_active) return 0;
+
+    FILE* pfile = fopen(snapshotFile.c_str(), "r");
+    if (pfile == NULL) {
+        LOG(INFO) << "No MODB snapshot found at " << snapshotFile;
+        return 0;
+    }
+
+    {
+        util::LockGuard guard(&item_mutex);
+        staleUntil = now(proc_loop) + snapshotHold;
+    }
+
+    StoreClient::notif_t notifs;
+    vector<reference_t> loaded;
+    serializer.readSnapshot(pfile, *client, notifs, loaded);
+    fclose(pfile);
+
+    {
+        // track the objects now so they are marked stale before the
+        // notifications reach objectUpdated
+        util::LockGuard guard(&item_mutex);
+        obj_state_by_uri& uri_index = obj_state.get<uri_tag>();
+        BOOST_FOREACH(const reference_t& r, loaded) {
+            obj_state_by_uri::iterator uit = uri_index.find(r.second);
+            if (uit == uri_index.end()) {
+                obj_state.insert(item(r.second, r.first,
+                                      0, policyRefTimerDuration,
+                                      REMOTE, false));
+                uit = uri_index.find(r.second);
+            }
+            if (!uit->details->local)
+                uit->details->stale = true;
+        }
+    }
+    client->deliverNotifications(notifs);
+    uv_async_send(&proc_async);
+
+    LOG(INFO) << "Loaded " << loaded.size()
+              << " stale managed objects from snapshot " << snapshotFile;
+    return loaded.size();
+}
+
+void Processor::writeSnapshot() {
+    if (snapshotFile.empty()) return;
+
+    // the snapshot timer and the final write on shutdown share the
+    // temporary file
+    util::LockGuard guard(&snapshot_mutex);
+
+    // write to a temporary file so a crash never leaves a truncated
+    // snapshot behind
+    const std::string tmpFile = snapshotFile + ".tmp";
+    FILE* pfile = fopen(tmpFile.c_str(), "w");
+    if (pfile == NULL) {
+        LOG(ERROR) << "Could not open MODB snapshot file "
+                   << tmpFile << " for writing";
+        return;
+    }
+    size_t objs = serializer.dumpSnapshot(pfile);
+    bool failed = (fflush(pfile) != 0);
+    failed |= (fclose(pfile) != 0);
+    if (failed || std::rename(tmpFile.c_str(), snapshotFile.c_str()) != 0) {
+        LOG(ERROR) << "Could not write MODB snapshot to " << snapshotFile;
+        std::remove(tmpFile.c_str());
+        return;
+    }
+    LOG(DEBUG) << "Wrote " << objs << " managed objects to snapshot "
+               << snapshotFile;
+}
+
+void Processor::revalidateStale(uint64_t reqId,
+                                const OF_UNORDERED_SET<URI>& returned) {
+    StoreClient::notif_t notifs;
+    util::LockGuard guard(&item_mutex);
+    obj_state_by_xid& xid_index = obj_state.get<xid_tag>();
+    obj_state_by_xid::iterator xi0,xi1;
+    boost::tuples::tie(xi0,xi1)=xid_index.equal_range(reqId);
+
+    for (; xi0 != xi1; ++xi0) {
+        if (!xi0->details->stale) continue;
+        if (returned.find(xi0->uri) != returned.end()) {
+            xi0->details->stale = false;
+            continue;
+        }
+        // wait until every peer has answered
+        if (xi0->details->pending_reqs > 0) continue;
+        xi0->details->stale = false;
+
+        // none of the peers have this object any longer
+        LOG(DEBUG) << "Removing stale object " << xi0->uri;
+        try {
+            client->remove(xi0->details->class_id, xi0->uri,
+                           false, &notifs);
+            client->queueNotification(xi0->details->class_id, xi0->uri,
+                                      notifs);
+        } catch (const std::out_of_range& e) {}
+    }
+    guard.release();
+
+    if (!notifs.empty())
+        client->deliverNotifications(notifs);
+}
+
+void Processor::clearStale(uint64_t reqId) {
+    util::LockGuard guard(&item_mutex);
+    obj_state_by_xid& xid_index = obj_state.get<xid_tag>();
+    obj_state_by_xid::iterator xi0,xi1;
+    boost::tuples::tie(xi0,xi1)=xid_index.equal_range(reqId);
+
+    bool cleared = false;
+    uint64_t curtime = now(proc_loop);
+    for (; xi0 != xi1; ++xi0) {
+        if (!xi0->details->stale) continue;
+        LOG(DEBUG) << "Resolve failed for stale object " << xi0->uri
+                   << "; ending its snapshot hold";
+        xi0->details->stale = false;
+        // collect it now if nothing references it
+        if (isOrphan(*xi0)) {
+            xid_index.modify(xi0, change_expiration(curtime));
+            cleared = true;
+        }
+    }
+    if (cleared && proc_active)
+        uv_async_send(&proc_async);
+}
+
+void Processor::resolveAgain(class_id_t class_id, const URI& uri) {
+    util::LockGuard guard(&item_mutex);
+    if (!proc_active) return;
+
+    obj_state_by_uri& uri_index = obj_state.get<uri_tag>();
+    obj_state_by_uri::iterator uit = uri_index.find(uri);
+    if (uit != uri_index.end() && uit->details->state == RESOLVED) {
+        uit->details->resolve_time = 0;
+        uri_index.modify(uit, change_expiration(now(proc_loop)));
+        uv_async_send(&proc_async);
+        return;
+    }
+
+    LOG(DEBUG) << "Resolving policy " << uri << " again";
+    vector<reference_t> refs;
+    refs.emplace_back(class_id, uri);
+    PolicyResolveReq* req = new PolicyResolveReq(this, nextXid++, refs);
+    pool.sendToRole(req, OFConstants::POLICY_REPOSITORY);
+}
+
 void Processor::setOpflexIdentity(const std::string& name,
                                   const std::string& domain) {
     pool.setOpflexIdentity(name, domain);
@@ -715,6 +1010,10 @@ OpflexHandler* Processor::newHandler(OpflexConnection* conn) {
 
 void Processor::handleNewConnections() {
     util::LockGuard guard(&item_mutex);
+    // Every observable is reported again below, so reports sent on
+    // a connection that has since dropped must not hold the window
+    // closed waiting for responses that will never come
+    outstandingReports.clear();
     BOOST_FOREACH(const item& i, obj_state) {
         uint64_t newexp = 0;
         const ClassInfo& ci = store->getClassInfo(i.details->class_id);
@@ -725,6 +1024,7 @@ void Processor::handleNewConnections() {
             resolveObj(ci.getType(), i, newexp, false);
         }
     }
+    flushReports();
 }
 
 void Processor::connectionReady(OpflexConnection* conn) {
@@ -733,6 +1033,15 @@ void Processor::connectionReady(OpflexConnection* conn) {
 
 void Processor::responseReceived(uint64_t reqId) {
     util::LockGuard guard(&item_mutex);
+    auto oit = outstandingReports.find(reqId);
+    if (oit != outstandingReports.end()) {
+        if (--oit->second.first == 0)
+            outstandingReports.erase(oit);
+        // the window has room again for queued reports
+        if (!pendingReports.empty() && proc_active)
+            uv_async_send(&proc_async);
+    }
+
     obj_state_by_xid& xid_index = obj_state.get<xid_tag>();
     obj_state_by_xid::iterator xi0,xi1;
     boost::tuples::tie(xi0,xi1)=xid_index.equal_range(reqId);
@@ -17,6 +17,8 @@
 
 #include <vector>
 #include <utility>
+#include <map>
+#include <functional>
 
 #include <boost/atomic.hpp>
 #include <boost/multi_index_container.hpp>
@@ -175,6 +177,26 @@ public:
      */
     bool isObjNew(const modb::URI& uri);
 
+    /**
+     * Maximum number of observables in a single state report
+     */
+    static const size_t MAX_REPORT_BATCH = 256;
+
+    /**
+     * Maximum number of state reports waiting for a response
+     */
+    static const size_t MAX_OUTSTANDING_REPORTS = 4;
+
+    /**
+     * Get the number of observables waiting to be reported
+     */
+    size_t getPendingReportCount();
+
+    /**
+     * Get the number of state reports waiting for a response
+     */
+    size_t getOutstandingReportCount();
+
     /**
      * Set the processing delay for unit tests
      */
@@ -262,6 +284,93 @@ public:
      */
     void disableObservableReporting();
 
+    /**
+     * Set the priority for reporting changes to the specified
+     * observable class.  Pending changes for higher-priority classes
+     * are reported to observers before those of lower-priority
+     * classes.
+     *
+     * @param class_id Observable class ID
+     * @param priority the reporting priority; the default is 0
+     */
+    void setObservablePriority(modb::class_id_t class_id, int priority);
+
+    /**
+     * Get the priority for reporting changes to the specified
+     * observable class
+     *
+     * @param class_id Observable class ID
+     * @return the reporting priority
+     */
+    int getObservablePriority(modb::class_id_t class_id);
+
+    /**
+     * Keep a snapshot on disk of the objects resolved from the
+     * remote peers, so that a restarted agent can start from the
+     * last known policy instead of an empty store.  The snapshot is
+     * rewritten once the resolved objects have been quiet for a
+     * while, and at least every interval while they keep changing.
+     * Must be called before start().
+     *
+     * @param file the path to the snapshot file
+     * @param interval the longest time in milliseconds that changes
+     * can go unsaved
+     * @param holdTime how long in milliseconds objects loaded from
+     * the snapshot are kept before they are garbage collected if
+     * nothing references them
+     */
+    void setSnapshot(const std::string& file, uint64_t interval,
+                     uint64_t holdTime);
+
+    /**
+     * Load the snapshot file into the store.  The objects are marked
+     * stale: they are usable right away but are revalidated against
+     * the remote peers as they are resolved, and removed if the peer
+     * no longer has them.  Call after start() once the local root
+     * objects exist.
+     *
+     * @return the number of objects loaded
+     */
+    size_t loadSnapshot();
+
+    /**
+     * Write the snapshot file now.  May be called from any thread
+     * while the processor is running.
+     */
+    void writeSnapshot();
+
+    /**
+     * Called when a resolve response has been applied to the store,
+     * to revalidate any stale objects from the snapshot that the
+     * request covered
+     *
+     * @param reqId the ID of the request
+     * @param returned the objects returned in the response
+     */
+    void revalidateStale(uint64_t reqId,
+                         const OF_UNORDERED_SET<modb::URI>& returned);
+
+    /**
+     * Called when a peer returns an error for a resolve request.  The
+     * stale objects the request covered lose their snapshot hold and
+     * are handled like any other resolved object: kept while
+     * referenced and resolved again on the usual schedule.
+     *
+     * @param reqId the ID of the request
+     */
+    void clearStale(uint64_t reqId);
+
+    /**
+     * Resolve a policy object again, for example after a peer sent
+     * an update for an object that is not in the store.  A tracked
+     * object is resolved on the next processing pass; otherwise a
+     * resolve request is sent for it right away.
+     *
+     * @param class_id the class of the object
+     * @param uri the URI of the object
+     */
+    void resolveAgain(modb::class_id_t class_id, const modb::URI& uri);
+
 private:
     /**
      * The system store client
@@ -298,6 +407,28 @@ private:
       */
      bool reportObservables;
 
+    /**
+     * Reporting priority for observable classes
+     */
+    std::map<modb::class_id_t, int> observablePriority;
+
+    /**
+     * Observables with changes waiting to be reported, by priority
+     * with the highest first.  An object is queued only once however
+     * often it changes, and its report carries the state of the
+     * object at the time the report is sent.
+     */
+    typedef OF_UNORDERED_MAP<modb::URI, modb::class_id_t> report_set_t;
+    std::map<int, report_set_t, std::greater<int> > pendingReports;
+
+    /**
+     * State reports that have been sent and not yet acknowledged,
+     * mapping the request ID to the number of responses still
+     * expected and the time the report was sent
+     */
+    OF_UNORDERED_MAP<uint64_t, std::pair<size_t, uint64_t> >
+        outstandingReports;
+
     /**
      * The status of items in the MODB with respect to the opflex
      * protocol
@@ -370,6 +501,12 @@ private:
          * Number of retries for this item
          */
         uint16_t retry_count;
+
+        /**
+         * Whether the item was loaded from the snapshot and has not
+         * been revalidated yet
+         */
+        bool stale;
     };
 
     /**
@@ -395,6 +532,7 @@ private:
             details->resolve_time = 0;
             details->pending_reqs = 0;
             details->retry_count = 0;
+            details->stale = false;
         }
         ~item() { if (details) delete details; }
         item& operator=( const item& rhs ) {
@@ -525,7 +663,22 @@ private:
     uv_async_t connect_async;
     uv_timer_t proc_timer;
 
+    /**
+     * Warm-start snapshot state
+     */
+    std::string snapshotFile;
+    uint64_t snapshotInterval;
+    uint64_t snapshotHold;
+    uint64_t staleUntil;
+    uint64_t snapshotChanges;
+    uint64_t snapshotWrittenChanges;
+    uint64_t lastChangeTime;
+    uint64_t lastSnapshotTime;
+    uv_timer_t snapshot_timer;
+    uv_mutex_t snapshot_mutex;
+
     static void timer_callback(uv_timer_t* handle);
+    static void snapshot_timer_cb(uv_timer_t* handle);
     static void cleanup_async_cb(uv_async_t *handle);
     static void proc_async_cb(uv_async_t *handle);
     static void connect_async_cb(uv_async_t *handle);
@@ -542,6 +695,9 @@ private:
     void sendToRole(const item& it, uint64_t& newexp,
                     internal::OpflexMessage* req,
                     ofcore::OFConstants::OpflexRole role);
+    void setPending(const item& it, uint64_t xid, size_t pending,
+                    uint64_t& newexp);
+    void flushReports();
     bool resolveObj(modb::ClassInfo::class_type_t type, const item& it,
                     uint64_t& newexp, bool checkTime = true);
     bool declareObj(modb::ClassInfo::class_type_t type, const item& it,
@@ -72,6 +72,13 @@ public:
                    const std::string& serverKeyPass,
                    bool verifyPeers);
 
+    /**
+     * Set the number of listener event loops.  Call before start()
+     *
+     * @param loops the number of loops
+     */
+    void setListenerLoops(size_t loops);
+
     /**
      * Start the server
      */
@@ -160,7 +167,9 @@ public:
     void policyUpdate(OpflexServerConnection* conn,
                       const std::vector<modb::reference_t>& replace,
                       const std::vector<modb::reference_t>& merge_children,
-                      const std::vector<modb::reference_t>& del);
+                      const std::vector<modb::reference_t>& del,
+                      const OpflexServerConnection::delta_map_t& delta =
+                      OpflexServerConnection::delta_map_t());
 
 
     /**
@@ -176,6 +185,10 @@ public:
     virtual void remoteObjectUpdated(modb::class_id_t class_id,
                                      const modb::URI& uri,
                                      gbp::PolicyUpdateOp op);
+    virtual void remotePropertiesUpdated(modb::class_id_t class_id,
+                                         const modb::URI& uri,
+                                         gbp::PolicyUpdateOp op,
+                                         const OF_UNORDERED_SET<modb::prop_id_t>& props);
 
     /**
      * on timer callback
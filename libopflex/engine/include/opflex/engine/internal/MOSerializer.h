@@ -50,6 +50,19 @@ public:
         virtual void remoteObjectUpdated(modb::class_id_t class_id,
                                          const modb::URI& uri,
                                          gbp::PolicyUpdateOp op) = 0;
+
+        /**
+         * A managed object that was already present was just
+         * written to the store, and only the given properties
+         * changed.  Its children are unchanged.  By default this is
+         * handled as a full object update.
+         */
+        virtual void remotePropertiesUpdated(modb::class_id_t class_id,
+                                             const modb::URI& uri,
+                                             gbp::PolicyUpdateOp op,
+                                             const OF_UNORDERED_SET<modb::prop_id_t>& props) {
+            remoteObjectUpdated(class_id, uri, op);
+        }
     };
 
     /**
@@ -205,122 +218,12 @@ public:
                            pit->second.getCardinality()))
                 continue;
 
-            switch (pit->second.getType()) {
-            case modb::PropertyInfo::STRING:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    writer.String(oi->getString(pit->first).c_str());
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getStringSize(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        writer.String(oi->getString(pit->first, i).c_str());
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::S64:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    writer.Int64(oi->getInt64(pit->first));
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getInt64Size(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        writer.Int64(oi->getInt64(pit->first, i));
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::ENUM8:
-            case modb::PropertyInfo::ENUM16:
-            case modb::PropertyInfo::ENUM32:
-            case modb::PropertyInfo::ENUM64:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    uint64_t v = oi->getUInt64(pit->first);
-                    serialize_enum(client, pit->second, writer, v);
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getReferenceSize(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        uint64_t v = oi->getUInt64(pit->first, i);
-                        serialize_enum(client, pit->second, writer, v);
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::U64:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    writer.Uint64(oi->getUInt64(pit->first));
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getUInt64Size(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        writer.Uint64(oi->getUInt64(pit->first, i));
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::MAC:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    writer.String(oi->getMAC(pit->first).toString().c_str());
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getMACSize(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        writer.String(oi->getMAC(pit->first, i)
-                                      .toString().c_str());
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::REFERENCE:
-                writer.StartObject();
-                writer.String("name");
-                writer.String(pit->second.getName().c_str());
-                writer.String("data");
-                if (pit->second.getCardinality() == modb::PropertyInfo::SCALAR) {
-                    modb::reference_t r = oi->getReference(pit->first);
-                    serialize_ref(client, writer, r);
-                } else {
-                    writer.StartArray();
-                    size_t len = oi->getReferenceSize(pit->first);
-                    for (size_t i = 0; i < len; ++i) {
-                        modb::reference_t r = oi->getReference(pit->first, i);
-                        serialize_ref(client, writer, r);
-                    }
-                    writer.EndArray();
-                }
-                writer.EndObject();
-                break;
-            case modb::PropertyInfo::COMPOSITE:
+            if (pit->second.getType() == modb::PropertyInfo::COMPOSITE) {
                 client.getChildren(class_id, uri, pit->first,
                                    pit->second.getClassId(),
                                    children[pit->second.getClassId()]);
-                break;
+            } else {
+                serialize_prop(client, pit->second, *oi, writer);
             }
         }
         writer.EndArray();
@@ -367,6 +270,68 @@ public:
         }
     }
 
+    /**
+     * Serialize only the given properties of an object, so that a
+     * peer that already has the object can apply the change with
+     * deserializeDelta().  Properties that are no longer set are
+     * listed by name under "unset".  Children are not included.
+     *
+     * @param class_id the class ID of the object to serialize
+     * @param uri the URI of the object instance
+     * @param client the store client to use to look up the data
+     * @param writer the writer to write to
+     * @param props the IDs of the properties to serialize
+     * @throws std::out_of_range if there is no such managed object
+     */
+    template <typename T>
+    void serializeDelta(modb::class_id_t class_id,
+                        const modb::URI& uri,
+                        modb::mointernal::StoreClient& client,
+                        T& writer,
+                        const OF_UNORDERED_SET<modb::prop_id_t>& props) {
+        const modb::ClassInfo& ci = store->getClassInfo(class_id);
+        const OF_SHARED_PTR<const modb::mointernal::ObjectInstance>
+            oi(client.get(class_id, uri));
+        std::vector<const modb::PropertyInfo*> unset;
+        writer.StartObject();
+
+        writer.String("subject");
+        writer.String(ci.getName().c_str());
+
+        writer.String("uri");
+        writer.String(uri.toString().c_str());
+
+        writer.String("properties");
+        writer.StartArray();
+        OF_UNORDERED_SET<modb::prop_id_t>::const_iterator it;
+        for (it = props.begin(); it != props.end(); ++it) {
+            modb::prop_id_t prop_id = *it;
+            const modb::PropertyInfo* pinfo;
+            try {
+                pinfo = &ci.getProperty(prop_id);
+            } catch (const std::out_of_range& e) {
+                continue;
+            }
+            if (pinfo->getType() == modb::PropertyInfo::COMPOSITE)
+                continue;
+            if (oi->isSet(prop_id, pinfo->getType(),
+                          pinfo->getCardinality()))
+                serialize_prop(client, *pinfo, *oi, writer);
+            else
+                unset.push_back(pinfo);
+        }
+        writer.EndArray();
+
+        writer.String("unset");
+        writer.StartArray();
+        for (size_t i = 0; i < unset.size(); ++i) {
+            writer.String(unset[i]->getName().c_str());
+        }
+        writer.EndArray();
+
+        writer.EndObject();
+    }
+
     /**
      * Deserialize the parameters from the JSON value into the object
      * instance.
@@ -385,6 +350,25 @@ public:
                      /* out */
                      modb::mointernal::StoreClient::notif_t* notifs = NULL);
 
+    /**
+     * Apply a property update written by serializeDelta() to an
+     * object already in the store.  The listed properties replace
+     * the current values; all other properties and the children of
+     * the object are left alone.
+     *
+     * @param mo the JSON value to deserialize
+     * @param client the store client where we should write the output
+     * @param notifs an optional map that will hold update
+     * notifications that should be dispatched as a result of this
+     * change.
+     * @return false if the object is not in the store, in which case
+     * the update could not be applied
+     */
+    bool deserializeDelta(const rapidjson::Value& mo,
+                          modb::mointernal::StoreClient& client,
+                          /* out */
+                          modb::mointernal::StoreClient::notif_t* notifs = NULL);
+
     /**
      * Dump the managed object database to the file specified as a
      * JSON blob.
@@ -401,6 +385,35 @@ public:
      */
     void dumpMODB(FILE* file);
 
+    /**
+     * Dump the managed objects that were received from remote peers,
+     * skipping objects written locally, to the file specified as a
+     * JSON blob.  Objects are written parents first so that the
+     * output can be read back with readSnapshot().
+     *
+     * @param file the file to write to.
+     * @return the number of managed objects written
+     */
+    size_t dumpSnapshot(FILE* file);
+
+    /**
+     * Read managed objects written by dumpSnapshot() into the MODB.
+     * Objects that are already present are left alone, since they
+     * are newer than the snapshot.
+     *
+     * @param file the file containing the managed objects
+     * @param client the store client to use
+     * @param notifs notifications to dispatch for the objects read
+     * @param loaded the objects that were written to the store
+     * @return the number of managed objects read
+     */
+    size_t readSnapshot(FILE* file,
+                        modb::mointernal::StoreClient& client,
+                        /* out */
+                        modb::mointernal::StoreClient::notif_t& notifs,
+                        /* out */
+                        std::vector<modb::reference_t>& loaded);
+
     /**
      * Dump the unresolved managed object database to the file specified as a
      * JSON blob.
@@ -457,6 +470,17 @@ private:
     modb::ObjectStore* store;
     Listener* listener;
 
+    /**
+     * Serialize the nonlocal objects in the subtree rooted at the
+     * given object
+     */
+    template <typename T>
+    void serializeRemote(modb::class_id_t class_id,
+                         const modb::URI& uri,
+                         modb::mointernal::StoreClient& client,
+                         T& writer,
+                         size_t& count);
+
     /**
      * Serialize a reference
      * @param client the store client to use to look up the data
@@ -482,6 +506,135 @@ private:
         }
     }
 
+    /**
+     * Serialize the value of a single property as a name/data pair
+     *
+     * @param client the store client to use to look up the data
+     * @param pinfo the property to serialize
+     * @param oi the object containing the property
+     * @param writer the writer to write to
+     */
+    template <typename T>
+    void serialize_prop(modb::mointernal::StoreClient& client,
+                        const modb::PropertyInfo& pinfo,
+                        const modb::mointernal::ObjectInstance& oi,
+                        T& writer) {
+        switch (pinfo.getType()) {
+        case modb::PropertyInfo::STRING:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                writer.String(oi.getString(pinfo.getId()).c_str());
+            } else {
+                writer.StartArray();
+                size_t len = oi.getStringSize(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    writer.String(oi.getString(pinfo.getId(), i).c_str());
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::S64:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                writer.Int64(oi.getInt64(pinfo.getId()));
+            } else {
+                writer.StartArray();
+                size_t len = oi.getInt64Size(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    writer.Int64(oi.getInt64(pinfo.getId(), i));
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::ENUM8:
+        case modb::PropertyInfo::ENUM16:
+        case modb::PropertyInfo::ENUM32:
+        case modb::PropertyInfo::ENUM64:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                uint64_t v = oi.getUInt64(pinfo.getId());
+                serialize_enum(client, pinfo, writer, v);
+            } else {
+                writer.StartArray();
+                size_t len = oi.getReferenceSize(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    uint64_t v = oi.getUInt64(pinfo.getId(), i);
+                    serialize_enum(client, pinfo, writer, v);
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::U64:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                writer.Uint64(oi.getUInt64(pinfo.getId()));
+            } else {
+                writer.StartArray();
+                size_t len = oi.getUInt64Size(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    writer.Uint64(oi.getUInt64(pinfo.getId(), i));
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::MAC:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                writer.String(oi.getMAC(pinfo.getId()).toString().c_str());
+            } else {
+                writer.StartArray();
+                size_t len = oi.getMACSize(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    writer.String(oi.getMAC(pinfo.getId(), i)
+                                  .toString().c_str());
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::REFERENCE:
+            writer.StartObject();
+            writer.String("name");
+            writer.String(pinfo.getName().c_str());
+            writer.String("data");
+            if (pinfo.getCardinality() == modb::PropertyInfo::SCALAR) {
+                modb::reference_t r = oi.getReference(pinfo.getId());
+                serialize_ref(client, writer, r);
+            } else {
+                writer.StartArray();
+                size_t len = oi.getReferenceSize(pinfo.getId());
+                for (size_t i = 0; i < len; ++i) {
+                    modb::reference_t r = oi.getReference(pinfo.getId(), i);
+                    serialize_ref(client, writer, r);
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+            break;
+        case modb::PropertyInfo::COMPOSITE:
+            break;
+        }
+    }
+
     /**
      * Serialize an enum
      * @param client the store client to use to look up the data
@@ -506,6 +659,23 @@ private:
         }
     }
 
+    /**
+     * Deserialize a list of name/data property values into the
+     * object instance
+     *
+     * @param ci the class of the object
+     * @param properties the JSON array of properties
+     * @param client the store client
+     * @param oi the object instance where we'll store the result
+     * @param replace clear the current value of each property
+     * before setting it, rather than appending to vectors
+     */
+    void deserialize_props(const modb::ClassInfo& ci,
+                           const rapidjson::Value& properties,
+                           modb::mointernal::StoreClient& client,
+                           modb::mointernal::ObjectInstance& oi,
+                           bool replace);
+
     /**
      * Deserialize a reference
      *
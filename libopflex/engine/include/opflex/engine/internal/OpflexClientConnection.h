@@ -118,6 +118,11 @@ private:
 
     OF_SHARED_PTR<OFStats> opflexStats;
 
+    /**
+     * The pool event loop this connection is pinned to
+     */
+    size_t loop_index;
+
     uv_timer_t* handshake_timer;
 
     static uv_loop_t* loop_selector(void* data);
@@ -133,6 +138,7 @@ protected:
                                 int error);
     void connectionFailure();
 
+    friend class OpflexPool;
 };
 
 
@@ -12,6 +12,8 @@
  */
 
 #include <set>
+#include <mutex>
+#include <vector>
 #include <netinet/in.h>
 #include <boost/atomic.hpp>
 #include <boost/thread/mutex.hpp>
@@ -87,6 +89,24 @@ public:
                    const std::string& serverKeyPass,
                    bool verifyPeers = true);
 
+    /**
+     * Set the number of event loops used to service connections.
+     * Each loop runs in its own thread with its own listen socket
+     * bound to the same port using SO_REUSEPORT, so the kernel
+     * spreads new connections across the loops.  Only TCP listeners
+     * support more than one loop.  Call before listen().
+     *
+     * @param loops the number of loops; defaults to 1
+     */
+    void setListenerLoops(size_t loops);
+
+    /**
+     * Get the number of event loops used to service connections
+     *
+     * @return the number of loops
+     */
+    size_t getListenerLoops() const { return nloops; }
+
     /**
      * Start listening on the local socket for new connections
      */
@@ -134,7 +154,8 @@ public:
     void sendToOne(OpflexServerConnection* conn, OpflexMessage* message);
 
     /**
-     * Add pending update for conn
+     * Add pending update for the connections subscribed to the URI
+     * or to one of its ancestors
      *
      * @param class_id class_id for modb::reference_t
      * @param uri uri for modb::reference_t
@@ -146,7 +167,22 @@ public:
                           gbp::PolicyUpdateOp op);
 
     /**
-     * Send pending updates to each agent
+     * Add a pending property update for the connections subscribed
+     * to the URI or to one of its ancestors
+     *
+     * @param class_id class_id for modb::reference_t
+     * @param uri uri for modb::reference_t
+     * @param op the update operation type for peers that need the
+     * whole object
+     * @param props the IDs of the properties that changed
+     */
+    void addPendingDelta(modb::class_id_t class_id,
+                         const modb::URI& uri,
+                         gbp::PolicyUpdateOp op,
+                         const OF_UNORDERED_SET<modb::prop_id_t>& props);
+
+    /**
+     * Send pending updates to each agent that has any
      */
     void sendUpdates();
 
@@ -196,24 +232,51 @@ private:
 
     boost::atomic<bool> active;
 
-    uv_loop_t server_loop;
-    uv_thread_t server_thread;
-
-    yajr::Listener* listener;
-
     uv_mutex_t conn_mutex;
     uv_key_t conn_mutex_key;
     typedef std::set<OpflexServerConnection*> conn_set_t;
     conn_set_t conns;
 
-    uv_async_t cleanup_async;
-    uv_async_t writeq_async;
+    /**
+     * An event loop with its own listen socket and the connections
+     * accepted on it
+     */
+    struct ListenerLoop {
+        OpflexListener* owner;
+        size_t index;
+        uv_loop_t server_loop;
+        uv_thread_t server_thread;
+        uv_async_t cleanup_async;
+        uv_async_t writeq_async;
+        yajr::Listener* listener;
+        conn_set_t conns;
+    };
+    size_t nloops;
+    std::vector<boost::shared_ptr<ListenerLoop> > loops;
+
+    /**
+     * Index from a resolved URI to the connections subscribed to it
+     */
+    typedef OF_UNORDERED_MAP<modb::URI, conn_set_t> sub_map_t;
+    sub_map_t subscriptions;
+    std::mutex sub_mutex;
+
+    /**
+     * Connections with updates queued since the last sendUpdates()
+     */
+    conn_set_t pending_conns;
+
+    void subscribe(const modb::URI& uri, OpflexServerConnection* conn);
+    void unsubscribe(const modb::URI& uri, OpflexServerConnection* conn);
+    void getSubscribers(const modb::URI& uri, conn_set_t& subscribers);
 
     static void server_thread_func(void* processor);
     static void on_cleanup_async(uv_async_t *handle);
     static void on_writeq_async(uv_async_t *handle);
-    void messagesReady();
-    uv_loop_t* getLoop() { return &server_loop; }
+    void messagesReady(OpflexServerConnection* conn);
+    uv_loop_t* getLoop(OpflexServerConnection* conn) {
+        return &loops[conn->loop_index]->server_loop;
+    }
     void connectionClosed(OpflexServerConnection* conn);
 
     static void* on_new_connection(yajr::Listener* listener,
@@ -14,6 +14,7 @@
 #include <string>
 
 #include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/document.h>
@@ -87,6 +88,51 @@ public:
 
 };
 
+/**
+ * A message whose payload has already been serialized.  Used when
+ * fanning the same message out to many connections: the payload is
+ * rendered once into an immutable buffer that is shared by every
+ * clone, so only the per-connection envelope is written for each
+ * peer.
+ */
+class PreparedOpflexMessage : public OpflexMessage {
+public:
+    /**
+     * Serialize the payload of the given message
+     *
+     * @param message the message to prepare
+     */
+    explicit PreparedOpflexMessage(const OpflexMessage& message);
+
+    /**
+     * Destroy the message
+     */
+    virtual ~PreparedOpflexMessage() {}
+
+    /**
+     * Clone the opflex message.  The serialized payload is shared
+     * with the clone.
+     */
+    virtual PreparedOpflexMessage* clone() {
+        return new PreparedOpflexMessage(*this);
+    }
+
+    virtual void serializePayload(yajr::rpc::SendHandler& writer) const;
+
+    virtual uint64_t getReqXid() const { return xid; }
+
+    /**
+     * Get the serialized payload
+     *
+     * @return the payload as rendered by the original message
+     */
+    const std::string& getPayload() const { return *payload; }
+
+private:
+    boost::shared_ptr<const std::string> payload;
+    uint64_t xid;
+};
+
 } /* namespace internal */
 } /* namespace engine */
 } /* namespace opflex */
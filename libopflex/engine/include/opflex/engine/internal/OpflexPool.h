@@ -15,6 +15,7 @@
 #include <utility>
 #include <map>
 #include <set>
+#include <vector>
 #include <memory>
 #include <mutex>
 
@@ -353,7 +354,26 @@ public:
     }
 
     /**
-     * Retrieve OpFlex client stats for each available peer
+     * Set the number of event loops used for peer connections.  Each
+     * peer connection is pinned to the loop with the fewest
+     * connections when it is added, so that message parsing and TLS
+     * for several peers can run on several cores.  Call before
+     * start().
+     *
+     * @param loops the number of loops; defaults to 1
+     */
+    void setClientLoops(size_t loops);
+
+    /**
+     * Get the number of event loops used for peer connections
+     *
+     * @return the number of loops
+     */
+    size_t getClientLoops() const { return nloops; }
+
+    /**
+     * Retrieve OpFlex client stats for each available peer.  The
+     * event loop metrics in the stats are refreshed for each peer.
      *
      * @param stats Map of named peers to associated OpFlex stats
      */
@@ -409,10 +429,26 @@ private:
     boost::asio::ip::address_v4 mac_proxy;
     opflex::modb::MAC tunnelMac;
 
-    uv_loop_t* client_loop;
-    uv_async_t conn_async;
-    uv_async_t cleanup_async;
-    uv_async_t writeq_async;
+    /**
+     * An event loop serving a shard of the peer connections
+     */
+    class ClientLoop : private boost::noncopyable {
+    public:
+        OpflexPool* pool;
+        size_t index;
+        std::string taskName;
+        uv_loop_t* loop;
+        uv_async_t conn_async;
+        uv_async_t cleanup_async;
+        uv_async_t writeq_async;
+        uv_prepare_t cpu_prepare;
+        /** number of connections pinned to this loop */
+        size_t nconns;
+        /** CPU time used by the loop thread, sampled each iteration */
+        boost::atomic<uint64_t> cpuNs;
+    };
+    size_t nloops;
+    std::vector<OF_SHARED_PTR<ClientLoop> > loops;
 
     std::list<ofcore::PeerStatusListener*> peerStatusListeners;
     ofcore::PeerStatusListener::Health curHealth;
@@ -424,12 +460,17 @@ private:
                     ofcore::OFConstants::OpflexRole role);
     void connectionClosed(OpflexClientConnection* conn);
     void doConnectionClosed(OpflexClientConnection* conn);
-    uv_loop_t* getLoop() { return client_loop; }
-    void messagesReady();
+    void assignLoop(OpflexClientConnection* conn);
+    ClientLoop* getClientLoop(OpflexClientConnection* conn);
+    uv_loop_t* getLoop(OpflexClientConnection* conn) {
+        return getClientLoop(conn)->loop;
+    }
+    void messagesReady(OpflexClientConnection* conn);
 
     static void on_conn_async(uv_async_t *handle);
     static void on_cleanup_async(uv_async_t *handle);
     static void on_writeq_async(uv_async_t *handle);
+    static void on_cpu_prepare(uv_prepare_t *handle);
 
     void updatePeerStatus(const std::string& hostname, int port,
                           ofcore::PeerStatusListener::PeerStatus status);
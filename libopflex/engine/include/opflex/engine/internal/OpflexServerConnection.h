@@ -13,7 +13,9 @@
 
 #include <arpa/inet.h>
 #include <uv.h>
+#include <atomic>
 #include <mutex>
+#include <vector>
 
 #include "opflex/engine/internal/OpflexConnection.h"
 #include "opflex/modb/URI.h"
@@ -37,6 +39,14 @@ class OpflexListener;
  */
 class OpflexServerConnection : public OpflexConnection {
 public:
+    /**
+     * Objects for which only some properties changed, mapped to the
+     * IDs of the changed properties
+     */
+    typedef OF_UNORDERED_MAP<opflex::modb::reference_t,
+                             OF_UNORDERED_SET<opflex::modb::prop_id_t> >
+        delta_map_t;
+
     /**
      * Create a new server connection associated with the given
      *
@@ -81,10 +91,12 @@ public:
     virtual void messagesReady();
 
     /**
-     * Add URI to resolve uri map
+     * Add URI to resolve uri map.  The URI expires after lifetime
+     * seconds unless it is refreshed, rounded up to the next policy
+     * refresh tick.
      *
      * @param uri uri to be added to map
-     * @lifetime lifetime of the uri
+     * @param lifetime lifetime of the uri in seconds
      */
     void addUri(const opflex::modb::URI& uri, int64_t lifetime);
 
@@ -114,6 +126,29 @@ public:
                           const opflex::modb::URI& uri,
                           opflex::gbp::PolicyUpdateOp op);
 
+    /**
+     * Add a property update for an object to the pending update.  If
+     * the peer does not accept property updates the whole object is
+     * sent instead.
+     *
+     * @param class_id class_id for modb::reference_t
+     * @param uri uri for modb::reference_t
+     * @param op the update operation type to use for a full update
+     * @param props the IDs of the properties that changed
+     */
+    void addPendingDelta(opflex::modb::class_id_t class_id,
+                         const opflex::modb::URI& uri,
+                         opflex::gbp::PolicyUpdateOp op,
+                         const OF_UNORDERED_SET<opflex::modb::prop_id_t>& props);
+
+    /**
+     * Set whether the peer accepts property updates in policy_update
+     * messages, as advertised in its identity
+     *
+     * @param enabled true if the peer accepts property updates
+     */
+    void setPolicyDelta(bool enabled) { policyDelta = enabled; }
+
     /**
      * Send pending updates to each agent
      */
@@ -124,23 +159,58 @@ public:
      */
     void sendTimeouts();
 
+    /**
+     * Get the index of the listener event loop servicing this
+     * connection
+     *
+     * @return the loop index
+     */
+    size_t getLoopIndex() const { return loop_index; }
+
 private:
     OpflexListener* listener;
+    /**
+     * The listener event loop servicing this connection
+     */
+    size_t loop_index;
 
     std::string remote_peer;
     void setRemotePeer(int rc, struct sockaddr_storage& name);
     /**
-     * uri_map is a map of URIs agent is interested in
+     * uri_map is a map of URIs agent is interested in to the policy
+     * refresh tick at which they expire
      */
-    OF_UNORDERED_MAP<opflex::modb::URI, int64_t> uri_map;
+    OF_UNORDERED_MAP<opflex::modb::URI, uint64_t> uri_map;
     std::mutex uri_map_mutex;
 
+    /**
+     * Hashed timing wheel of URI expiry deadlines, indexed by policy
+     * refresh tick.  Entries whose deadline no longer matches uri_map
+     * have been refreshed or cleared and are dropped lazily.
+     */
+    static const size_t EXPIRY_WHEEL_SLOTS = 64;
+    typedef std::vector<std::pair<opflex::modb::URI, uint64_t> > wheel_slot_t;
+    wheel_slot_t expiry_wheel[EXPIRY_WHEEL_SLOTS];
+    uint64_t prr_tick;
+
+    /**
+     * Remove all the URIs of this connection from the listener's
+     * subscription index
+     */
+    void clearSubscriptions();
+
     /**
      * replace and del vectors are used to construct policy update
      */
     std::vector<opflex::modb::reference_t> replace;
     std::vector<opflex::modb::reference_t> merge;
     std::vector<opflex::modb::reference_t> deleted;
+    delta_map_t delta;
+
+    /**
+     * True if the peer accepts property updates
+     */
+    std::atomic<bool> policyDelta;
 
     /**
      * Start a thread for sending policy updates to agent
@@ -156,6 +226,8 @@ private:
     static void on_prr_timer_async(uv_async_t* handle);
 
     yajr::Peer* peer;
+
+    friend class OpflexListener;
 };
 
 
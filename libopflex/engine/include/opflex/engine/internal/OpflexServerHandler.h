@@ -12,6 +12,7 @@
  */
 
 #include <string>
+#include <vector>
 
 #include <boost/atomic.hpp>
 #include <boost/thread/lock_guard.hpp>
@@ -42,12 +43,13 @@ public:
      * connection
      */
     OpflexServerHandler(OpflexConnection* conn, GbpOpflexServerImpl* server_)
-        : OpflexHandler(conn), server(server_), flakyMode(false) {}
+        : OpflexHandler(conn), server(server_), flakyMode(false),
+          resolveErrors(false), holdStateReports(false) {}
 
     /**
      * Destroy the handler
      */
-    virtual ~OpflexServerHandler() {}
+    virtual ~OpflexServerHandler();
 
     /**
      * Check whether the server has recieved a specific resolution
@@ -70,6 +72,34 @@ public:
      */
     void setFlaky(bool flakyMode) { this->flakyMode = flakyMode; }
 
+    /**
+     * Enable or disable resolve errors.  When enabled, answer every
+     * policy resolve request with an error.
+     *
+     * @param resolveErrors true to enable resolve errors
+     */
+    void setResolveErrors(bool resolveErrors) {
+        this->resolveErrors = resolveErrors;
+    }
+
+    /**
+     * Enable or disable holding state report responses.  While
+     * enabled, state reports are applied but not acknowledged;
+     * disabling it sends the responses that were held.
+     *
+     * @param hold true to hold state report responses
+     */
+    void setHoldStateReports(bool hold);
+
+    /**
+     * Get the URIs of the observables in each state report received,
+     * in the order they were received
+     */
+    std::vector<std::vector<std::string> > getStateReports() {
+        boost::lock_guard<boost::mutex> guard(reportMutex);
+        return stateReports;
+    }
+
     // *************
     // OpflexHandler
     // *************
@@ -102,6 +132,11 @@ protected:
     OF_UNORDERED_SET<modb::reference_t> resolutions;
     OF_UNORDERED_SET<modb::reference_t> declarations;
     boost::atomic<bool> flakyMode;
+    boost::atomic<bool> resolveErrors;
+    boost::mutex reportMutex;
+    std::vector<std::vector<std::string> > stateReports;
+    bool holdStateReports;
+    std::vector<OpflexMessage*> heldResponses;
 };
 
 } /* namespace internal */
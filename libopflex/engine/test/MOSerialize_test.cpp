@@ -272,6 +272,140 @@ BOOST_FIXTURE_TEST_CASE( mo_deserialize , BaseFixture ) {
     serializer.readMOs(moFile, sysClient);
 }
 
+BOOST_FIXTURE_TEST_CASE( snapshot , BaseFixture ) {
+    StoreClient::notif_t notifs;
+
+    static const char buffer[] =
+        "[{\"subject\":\"class1\",\"uri\":\"/\",\"properties\":"
+        "[{\"name\":\"prop1\",\"data\":42}],\"children\":"
+        "[\"/class2/-84\",\"/class2/-42\"]},{\"subject\":\"class2\","
+        "\"uri\":\"/class2/-84\",\"properties\":[{\"name\":\"prop4\","
+        "\"data\":-84}],\"children\":[],\"parent_subject\":\"class1\","
+        "\"parent_uri\":\"/\",\"parent_relation\":\"class2\"},"
+        "{\"subject\":\"class2\",\"uri\":\"/class2/-42\",\"properties\":"
+        "[{\"name\":\"prop4\",\"data\":-42}],\"children\":[],"
+        "\"parent_subject\":\"class1\",\"parent_uri\":\"/\","
+        "\"parent_relation\":\"class2\"}]";
+
+    MOSerializer serializer(&db);
+    StoreClient& sysClient = db.getStoreClient("_SYSTEM_");
+    Document d;
+    d.Parse(buffer);
+    for (SizeType i = 0; i < d.Size(); ++i) {
+        serializer.deserialize(d[i], sysClient, false, &notifs);
+    }
+    notifs.clear();
+
+    string snapshotFilename("/tmp/mo-snapshot.db");
+    FILE* snapshotFile = fopen(snapshotFilename.c_str(), "w");
+    BOOST_REQUIRE(snapshotFile != NULL);
+    BOOST_CHECK_EQUAL(3, serializer.dumpSnapshot(snapshotFile));
+    fclose(snapshotFile);
+
+    URI uri2("/class2/-42");
+    sysClient.remove(2, uri2, false);
+    BOOST_CHECK_THROW(sysClient.get(2, uri2), out_of_range);
+
+    // only the missing object is loaded
+    std::vector<reference_t> loaded;
+    snapshotFile = fopen(snapshotFilename.c_str(), "r");
+    BOOST_REQUIRE(snapshotFile != NULL);
+    BOOST_CHECK_EQUAL(1, serializer.readSnapshot(snapshotFile, sysClient,
+                                                 notifs, loaded));
+    fclose(snapshotFile);
+    BOOST_CHECK(loaded.at(0) == make_pair((class_id_t)2, uri2));
+    BOOST_CHECK_EQUAL(-42, sysClient.get(2, uri2)->getInt64(4));
+    BOOST_CHECK(notifs.find(uri2) != notifs.end());
+    std::remove(snapshotFilename.c_str());
+}
+
+class DeltaListener : public MOSerializer::Listener {
+public:
+    virtual void remoteObjectUpdated(class_id_t class_id,
+                                     const URI& uri,
+                                     opflex::gbp::PolicyUpdateOp op) {
+        full.insert(uri);
+    }
+
+    virtual void remotePropertiesUpdated(class_id_t class_id,
+                                         const URI& uri,
+                                         opflex::gbp::PolicyUpdateOp op,
+                                         const OF_UNORDERED_SET<prop_id_t>& props) {
+        delta[uri] = props;
+    }
+
+    OF_UNORDERED_SET<URI> full;
+    OF_UNORDERED_MAP<URI, OF_UNORDERED_SET<prop_id_t> > delta;
+};
+
+BOOST_FIXTURE_TEST_CASE( delta , BaseFixture ) {
+    StoreClient::notif_t notifs;
+
+    static const char buffer[] =
+        "[{\"subject\":\"class1\",\"uri\":\"/\",\"properties\":"
+        "[{\"name\":\"prop2\",\"data\":[\"test1\",\"test2\"]},"
+        "{\"name\":\"prop1\",\"data\":42}],\"children\":"
+        "[\"/class2/-42\"]},{\"subject\":\"class2\","
+        "\"uri\":\"/class2/-42\",\"properties\":[{\"name\":\"prop4\","
+        "\"data\":-42}],\"children\":[],\"parent_subject\":\"class1\","
+        "\"parent_uri\":\"/\",\"parent_relation\":\"class2\"}]";
+    static const char buffer2[] =
+        "[{\"subject\":\"class1\",\"uri\":\"/\",\"properties\":"
+        "[{\"name\":\"prop1\",\"data\":84}],\"children\":"
+        "[\"/class2/-42\"]}]";
+
+    DeltaListener listener;
+    MOSerializer serializer(&db, &listener);
+    StoreClient& sysClient = db.getStoreClient("_SYSTEM_");
+    URI uri("/");
+    Document d;
+    d.Parse(buffer);
+    for (SizeType i = 0; i < d.Size(); ++i) {
+        serializer.deserialize(d[i], sysClient, true, &notifs);
+    }
+    BOOST_CHECK(listener.full.count(uri));
+    BOOST_CHECK(listener.delta.empty());
+
+    // only the properties of an existing object changed
+    Document d2;
+    d2.Parse(buffer2);
+    serializer.deserialize(d2[0], sysClient, true, &notifs);
+    BOOST_REQUIRE(listener.delta.count(uri));
+    const OF_UNORDERED_SET<prop_id_t>& changed = listener.delta[uri];
+    BOOST_CHECK_EQUAL(2, changed.size());
+    BOOST_CHECK(changed.count(1) && changed.count(2));
+
+    StringBuffer sb;
+    Writer<StringBuffer> writer(sb);
+    serializer.serializeDelta(1, uri, sysClient, writer, changed);
+    BOOST_CHECK_EQUAL("{\"subject\":\"class1\",\"uri\":\"/\","
+                      "\"properties\":[{\"name\":\"prop1\",\"data\":84}],"
+                      "\"unset\":[\"prop2\"]}", sb.GetString());
+
+    // restore the original and apply the delta
+    for (SizeType i = 0; i < d.Size(); ++i) {
+        serializer.deserialize(d[i], sysClient, true, &notifs);
+    }
+    notifs.clear();
+    Document d3;
+    d3.Parse(sb.GetString());
+    BOOST_CHECK(serializer.deserializeDelta(d3, sysClient, &notifs));
+    OF_SHARED_PTR<const ObjectInstance> oi = sysClient.get(1, uri);
+    BOOST_CHECK_EQUAL(84, oi->getUInt64(1));
+    BOOST_CHECK_EQUAL(0, oi->getStringSize(2));
+    std::vector<URI> children;
+    sysClient.getChildren(1, uri, 3, 2, children);
+    BOOST_CHECK_EQUAL(1, children.size());
+    BOOST_CHECK_EQUAL(1, notifs.size());
+    BOOST_CHECK(notifs.find(uri) != notifs.end());
+
+    // nothing to apply the delta to
+    Document d4;
+    d4.Parse("{\"subject\":\"class2\",\"uri\":\"/class2/-84\","
+             "\"properties\":[{\"name\":\"prop4\",\"data\":-84}]}");
+    BOOST_CHECK(!serializer.deserializeDelta(d4, sysClient, &notifs));
+}
+
 BOOST_FIXTURE_TEST_CASE( types , BaseFixture ) {
     MOSerializer serializer(&db);
     StringBuffer buffer;
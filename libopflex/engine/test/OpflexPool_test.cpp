@@ -15,10 +15,16 @@
 #endif
 
 
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include <boost/test/unit_test.hpp>
 
 #include "opflex/ofcore/OFConstants.h"
 #include "opflex/engine/internal/OpflexPool.h"
+#include "opflex/engine/internal/OpflexMessage.h"
+#include "opflex/ofcore/OFStats.h"
 
 using namespace opflex::engine;
 using namespace opflex::engine::internal;
@@ -58,6 +64,40 @@ public:
     bool closed;
 };
 
+class CountingMessage : public OpflexMessage {
+public:
+    CountingMessage(int& count_)
+        : OpflexMessage("test_method", REQUEST), count(count_) {}
+
+    virtual CountingMessage* clone() {
+        return new CountingMessage(*this);
+    }
+
+    virtual void serializePayload(yajr::rpc::SendHandler& writer) const {
+        count += 1;
+        writer.StartArray();
+        writer.StartObject();
+        writer.String("value");
+        writer.Uint(42);
+        writer.EndObject();
+        writer.EndArray();
+    }
+
+    virtual uint64_t getReqXid() const { return 7; }
+
+    int& count;
+};
+
+static std::string serializeEnvelope(const OpflexMessage& message) {
+    yajr::internal::StringQueue sq;
+    yajr::rpc::SendHandler writer(sq);
+    writer.StartObject();
+    writer.String("params");
+    message.serializePayload(writer);
+    writer.EndObject();
+    return sq.GetString();
+}
+
 class PoolFixture {
 public:
     PoolFixture() : pool(handlerFactory, threadManager) {
@@ -73,8 +113,124 @@ public:
     OpflexPool pool;
 };
 
+class MultiLoopFixture {
+public:
+    MultiLoopFixture() : pool(handlerFactory, threadManager) {
+        pool.setClientLoops(3);
+        pool.start();
+    }
+
+    ~MultiLoopFixture() {
+        pool.stop();
+    }
+
+    OF_SHARED_PTR<OFStats> getStats(const std::string& peer) {
+        std::unordered_map<std::string,
+                           OF_SHARED_PTR<OFStats> > stats;
+        pool.getOpflexPeerStats(stats);
+        auto it = stats.find(peer);
+        BOOST_REQUIRE(it != stats.end());
+        return it->second;
+    }
+
+    uint64_t getLoopId(const std::string& peer) {
+        return getStats(peer)->getLoopId();
+    }
+
+    opflex::util::ThreadManager threadManager;
+    EmptyHandlerFactory handlerFactory;
+    OpflexPool pool;
+};
+
+/**
+ * Connection that keeps its queued messages instead of handing them
+ * to the pool event loop
+ */
+class HeldWritesConn : public MockClientConn {
+public:
+    HeldWritesConn(HandlerFactory& handlerFactory,
+                   OpflexPool* pool,
+                   const std::string& hostname,
+                   int port)
+        : MockClientConn(handlerFactory, pool, hostname, port) {}
+
+    virtual void messagesReady() {}
+};
+
 BOOST_AUTO_TEST_SUITE(OpflexPool_test)
 
+BOOST_FIXTURE_TEST_CASE( loop_assignment , MultiLoopFixture ) {
+    BOOST_CHECK_EQUAL(3, pool.getClientLoops());
+
+    MockClientConn* c1 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1234);
+    MockClientConn* c2 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1235);
+    MockClientConn* c3 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1236);
+    MockClientConn* c4 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1237);
+    pool.addPeer(c1);
+    pool.addPeer(c2);
+    pool.addPeer(c3);
+
+    // each peer goes to the least loaded loop
+    BOOST_CHECK_EQUAL(0, getLoopId("1.2.3.4:1234"));
+    BOOST_CHECK_EQUAL(1, getLoopId("1.2.3.4:1235"));
+    BOOST_CHECK_EQUAL(2, getLoopId("1.2.3.4:1236"));
+
+    pool.addPeer(c4);
+    BOOST_CHECK_EQUAL(0, getLoopId("1.2.3.4:1237"));
+
+    // removing a peer frees its place on the loop, and the next peer
+    // is pinned there
+    c2->disconnect();
+    MockClientConn* c5 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1238);
+    pool.addPeer(c5);
+    BOOST_CHECK_EQUAL(1, getLoopId("1.2.3.4:1238"));
+
+    MockClientConn* c6 = new MockClientConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1239);
+    pool.addPeer(c6);
+    BOOST_CHECK_EQUAL(1, getLoopId("1.2.3.4:1239"));
+
+    c1->disconnect();
+    c3->disconnect();
+    c4->disconnect();
+    c5->disconnect();
+    c6->disconnect();
+}
+
+BOOST_FIXTURE_TEST_CASE( loop_stats , MultiLoopFixture ) {
+    HeldWritesConn* c1 = new HeldWritesConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1234);
+    HeldWritesConn* c2 = new HeldWritesConn(handlerFactory, &pool,
+                                            "1.2.3.4", 1235);
+    pool.addPeer(c1);
+    pool.addPeer(c2);
+
+    OF_SHARED_PTR<OFStats> s1 = getStats("1.2.3.4:1234");
+    BOOST_CHECK_EQUAL(0, s1->getLoopId());
+    BOOST_CHECK_EQUAL(0, s1->getWriteQueueDepth());
+    uint64_t cpuMs = s1->getLoopCpuMs();
+
+    int count = 0;
+    c2->sendMessage(new CountingMessage(count), false);
+    c2->sendMessage(new CountingMessage(count), false);
+
+    OF_SHARED_PTR<OFStats> s2 = getStats("1.2.3.4:1235");
+    BOOST_CHECK_EQUAL(1, s2->getLoopId());
+    BOOST_CHECK_EQUAL(2, s2->getWriteQueueDepth());
+    BOOST_CHECK_EQUAL(0, getStats("1.2.3.4:1234")->getWriteQueueDepth());
+
+    // the loop CPU time only moves forward
+    BOOST_CHECK(getStats("1.2.3.4:1234")->getLoopCpuMs() >= cpuMs);
+
+    c1->disconnect();
+    c2->disconnect();
+}
+
 BOOST_FIXTURE_TEST_CASE( manage_roles , PoolFixture ) {
     MockClientConn* c1 = new MockClientConn(handlerFactory, &pool,
                                             "1.2.3.4", 1234);
@@ -164,4 +320,47 @@ BOOST_FIXTURE_TEST_CASE( manage_ivxlan_roles , PoolFixture ) {
     c3->disconnect();
 }
 
+BOOST_AUTO_TEST_CASE( prepared_message ) {
+    int count = 0;
+    CountingMessage message(count);
+    std::string expected = serializeEnvelope(message);
+    BOOST_CHECK_EQUAL(1, count);
+
+    PreparedOpflexMessage prepared(message);
+    BOOST_CHECK_EQUAL(2, count);
+    BOOST_CHECK_EQUAL("test_method", prepared.getMethod());
+    BOOST_CHECK_EQUAL(7u, prepared.getReqXid());
+
+    std::unique_ptr<OpflexMessage> c1(prepared.clone());
+    std::unique_ptr<OpflexMessage> c2(prepared.clone());
+    BOOST_CHECK_EQUAL(expected, serializeEnvelope(*c1));
+    BOOST_CHECK_EQUAL(expected, serializeEnvelope(*c2));
+    BOOST_CHECK_EQUAL(2, count);
+    BOOST_CHECK_EQUAL(&prepared.getPayload(),
+                      &static_cast<PreparedOpflexMessage*>(c1.get())->getPayload());
+
+    // the payload is queued to the connection by reference
+    yajr::internal::StringQueue sq;
+    yajr::rpc::SendHandler writer(sq);
+    writer.StartObject();
+    writer.String("params");
+    c1->serializePayload(writer);
+    writer.EndObject();
+    bool shared = false;
+    for (const iovec& i : sq.GetIovec()) {
+        if (i.iov_base == prepared.getPayload().data() &&
+            i.iov_len == prepared.getPayload().size())
+            shared = true;
+    }
+    BOOST_CHECK(shared);
+    BOOST_CHECK_EQUAL(expected, sq.GetString());
+
+    // consuming across the shared chunk leaves the rest queued
+    size_t head = expected.size() - 2;
+    sq.Consume(head);
+    BOOST_CHECK_EQUAL(expected.substr(head), sq.GetString());
+    sq.Consume(2);
+    BOOST_CHECK(sq.Empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,9 +15,14 @@
 #endif
 
 
+#include <algorithm>
+#include <cstdio>
+#include <set>
 #include <vector>
 #include <unistd.h>
 
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/thread/lock_guard.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/assign/list_of.hpp>
@@ -431,6 +436,89 @@ BOOST_FIXTURE_TEST_CASE( endpoint_declare_flaky, ServerFixture ) {
     BOOST_CHECK_EQUAL(43, roi2_2->getInt64(4));
 }
 
+class MultiLoopServerFixture : public BaseFixture {
+public:
+    MultiLoopServerFixture()
+        : opflexServer(8009, SERVER_ROLES,
+                       list_of(make_pair(SERVER_ROLES, LOCALHOST":8009")),
+                       vector<std::string>(),
+                       md, 60) {
+        opflexServer.setListenerLoops(2);
+        opflexServer.start();
+        WAIT_FOR(opflexServer.getListener().isListening(), 1000);
+    }
+
+    ~MultiLoopServerFixture() {
+        BOOST_FOREACH(Processor* p, clients) {
+            p->stop();
+            delete p;
+        }
+        BOOST_FOREACH(ObjectStore* s, stores) {
+            s->stop();
+            delete s;
+        }
+        opflexServer.stop();
+        threadManager.stop();
+    }
+
+    Processor* addClient() {
+        ObjectStore* store = new ObjectStore(threadManager);
+        store->init(md);
+        store->start();
+        stores.push_back(store);
+
+        Processor* p = new Processor(store, threadManager);
+        p->setOpflexIdentity("testelement" +
+                             boost::lexical_cast<std::string>(clients.size()),
+                             "testdomain");
+        p->start();
+        p->addPeer(LOCALHOST, 8009);
+        clients.push_back(p);
+        return p;
+    }
+
+    GbpOpflexServerImpl opflexServer;
+    vector<ObjectStore*> stores;
+    vector<Processor*> clients;
+};
+
+static bool loop_index_pred(OpflexServerConnection* conn, void* user) {
+    ((std::set<size_t>*)user)->insert(conn->getLoopIndex());
+    return true;
+}
+
+static bool count_conn_pred(OpflexServerConnection* conn, void* user) {
+    (*(size_t*)user) += 1;
+    return true;
+}
+
+static size_t countServerConns(GbpOpflexServerImpl& server) {
+    size_t count = 0;
+    server.getListener().applyConnPred(count_conn_pred, &count);
+    return count;
+}
+
+// connections accepted by a multi-loop listener should be spread
+// across its loops and each should complete its handshake
+BOOST_FIXTURE_TEST_CASE( listener_loops, MultiLoopServerFixture ) {
+    static const size_t NCLIENTS = 16;
+    BOOST_CHECK_EQUAL(2, opflexServer.getListener().getListenerLoops());
+
+    for (size_t i = 0; i < NCLIENTS; ++i)
+        addClient();
+    BOOST_FOREACH(Processor* p, clients) {
+        WAIT_FOR(connReady(p->getPool(), LOCALHOST, 8009), 1000);
+    }
+    WAIT_FOR(countServerConns(opflexServer) == NCLIENTS, 1000);
+
+    std::set<size_t> loopIndexes;
+    opflexServer.getListener().applyConnPred(loop_index_pred, &loopIndexes);
+    BOOST_CHECK_EQUAL(2, loopIndexes.size());
+    BOOST_FOREACH(size_t index, loopIndexes) {
+        BOOST_CHECK(index < 2);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE( main_loop_adaptor, SyncFixture ) {
     GbpOpflexServerImpl opflexServer(8009,
                                      SERVER_ROLES,
@@ -663,6 +751,285 @@ BOOST_FIXTURE_TEST_CASE( policy_resolve_flaky, PolicyFixture ) {
     WAIT_FOR(opflexServer.getListener().applyConnPred(resolutions_pred, NULL), 1000);
 }
 
+// test that an update to a child is sent to the peers subscribed to
+// its ancestor
+BOOST_FIXTURE_TEST_CASE( policy_update_subtree, PolicyFixture ) {
+    startClient();
+    WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+    setup();
+
+    WAIT_FOR(itemPresent(client2, 6, c6u), 1000);
+    WAIT_FOR(opflexServer.getListener().applyConnPred(resolutions_pred, NULL), 1000);
+
+    vector<reference_t> replace;
+    vector<reference_t> merge;
+    vector<reference_t> del;
+
+    oi6->setString(13, "subtree");
+    rclient->put(6, c6u, oi6);
+    merge.emplace_back(6, c6u);
+    opflexServer.policyUpdate(replace, merge, del);
+    WAIT_FOR("subtree" == client2->get(6, c6u)->getString(13), 1000);
+    BOOST_CHECK_EQUAL("test", client2->get(4, c4u)->getString(9));
+}
+
+static bool get_conn_pred(OpflexServerConnection* conn, void* user) {
+    *(OpflexServerConnection**)user = conn;
+    return true;
+}
+
+// test that a property update for an object the client is missing
+// makes the client resolve the object again
+BOOST_FIXTURE_TEST_CASE( policy_update_missing, PolicyFixture ) {
+    startClient();
+    WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+    setup();
+
+    WAIT_FOR(itemPresent(client2, 6, c6u), 1000);
+    WAIT_FOR(opflexServer.getListener().applyConnPred(resolutions_pred, NULL), 1000);
+
+    // lose the child on the client
+    client2->remove(6, c6u, false);
+    BOOST_CHECK(!itemPresent(client2, 6, c6u));
+
+    OpflexServerConnection* conn = NULL;
+    opflexServer.getListener().applyConnPred(get_conn_pred, &conn);
+    BOOST_REQUIRE(conn != NULL);
+
+    oi6->setString(13, "delta");
+    rclient->put(6, c6u, oi6);
+    OpflexServerConnection::delta_map_t delta;
+    delta[std::make_pair((class_id_t)6, c6u)].insert(13);
+    opflexServer.policyUpdate(conn, vector<reference_t>(),
+                              vector<reference_t>(), vector<reference_t>(),
+                              delta);
+
+    WAIT_FOR(itemPresent(client2, 6, c6u), 1000);
+    BOOST_CHECK_EQUAL("delta", client2->get(6, c6u)->getString(13));
+    BOOST_CHECK_EQUAL("test", client2->get(4, c4u)->getString(9));
+}
+
+static const char SNAPSHOT[] =
+    "[{\"subject\":\"class4\",\"uri\":\"/class4/test/\",\"properties\":"
+    "[{\"name\":\"prop9\",\"data\":\"old\"}],\"children\":[],"
+    "\"parent_subject\":\"class1\",\"parent_uri\":\"/\","
+    "\"parent_relation\":\"class4\"},"
+    "{\"subject\":\"class4\",\"uri\":\"/class4/gone/\",\"properties\":"
+    "[{\"name\":\"prop9\",\"data\":\"gone\"}],\"children\":[],"
+    "\"parent_subject\":\"class1\",\"parent_uri\":\"/\","
+    "\"parent_relation\":\"class4\"}]";
+
+class SnapshotFixture : public BasePFixture {
+public:
+    SnapshotFixture(uint64_t holdTime)
+        : BasePFixture(),
+          snapshotFile("/tmp/processor-snapshot.db"),
+          opflexServer(8009, SERVER_ROLES,
+                       list_of(make_pair(SERVER_ROLES, LOCALHOST":8009")),
+                       vector<std::string>(),
+                       md, 60),
+          c4u("/class4/test/"),
+          c4gone("/class4/gone/"),
+          c5u("/class5/test/"),
+          c6u("/class4/test/class6/test2/") {
+        FILE* f = fopen(snapshotFile.c_str(), "w");
+        BOOST_REQUIRE(f != NULL);
+        fputs(SNAPSHOT, f);
+        fclose(f);
+
+        processor.setSnapshot(snapshotFile, 60000, holdTime);
+        processor.start();
+        opflexServer.start();
+        WAIT_FOR(opflexServer.getListener().isListening(), 1000);
+
+        // the local root must exist before the snapshot is loaded
+        client1->put(1, URI::ROOT, OF_MAKE_SHARED<ObjectInstance>(1));
+        client1->queueNotification(1, URI::ROOT, notifs);
+        client1->deliverNotifications(notifs);
+        notifs.clear();
+
+        // the server has the current version of the first object
+        // only
+        StoreClient* rclient = opflexServer.getSystemClient();
+        OF_SHARED_PTR<ObjectInstance> oi4 =
+            OF_MAKE_SHARED<ObjectInstance>(4);
+        OF_SHARED_PTR<ObjectInstance> oi6 =
+            OF_MAKE_SHARED<ObjectInstance>(6);
+        oi4->setString(9, "test");
+        oi6->setString(13, "test2");
+        rclient->put(1, URI::ROOT, OF_MAKE_SHARED<ObjectInstance>(1));
+        rclient->put(4, c4u, oi4);
+        rclient->put(6, c6u, oi6);
+        rclient->addChild(1, URI::ROOT, 8, 4, c4u);
+        rclient->addChild(4, c4u, 12, 6, c6u);
+    }
+
+    ~SnapshotFixture() {
+        processor.stop();
+        opflexServer.stop();
+        std::remove(snapshotFile.c_str());
+    }
+
+    void setReference(bool set) {
+        if (set) {
+            OF_SHARED_PTR<ObjectInstance> oi5 =
+                OF_MAKE_SHARED<ObjectInstance>(5);
+            oi5->setString(10, "test");
+            oi5->addReference(11, 4, c4u);
+            oi5->addReference(11, 4, c4gone);
+            client2->put(5, c5u, oi5);
+        } else {
+            client2->remove(5, c5u, false, &notifs);
+        }
+        client2->queueNotification(5, c5u, notifs);
+        client2->deliverNotifications(notifs);
+        notifs.clear();
+    }
+
+    std::string snapshotFile;
+    GbpOpflexServerImpl opflexServer;
+    StoreClient::notif_t notifs;
+    URI c4u;
+    URI c4gone;
+    URI c5u;
+    URI c6u;
+};
+
+class SnapshotHoldFixture : public SnapshotFixture {
+public:
+    SnapshotHoldFixture() : SnapshotFixture(500) {}
+};
+
+class SnapshotResolveFixture : public SnapshotFixture {
+public:
+    SnapshotResolveFixture() : SnapshotFixture(60000) {}
+};
+
+// unreferenced objects from the snapshot are kept until the hold
+// time expires
+BOOST_FIXTURE_TEST_CASE( snapshot_stale_hold, SnapshotHoldFixture ) {
+    BOOST_CHECK_EQUAL(2, processor.loadSnapshot());
+    BOOST_REQUIRE(itemPresent(client2, 4, c4u));
+    BOOST_CHECK_EQUAL("old", client2->get(4, c4u)->getString(9));
+
+    usleep(250000);
+    BOOST_CHECK(itemPresent(client2, 4, c4u));
+    BOOST_CHECK(itemPresent(client2, 4, c4gone));
+
+    WAIT_FOR(!itemPresent(client2, 4, c4u), 2000);
+    WAIT_FOR(!itemPresent(client2, 4, c4gone), 2000);
+}
+
+// resolving stale objects replaces the ones the peer returns and
+// removes the ones it no longer has, even while referenced
+BOOST_FIXTURE_TEST_CASE( snapshot_revalidate, SnapshotResolveFixture ) {
+    BOOST_CHECK_EQUAL(2, processor.loadSnapshot());
+    setReference(true);
+    startClient();
+    WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+
+    WAIT_FOR("test" == client2->get(4, c4u)->getString(9), 1000);
+    WAIT_FOR(itemPresent(client2, 6, c6u), 1000);
+    WAIT_FOR(!itemPresent(client2, 4, c4gone), 1000);
+
+    // a revalidated object is collected as usual once unreferenced,
+    // without waiting for the hold time
+    setReference(false);
+    WAIT_FOR(!itemPresent(client2, 4, c4u), 2000);
+    WAIT_FOR(!itemPresent(client2, 6, c6u), 2000);
+}
+
+static bool resolve_errors_pred(OpflexServerConnection* conn, void* user) {
+    OpflexServerHandler* handler = (OpflexServerHandler*)conn->getHandler();
+    handler->setResolveErrors(true);
+    return true;
+}
+
+static uint64_t resolveErrs(Processor& processor) {
+    OpflexClientConnection* conn =
+        processor.getPool().getPeer(LOCALHOST, 8009);
+    return conn ? conn->getOpflexStats()->getPolResolveErrs() : 0;
+}
+
+// a failed resolve ends the hold of the stale objects it covered,
+// but does not remove them
+BOOST_FIXTURE_TEST_CASE( snapshot_resolve_error, SnapshotResolveFixture ) {
+    BOOST_CHECK_EQUAL(2, processor.loadSnapshot());
+    startClient();
+    WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+    opflexServer.getListener().applyConnPred(resolve_errors_pred, NULL);
+
+    setReference(true);
+    WAIT_FOR(resolveErrs(processor) >= 2, 1000);
+    BOOST_CHECK_EQUAL("old", client2->get(4, c4u)->getString(9));
+    BOOST_CHECK(itemPresent(client2, 4, c4gone));
+
+    setReference(false);
+    WAIT_FOR(!itemPresent(client2, 4, c4u), 2000);
+    WAIT_FOR(!itemPresent(client2, 4, c4gone), 2000);
+}
+
+typedef std::pair<URI, int64_t> uri_lifetime_t;
+
+static bool add_uri_pred(OpflexServerConnection* conn, void* user) {
+    uri_lifetime_t* u = (uri_lifetime_t*)user;
+    conn->addUri(u->first, u->second);
+    return true;
+}
+
+static bool get_uri_pred(OpflexServerConnection* conn, void* user) {
+    return conn->getUri(*(URI*)user);
+}
+
+class PrrFixture : public Fixture {
+public:
+    PrrFixture()
+        : opflexServer(8009, SERVER_ROLES,
+                       list_of(make_pair(SERVER_ROLES, LOCALHOST":8009")),
+                       vector<std::string>(),
+                       md, 1) {
+        opflexServer.start();
+        WAIT_FOR(opflexServer.getListener().isListening(), 1000);
+        processor.addPeer(LOCALHOST, 8009);
+        WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+    }
+
+    ~PrrFixture() {
+        opflexServer.stop();
+    }
+
+    GbpOpflexServerImpl opflexServer;
+};
+
+// test expiry of resolved URIs on the policy refresh ticks
+BOOST_FIXTURE_TEST_CASE( uri_expiry, PrrFixture ) {
+    OpflexListener& listener = opflexServer.getListener();
+    URI shortUri("/expirytest/short/");
+    URI longUri("/expirytest/long/");
+    URI refreshUri("/expirytest/refresh/");
+
+    uri_lifetime_t s(shortUri, 1);
+    uri_lifetime_t l(longUri, 3600);
+    uri_lifetime_t r(refreshUri, 1);
+    listener.applyConnPred(add_uri_pred, &s);
+    listener.applyConnPred(add_uri_pred, &l);
+    listener.applyConnPred(add_uri_pred, &r);
+    BOOST_CHECK(listener.applyConnPred(get_uri_pred, &shortUri));
+    BOOST_CHECK(listener.applyConnPred(get_uri_pred, &longUri));
+
+    // refreshing moves the deadline; the old wheel entry is stale
+    r.second = 3600;
+    listener.applyConnPred(add_uri_pred, &r);
+
+    WAIT_FOR(!listener.applyConnPred(get_uri_pred, &shortUri), 5000);
+    BOOST_CHECK(listener.applyConnPred(get_uri_pred, &longUri));
+
+    // let the stale entry for the refreshed URI come due
+    usleep(2500000);
+    BOOST_CHECK(listener.applyConnPred(get_uri_pred, &refreshUri));
+    BOOST_CHECK(listener.applyConnPred(get_uri_pred, &longUri));
+}
+
 class StateFixture : public ServerFixture {
 public:
     StateFixture()
@@ -741,6 +1108,211 @@ BOOST_FIXTURE_TEST_CASE( state_report_reconnect, StateFixture ) {
     BOOST_CHECK_EQUAL(12, rclient->get(3, u3)->getInt64(6));
 }
 
+static bool hold_reports_pred(OpflexServerConnection* conn, void* user) {
+    OpflexServerHandler* handler = (OpflexServerHandler*)conn->getHandler();
+    handler->setHoldStateReports(*(bool*)user);
+    return true;
+}
+
+static bool get_reports_pred(OpflexServerConnection* conn, void* user) {
+    OpflexServerHandler* handler = (OpflexServerHandler*)conn->getHandler();
+    *(vector<vector<std::string> >*)user = handler->getStateReports();
+    return true;
+}
+
+class ReportFixture : public StateFixture {
+public:
+    ReportFixture() : StateFixture(), baseReports(0) {
+        // keep unacknowledged reports in the window for the whole test
+        processor.setRetryDelay(60000);
+    }
+
+    void start() {
+        startClient();
+        WAIT_FOR(connReady(processor.getPool(), LOCALHOST, 8009), 1000);
+        setup();
+        WAIT_FOR(itemPresent(rclient, 3, u3), 1000);
+        WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+        baseReports = getStateReports().size();
+    }
+
+    URI putObservable(int64_t id, const std::string& value) {
+        URI uri("/class2/42/class3/" + std::to_string(id) + "/test/");
+        OF_SHARED_PTR<ObjectInstance> oi = OF_MAKE_SHARED<ObjectInstance>(3);
+        oi->setInt64(6, id);
+        oi->setString(7, "test");
+        oi->setString(16, value);
+        client2->put(3, uri, oi);
+        client2->queueNotification(3, uri, notifs);
+        client2->deliverNotifications(notifs);
+        notifs.clear();
+        return uri;
+    }
+
+    void holdStateReports(bool hold) {
+        opflexServer.getListener().applyConnPred(hold_reports_pred, &hold);
+    }
+
+    // state reports received by the server since start()
+    vector<vector<std::string> > getStateReports() {
+        vector<vector<std::string> > reports;
+        opflexServer.getListener().applyConnPred(get_reports_pred, &reports);
+        reports.erase(reports.begin(), reports.begin() + baseReports);
+        return reports;
+    }
+
+    // hold the server responses and report one observable at a time
+    // until the window of unacknowledged reports is full
+    void fillReportWindow() {
+        holdStateReports(true);
+        for (size_t i = 0; i < Processor::MAX_OUTSTANDING_REPORTS; i++) {
+            putObservable(100 + i, "fill");
+            WAIT_FOR(getStateReports().size() == i + 1, 1000);
+        }
+        WAIT_FOR(processor.getOutstandingReportCount() ==
+                 Processor::MAX_OUTSTANDING_REPORTS, 1000);
+    }
+
+    size_t baseReports;
+};
+
+// test that a full window holds back reports until responses arrive
+BOOST_FIXTURE_TEST_CASE( state_report_window, ReportFixture ) {
+    start();
+    fillReportWindow();
+
+    URI u = putObservable(200, "blocked");
+    WAIT_FOR(processor.getPendingReportCount() == 1, 1000);
+    usleep(100000);
+    BOOST_CHECK_EQUAL(Processor::MAX_OUTSTANDING_REPORTS,
+                      getStateReports().size());
+    BOOST_CHECK_EQUAL(Processor::MAX_OUTSTANDING_REPORTS,
+                      processor.getOutstandingReportCount());
+    BOOST_CHECK(!itemPresent(rclient, 3, u));
+
+    // the responses reopen the window
+    holdStateReports(false);
+    WAIT_FOR(itemPresent(rclient, 3, u), 1000);
+    WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+    BOOST_CHECK_EQUAL(0, processor.getPendingReportCount());
+    vector<vector<std::string> > reports = getStateReports();
+    BOOST_REQUIRE_EQUAL(Processor::MAX_OUTSTANDING_REPORTS + 1,
+                        reports.size());
+    BOOST_REQUIRE_EQUAL(1, reports.back().size());
+    BOOST_CHECK_EQUAL(u.toString(), reports.back().front());
+}
+
+// test that queued observables are sent in batches
+BOOST_FIXTURE_TEST_CASE( state_report_batch, ReportFixture ) {
+    start();
+    fillReportWindow();
+
+    const size_t count = 2 * Processor::MAX_REPORT_BATCH + 88;
+    for (size_t i = 0; i < count; i++)
+        putObservable(1000 + i, "batch");
+    WAIT_FOR(processor.getPendingReportCount() == count, 5000);
+
+    holdStateReports(false);
+    WAIT_FOR(processor.getPendingReportCount() == 0, 1000);
+    WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+
+    vector<vector<std::string> > reports = getStateReports();
+    BOOST_REQUIRE_EQUAL(Processor::MAX_OUTSTANDING_REPORTS + 3,
+                        reports.size());
+    BOOST_CHECK_EQUAL(Processor::MAX_REPORT_BATCH, reports[4].size());
+    BOOST_CHECK_EQUAL(Processor::MAX_REPORT_BATCH, reports[5].size());
+    BOOST_CHECK_EQUAL(88, reports[6].size());
+
+    // every observable is reported exactly once
+    OF_UNORDERED_SET<std::string> uris;
+    for (size_t i = Processor::MAX_OUTSTANDING_REPORTS;
+         i < reports.size(); i++)
+        uris.insert(reports[i].begin(), reports[i].end());
+    BOOST_CHECK_EQUAL(count, uris.size());
+}
+
+// test that an observable that changes while queued is reported once
+// with its latest state
+BOOST_FIXTURE_TEST_CASE( state_report_dedup, ReportFixture ) {
+    start();
+    fillReportWindow();
+
+    URI u = putObservable(200, "v0");
+    WAIT_FOR(processor.getPendingReportCount() == 1, 1000);
+    for (int i = 1; i <= 4; i++) {
+        putObservable(200, "v" + std::to_string(i));
+        usleep(20000);
+    }
+    BOOST_CHECK_EQUAL(1, processor.getPendingReportCount());
+
+    holdStateReports(false);
+    WAIT_FOR(itemPresent(rclient, 3, u), 1000);
+    WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+    BOOST_CHECK_EQUAL("v4", rclient->get(3, u)->getString(16));
+
+    vector<vector<std::string> > reports = getStateReports();
+    BOOST_REQUIRE_EQUAL(Processor::MAX_OUTSTANDING_REPORTS + 1,
+                        reports.size());
+    BOOST_REQUIRE_EQUAL(1, reports.back().size());
+    BOOST_CHECK_EQUAL(u.toString(), reports.back().front());
+}
+
+// test that higher priority observables are reported first.  The
+// test model has a single observable class, so its priority is
+// raised between queueing the two objects.
+BOOST_FIXTURE_TEST_CASE( state_report_priority, ReportFixture ) {
+    start();
+    fillReportWindow();
+
+    URI low = putObservable(200, "low");
+    WAIT_FOR(processor.getPendingReportCount() == 1, 1000);
+    processor.setObservablePriority(3, 1);
+    URI high = putObservable(201, "high");
+    WAIT_FOR(processor.getPendingReportCount() == 2, 1000);
+
+    holdStateReports(false);
+    WAIT_FOR(processor.getPendingReportCount() == 0, 1000);
+    WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+
+    vector<vector<std::string> > reports = getStateReports();
+    BOOST_REQUIRE_EQUAL(Processor::MAX_OUTSTANDING_REPORTS + 2,
+                        reports.size());
+    BOOST_REQUIRE_EQUAL(1, reports[4].size());
+    BOOST_CHECK_EQUAL(high.toString(), reports[4].front());
+    BOOST_REQUIRE_EQUAL(1, reports[5].size());
+    BOOST_CHECK_EQUAL(low.toString(), reports[5].front());
+}
+
+// test that a new connection reopens a window held full by reports
+// that will never be acknowledged
+BOOST_FIXTURE_TEST_CASE( state_report_reconnect_window, ReportFixture ) {
+    start();
+    fillReportWindow();
+
+    URI u = putObservable(200, "blocked");
+    WAIT_FOR(processor.getPendingReportCount() == 1, 1000);
+
+    // what the handler calls once a reconnected peer is ready
+    processor.connectionReady(processor.getPool().getPeer(LOCALHOST, 8009));
+    WAIT_FOR(processor.getPendingReportCount() == 0, 1000);
+    WAIT_FOR(getStateReports().size() ==
+             Processor::MAX_OUTSTANDING_REPORTS + 1, 1000);
+    BOOST_CHECK_EQUAL(1, processor.getOutstandingReportCount());
+
+    // the observables are all reported again, including the one that
+    // was blocked
+    vector<vector<std::string> > reports = getStateReports();
+    BOOST_REQUIRE_EQUAL(Processor::MAX_OUTSTANDING_REPORTS + 1,
+                        reports.size());
+    const vector<std::string>& last = reports.back();
+    BOOST_CHECK(std::find(last.begin(), last.end(), u.toString()) !=
+                last.end());
+
+    holdStateReports(false);
+    WAIT_FOR(itemPresent(rclient, 3, u), 1000);
+    WAIT_FOR(processor.getOutstandingReportCount() == 0, 1000);
+}
+
 class EndpointResFixture : public ServerFixture {
 public:
     EndpointResFixture()
@@ -871,4 +1443,14 @@ BOOST_FIXTURE_TEST_CASE( test_override_observale_reporting, BasePFixture ) {
     BOOST_CHECK(processor.isObservableReportable(classId));
 }
 
+BOOST_FIXTURE_TEST_CASE( test_observable_priority, BasePFixture ) {
+
+    const class_id_t classId = 12;
+    // default priority
+    BOOST_CHECK_EQUAL(0, processor.getObservablePriority(classId));
+    processor.setObservablePriority(classId, 2);
+    BOOST_CHECK_EQUAL(2, processor.getObservablePriority(classId));
+    BOOST_CHECK_EQUAL(0, processor.getObservablePriority(classId + 1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -15,6 +15,7 @@
 #define MODB_OBJECTLISTENER_H
 
 #include <set>
+#include <vector>
 #include "ClassInfo.h"
 #include "URI.h"
 
@@ -62,6 +63,27 @@ public:
      * @param uri the URI for the updated object
      */
     virtual void objectUpdated(class_id_t class_id, const URI& uri) = 0;
+
+    /**
+     * The specified URIs of the given class have been added, updated,
+     * or deleted.  Notifications are delivered in batches: each time
+     * the notification thread wakes up, each listener gets one call
+     * per class with all the URIs that changed since the last batch.
+     * Listeners that can handle a batch more cheaply than each URI in
+     * turn should override this.  The default implementation calls
+     * objectUpdated() for each URI.
+     *
+     * @param class_id the class ID for the type associated with the
+     * updated objects
+     * @param uris the URIs for the updated objects, in the order the
+     * updates were queued
+     */
+    virtual void objectsUpdated(class_id_t class_id,
+                                const std::vector<URI>& uris) {
+        std::vector<URI>::const_iterator it;
+        for (it = uris.begin(); it != uris.end(); ++it)
+            objectUpdated(class_id, *it);
+    }
 };
 
 /* @} modb */
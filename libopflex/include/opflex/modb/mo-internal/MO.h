@@ -70,6 +70,15 @@ public:
      */
     const URI& getURI() const;
 
+    /**
+     * Get the URI of the parent of this managed object from the
+     * store.
+     *
+     * @return the URI of the parent, or boost::none if the object is
+     * no longer in the store or has no parent
+     */
+    boost::optional<URI> getParentURI() const;
+
 protected:
 
     /**
@@ -187,6 +196,28 @@ protected:
         }
     }
 
+    /**
+     * Resolve the objects of the specified class that refer to the
+     * target URI through the given reference property to their
+     * managed object wrapper classes.
+     */
+    template <class T> static
+    void resolveReferences(ofcore::OFFramework& framework,
+                           class_id_t class_id,
+                           prop_id_t prop,
+                           const URI& target,
+                           /* out */ std::vector<OF_SHARED_PTR<T> >& out) {
+        std::vector<URI> refURIs;
+        MO::getStoreClient(framework)
+            .getReferences(class_id, prop, target, refURIs);
+        std::vector<URI>::const_iterator it;
+        for (it = refURIs.begin(); it != refURIs.end(); ++it) {
+            boost::optional<OF_SHARED_PTR<T> > ref =
+                resolve<T>(framework, class_id, *it);
+            if (ref) out.push_back(ref.get());
+        }
+    }
+
     /**
      * Add a child of the specified type to the mutator and
      * instantiate the correct wrapper class
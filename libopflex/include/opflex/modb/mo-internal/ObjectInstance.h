@@ -161,6 +161,19 @@ public:
                PropertyInfo::property_type_t type,
                PropertyInfo::cardinality_t cardinality);
 
+    /**
+     * Compute the properties whose values differ between this object
+     * and another instance of the same class.  A property that is
+     * set in only one of the two objects is considered changed.
+     *
+     * @param other the object to compare against
+     * @param changed the set to which the IDs of the changed
+     * properties will be added
+     */
+    void getChangedProperties(const ObjectInstance& other,
+                              /* out */
+                              OF_UNORDERED_SET<prop_id_t>& changed) const;
+
     /**
      * Get the unsigned 64-bit valued property for prop_name.
      *
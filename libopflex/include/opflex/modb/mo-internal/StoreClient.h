@@ -200,6 +200,36 @@ public:
                      class_id_t child_class,
                      /* out */ std::vector<URI>& output);
 
+    /**
+     * Get the objects in the store that refer to the target URI
+     * through any of their reference properties.  This uses an index
+     * maintained as objects are written, so the cost is proportional
+     * to the number of references to the target.
+     *
+     * @param target the URI of the referenced object
+     * @param output the output array that will get a (reference_t,
+     * prop_id_t) pair for each referencing object and the property
+     * that refers to the target
+     */
+    void getReferences(const URI& target,
+                       /* out */ std::vector<std::pair<reference_t,
+                                                       prop_id_t> >& output);
+
+    /**
+     * Get the objects of the given class that refer to the target URI
+     * through the given reference property.
+     *
+     * @param class_id the class ID of the referencing objects
+     * @param prop the reference property of the referencing objects
+     * @param target the URI of the referenced object
+     * @param output the output array that will get the URIs of the
+     * referencing objects
+     * @throws std::out_of_range If no such class ID is registered
+     */
+    void getReferences(class_id_t class_id, prop_id_t prop,
+                       const URI& target,
+                       /* out */ std::vector<URI>& output);
+
     /**
      * Remove all the children of the given object, exluding the
      * object itself.
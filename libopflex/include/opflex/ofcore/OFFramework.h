@@ -741,6 +741,57 @@ public:
      */
      void setHandshakeTimeout(const uint32_t timeout);
 
+    /**
+     * Set the number of event loops used for peer connections.
+     * Peer connections are spread across the loops so that several
+     * peers can be served on several cores.  Must be called before
+     * start().
+     *
+     * @param loops the number of connection loops; defaults to 1
+     */
+    void setConnectionLoops(size_t loops);
+
+    /**
+     * Set the number of threads used to deliver object
+     * notifications.  With more than one thread, different
+     * listeners are notified concurrently, so listeners registered
+     * with the framework must not depend on each other's
+     * notifications.  Must be called before start().
+     *
+     * @param threads the number of notification threads; defaults
+     * to 1
+     */
+    void setNotifThreads(size_t threads);
+
+    /**
+     * Keep a snapshot on disk of the policy resolved from the
+     * OpFlex peers so that a restarted agent can load it with
+     * loadSnapshot() and program the last known policy before the
+     * peers are reachable.  Must be called before start().
+     *
+     * @param file the path to the snapshot file
+     * @param interval the maximum interval in milliseconds between
+     * snapshot writes while the policy is changing
+     * @param holdTime how long in milliseconds objects loaded from
+     * the snapshot are kept if nothing references them
+     */
+    void setSnapshot(const std::string& file, uint64_t interval,
+                     uint64_t holdTime);
+
+    /**
+     * Load the snapshot configured with setSnapshot().  The loaded
+     * objects are revalidated against the peers once they connect.
+     * Must be called after start().
+     *
+     * @return the number of objects loaded
+     */
+    size_t loadSnapshot();
+
+    /**
+     * Write the snapshot configured with setSnapshot() immediately
+     */
+    void writeSnapshot();
+
     /**
      * Start the framework.  This will start all the framework threads
      * and attempt to connect to configured OpFlex peers.
@@ -912,6 +963,17 @@ public:
       */
      void disableObservableReporting();
 
+    /**
+     * Set the priority for reporting changes to the specified
+     * observable class.  When observable changes are queued behind
+     * unacknowledged reports, those of higher-priority classes are
+     * sent first.
+     *
+     * @param class_id Observable class ID
+     * @param priority the reporting priority; the default is 0
+     */
+    void setObservablePriority(modb::class_id_t class_id, int priority);
+
 private:
     /**
      * Get the object store that provides access to the managed object
@@ -121,6 +121,27 @@ public:
     /** get the number of policies requested by the client which is not yet received */
     uint64_t getPolUnresolvedCount() { return polUnresolvedCount; }
 
+    /** get the index of the event loop serving the connection */
+    uint64_t getLoopId() { return loopId; }
+    /** set the index of the event loop serving the connection */
+    void setLoopId(uint64_t id) { loopId = id; }
+    /** get the CPU time used by the connection's event loop in ms */
+    uint64_t getLoopCpuMs() { return loopCpuMs; }
+    /** set the CPU time used by the connection's event loop in ms */
+    void setLoopCpuMs(uint64_t ms) { loopCpuMs = ms; }
+    /** get the number of messages waiting to be written to the peer */
+    uint64_t getWriteQueueDepth() { return writeQueueDepth; }
+    /** set the number of messages waiting to be written to the peer */
+    void setWriteQueueDepth(uint64_t depth) { writeQueueDepth = depth; }
+    /** get the number of full TLS handshakes with the peer */
+    uint64_t getTlsFullHandshakes() { return tlsFullHandshakes; }
+    /** set the number of full TLS handshakes with the peer */
+    void setTlsFullHandshakes(uint64_t n) { tlsFullHandshakes = n; }
+    /** get the number of resumed TLS handshakes with the peer */
+    uint64_t getTlsResumedHandshakes() { return tlsResumedHandshakes; }
+    /** set the number of resumed TLS handshakes with the peer */
+    void setTlsResumedHandshakes(uint64_t n) { tlsResumedHandshakes = n; }
+
 
 private:
 
@@ -151,6 +172,12 @@ private:
     std::atomic_ullong stateReportErrs{};
  
     std::atomic_ullong polUnresolvedCount{};
+
+    std::atomic_ullong loopId{};
+    std::atomic_ullong loopCpuMs{};
+    std::atomic_ullong writeQueueDepth{};
+    std::atomic_ullong tlsFullHandshakes{};
+    std::atomic_ullong tlsResumedHandshakes{};
 };
 
 #endif //OPFLEX_OFSTATS_H
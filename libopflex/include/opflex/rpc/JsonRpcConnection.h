@@ -117,6 +117,14 @@ public:
      */
     void processWriteQueue();
 
+    /**
+     * Get the number of messages waiting in the write queue.  This
+     * can be called from any thread.
+     *
+     * @return the queue depth
+     */
+    size_t getWriteQueueDepth();
+
     /**
      * Send the JSON-RPC message to the remote peer.  This can be called
      * from any thread.
@@ -113,6 +113,15 @@ public:
                    const std::string& serverKeyPass,
                    bool verifyPeers = true);
 
+    /**
+     * Set the number of event loops used to service agent
+     * connections.  Connections are spread across the loops by the
+     * kernel using SO_REUSEPORT.  Call before start()
+     *
+     * @param loops the number of listener loops
+     */
+    void setListenerLoops(size_t loops);
+
     /**
      * Get the peers that this server was configured with
      *
@@ -57,6 +57,14 @@ public:
      */
     ofcore::MainLoopAdaptor* getAdaptor();
 
+    /**
+     * Check whether tasks run on the main loop adaptor instead of
+     * their own threads
+     *
+     * @return true if all tasks share the adaptor's loop
+     */
+    bool hasAdaptor() const { return adaptor.get() != NULL; }
+
     /**
      * Perform final cleanup
      */
@@ -1157,13 +1157,15 @@ class ListeningTcpPeer : public ListeningPeer {
      * @param data opaque data
      * @param listenerUvLoop libuv loop listener
      * @param uvLoopSelector libuv loop selector
+     * @param reusePort set SO_REUSEPORT on the listening socket
      */
     explicit ListeningTcpPeer(
             ::yajr::Peer::StateChangeCb connectionHandler,
             ::yajr::Listener::AcceptCb acceptHandler,
             void * data,
             uv_loop_t * listenerUvLoop = NULL,
-            ::yajr::Peer::UvLoopSelector uvLoopSelector = NULL)
+            ::yajr::Peer::UvLoopSelector uvLoopSelector = NULL,
+            bool reusePort = false)
         :
           ListeningPeer(
                   connectionHandler,
@@ -1171,7 +1173,8 @@ class ListeningTcpPeer : public ListeningPeer {
                   data,
                   listenerUvLoop,
                   uvLoopSelector
-          ) {
+          ),
+          reusePort_(reusePort) {
               createFail_ = 0;
               listen_on_ = sockaddr_storage();
           }
@@ -1184,6 +1187,7 @@ class ListeningTcpPeer : public ListeningPeer {
 
   private:
     struct sockaddr_storage listen_on_;
+    bool reusePort_;
 
 };
 static_assert (sizeof(ListeningTcpPeer) <= 4096, "ListeningTcpPeer won't fit on one page");
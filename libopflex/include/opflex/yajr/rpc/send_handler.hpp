@@ -14,7 +14,15 @@
 
 #include <rapidjson/encodings.h>
 
+#include <boost/shared_ptr.hpp>
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cassert>
 #include <deque>
+#include <string>
+#include <vector>
 
 namespace yajr {
 namespace internal {
@@ -22,7 +30,12 @@ namespace internal {
 bool isLegitPunct(int c);
 
 /**
- * Generic string queue
+ * Generic string queue.  The queue is a sequence of chunks: the
+ * characters written with Put() go to chunks owned by the queue,
+ * while PutShared() appends a reference to an immutable buffer that
+ * can be shared with other queues, so a payload rendered once can be
+ * queued to many peers without copying it.
+ *
  * @tparam Encoding String encoding
  */
 template <typename Encoding = rapidjson::UTF8<> >
@@ -31,23 +44,51 @@ struct GenericStringQueue {
     /** Character */
     typedef typename Encoding::Ch Ch;
 
+    /** String of characters */
+    typedef std::basic_string<Ch> String;
+
+    /** Construct an empty queue */
+    GenericStringQueue() : size_(0) {}
+
     /** add char to queue */
     void Put(Ch c) {
-        deque_.push_back(c);
+        if (chunks_.empty() || chunks_.back().sealed) {
+            chunks_.push_back(Chunk());
+        }
+        chunks_.back().owned.push_back(c);
+        ++size_;
         assert(::yajr::internal::isLegitPunct(c));
     }
 
+    /**
+     * Add a shared buffer to the queue without copying it
+     *
+     * @param buffer the buffer to add, which must not be modified
+     * afterwards
+     */
+    void PutShared(boost::shared_ptr<const String> const & buffer) {
+        if (!buffer || buffer->empty()) {
+            return;
+        }
+        Chunk c;
+        c.shared = buffer;
+        c.sealed = true;
+        chunks_.push_back(c);
+        size_ += buffer->size();
+    }
+
     /** Flush the buffer */
     void Flush() {}
 
     /** Clear the buffer */
     void Clear() {
-        deque_.clear();
+        chunks_.clear();
+        size_ = 0;
     }
 
     /** Shrink to fit */
     void ShrinkToFit() {
-        deque_.shrink_to_fit();
+        chunks_.shrink_to_fit();
     }
 
     /**
@@ -55,11 +96,115 @@ struct GenericStringQueue {
      * @return size
      */
     size_t GetSize() const {
-        return deque_.size();
+        return size_;
+    }
+
+    /**
+     * Check whether the queue is empty
+     * @return true if there is nothing queued
+     */
+    bool Empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * Get the io vectors for everything queued.  The chunks returned
+     * are sealed, so they are not moved by later writes until they
+     * are consumed.
+     *
+     * @return the io vectors
+     */
+    std::vector<iovec> GetIovec() {
+        std::vector<iovec> iov;
+        iov.reserve(chunks_.size());
+        for (Chunk& c : chunks_) {
+            c.sealed = true;
+            iovec i = {
+                const_cast< void * >(static_cast< void const * >(c.data())),
+                c.size() * sizeof(Ch)
+            };
+            iov.push_back(i);
+        }
+        return iov;
+    }
+
+    /**
+     * Copy queued characters
+     *
+     * @param out the destination
+     * @param from the offset from the head of the queue to copy from
+     * @param n the maximum number of characters to copy
+     * @return the number of characters copied
+     */
+    size_t Copy(Ch * out, size_t from, size_t n) const {
+        size_t copied = 0;
+        for (typename std::deque<Chunk>::const_iterator it = chunks_.begin();
+             it != chunks_.end() && copied < n; ++it) {
+            size_t size = it->size();
+            if (from >= size) {
+                from -= size;
+                continue;
+            }
+            size_t len = std::min(size - from, n - copied);
+            std::copy(it->data() + from, it->data() + from + len,
+                      out + copied);
+            copied += len;
+            from = 0;
+        }
+        return copied;
+    }
+
+    /**
+     * Remove characters from the head of the queue
+     *
+     * @param n the number of characters to remove
+     */
+    void Consume(size_t n) {
+        assert(n <= size_);
+        size_ -= n;
+        while (n) {
+            Chunk& c = chunks_.front();
+            size_t len = std::min(c.size(), n);
+            c.offset += len;
+            n -= len;
+            if (!c.size()) {
+                chunks_.pop_front();
+            }
+        }
+    }
+
+    /**
+     * Get a copy of everything queued
+     * @return the queued characters
+     */
+    String GetString() const {
+        String str(size_, Ch());
+        Copy(&str[0], 0, size_);
+        return str;
     }
 
-    /** deque of chars */
-    std::deque<Ch> deque_;
+private:
+    struct Chunk {
+        Chunk() : offset(0), sealed(false) {}
+        /** shared immutable buffer, if set */
+        boost::shared_ptr<const String> shared;
+        /** characters owned by the queue */
+        String owned;
+        /** characters already consumed */
+        size_t offset;
+        /** true if no more characters may be appended */
+        bool sealed;
+
+        Ch const * data() const {
+            return (shared ? shared->data() : owned.data()) + offset;
+        }
+        size_t size() const {
+            return (shared ? shared->size() : owned.size()) - offset;
+        }
+    };
+
+    std::deque<Chunk> chunks_;
+    size_t size_;
 };
 
 //! String buffer with UTF8 encoding
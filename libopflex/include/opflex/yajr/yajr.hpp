@@ -314,8 +314,10 @@ struct Listener {
                               /**< [in] callback data for the accept callback */
         uv_loop_t                  * listenerUvLoop    = NULL,
                                        /**< [in] libuv loop for this Listener */
-        Peer::UvLoopSelector         uvLoopSelector    = NULL
+        Peer::UvLoopSelector         uvLoopSelector    = NULL,
                  /**< [in] libuv loop selector for the accepted passive peers */
+        bool                         reusePort         = false
+          /**< [in] set SO_REUSEPORT so several listeners can share the port */
     );
 
     /**
@@ -114,5 +114,57 @@ void ClassIndex::getAll(uri_set_t& output) const {
     output.insert(instance_map.begin(), instance_map.end());
 }
 
+bool ClassIndex::addRef(const URI& source, prop_id_t prop,
+                        const URI& target) {
+    std::pair<uri_prop_uri_map_t::iterator, bool> r =
+        ref_map.insert(std::make_pair(target, prop_uri_map_t()));
+    r.first->second[prop].insert(source);
+    return r.second;
+}
+
+bool ClassIndex::delRef(const URI& source, prop_id_t prop,
+                        const URI& target) {
+    uri_prop_uri_map_t::iterator rit = ref_map.find(target);
+    if (rit == ref_map.end()) return false;
+    prop_uri_map_t& pmap = rit->second;
+
+    prop_uri_map_t::iterator pit = pmap.find(prop);
+    if (pit == pmap.end()) return false;
+
+    pit->second.erase(source);
+    if (pit->second.size() == 0) {
+        pmap.erase(pit);
+        if (pmap.size() == 0) {
+            ref_map.erase(rit);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClassIndex::getRefs(const URI& target,
+                         std::vector<std::pair<URI, prop_id_t> >& output) const {
+    uri_prop_uri_map_t::const_iterator rit = ref_map.find(target);
+    if (rit == ref_map.end()) return;
+
+    prop_uri_map_t::const_iterator pit;
+    for (pit = rit->second.begin(); pit != rit->second.end(); ++pit) {
+        uri_set_t::const_iterator it;
+        for (it = pit->second.begin(); it != pit->second.end(); ++it) {
+            output.push_back(std::make_pair(*it, pit->first));
+        }
+    }
+}
+
+void ClassIndex::getRefs(const URI& target, prop_id_t prop,
+                         std::vector<URI>& output) const {
+    uri_prop_uri_map_t::const_iterator rit = ref_map.find(target);
+    if (rit == ref_map.end()) return;
+
+    prop_uri_map_t::const_iterator pit = rit->second.find(prop);
+    if (pit == rit->second.end()) return;
+    output.insert(output.end(), pit->second.begin(), pit->second.end());
+}
+
 } /* namespace modb */
 } /* namespace opflex */
@@ -0,0 +1,121 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*
+ * Implementation for ListenerPool class.
+ *
+ * Copyright (c) 2014 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+
+/* This must be included before anything else */
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdexcept>
+
+#include <boost/foreach.hpp>
+
+#include "opflex/modb/internal/ListenerPool.h"
+#include "opflex/util/LockGuard.h"
+#include "opflex/logging/internal/logging.hpp"
+
+namespace opflex {
+namespace modb {
+
+ListenerPool::ListenerPool()
+    : jobs(NULL), next(0), pending(0), shouldRun(false) {
+    uv_mutex_init(&mutex);
+    uv_cond_init(&work_cond);
+    uv_cond_init(&done_cond);
+}
+
+ListenerPool::~ListenerPool() {
+    stop();
+    uv_cond_destroy(&done_cond);
+    uv_cond_destroy(&work_cond);
+    uv_mutex_destroy(&mutex);
+}
+
+void ListenerPool::start(size_t threads) {
+    if (threads <= 1 || !workers.empty()) return;
+
+    shouldRun = true;
+    workers.resize(threads - 1);
+    for (size_t i = 0; i < workers.size(); ++i) {
+        int rc = uv_thread_create(&workers[i], worker_func, this);
+        if (rc < 0) {
+            workers.resize(i);
+            LOG(ERROR) << "Could not create listener thread: "
+                       << uv_strerror(rc);
+            break;
+        }
+    }
+}
+
+void ListenerPool::stop() {
+    if (workers.empty()) return;
+    {
+        util::LockGuard guard(&mutex);
+        shouldRun = false;
+        uv_cond_broadcast(&work_cond);
+    }
+    BOOST_FOREACH(uv_thread_t& thread, workers) {
+        uv_thread_join(&thread);
+    }
+    workers.clear();
+}
+
+// must be called with the mutex held
+void ListenerPool::runJobs() {
+    while (jobs != NULL && next < jobs->size()) {
+        const job_t& job = (*jobs)[next++];
+        uv_mutex_unlock(&mutex);
+        try {
+            job();
+        } catch (const std::exception& ex) {
+            LOG(ERROR) << "Exception in listener job: " << ex.what();
+        } catch (...) {
+            LOG(ERROR) << "Unknown error in listener job";
+        }
+        uv_mutex_lock(&mutex);
+        if (--pending == 0)
+            uv_cond_broadcast(&done_cond);
+    }
+}
+
+void ListenerPool::worker_func(void* data) {
+    ListenerPool* pool = static_cast<ListenerPool*>(data);
+    util::LockGuard guard(&pool->mutex);
+    while (true) {
+        while (pool->shouldRun &&
+               (pool->jobs == NULL || pool->next >= pool->jobs->size()))
+            uv_cond_wait(&pool->work_cond, &pool->mutex);
+        if (!pool->shouldRun) return;
+        pool->runJobs();
+    }
+}
+
+void ListenerPool::run(const std::vector<job_t>& jobs_) {
+    if (workers.empty() || jobs_.size() <= 1) {
+        BOOST_FOREACH(const job_t& job, jobs_) {
+            job();
+        }
+        return;
+    }
+
+    util::LockGuard guard(&mutex);
+    jobs = &jobs_;
+    next = 0;
+    pending = jobs_.size();
+    uv_cond_broadcast(&work_cond);
+    runJobs();
+    while (pending > 0)
+        uv_cond_wait(&done_cond, &mutex);
+    jobs = NULL;
+}
+
+} /* namespace modb */
+} /* namespace opflex */
@@ -146,6 +146,19 @@ bool ObjectInstance::unset(prop_id_t prop_id,
     return true;
 }
 
+void ObjectInstance::getChangedProperties(const ObjectInstance& other,
+                                          OF_UNORDERED_SET<prop_id_t>& changed) const {
+    BOOST_FOREACH(const prop_map_t::value_type& v, prop_map) {
+        auto it = other.prop_map.find(v.first);
+        if (it == other.prop_map.end() || v.second != it->second)
+            changed.insert(boost::get<2>(v.first));
+    }
+    BOOST_FOREACH(const prop_map_t::value_type& v, other.prop_map) {
+        if (prop_map.find(v.first) == prop_map.end())
+            changed.insert(boost::get<2>(v.first));
+    }
+}
+
 uint64_t ObjectInstance::getUInt64(prop_id_t prop_id) const {
     const Value& v = prop_map.at(make_tuple(PropertyInfo::U64,
                                             PropertyInfo::SCALAR,
@@ -20,6 +20,7 @@
 
 #include "opflex/modb/internal/ObjectStore.h"
 #include "opflex/util/LockGuard.h"
+#include "opflex/logging/internal/logging.hpp"
 
 namespace opflex {
 namespace modb {
@@ -28,7 +29,8 @@ using mointernal::StoreClient;
 
 ObjectStore::ObjectStore(util::ThreadManager& threadManager_)
     : systemClient(this, NULL), readOnlyClient(this, NULL, true),
-      notif_proc(this), notif_queue(&notif_proc, threadManager_) {
+      notif_proc(this), notif_queue(&notif_proc, threadManager_),
+      notif_threads(1) {
     uv_mutex_init(&listener_mutex);
 }
 
@@ -74,14 +76,67 @@ ObjectStore::NotifQueueProc::NotifQueueProc(ObjectStore* store_)
 
 void ObjectStore::NotifQueueProc::processItem(const URI& uri,
                                               const boost::any& data) {
-    util::LockGuard guard(&store->listener_mutex);
-    std::list<ObjectListener*>::const_iterator it;
     class_id_t class_id = boost::any_cast<class_id_t>(data);
-    std::list<ObjectListener*>& listeners =
-        store->class_map.at(class_id).listeners;
-    for (it = listeners.begin(); it != listeners.end(); ++it) {
-        (*it)->objectUpdated(class_id, uri);
+    std::vector<URI>& uris = batch[class_id];
+    if (uris.empty())
+        batch_classes.push_back(class_id);
+    uris.push_back(uri);
+}
+
+void ObjectStore::NotifQueueProc::notify(ObjectListener* listener,
+                                         const std::vector<class_id_t>& classes,
+                                         const batch_t& batch) {
+    BOOST_FOREACH(class_id_t class_id, classes) {
+        try {
+            listener->objectsUpdated(class_id, batch.at(class_id));
+        } catch (const std::exception& ex) {
+            LOG(ERROR) << "Exception while processing notification queue: "
+                       << ex.what();
+        } catch (...) {
+            LOG(ERROR) << "Unknown error while processing notification queue";
+        }
+    }
+}
+
+void ObjectStore::NotifQueueProc::batchComplete() {
+    std::vector<class_id_t> classes;
+    batch_t cur;
+    classes.swap(batch_classes);
+    cur.swap(batch);
+    if (classes.empty()) return;
+
+    util::LockGuard guard(&store->listener_mutex);
+
+    // Group the classes in the batch by listener, preserving the
+    // order in which the classes were first seen
+    std::vector<ObjectListener*> listeners;
+    OF_UNORDERED_MAP<ObjectListener*, std::vector<class_id_t> > lclasses;
+    BOOST_FOREACH(class_id_t class_id, classes) {
+        BOOST_FOREACH(ObjectListener* listener,
+                      store->class_map.at(class_id).listeners) {
+            std::vector<class_id_t>& lc = lclasses[listener];
+            if (lc.empty())
+                listeners.push_back(listener);
+            lc.push_back(class_id);
+        }
+    }
+
+    if (store->listener_pool.size() <= 1 || listeners.size() <= 1) {
+        BOOST_FOREACH(ObjectListener* listener, listeners) {
+            notify(listener, lclasses[listener], cur);
+        }
+        return;
     }
+
+    std::vector<ListenerPool::job_t> jobs;
+    jobs.reserve(listeners.size());
+    BOOST_FOREACH(ObjectListener* listener, listeners) {
+        const std::vector<class_id_t>& lc = lclasses[listener];
+        jobs.push_back([listener, &lc, &cur]() {
+                notify(listener, lc, cur);
+            });
+    }
+    store->listener_pool.run(jobs);
 }
 
 const std::string& ObjectStore::NotifQueueProc::taskName() {
@@ -89,12 +144,18 @@ const std::string& ObjectStore::NotifQueueProc::taskName() {
     return name;
 }
 
+void ObjectStore::setNotifThreads(size_t threads) {
+    notif_threads = threads;
+}
+
 void ObjectStore::start() {
+    listener_pool.start(notif_threads);
     notif_queue.start();
 }
 
 void ObjectStore::stop() {
     notif_queue.stop();
+    listener_pool.stop();
 }
 
 Region* ObjectStore::getRegion(const std::string& owner) {
@@ -14,6 +14,8 @@
 #  include <config.h>
 #endif
 
+#include <set>
+
 #include <boost/foreach.hpp>
 
 #include "opflex/modb/internal/Region.h"
@@ -24,6 +26,7 @@ namespace opflex {
 namespace modb {
 
 using std::string;
+using std::set;
 using std::vector;
 using std::pair;
 using std::make_pair;
@@ -41,6 +44,64 @@ Region::~Region() {
 
 void Region::addClass(const ClassInfo& class_info) {
     class_map[class_info.getId()];
+
+    ClassInfo::property_map_t::const_iterator it;
+    for (it = class_info.getProperties().begin();
+         it != class_info.getProperties().end(); ++it) {
+        if (it->second.getType() == PropertyInfo::REFERENCE)
+            ref_prop_map[class_info.getId()].push_back(it->second);
+    }
+}
+
+typedef set<pair<prop_id_t, URI> > prop_ref_set_t;
+
+static void getPropRefs(const vector<PropertyInfo>& props,
+                        const ObjectInstance* oi,
+                        /* out */ prop_ref_set_t& output) {
+    if (oi == NULL) return;
+    vector<PropertyInfo>::const_iterator it;
+    for (it = props.begin(); it != props.end(); ++it) {
+        prop_id_t prop = it->getId();
+        if (it->getCardinality() == PropertyInfo::SCALAR) {
+            if (oi->isSet(prop, PropertyInfo::REFERENCE))
+                output.insert(make_pair(prop,
+                                        oi->getReference(prop).second));
+        } else {
+            size_t size = oi->getReferenceSize(prop);
+            for (size_t i = 0; i < size; ++i)
+                output.insert(make_pair(prop,
+                                        oi->getReference(prop, i).second));
+        }
+    }
+}
+
+void Region::updateRefs(class_id_t class_id, ClassIndex& ci, const URI& uri,
+                        const ObjectInstance* old_oi,
+                        const ObjectInstance* new_oi) {
+    ref_prop_map_t::const_iterator pit = ref_prop_map.find(class_id);
+    if (pit == ref_prop_map.end()) return;
+
+    prop_ref_set_t old_refs, new_refs;
+    getPropRefs(pit->second, old_oi, old_refs);
+    getPropRefs(pit->second, new_oi, new_refs);
+
+    prop_ref_set_t::const_iterator it;
+    for (it = old_refs.begin(); it != old_refs.end(); ++it) {
+        if (new_refs.find(*it) != new_refs.end()) continue;
+        if (ci.delRef(uri, it->first, it->second)) {
+            ref_class_map_t::iterator cit = ref_class_map.find(it->second);
+            if (cit != ref_class_map.end()) {
+                cit->second.erase(class_id);
+                if (cit->second.empty())
+                    ref_class_map.erase(cit);
+            }
+        }
+    }
+    for (it = new_refs.begin(); it != new_refs.end(); ++it) {
+        if (old_refs.find(*it) != old_refs.end()) continue;
+        if (ci.addRef(uri, it->first, it->second))
+            ref_class_map[it->second].insert(class_id);
+    }
 }
 
 bool Region::isPresent(const URI& uri) {
@@ -69,7 +130,9 @@ void Region::put(class_id_t class_id, const URI& uri,
     LockGuard guard(&region_mutex);
     try {
         ClassIndex& ci = class_map.at(class_id);
-        uri_map[uri] = oi;
+        OF_SHARED_PTR<const ObjectInstance>& cur = uri_map[uri];
+        updateRefs(class_id, ci, uri, cur.get(), oi.get());
+        cur = oi;
         ci.addInstance(uri);
         if (!ci.hasParent(uri)) roots.insert(make_pair(class_id, uri));
     } catch (const std::out_of_range& e) {
@@ -86,11 +149,13 @@ bool Region::putIfModified(class_id_t class_id, const URI& uri,
         bool result = true;
         if (it != uri_map.end()) {
             if (*oi != *it->second) {
+                updateRefs(class_id, ci, uri, it->second.get(), oi.get());
                 it->second = oi;
             } else {
                 result = false;
             }
         } else {
+            updateRefs(class_id, ci, uri, NULL, oi.get());
             uri_map[uri] = oi;
             ci.addInstance(uri);
         }
@@ -107,7 +172,11 @@ bool Region::remove(class_id_t class_id, const URI& uri) {
     ClassIndex& ci = class_map.at(class_id);
     ci.delInstance(uri);
     roots.erase(make_pair(class_id, uri));
-    return (0 != uri_map.erase(uri));
+    uri_map_t::iterator it = uri_map.find(uri);
+    if (it == uri_map.end()) return false;
+    updateRefs(class_id, ci, uri, it->second.get(), NULL);
+    uri_map.erase(it);
+    return true;
 }
 
 bool Region::addChild(class_id_t parent_class,
@@ -173,5 +242,32 @@ void Region::getObjectsForClass(class_id_t class_id,
     ci.getAll(output);
 }
 
+void Region::getReferences(const URI& target,
+                           /* out */ vector<ref_t>& output) {
+    LockGuard guard(&region_mutex);
+    ref_class_map_t::const_iterator cit = ref_class_map.find(target);
+    if (cit == ref_class_map.end()) return;
+
+    vector<pair<URI, prop_id_t> > refs;
+    OF_UNORDERED_SET<class_id_t>::const_iterator it;
+    for (it = cit->second.begin(); it != cit->second.end(); ++it) {
+        class_map.at(*it).getRefs(target, refs);
+        vector<pair<URI, prop_id_t> >::const_iterator rit;
+        for (rit = refs.begin(); rit != refs.end(); ++rit) {
+            output.push_back(make_pair(make_pair(*it, rit->first),
+                                       rit->second));
+        }
+        refs.clear();
+    }
+}
+
+void Region::getReferences(class_id_t class_id, prop_id_t prop,
+                           const URI& target,
+                           /* out */ vector<URI>& output) {
+    LockGuard guard(&region_mutex);
+    ClassIndex& ci = class_map.at(class_id);
+    ci.getRefs(target, prop, output);
+}
+
 } /* namespace modb */
 } /* namespace opflex */
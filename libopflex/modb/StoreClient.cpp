@@ -197,6 +197,23 @@ void StoreClient::getChildren(class_id_t parent_class,
                    child_class, output);
 }
 
+void StoreClient::getReferences(const URI& target,
+                                /* out */ std::vector<std::pair<reference_t,
+                                                                prop_id_t> >& output) {
+    ObjectStore::region_owner_map_t::const_iterator it;
+    for (it = store->region_owner_map.begin();
+         it != store->region_owner_map.end(); ++it) {
+        it->second->getReferences(target, output);
+    }
+}
+
+void StoreClient::getReferences(class_id_t class_id, prop_id_t prop,
+                                const URI& target,
+                                /* out */ std::vector<URI>& output) {
+    Region* r = store->getRegion(class_id);
+    r->getReferences(class_id, prop, target, output);
+}
+
 bool StoreClient::getParent(class_id_t child_class, const URI& child,
                             /* out */ std::pair<URI, prop_id_t>& parent) {
     Region *r;
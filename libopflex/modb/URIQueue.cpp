@@ -56,6 +56,15 @@ void URIQueue::proc_async_func(uv_async_t* handle) {
                 LOG(ERROR) << "Unknown error processing notification queue";
             }
         }
+
+        try {
+            queue->processor->batchComplete();
+        } catch (const std::exception& ex) {
+            LOG(ERROR) << "Exception while processing notification queue: "
+                       << ex.what();
+        } catch (...) {
+            LOG(ERROR) << "Unknown error processing notification queue";
+        }
     }
 }
 
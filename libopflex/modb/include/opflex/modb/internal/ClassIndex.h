@@ -15,6 +15,7 @@
 #define MODB_CLASSINDEX_H
 
 #include <utility>
+#include <vector>
 
 #include "opflex/modb/URI.h"
 #include "opflex/modb/ClassInfo.h"
@@ -128,6 +129,51 @@ public:
      */
     void getAll(OF_UNORDERED_SET<URI>& output) const;
 
+    /**
+     * Record that the given source instance of this class refers to
+     * the target URI through the given reference property.
+     *
+     * @param source the URI of the referencing object
+     * @param prop the reference property of the referencing object
+     * @param target the URI of the referenced object
+     * @return true if this is the first reference to the target from
+     * an instance of this class
+     */
+    bool addRef(const URI& source, prop_id_t prop, const URI& target);
+
+    /**
+     * Remove a reference added with addRef()
+     *
+     * @param source the URI of the referencing object
+     * @param prop the reference property of the referencing object
+     * @param target the URI of the referenced object
+     * @return true if no instance of this class refers to the target
+     * any longer
+     */
+    bool delRef(const URI& source, prop_id_t prop, const URI& target);
+
+    /**
+     * Get the instances of this class that refer to the target URI
+     *
+     * @param target the URI of the referenced object
+     * @param output the output array that will get (URI, prop_id_t)
+     * pairs for the referencing object and the reference property
+     */
+    void getRefs(const URI& target,
+                 /* out */ std::vector<std::pair<URI, prop_id_t> >& output) const;
+
+    /**
+     * Get the instances of this class that refer to the target URI
+     * through the given reference property
+     *
+     * @param target the URI of the referenced object
+     * @param prop the reference property of the referencing object
+     * @param output the output array that will get the URIs of the
+     * referencing objects
+     */
+    void getRefs(const URI& target, prop_id_t prop,
+                 /* out */ std::vector<URI>& output) const;
+
 private:
     typedef OF_UNORDERED_SET<URI> uri_set_t;
     typedef OF_UNORDERED_MAP<prop_id_t, uri_set_t> prop_uri_map_t;
@@ -151,6 +197,12 @@ private:
      */
     OF_UNORDERED_SET<URI> instance_map;
 
+    /**
+     * Maps the URIs of referenced objects to the instances of this
+     * class index's type that refer to them.
+     */
+    uri_prop_uri_map_t ref_map;
+
 };
 
 } /* namespace modb */
@@ -0,0 +1,95 @@
+/* -*- C++ -*-; c-basic-offset: 4; indent-tabs-mode: nil */
+/*!
+ * @file ListenerPool.h
+ * @brief Interface definition file for ListenerPool
+ */
+/*
+ * Copyright (c) 2014 Cisco Systems, Inc. and others.  All rights reserved.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the Eclipse Public License v1.0 which accompanies this distribution,
+ * and is available at http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef MODB_LISTENERPOOL_H
+#define MODB_LISTENERPOOL_H
+
+#include <functional>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <uv.h>
+
+namespace opflex {
+namespace modb {
+
+/**
+ * @brief A fixed set of worker threads used to deliver a batch of
+ * notifications to independent listeners concurrently.
+ *
+ * The thread calling run() takes part in running the jobs, and run()
+ * returns only once every job in the batch has finished.
+ */
+class ListenerPool : private boost::noncopyable {
+public:
+    /**
+     * A unit of work to run on the pool
+     */
+    typedef std::function<void()> job_t;
+
+    /**
+     * Construct a new, stopped pool
+     */
+    ListenerPool();
+
+    /**
+     * Stop the pool and destroy it
+     */
+    ~ListenerPool();
+
+    /**
+     * Start the worker threads
+     *
+     * @param threads the number of jobs to run concurrently,
+     * including the calling thread.  With 1 or less no worker
+     * threads are started and jobs run on the calling thread.
+     */
+    void start(size_t threads);
+
+    /**
+     * Stop and join the worker threads
+     */
+    void stop();
+
+    /**
+     * Run the jobs to completion
+     *
+     * @param jobs the jobs to run.  Each job must catch its own
+     * exceptions.
+     */
+    void run(const std::vector<job_t>& jobs);
+
+    /**
+     * Get the number of jobs that can run concurrently
+     */
+    size_t size() const { return workers.size() + 1; }
+
+private:
+    std::vector<uv_thread_t> workers;
+    uv_mutex_t mutex;
+    uv_cond_t work_cond;
+    uv_cond_t done_cond;
+
+    const std::vector<job_t>* jobs;
+    size_t next;
+    size_t pending;
+    bool shouldRun;
+
+    void runJobs();
+    static void worker_func(void* data);
+};
+
+} /* namespace modb */
+} /* namespace opflex */
+
+#endif /* MODB_LISTENERPOOL_H */
@@ -24,6 +24,7 @@
 #include "opflex/modb/mo-internal/StoreClient.h"
 #include "opflex/modb/internal/Region.h"
 #include "opflex/modb/internal/URIQueue.h"
+#include "opflex/modb/internal/ListenerPool.h"
 
 namespace opflex {
 namespace modb {
@@ -65,6 +66,17 @@ public:
      */
     void stop();
 
+    /**
+     * Set the number of threads used to deliver notifications to
+     * listeners.  With more than one thread, each batch of
+     * notifications is fanned out so that different listeners run
+     * concurrently; a single listener is never called concurrently
+     * with itself.  Must be called before start()
+     *
+     * @param threads the number of notification threads
+     */
+    void setNotifThreads(size_t threads);
+
     /**
      * Get the class info object for the given class ID
      * @param class_id the class ID
@@ -220,12 +232,22 @@ private:
     public:
         NotifQueueProc(ObjectStore* store);
 
-        // notify all the listeners
+        // accumulate the notification into the current batch
         virtual void processItem(const URI& uri,
                                  const boost::any& data);
+        // notify all the listeners of the current batch
+        virtual void batchComplete();
         virtual const std::string& taskName();
     private:
+        typedef OF_UNORDERED_MAP<class_id_t, std::vector<URI> > batch_t;
+
         ObjectStore* store;
+        std::vector<class_id_t> batch_classes;
+        batch_t batch;
+
+        static void notify(ObjectListener* listener,
+                           const std::vector<class_id_t>& classes,
+                           const batch_t& batch);
     };
 
     /**
@@ -234,6 +256,12 @@ private:
     NotifQueueProc notif_proc;
     URIQueue notif_queue;
 
+    /**
+     * Threads used to fan notifications out to listeners
+     */
+    size_t notif_threads;
+    ListenerPool listener_pool;
+
     /**
      * Mutex for accessing listeners
      */
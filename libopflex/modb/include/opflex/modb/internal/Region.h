@@ -236,6 +236,40 @@ public:
     void getObjectsForClass(class_id_t class_id,
                             /* out */ OF_UNORDERED_SET<URI>& output);
 
+    /**
+     * A referencing object and the reference property that refers to
+     * the target
+     */
+    typedef std::pair<reference_t, prop_id_t> ref_t;
+
+    /**
+     * Get the objects in this region that refer to the target URI
+     * through any of their reference properties.  The cost is
+     * proportional to the number of references rather than the
+     * number of objects in the region.
+     *
+     * @param target the URI of the referenced object
+     * @param output the output array that will get the referencing
+     * objects and properties
+     */
+    void getReferences(const URI& target,
+                       /* out */ std::vector<ref_t>& output);
+
+    /**
+     * Get the objects of the given class that refer to the target URI
+     * through the given reference property.
+     *
+     * @param class_id the class ID of the referencing objects
+     * @param prop the reference property of the referencing objects
+     * @param target the URI of the referenced object
+     * @param output the output array that will get the URIs of the
+     * referencing objects
+     * @throws std::out_of_range if the class is not found
+     */
+    void getReferences(class_id_t class_id, prop_id_t prop,
+                       const URI& target,
+                       /* out */ std::vector<URI>& output);
+
 private:
     /**
      * The store client associated with this region
@@ -259,6 +293,31 @@ private:
     class_map_t class_map;
     uri_map_t uri_map;
     obj_set_t roots;
+
+    typedef OF_UNORDERED_MAP<class_id_t,
+                             std::vector<PropertyInfo> > ref_prop_map_t;
+    typedef OF_UNORDERED_MAP<URI, OF_UNORDERED_SET<class_id_t> > ref_class_map_t;
+
+    /**
+     * The reference properties of each class in the region
+     */
+    ref_prop_map_t ref_prop_map;
+
+    /**
+     * Maps the URIs of referenced objects to the classes in the
+     * region with instances that refer to them.  The referencing
+     * instances themselves are indexed in the class index.
+     */
+    ref_class_map_t ref_class_map;
+
+    /**
+     * Update the reference index for an object that is changing
+     * from old_oi to new_oi.  Either may be NULL.  Must be called
+     * with the region mutex held.
+     */
+    void updateRefs(class_id_t class_id, ClassIndex& ci, const URI& uri,
+                    const mointernal::ObjectInstance* old_oi,
+                    const mointernal::ObjectInstance* new_oi);
 };
 
 } /* namespace modb */
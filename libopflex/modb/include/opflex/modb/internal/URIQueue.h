@@ -62,6 +62,13 @@ public:
          */
         virtual void processItem(const URI& uri,
                                  const boost::any& data) = 0;
+
+        /**
+         * Called once all the items taken from the queue in one
+         * wake-up have been passed to processItem(), so that the
+         * processor can handle them as a batch.
+         */
+        virtual void batchComplete() {}
     };
 
     /**
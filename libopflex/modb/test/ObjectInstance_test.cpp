@@ -170,4 +170,25 @@ BOOST_AUTO_TEST_CASE( vector ) {
 
 }
 
+BOOST_AUTO_TEST_CASE( changed_properties ) {
+    ObjectInstance oi(1);
+    oi.setUInt64(1, 42);
+    oi.setString(2, "value");
+    oi.addInt64(3, 1);
+    ObjectInstance oi2(oi);
+
+    OF_UNORDERED_SET<prop_id_t> changed;
+    oi.getChangedProperties(oi2, changed);
+    BOOST_CHECK(changed.empty());
+
+    oi2.setUInt64(1, 43);
+    oi2.addInt64(3, 2);
+    oi2.setString(4, "new");
+    oi2.unset(2, PropertyInfo::STRING, PropertyInfo::SCALAR);
+    oi.getChangedProperties(oi2, changed);
+    BOOST_CHECK_EQUAL(4, changed.size());
+    BOOST_CHECK(changed.count(1) && changed.count(2) &&
+                changed.count(3) && changed.count(4));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -179,4 +179,202 @@ BOOST_FIXTURE_TEST_CASE( tree, BaseFixture ) {
     output.clear();
 }
 
+
+// check that the reverse reference index tracks reference properties
+// as objects are written, updated and removed
+BOOST_FIXTURE_TEST_CASE( references, BaseFixture ) {
+    URI t1("/class4/1");
+    URI t2("/class4/2");
+    URI t3("/class8/3");
+    URI src5("/class5/5");
+    URI src9("/class9/9");
+
+    OF_SHARED_PTR<ObjectInstance> oi5 = OF_MAKE_SHARED<ObjectInstance>(5);
+    oi5->addReference(11, 4, t1);
+    oi5->addReference(11, 4, t2);
+    client2->put(5, src5, oi5);
+
+    OF_SHARED_PTR<ObjectInstance> oi9 = OF_MAKE_SHARED<ObjectInstance>(9);
+    oi9->setReference(19, 8, t1);
+    client2->put(9, src9, oi9);
+
+    vector<std::pair<reference_t, prop_id_t> > refs;
+    client1->getReferences(t1, refs);
+    BOOST_CHECK_EQUAL(2, refs.size());
+    BOOST_CHECK(find(refs.begin(), refs.end(),
+                     std::make_pair(std::make_pair((class_id_t)5, src5),
+                                    (prop_id_t)11)) != refs.end());
+    BOOST_CHECK(find(refs.begin(), refs.end(),
+                     std::make_pair(std::make_pair((class_id_t)9, src9),
+                                    (prop_id_t)19)) != refs.end());
+    refs.clear();
+
+    vector<URI> output;
+    client1->getReferences(5, 11, t2, output);
+    BOOST_CHECK_EQUAL(1, output.size());
+    BOOST_CHECK_EQUAL(src5, output.at(0));
+    output.clear();
+
+    // retarget the scalar reference
+    oi9 = OF_MAKE_SHARED<ObjectInstance>(9);
+    oi9->setReference(19, 8, t3);
+    BOOST_CHECK(client2->putIfModified(9, src9, oi9));
+    client1->getReferences(t1, refs);
+    BOOST_CHECK_EQUAL(1, refs.size());
+    refs.clear();
+    client1->getReferences(9, 19, t3, output);
+    BOOST_CHECK_EQUAL(1, output.size());
+    output.clear();
+
+    client2->remove(5, src5, false);
+    client1->getReferences(t1, refs);
+    BOOST_CHECK_EQUAL(0, refs.size());
+    client1->getReferences(5, 11, t2, output);
+    BOOST_CHECK_EQUAL(0, output.size());
+    BOOST_CHECK_THROW(client1->getReferences(87, 11, t2, output),
+                      out_of_range);
+}
+
+class PoolFixture : public MDFixture {
+public:
+    PoolFixture()
+        : MDFixture(), db(threadManager) {
+        db.init(md);
+        db.setNotifThreads(3);
+        db.start();
+        client1 = &db.getStoreClient("owner1");
+    }
+
+    ~PoolFixture() {
+        db.stop();
+    }
+
+    opflex::util::ThreadManager threadManager;
+    ObjectStore db;
+    mointernal::StoreClient* client1;
+};
+
+class BatchListener : public TestListener {
+public:
+    BatchListener() : active(0), overlapped(false) {}
+
+    virtual void objectsUpdated(class_id_t class_id,
+                                const std::vector<URI>& uris) {
+        if (++active > 1) overlapped = true;
+        usleep(1000);
+        {
+            opflex::util::LockGuard guard(&mutex);
+            batches.push_back(std::make_pair(class_id, uris));
+        }
+        ObjectListener::objectsUpdated(class_id, uris);
+        --active;
+    }
+
+    // the batches delivered for the given class
+    vector<vector<URI> > getBatches(class_id_t class_id) {
+        opflex::util::LockGuard guard(&mutex);
+        vector<vector<URI> > result;
+        for (size_t i = 0; i < batches.size(); ++i) {
+            if (batches[i].first == class_id)
+                result.push_back(batches[i].second);
+        }
+        return result;
+    }
+
+    vector<std::pair<class_id_t, vector<URI> > > batches;
+    boost::atomic<int> active;
+    boost::atomic<bool> overlapped;
+};
+
+// Holds up the notification thread until released
+class BlockingListener : public ObjectListener {
+public:
+    BlockingListener() : blocked(true), entered(false) {}
+
+    virtual void objectUpdated(class_id_t class_id, const URI& uri) {
+        entered = true;
+        while (blocked)
+            usleep(1000);
+    }
+
+    boost::atomic<bool> blocked;
+    boost::atomic<bool> entered;
+};
+
+// check that notifications are delivered in batches to every
+// listener when fanned out on the listener pool
+BOOST_FIXTURE_TEST_CASE( batched_notifications, PoolFixture ) {
+    OF_UNORDERED_MAP<URI, class_id_t> notifs;
+    mointernal::StoreClient* client2 = &db.getStoreClient("owner2");
+
+    // class 2 is watched by every listener, class 1 only by some
+    BatchListener listeners[4];
+    for (size_t i = 0; i < 4; ++i) {
+        if (i >= 2)
+            db.registerListener(1, &listeners[i]);
+        db.registerListener(2, &listeners[i]);
+    }
+
+    // hold the notification thread so that the notifications below
+    // are queued up and dispatched together
+    BlockingListener blocker;
+    db.registerListener(7, &blocker);
+    URI uri7("/class7/1");
+    client2->put(7, uri7, OF_MAKE_SHARED<ObjectInstance>(7));
+    client2->queueNotification(7, uri7, notifs);
+    client2->deliverNotifications(notifs);
+    notifs.clear();
+    WAIT_FOR(blocker.entered, 500);
+
+    URI uri1("/");
+    URI uri2("/prop3/42");
+    URI uri4("/prop3/43");
+
+    client1->put(1, uri1, OF_MAKE_SHARED<ObjectInstance>(1));
+    client1->put(2, uri2, OF_MAKE_SHARED<ObjectInstance>(2));
+    client1->put(2, uri4, OF_MAKE_SHARED<ObjectInstance>(2));
+    client1->queueNotification(1, uri1, notifs);
+    client1->queueNotification(2, uri2, notifs);
+    client1->queueNotification(2, uri4, notifs);
+    client1->deliverNotifications(notifs);
+    blocker.blocked = false;
+
+    for (size_t i = 0; i < 4; ++i) {
+        WAIT_FOR(listeners[i].contains(uri2), 500);
+        WAIT_FOR(listeners[i].contains(uri4), 500);
+        if (i >= 2) {
+            WAIT_FOR(listeners[i].contains(uri1), 500);
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        // both objects of class 2 in a single call
+        vector<vector<URI> > b2 = listeners[i].getBatches(2);
+        BOOST_REQUIRE_EQUAL(1, b2.size());
+        BOOST_REQUIRE_EQUAL(2, b2[0].size());
+        BOOST_CHECK(std::find(b2[0].begin(), b2[0].end(), uri2) !=
+                    b2[0].end());
+        BOOST_CHECK(std::find(b2[0].begin(), b2[0].end(), uri4) !=
+                    b2[0].end());
+
+        vector<vector<URI> > b1 = listeners[i].getBatches(1);
+        if (i >= 2) {
+            BOOST_REQUIRE_EQUAL(1, b1.size());
+            BOOST_CHECK_EQUAL(1, b1[0].size());
+            BOOST_CHECK_EQUAL(uri1, b1[0].at(0));
+        } else {
+            BOOST_CHECK_EQUAL(0, b1.size());
+            BOOST_CHECK(!listeners[i].contains(uri1));
+        }
+        BOOST_CHECK(!listeners[i].overlapped);
+    }
+
+    db.unregisterListener(7, &blocker);
+    for (size_t i = 0; i < 4; ++i) {
+        if (i >= 2)
+            db.unregisterListener(1, &listeners[i]);
+        db.unregisterListener(2, &listeners[i]);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
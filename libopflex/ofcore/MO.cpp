@@ -81,6 +81,14 @@ const modb::URI& MO::getURI() const {
     return pimpl->uri;
 }
 
+boost::optional<modb::URI> MO::getParentURI() const {
+    std::pair<URI, prop_id_t> parent(URI::ROOT, 0);
+    if (getStoreClient(pimpl->framework)
+        .getParent(pimpl->class_id, pimpl->uri, parent))
+        return parent.first;
+    return boost::none;
+}
+
 const ObjectInstance& MO::getObjectInstance() const {
     return *pimpl->oi;
 }
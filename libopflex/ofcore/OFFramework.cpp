@@ -117,6 +117,27 @@ void OFFramework::setHandshakeTimeout(const uint32_t timeout) {
     pimpl->processor.setHandshakeTimeout(timeout);
 }
 
+void OFFramework::setConnectionLoops(size_t loops) {
+    pimpl->processor.getPool().setClientLoops(loops);
+}
+
+void OFFramework::setNotifThreads(size_t threads) {
+    pimpl->db.setNotifThreads(threads);
+}
+
+void OFFramework::setSnapshot(const std::string& file, uint64_t interval,
+                              uint64_t holdTime) {
+    pimpl->processor.setSnapshot(file, interval, holdTime);
+}
+
+size_t OFFramework::loadSnapshot() {
+    return pimpl->processor.loadSnapshot();
+}
+
+void OFFramework::writeSnapshot() {
+    pimpl->processor.writeSnapshot();
+}
+
 void OFFramework::start() {
     LOG(DEBUG) << "Starting OpFlex Framework";
     pimpl->started = true;
@@ -289,5 +310,10 @@ void OFFramework::overrideObservableReporting(modb::class_id_t class_id, bool en
 void OFFramework::disableObservableReporting() {
     pimpl->processor.disableObservableReporting();
 }
+
+void OFFramework::setObservablePriority(modb::class_id_t class_id,
+                                        int priority) {
+    pimpl->processor.setObservablePriority(class_id, priority);
+}
 } /* namespace ofcore */
 } /* namespace opflex */
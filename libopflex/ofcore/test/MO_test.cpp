@@ -124,6 +124,12 @@ BOOST_FIXTURE_TEST_CASE( model, FrameworkFixture ) {
     BOOST_CHECK_EQUAL(r4.get()->getURI().toString(),
                       r5.get()->getClass4Ref(0).second.toString());
 
+    BOOST_CHECK(!r1.get()->getParentURI());
+    BOOST_CHECK_EQUAL(uri1.toString(),
+                      r2.get()->getParentURI().get().toString());
+    BOOST_CHECK_EQUAL(uri2.toString(),
+                      r3.get()->getParentURI().get().toString());
+
 
     //Mutator mutator3(framework, "owner1");
     //r2.remove();
@@ -69,6 +69,7 @@ BOOST_AUTO_TEST_CASE( test_misc ) {
     fw.getV6Proxy(proxy);
     fw.getMacProxy(proxy);
     fw.overrideObservableReporting(1, false);
+    fw.setObservablePriority(1, 1);
     fw.disableObservableReporting();
 }
 